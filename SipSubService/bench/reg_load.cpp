@@ -0,0 +1,624 @@
+// reg_load.cpp
+// SipSupService 的端到端 REGISTER 压测：一个进程内模拟 --devices 个下级平台 / 摄像机，
+// 经回环地址的 UDP / TCP 向上级发送 REGISTER、刷新注册与 Keepalive MESSAGE，统计吞吐、时延与错误。
+//
+// 注册流程与 SipRegister::gbRegister 相同（pjsip_regc + 摘要认证，401 质询由 regc 自动带凭证重发），
+// 心跳报文与 SipKeepalive::sendKeepalive 相同。每个设备有自己的 20 位编码、regc 与认证信息
+// （realm 为设备编码，与上级质询一致；用户名 / 密码取 --usr / --pwd，上级只校验这一组账号）。
+// TCP 设备各自建立一条连接（--tcp-pct 指定比例），UDP 设备共用本地的 UDP 端口。
+//
+// 运行分两个阶段：
+//   register:  按 --register-rate 个/秒让全部设备首次注册，等全部完成；
+//   steady:    持续 --duration-sec 秒，按 --refresh-rate 个/秒轮流刷新注册（仍为 REGISTER），
+//              按 --keepalive-rate 个/秒轮流让已注册的设备发送 Keepalive。
+// 发送按固定速率排期（开环），设备上一个请求尚未完成时本次跳过并计入 skipped。
+// 每类请求输出：成功吞吐（ops_per_sec）、p50 / p99 / p999 时延、401 质询比例与各类错误计数。
+// 错误（失败的最终响应与发送失败）占已发送请求的比例超过 --max-error-pct 时以非零状态退出。
+//
+// 上级需要认识这些设备编码：先用 --write-sup-conf 生成与本次参数一致的上级配置，
+// 复制到 SUP_CONF_FILE 后启动 SipSupService，再以相同参数运行压测。
+//
+// 用法: reg_load [--target-ip ip] [--target-port N] [--sup-id id] [--local-ip ip] [--local-port N]
+//                [--devices N] [--id-prefix 13位前缀] [--tcp-pct N] [--auth 0|1] [--usr name] [--pwd password]
+//                [--register-rate N] [--refresh-rate N] [--keepalive-rate N] [--duration-sec N]
+//                [--expires N] [--io-threads N] [--max-error-pct N]
+//                [--write-sup-conf path] [--out result.json]
+
+#include "bench_util.h"
+#include "pjsip_utils.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    enum class Op { REGISTER = 0, REFRESH, KEEPALIVE, COUNT };
+    constexpr size_t OP_COUNT = static_cast<size_t>(Op::COUNT);
+
+    const char* opName(Op op)
+    {
+        switch (op)
+        {
+        case Op::REGISTER:  return "register";
+        case Op::REFRESH:   return "refresh";
+        case Op::KEEPALIVE: return "keepalive";
+        default:            return "unknown";
+        }
+    }
+
+    struct Options
+    {
+        std::string target_ip{ "127.0.0.1" };
+        int target_port{ 5061 };
+        std::string sup_id{ "10000000002000000001" };
+        std::string local_ip{ "127.0.0.1" };
+        int local_port{ 7100 };
+        size_t devices{ 1000 };
+        std::string id_prefix{ "1100000000132" };
+        int tcp_pct{ 0 };
+        bool auth{ true };
+        std::string usr{ "admin" };
+        std::string pwd{ "123" };
+        double register_rate{ 500.0 };
+        double refresh_rate{ 200.0 };
+        double keepalive_rate{ 500.0 };
+        int duration_sec{ 30 };
+        int expires{ 3600 };
+        size_t io_threads{ 2 };
+        double max_error_pct{ 1.0 };
+        std::string sup_conf;
+    };
+
+    struct Device
+    {
+        std::string id;
+        bool tcp{ false };
+        pjsip_regc* regc{ nullptr };
+        pjsip_transport* tp{ nullptr };      // TCP 设备独占的连接
+        std::string from;
+        std::string to;
+        std::string target;
+
+        std::atomic<bool> reg_busy{ false };
+        std::atomic<bool> ka_busy{ false };
+        std::atomic<bool> registered{ false };
+        std::atomic<bool> challenged{ false };
+        Op reg_op{ Op::REGISTER };
+        int64_t reg_sent_ns{ 0 };
+        int64_t ka_sent_ns{ 0 };
+        uint32_t sn{ 0 };
+    };
+
+    // 每类请求的计数与时延样本，发送线程与 PJSIP 事件线程都会写入
+    struct OpStats
+    {
+        std::mutex mutex;
+        std::vector<int64_t> latency_ns;     // 每个最终响应一个样本
+        uint64_t sent{ 0 };
+        uint64_t ok{ 0 };
+        uint64_t challenged{ 0 };            // 收到过 401 质询的请求数
+        uint64_t auth_failed{ 0 };           // 最终响应 401 / 403
+        uint64_t not_found{ 0 };             // 404，上级不认识该设备
+        uint64_t timeout{ 0 };               // 408，事务超时
+        uint64_t transport_error{ 0 };       // 503 或发送后传输出错
+        uint64_t other_error{ 0 };
+        uint64_t send_failed{ 0 };           // 未能发出
+        uint64_t skipped{ 0 };               // 设备上一个请求未完成或尚未注册
+
+        uint64_t errors() const { return auth_failed + not_found + timeout + transport_error + other_error + send_failed; }
+        uint64_t completed() const { return latency_ns.size(); }
+    };
+
+    // GB28181 MESSAGE 方法（pjsip 没有内置常量）
+    const pjsip_method s_message_method = {
+        PJSIP_OTHER_METHOD, { const_cast<char*>("MESSAGE"), 7 }
+    };
+
+    pjsip_endpoint* g_endpt = nullptr;
+    std::vector<std::unique_ptr<Device>> g_devices;
+    std::unordered_map<std::string, Device*> g_device_by_id;
+    std::array<OpStats, OP_COUNT> g_stats;
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::string deviceId(const Options& opt, size_t i)
+    {
+        std::string suffix = std::to_string(i + 1);
+        return opt.id_prefix + std::string(7 - std::min<size_t>(7, suffix.size()), '0') + suffix;
+    }
+
+    void record(Op op, pj_status_t status, int code, int64_t latency_ns, bool challenged)
+    {
+        OpStats& stats = g_stats[static_cast<size_t>(op)];
+        std::lock_guard<std::mutex> lock(stats.mutex);
+        stats.latency_ns.push_back(latency_ns);
+        if (challenged) ++stats.challenged;
+        if (code / 100 == 2) ++stats.ok;
+        else if (code == PJSIP_SC_UNAUTHORIZED || code == PJSIP_SC_FORBIDDEN) ++stats.auth_failed;
+        else if (code == PJSIP_SC_NOT_FOUND) ++stats.not_found;
+        else if (code == PJSIP_SC_REQUEST_TIMEOUT) ++stats.timeout;
+        else if (status != PJ_SUCCESS || code == PJSIP_SC_SERVICE_UNAVAILABLE) ++stats.transport_error;
+        else ++stats.other_error;
+    }
+
+    void count(Op op, uint64_t OpStats::* field)
+    {
+        OpStats& stats = g_stats[static_cast<size_t>(op)];
+        std::lock_guard<std::mutex> lock(stats.mutex);
+        ++(stats.*field);
+    }
+
+    // regc 自动处理的 401 不会回调，在事务层之前统计
+    pj_bool_t onRxResponse(pjsip_rx_data* rdata)
+    {
+        pjsip_msg* msg = rdata->msg_info.msg;
+        if (msg && msg->line.status.code == PJSIP_SC_UNAUTHORIZED && rdata->msg_info.cseq
+            && rdata->msg_info.cseq->method.id == PJSIP_REGISTER_METHOD && rdata->msg_info.from)
+        {
+            auto uri = static_cast<pjsip_sip_uri*>(pjsip_uri_get_uri(rdata->msg_info.from->uri));
+            auto it = g_device_by_id.find(std::string(uri->user.ptr, uri->user.slen));
+            if (it != g_device_by_id.end())
+            {
+                it->second->challenged.store(true, std::memory_order_relaxed);
+            }
+        }
+        return PJ_FALSE;
+    }
+
+    pjsip_module s_counter_mod = {
+        nullptr, nullptr,
+        { const_cast<char*>("mod-reg-load"), 12 }, -1,
+        PJSIP_MOD_PRIORITY_TSX_LAYER - 1,
+        nullptr, nullptr, nullptr, nullptr,
+        nullptr,
+        &onRxResponse,
+        nullptr, nullptr, nullptr
+    };
+
+    void onRegisterResult(pjsip_regc_cbparam* param)
+    {
+        auto device = static_cast<Device*>(param->token);
+        int64_t latency = nowNs() - device->reg_sent_ns;
+        record(device->reg_op, param->status, param->code, latency,
+            device->challenged.exchange(false, std::memory_order_relaxed));
+        device->registered.store(param->code / 100 == 2, std::memory_order_release);
+        device->reg_busy.store(false, std::memory_order_release);
+    }
+
+    void onKeepaliveResult(void* token, pjsip_event* e)
+    {
+        auto device = static_cast<Device*>(token);
+        int64_t latency = nowNs() - device->ka_sent_ns;
+        pjsip_transaction* tsx = (e && e->type == PJSIP_EVENT_TSX_STATE) ? e->body.tsx_state.tsx : nullptr;
+        int code = tsx ? tsx->status_code : PJSIP_SC_REQUEST_TIMEOUT;
+        record(Op::KEEPALIVE, PJ_SUCCESS, code, latency, false);
+        device->ka_busy.store(false, std::memory_order_release);
+    }
+
+    // 与 SipRegister::gbRegister 相同的 regc 初始化
+    pj_status_t setupDevice(const Options& opt, Device& device)
+    {
+        device.from = fmt::format("<sip:{}@{}:{}>", device.id, opt.local_ip, opt.local_port);
+        device.to = fmt::format("<sip:{}@{}:{}>", opt.sup_id, opt.target_ip, opt.target_port);
+        device.target = fmt::format("sip:{}@{}:{};transport={}", opt.sup_id, opt.target_ip, opt.target_port,
+            device.tcp ? "tcp" : "udp");
+        std::string contact_hdr = fmt::format("sip:{}@{}:{}", device.id, opt.local_ip, opt.local_port);
+
+        pj_str_t from = pj_str(device.from.data());
+        pj_str_t to = pj_str(device.to.data());
+        pj_str_t contact = pj_str(contact_hdr.data());
+        pj_str_t req_line = pj_str(device.target.data());
+
+        pj_status_t status = pjsip_regc_create(g_endpt, &device, &onRegisterResult, &device.regc);
+        if (status != PJ_SUCCESS)
+        {
+            LOG(ERROR) << "pjsip_regc_create failed for " << device.id << ": " << PjSipUtils::getPjStatusString(status);
+            return status;
+        }
+        status = pjsip_regc_init(device.regc, &req_line, &from, &to, 1, &contact, opt.expires);
+        if (status != PJ_SUCCESS)
+        {
+            LOG(ERROR) << "pjsip_regc_init failed for " << device.id << ": " << PjSipUtils::getPjStatusString(status);
+            return status;
+        }
+
+        if (device.tcp)
+        {
+            // 摄像机各自连接上级：不复用已有连接（需要 PJSIP 2.10 及以上）
+            pj_sockaddr addr;
+            pj_str_t host = pj_str(const_cast<char*>(opt.target_ip.c_str()));
+            status = pj_sockaddr_init(pj_AF_INET(), &addr, &host, static_cast<pj_uint16_t>(opt.target_port));
+            if (status != PJ_SUCCESS)
+            {
+                return status;
+            }
+            pjsip_tpselector sel;
+            pj_bzero(&sel, sizeof(sel));
+            sel.type = PJSIP_TPSELECTOR_NONE;
+            sel.disable_connection_reuse = PJ_TRUE;
+            status = pjsip_endpt_acquire_transport(g_endpt, PJSIP_TRANSPORT_TCP, &addr,
+                pj_sockaddr_get_len(&addr), &sel, &device.tp);
+            if (status != PJ_SUCCESS || !device.tp)
+            {
+                LOG(ERROR) << "Failed to connect TCP for " << device.id << ": " << PjSipUtils::getPjStatusString(status);
+                return status != PJ_SUCCESS ? status : PJ_EUNKNOWN;
+            }
+            pj_bzero(&sel, sizeof(sel));
+            sel.type = PJSIP_TPSELECTOR_TRANSPORT;
+            sel.u.transport = device.tp;
+            pjsip_regc_set_transport(device.regc, &sel);
+        }
+
+        if (opt.auth)
+        {
+            pjsip_cred_info cred;
+            pj_bzero(&cred, sizeof(cred));
+            cred.scheme = pj_str(const_cast<char*>("digest"));
+            cred.realm = pj_str(device.id.data());
+            cred.username = pj_str(const_cast<char*>(opt.usr.c_str()));
+            cred.data_type = PJSIP_CRED_DATA_PLAIN_PASSWD;
+            cred.data = pj_str(const_cast<char*>(opt.pwd.c_str()));
+            // regc 复制凭证，之后不再引用这里的字符串
+            status = pjsip_regc_set_credentials(device.regc, 1, &cred);
+            if (status != PJ_SUCCESS)
+            {
+                LOG(ERROR) << "pjsip_regc_set_credentials failed for " << device.id;
+                return status;
+            }
+        }
+        return PJ_SUCCESS;
+    }
+
+    void sendRegister(Device& device, Op op)
+    {
+        bool idle = false;
+        if (!device.reg_busy.compare_exchange_strong(idle, true, std::memory_order_acq_rel))
+        {
+            count(op, &OpStats::skipped);
+            return;
+        }
+        device.reg_op = op;
+        device.challenged.store(false, std::memory_order_relaxed);
+        count(op, &OpStats::sent);
+
+        // 自动刷新关闭，刷新节奏由压测控制
+        pjsip_tx_data* tdata = nullptr;
+        device.reg_sent_ns = nowNs();
+        pj_status_t status = pjsip_regc_register(device.regc, PJ_FALSE, &tdata);
+        if (status == PJ_SUCCESS)
+        {
+            status = pjsip_regc_send(device.regc, tdata);
+        }
+        if (status != PJ_SUCCESS)
+        {
+            count(op, &OpStats::send_failed);
+            device.reg_busy.store(false, std::memory_order_release);
+        }
+    }
+
+    // 与 SipKeepalive::sendKeepalive 相同的 Keepalive MESSAGE
+    void sendKeepalive(Device& device)
+    {
+        bool idle = false;
+        if (!device.ka_busy.compare_exchange_strong(idle, true, std::memory_order_acq_rel))
+        {
+            count(Op::KEEPALIVE, &OpStats::skipped);
+            return;
+        }
+        std::string body = fmt::format(
+            "<?xml version=\"1.0\" encoding=\"GB2312\"?>\r\n"
+            "<Notify>\r\n"
+            "<CmdType>Keepalive</CmdType>\r\n"
+            "<SN>{}</SN>\r\n"
+            "<DeviceID>{}</DeviceID>\r\n"
+            "<Status>OK</Status>\r\n"
+            "</Notify>\r\n", device.sn++, device.id);
+
+        pj_str_t from = pj_str(device.from.data());
+        pj_str_t to = pj_str(device.to.data());
+        pj_str_t target = pj_str(device.target.data());
+        pjsip_tx_data* tdata = nullptr;
+        pj_status_t status = pjsip_endpt_create_request(g_endpt, &s_message_method,
+            &target, &from, &to, nullptr, nullptr, -1, nullptr, &tdata);
+        if (status != PJ_SUCCESS || !tdata)
+        {
+            count(Op::KEEPALIVE, &OpStats::send_failed);
+            device.ka_busy.store(false, std::memory_order_release);
+            return;
+        }
+
+        pj_str_t type = pj_str(const_cast<char*>("Application"));
+        pj_str_t subtype = pj_str(const_cast<char*>("MANSCDP+xml"));
+        pj_str_t text;
+        pj_strdup2(tdata->pool, &text, body.c_str());
+        tdata->msg->body = pjsip_msg_body_create(tdata->pool, &type, &subtype, &text);
+        if (device.tp)
+        {
+            pjsip_tpselector sel;
+            pj_bzero(&sel, sizeof(sel));
+            sel.type = PJSIP_TPSELECTOR_TRANSPORT;
+            sel.u.transport = device.tp;
+            pjsip_tx_data_set_transport(tdata, &sel);
+        }
+
+        count(Op::KEEPALIVE, &OpStats::sent);
+        device.ka_sent_ns = nowNs();
+        // 发送失败时 pjsip 内部释放 tdata
+        status = pjsip_endpt_send_request(g_endpt, tdata, -1, &device, &onKeepaliveResult);
+        if (status != PJ_SUCCESS)
+        {
+            count(Op::KEEPALIVE, &OpStats::send_failed);
+            device.ka_busy.store(false, std::memory_order_release);
+        }
+    }
+
+    // 固定速率排期：落后时补发，不因响应变慢而降低发送速率
+    struct Pacer
+    {
+        int64_t interval_ns{ 0 };
+        int64_t next_ns{ 0 };
+
+        Pacer(double rate, int64_t start_ns)
+            : interval_ns(rate > 0 ? static_cast<int64_t>(1e9 / rate) : 0)
+            , next_ns(start_ns)
+        {
+        }
+
+        bool enabled() const { return interval_ns > 0; }
+        bool due(int64_t now) { if (!enabled() || next_ns > now) return false; next_ns += interval_ns; return true; }
+    };
+
+    uint64_t inFlight()
+    {
+        uint64_t total = 0;
+        for (auto& stats : g_stats)
+        {
+            std::lock_guard<std::mutex> lock(stats.mutex);
+            total += stats.sent - stats.send_failed - stats.completed();
+        }
+        return total;
+    }
+
+    // 等待已发出的请求全部得到最终响应（UDP 事务超时为 32 秒）
+    void drain(int64_t timeout_ns)
+    {
+        int64_t deadline = nowNs() + timeout_ns;
+        while (inFlight() > 0 && nowNs() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    double percentileMs(std::vector<int64_t>& samples, double p)
+    {
+        if (samples.empty()) return 0.0;
+        size_t idx = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+        return static_cast<double>(samples[idx]) / 1e6;
+    }
+
+    Bench::Result report(Op op, int64_t elapsed_ns)
+    {
+        OpStats& stats = g_stats[static_cast<size_t>(op)];
+        std::lock_guard<std::mutex> lock(stats.mutex);
+        Bench::Result result = Bench::makeResult(opName(op), stats.ok, static_cast<double>(elapsed_ns));
+        uint64_t completed = stats.completed();
+        result.metrics.emplace_back("sent", static_cast<double>(stats.sent));
+        result.metrics.emplace_back("p50_ms", percentileMs(stats.latency_ns, 0.50));
+        result.metrics.emplace_back("p99_ms", percentileMs(stats.latency_ns, 0.99));
+        result.metrics.emplace_back("p999_ms", percentileMs(stats.latency_ns, 0.999));
+        result.metrics.emplace_back("max_ms", percentileMs(stats.latency_ns, 1.0));
+        result.metrics.emplace_back("challenge_ratio", completed ? static_cast<double>(stats.challenged) / completed : 0.0);
+        result.metrics.emplace_back("auth_failed", static_cast<double>(stats.auth_failed));
+        result.metrics.emplace_back("not_found", static_cast<double>(stats.not_found));
+        result.metrics.emplace_back("timeout", static_cast<double>(stats.timeout));
+        result.metrics.emplace_back("transport_error", static_cast<double>(stats.transport_error));
+        result.metrics.emplace_back("other_error", static_cast<double>(stats.other_error));
+        result.metrics.emplace_back("send_failed", static_cast<double>(stats.send_failed));
+        result.metrics.emplace_back("skipped", static_cast<double>(stats.skipped));
+        return result;
+    }
+
+    // 生成与压测参数一致的上级配置（[sip_server] 中列出全部模拟设备）
+    bool writeSupConf(const Options& opt)
+    {
+        std::ofstream out(opt.sup_conf);
+        if (!out)
+        {
+            std::fprintf(stderr, "failed to open %s\n", opt.sup_conf.c_str());
+            return false;
+        }
+        out << "#sip_sup_service.conf generated by reg_load\n\n"
+            << "[local_server]\nlocal_ip = " << opt.target_ip << "\nlocal_port = 11300\nadmin_ip = 127.0.0.1\n\n"
+            << "[sip_server]\nsip_id = " << opt.sup_id << "\nsip_ip = " << opt.target_ip
+            << "\nsip_port = " << opt.target_port << "\nsip_realm = " << opt.sup_id
+            << "\nsip_usr = " << opt.usr << "\nsip_pwd = " << opt.pwd
+            << "\nsubnode_num = " << opt.devices << "\n\n";
+        for (size_t i = 0; i < opt.devices; ++i)
+        {
+            bool tcp = static_cast<int>(i % 100) < opt.tcp_pct;
+            out << "subnode_id" << i + 1 << " = " << deviceId(opt, i) << "\n"
+                << "subnode_ip" << i + 1 << " = " << opt.local_ip << "\n"
+                << "subnode_port" << i + 1 << " = " << opt.local_port << "\n"
+                << "subnode_proto" << i + 1 << " = " << (tcp ? 1 : 0) << "\n"
+                << "subnode_auth" << i + 1 << " = " << (opt.auth ? "true" : "false") << "\n\n";
+        }
+        return static_cast<bool>(out);
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        double number = std::strtod(value.c_str(), nullptr);
+        if (arg == "--target-ip") opt.target_ip = value;
+        else if (arg == "--target-port") opt.target_port = static_cast<int>(number);
+        else if (arg == "--sup-id") opt.sup_id = value;
+        else if (arg == "--local-ip") opt.local_ip = value;
+        else if (arg == "--local-port") opt.local_port = static_cast<int>(number);
+        else if (arg == "--devices") opt.devices = static_cast<size_t>(std::max(1.0, number));
+        else if (arg == "--id-prefix") opt.id_prefix = value;
+        else if (arg == "--tcp-pct") opt.tcp_pct = std::clamp(static_cast<int>(number), 0, 100);
+        else if (arg == "--auth") opt.auth = number != 0;
+        else if (arg == "--usr") opt.usr = value;
+        else if (arg == "--pwd") opt.pwd = value;
+        else if (arg == "--register-rate") opt.register_rate = number;
+        else if (arg == "--refresh-rate") opt.refresh_rate = number;
+        else if (arg == "--keepalive-rate") opt.keepalive_rate = number;
+        else if (arg == "--duration-sec") opt.duration_sec = static_cast<int>(number);
+        else if (arg == "--expires") opt.expires = static_cast<int>(number);
+        else if (arg == "--io-threads") opt.io_threads = static_cast<size_t>(std::max(1.0, number));
+        else if (arg == "--max-error-pct") opt.max_error_pct = number;
+        else if (arg == "--write-sup-conf") opt.sup_conf = value;
+    }
+
+    if (!opt.sup_conf.empty())
+    {
+        return writeSupConf(opt) ? 0 : 1;
+    }
+
+    // 只输出告警及以上，逐请求的日志会干扰测量
+    AsyncLog::setLevel(SIP_LOG_LEVEL_WARNING);
+    PjSipUtils::routePjLog();
+
+    SipTypes::CachingPoolPtr caching_pool;
+    SipTypes::EndpointPtr endpt;
+    if (PjSipUtils::initCore(caching_pool, endpt) != PJ_SUCCESS
+        || PjSipUtils::initTransports(endpt, opt.local_port) != PJ_SUCCESS
+        || pjsip_endpt_register_module(endpt.get(), &s_counter_mod) != PJ_SUCCESS)
+    {
+        std::fprintf(stderr, "failed to initialize PJSIP on port %d\n", opt.local_port);
+        return 1;
+    }
+    g_endpt = endpt.get();
+
+    std::atomic<bool> running{ true };
+    std::vector<std::thread> io_threads;
+    for (size_t t = 0; t < opt.io_threads; ++t)
+    {
+        io_threads.emplace_back([&] {
+            PjSipUtils::ThreadRegistrar thread_registrar;
+            while (running.load(std::memory_order_acquire))
+            {
+                pj_time_val timeout = { 0, 10 };
+                pjsip_endpt_handle_events(g_endpt, &timeout);
+            }
+        });
+    }
+
+    for (size_t i = 0; i < opt.devices; ++i)
+    {
+        auto device = std::make_unique<Device>();
+        device->id = deviceId(opt, i);
+        device->tcp = static_cast<int>(i % 100) < opt.tcp_pct;
+        g_device_by_id.emplace(device->id, device.get());
+        g_devices.push_back(std::move(device));
+    }
+    size_t ready = 0;
+    for (auto& device : g_devices)
+    {
+        if (setupDevice(opt, *device) == PJ_SUCCESS) ++ready;
+    }
+    std::fprintf(stderr, "%zu of %zu devices ready (%d%% TCP), target %s:%d\n",
+        ready, g_devices.size(), opt.tcp_pct, opt.target_ip.c_str(), opt.target_port);
+
+    Bench::Reporter reporter("reg_load", argc, argv);
+    constexpr int64_t DRAIN_NS = 40LL * 1000000000;
+
+    // 阶段一：全部设备首次注册
+    int64_t start = nowNs();
+    Pacer register_pacer(opt.register_rate, start);
+    for (auto& device : g_devices)
+    {
+        if (!device->regc) continue;
+        while (register_pacer.enabled() && !register_pacer.due(nowNs()))
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        sendRegister(*device, Op::REGISTER);
+    }
+    drain(DRAIN_NS);
+    int64_t register_elapsed = nowNs() - start;
+
+    // 阶段二：刷新注册与心跳
+    start = nowNs();
+    int64_t end = start + static_cast<int64_t>(opt.duration_sec) * 1000000000;
+    Pacer refresh_pacer(opt.refresh_rate, start);
+    Pacer keepalive_pacer(opt.keepalive_rate, start);
+    size_t refresh_next = 0;
+    size_t keepalive_next = 0;
+    for (int64_t now = start; now < end; now = nowNs())
+    {
+        while (refresh_pacer.due(now))
+        {
+            Device& device = *g_devices[refresh_next];
+            refresh_next = (refresh_next + 1) % g_devices.size();
+            if (device.regc) sendRegister(device, Op::REFRESH);
+        }
+        while (keepalive_pacer.due(now))
+        {
+            Device& device = *g_devices[keepalive_next];
+            keepalive_next = (keepalive_next + 1) % g_devices.size();
+            if (device.registered.load(std::memory_order_acquire))
+                sendKeepalive(device);
+            else
+                count(Op::KEEPALIVE, &OpStats::skipped);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    int64_t steady_elapsed = nowNs() - start;
+    drain(DRAIN_NS);
+
+    running.store(false, std::memory_order_release);
+    for (auto& thread : io_threads) thread.join();
+    for (auto& device : g_devices)
+    {
+        if (device->regc) pjsip_regc_destroy(device->regc);
+        if (device->tp) pjsip_transport_dec_ref(device->tp);
+    }
+
+    int rc = 0;
+    uint64_t sent = 0;
+    uint64_t errors = 0;
+    for (size_t i = 0; i < OP_COUNT; ++i)
+    {
+        Op op = static_cast<Op>(i);
+        {
+            std::lock_guard<std::mutex> lock(g_stats[i].mutex);
+            if (g_stats[i].sent == 0 && g_stats[i].skipped == 0) continue;
+            sent += g_stats[i].sent;
+            errors += g_stats[i].errors();
+        }
+        reporter.add(report(op, op == Op::REGISTER ? register_elapsed : steady_elapsed));
+    }
+    if (sent == 0 || static_cast<double>(errors) * 100.0 > opt.max_error_pct * static_cast<double>(sent))
+    {
+        std::fprintf(stderr, "%llu of %llu requests failed (budget %.2f%%)\n",
+            static_cast<unsigned long long>(errors), static_cast<unsigned long long>(sent), opt.max_error_pct);
+        rc = 1;
+    }
+
+    PjSipUtils::cleanupCore(caching_pool, endpt);
+    int out = reporter.finish();
+    return rc != 0 ? rc : out;
+}
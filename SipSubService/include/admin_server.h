@@ -0,0 +1,72 @@
+// admin_server.h - 本地管理/指标 HTTP 接口
+//
+// 基于 libevent evhttp，在独立的服务线程 "admin-http" 上监听 [local_server] local_port，
+// 只处理 GET。内置路由：
+//   /metrics        Prometheus 文本格式的指标快照（MetricsRegistry）
+//   /debug/threads  请求线程池、服务线程与定时器的统计（JSON）
+//   /debug/logs     异步日志与日志限流的统计（JSON）
+//   /debug/pools    PJSIP 内存池用量与容量最大的池（JSON，最近一次定时采集的结果）
+// 其他模块通过 addRoute 注册自己的调试路由（如 /debug/domains）。
+// 处理函数在 admin-http 线程上执行，只能读取快照或原子统计，不能阻塞信令线程持有的锁。
+
+#pragma once
+
+#include "common.h"
+#include "service_thread.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+struct evhttp;
+struct evhttp_request;
+
+struct AdminResponse
+{
+    int status{ 200 };
+    std::string content_type{ "application/json" };
+    std::string body;
+
+    // 以缩进格式写入 JSON 正文
+    void setJson(const Json::Value& value);
+};
+
+class AdminServer
+{
+public:
+    using Handler = std::function<void(AdminResponse&)>;
+
+    static std::shared_ptr<AdminServer> getInstance();
+    ~AdminServer();
+
+    AdminServer(const AdminServer&) = delete;
+    AdminServer& operator=(const AdminServer&) = delete;
+
+    // 启动前后均可注册；同一路径重复注册时替换原处理函数
+    void addRoute(const std::string& path, Handler handler);
+
+    // 绑定失败返回 false，不影响信令服务
+    bool start(const std::string& ip, int port);
+    void stop();
+    bool isRunning() const;
+
+private:
+    AdminServer();
+
+    static void onRequest(evhttp_request* req, void* arg);
+    void handle(evhttp_request* req);
+    void registerBuiltinRoutes();
+
+    std::map<std::string, std::shared_ptr<Handler>> routes_;
+    mutable std::mutex routes_mutex_;
+
+    event_base* base_{ nullptr };
+    evhttp* http_{ nullptr };
+    std::unique_ptr<ServiceThread> thread_;
+    mutable std::mutex state_mutex_;
+
+    static std::shared_ptr<AdminServer> instance_;
+    static std::mutex instance_mutex_;
+};
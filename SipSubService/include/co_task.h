@@ -0,0 +1,215 @@
+// co_task.h - 运行在线程池上的 C++20 协程
+//
+// CoTask<T>: 惰性启动的协程任务，被 co_await 时才开始执行，结束时通过对称转移
+//            直接恢复等待方。挂起期间只占用协程帧（通常几百字节），不占用线程，
+//            因此大量并发的待决事务不需要同样数量的线程。
+// coSpawn(): 把 CoTask<void> 分离后投递到线程池执行，协程结束时自行销毁帧。
+// coStart(): 在当前线程启动并分离，执行到第一个挂起点返回（适合需要在
+//            已注册到 PJSIP 的线程上发出请求的场景）。
+// resumeOn(): co_await 后切换到线程池的工作线程继续执行。
+//
+// 被分离的协程抛出的异常无人接收，只记录日志。
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "ev_thread_pool.h"
+
+template<class T = void>
+class CoTask;
+
+namespace detail {
+
+    struct CoPromiseBase
+    {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr error;
+        bool detached{ false };
+
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+
+            template<class P>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+            {
+                CoPromiseBase& promise = handle.promise();
+                if (promise.continuation)
+                    return promise.continuation;
+                if (promise.detached)
+                {
+                    if (promise.error)
+                        logDetachedError(promise.error);
+                    handle.destroy();
+                }
+                return std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+
+        static void logDetachedError(const std::exception_ptr& error) noexcept
+        {
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Unhandled exception in detached coroutine: " << e.what();
+            } catch (...) {
+                LOG(ERROR) << "Unhandled unknown exception in detached coroutine";
+            }
+        }
+    };
+
+    template<class T>
+    struct CoPromise : CoPromiseBase
+    {
+        std::optional<T> value;
+
+        CoTask<T> get_return_object() noexcept;
+
+        template<class U>
+        void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+        T result()
+        {
+            if (error) std::rethrow_exception(error);
+            return std::move(*value);
+        }
+    };
+
+    template<>
+    struct CoPromise<void> : CoPromiseBase
+    {
+        CoTask<void> get_return_object() noexcept;
+
+        void return_void() noexcept {}
+
+        void result()
+        {
+            if (error) std::rethrow_exception(error);
+        }
+    };
+
+} // namespace detail
+
+template<class T>
+class [[nodiscard]] CoTask
+{
+public:
+    using promise_type = detail::CoPromise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    CoTask() noexcept = default;
+    explicit CoTask(handle_type handle) noexcept : handle_(handle) {}
+
+    CoTask(CoTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    CoTask& operator=(CoTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+
+    ~CoTask()
+    {
+        if (handle_) handle_.destroy();
+    }
+
+    bool valid() const noexcept { return static_cast<bool>(handle_); }
+
+    // 交出协程帧的所有权（分离执行时使用）
+    handle_type release() noexcept { return std::exchange(handle_, {}); }
+
+    auto operator co_await() noexcept
+    {
+        struct Awaiter
+        {
+            handle_type handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{ handle_ };
+    }
+
+private:
+    handle_type handle_;
+};
+
+namespace detail {
+
+    template<class T>
+    CoTask<T> CoPromise<T>::get_return_object() noexcept
+    {
+        return CoTask<T>(std::coroutine_handle<CoPromise<T>>::from_promise(*this));
+    }
+
+    inline CoTask<void> CoPromise<void>::get_return_object() noexcept
+    {
+        return CoTask<void>(std::coroutine_handle<CoPromise<void>>::from_promise(*this));
+    }
+
+} // namespace detail
+
+// 切换到线程池继续执行；线程池已停止时抛出 std::runtime_error
+inline auto resumeOn(ThreadPool& pool, TrafficClass cls = TrafficClass::CONTROL)
+{
+    struct Awaiter
+    {
+        ThreadPool& pool;
+        TrafficClass cls;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            pool.post(cls, [handle]() { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+    return Awaiter{ pool, cls };
+}
+
+// 分离并投递到线程池执行
+inline void coSpawn(ThreadPool& pool, CoTask<void> task, TrafficClass cls = TrafficClass::CONTROL)
+{
+    auto handle = task.release();
+    if (!handle) return;
+    handle.promise().detached = true;
+    try {
+        pool.post(cls, [handle]() { handle.resume(); });
+    } catch (...) {
+        handle.destroy();
+        throw;
+    }
+}
+
+// 分离并在当前线程启动，执行到第一个挂起点（或结束）后返回
+inline void coStart(CoTask<void> task)
+{
+    auto handle = task.release();
+    if (!handle) return;
+    handle.promise().detached = true;
+    handle.resume();
+}
@@ -0,0 +1,472 @@
+// ev_task.h - 线程池任务类型
+//
+// TaskFunction: 只可移动的 void() 可调用对象，不超过 INLINE_SIZE 字节的
+//               可调用对象直接存放在内部缓冲区，投递任务时不需要堆分配。
+// TaskPromise / TaskFuture: 轻量 promise/future，共享状态只做一次分配，
+//               接口与 std::future 常用部分保持一致（valid/wait/wait_for/get）。
+// CancellationSource / CancellationToken: 协作式取消。线程池在出队时丢弃已取消
+//               或已过截止时间的任务；执行中的任务可通过 TaskContext 检查自身状态，
+//               耗时较长的处理函数应在各阶段之间调用 TaskContext::throwIfCancelled()；
+//               挂起等待的协程通过 onCancel() 注册回调，在取消时被提前唤醒。
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ===== 只可移动、带小缓冲区优化的任务函数 =====
+class TaskFunction
+{
+public:
+    // 内联缓冲区大小：可容纳捕获若干 shared_ptr 的 lambda 与一个 TaskPromise
+    static constexpr size_t INLINE_SIZE = 64;
+
+    TaskFunction() noexcept = default;
+
+    template <typename F,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, TaskFunction>>>
+    TaskFunction(F&& func)
+    {
+        using Fn = std::decay_t<F>;
+        if constexpr (fitsInline<Fn>())
+        {
+            new (storage_) Fn(std::forward<F>(func));
+            ops_ = &InlineOps<Fn>::ops;
+        }
+        else
+        {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(func));
+            ops_ = &HeapOps<Fn>::ops;
+        }
+    }
+
+    TaskFunction(TaskFunction&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    TaskFunction& operator=(TaskFunction&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    TaskFunction(const TaskFunction&) = delete;
+    TaskFunction& operator=(const TaskFunction&) = delete;
+
+    ~TaskFunction()
+    {
+        reset();
+    }
+
+    void operator()()
+    {
+        ops_->invoke(storage_);
+    }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    template <typename Fn>
+    static constexpr bool fitsInline()
+    {
+        return sizeof(Fn) <= INLINE_SIZE
+            && alignof(Fn) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+private:
+    struct Ops
+    {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src) noexcept;  // 移动后源对象已析构
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename Fn>
+    struct InlineOps
+    {
+        static void invoke(void* storage) { (*static_cast<Fn*>(storage))(); }
+        static void move(void* dst, void* src) noexcept
+        {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        }
+        static void destroy(void* storage) noexcept { static_cast<Fn*>(storage)->~Fn(); }
+        static constexpr Ops ops{ &invoke, &move, &destroy };
+    };
+
+    template <typename Fn>
+    struct HeapOps
+    {
+        static void invoke(void* storage) { (**static_cast<Fn**>(storage))(); }
+        static void move(void* dst, void* src) noexcept
+        {
+            *static_cast<Fn**>(dst) = *static_cast<Fn**>(src);
+        }
+        static void destroy(void* storage) noexcept { delete *static_cast<Fn**>(storage); }
+        static constexpr Ops ops{ &invoke, &move, &destroy };
+    };
+
+    void moveFrom(TaskFunction& other) noexcept
+    {
+        ops_ = other.ops_;
+        if (ops_)
+        {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (ops_)
+        {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[INLINE_SIZE];
+    const Ops* ops_{ nullptr };
+};
+
+// ===== 协作式取消 =====
+// 任务被取消或超过截止时间：出队时被丢弃的任务，其 future 也会收到该异常
+class TaskCancelledError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+namespace detail {
+    // 取消状态：标志位 + 取消时要调用的回调（挂起的协程据此提前恢复）
+    struct CancelState
+    {
+        std::atomic<bool> cancelled{ false };
+        std::mutex mutex;
+        uint64_t next_id{ 0 };
+        std::vector<std::pair<uint64_t, std::function<void()>>> callbacks;
+    };
+}
+
+class CancellationToken
+{
+public:
+    // 默认构造的令牌不可取消，也不需要分配
+    CancellationToken() noexcept = default;
+
+    bool cancellable() const noexcept { return state_ != nullptr; }
+    bool isCancelled() const noexcept
+    {
+        return state_ && state_->cancelled.load(std::memory_order_acquire);
+    }
+
+    // 注册取消回调，返回用于注销的id。已取消时在当前线程立即调用并返回0；
+    // 否则由调用 cancel() 的线程调用。回调与注销可能并发，回调自身需持有所需的状态
+    uint64_t onCancel(std::function<void()> callback) const
+    {
+        if (!state_) return 0;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (!state_->cancelled.load(std::memory_order_acquire))
+            {
+                uint64_t id = ++state_->next_id;
+                state_->callbacks.emplace_back(id, std::move(callback));
+                return id;
+            }
+        }
+        callback();
+        return 0;
+    }
+
+    void removeCallback(uint64_t id) const noexcept
+    {
+        if (!state_ || id == 0) return;
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        auto& callbacks = state_->callbacks;
+        for (auto it = callbacks.begin(); it != callbacks.end(); ++it)
+        {
+            if (it->first == id)
+            {
+                callbacks.erase(it);
+                return;
+            }
+        }
+    }
+
+private:
+    friend class CancellationSource;
+
+    explicit CancellationToken(std::shared_ptr<detail::CancelState> state) noexcept
+        : state_(std::move(state))
+    {
+    }
+
+    std::shared_ptr<detail::CancelState> state_;
+};
+
+class CancellationSource
+{
+public:
+    CancellationSource()
+        : state_(std::make_shared<detail::CancelState>())
+    {
+    }
+
+    CancellationToken token() const noexcept { return CancellationToken(state_); }
+
+    // 只有第一次调用生效；回调在锁外依次执行
+    void cancel() noexcept
+    {
+        std::vector<std::pair<uint64_t, std::function<void()>>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->cancelled.exchange(true, std::memory_order_acq_rel)) return;
+            callbacks.swap(state_->callbacks);
+        }
+        for (auto& entry : callbacks)
+        {
+            try {
+                entry.second();
+            } catch (...) {
+            }
+        }
+    }
+    bool isCancelled() const noexcept { return state_->cancelled.load(std::memory_order_acquire); }
+
+private:
+    std::shared_ptr<detail::CancelState> state_;
+};
+
+// 当前线程正在执行的池任务的截止时间与取消令牌（由线程池设置）
+class TaskContext
+{
+public:
+    // steady_clock 纳秒，与任务遥测的时间戳一致
+    static int64_t nowNs() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 截止时间，0 表示没有（不在池任务中时也为0）
+    static int64_t deadlineNs() noexcept { return current().deadline_ns; }
+
+    // 距截止时间的剩余纳秒；没有截止时间时返回 INT64_MAX
+    static int64_t remainingNs() noexcept
+    {
+        int64_t deadline = current().deadline_ns;
+        return deadline ? deadline - nowNs() : INT64_MAX;
+    }
+
+    static bool cancelled() noexcept
+    {
+        const State& state = current();
+        if (state.token && state.token->isCancelled()) return true;
+        return state.deadline_ns && nowNs() > state.deadline_ns;
+    }
+
+    static void throwIfCancelled()
+    {
+        const State& state = current();
+        if (state.token && state.token->isCancelled())
+            throw TaskCancelledError("task cancelled");
+        if (state.deadline_ns && nowNs() > state.deadline_ns)
+            throw TaskCancelledError("task deadline exceeded");
+    }
+
+    // 线程池在执行任务前后调用
+    static void enter(int64_t deadline_ns, const CancellationToken* token) noexcept
+    {
+        current() = State{ deadline_ns, token, nullptr };
+    }
+    static void leave() noexcept { current() = State{}; }
+
+    // 线程池丢弃任务期间设置丢弃原因，被销毁的 TaskPromise 据此通知等待方
+    static void setDropReason(const char* reason) noexcept { current().drop_reason = reason; }
+    static const char* dropReason() noexcept { return current().drop_reason; }
+
+private:
+    struct State
+    {
+        int64_t deadline_ns{ 0 };
+        const CancellationToken* token{ nullptr };
+        const char* drop_reason{ nullptr };
+    };
+
+    static State& current() noexcept
+    {
+        static thread_local State state;
+        return state;
+    }
+};
+
+// ===== 轻量 promise / future =====
+namespace detail {
+
+    struct TaskStateBase
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool ready{ false };
+        std::exception_ptr error;
+    };
+
+    template <typename T>
+    struct TaskState : TaskStateBase
+    {
+        std::optional<T> value;
+    };
+
+    template <>
+    struct TaskState<void> : TaskStateBase
+    {
+    };
+
+} // namespace detail
+
+template <typename T>
+class TaskFuture
+{
+public:
+    TaskFuture() noexcept = default;
+
+    bool valid() const noexcept { return state_ != nullptr; }
+
+    void wait() const
+    {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->cv.wait(lock, [this] { return state_->ready; });
+    }
+
+    template <typename Rep, typename Period>
+    std::future_status wait_for(const std::chrono::duration<Rep, Period>& timeout) const
+    {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        return state_->cv.wait_for(lock, timeout, [this] { return state_->ready; })
+            ? std::future_status::ready
+            : std::future_status::timeout;
+    }
+
+    // 与 std::future 一致：get 之后 future 不再有效
+    T get()
+    {
+        wait();
+        auto state = std::move(state_);
+        if (state->error)
+        {
+            std::rethrow_exception(state->error);
+        }
+        if constexpr (!std::is_void_v<T>)
+        {
+            return std::move(*state->value);
+        }
+    }
+
+private:
+    template <typename>
+    friend class TaskPromise;
+
+    explicit TaskFuture(std::shared_ptr<detail::TaskState<T>> state)
+        : state_(std::move(state))
+    {
+    }
+
+    std::shared_ptr<detail::TaskState<T>> state_;
+};
+
+template <typename T>
+class TaskPromise
+{
+public:
+    TaskPromise()
+        : state_(std::make_shared<detail::TaskState<T>>())
+    {
+    }
+
+    TaskPromise(TaskPromise&&) noexcept = default;
+    TaskPromise& operator=(TaskPromise&&) noexcept = default;
+    TaskPromise(const TaskPromise&) = delete;
+    TaskPromise& operator=(const TaskPromise&) = delete;
+
+    // 任务未执行就被销毁时，等待方收到 broken_promise；
+    // 线程池因取消或过期丢弃任务时收到 TaskCancelledError
+    ~TaskPromise()
+    {
+        if (state_)
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (!state_->ready)
+            {
+                const char* reason = TaskContext::dropReason();
+                state_->error = reason
+                    ? std::make_exception_ptr(TaskCancelledError(reason))
+                    : std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
+                state_->ready = true;
+                state_->cv.notify_all();
+            }
+        }
+    }
+
+    TaskFuture<T> getFuture() { return TaskFuture<T>(state_); }
+
+    template <typename... V>
+    void setValue(V&&... value)
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if constexpr (!std::is_void_v<T>)
+        {
+            state_->value.emplace(std::forward<V>(value)...);
+        }
+        state_->ready = true;
+        state_->cv.notify_all();
+    }
+
+    void setException(std::exception_ptr error)
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->error = std::move(error);
+        state_->ready = true;
+        state_->cv.notify_all();
+    }
+
+    // 执行 func 并把返回值或异常写入共享状态
+    template <typename F>
+    void fulfill(F&& func)
+    {
+        try {
+            if constexpr (std::is_void_v<T>)
+            {
+                std::forward<F>(func)();
+                setValue();
+            }
+            else
+            {
+                setValue(std::forward<F>(func)());
+            }
+        } catch (...) {
+            setException(std::current_exception());
+        }
+    }
+
+private:
+    std::shared_ptr<detail::TaskState<T>> state_;
+};
@@ -1,11 +1,28 @@
-// ev_thread_pool.h - 修复版
+// ev_thread_pool.h - 工作窃取线程池
+//
+// 每个工作线程拥有自己的分类别任务队列：本线程提交的任务压入自身队列，
+// 外部线程提交的任务进入全局注入队列，空闲线程可从其他线程队列窃取，
+// 各队列均从头部出队，同一类别内保持先进先出。提交与出队不再争用同一把全局锁。
+//
+// 每个流量类别（TrafficClass）一个通道，通道之间按权重做虚拟时间（stride）
+// 加权公平调度：每取出一个任务，该类别的虚拟时间前进 1/权重，取任务时优先选择
+// 虚拟时间最小的非空类别，高权重类别获得更多执行机会但不会独占线程。
+// 老化：某类别积压后超过 max_wait_ms 仍未取得进展时优先调度该类别，
+// 保证持续的信令高峰下批量任务仍能前进。
+//
+// 任务可携带截止时间与取消令牌（TaskOptions）：出队时已取消或已过截止时间的任务
+// 不再执行，计入 expiredTasks() / cancelledTasks()，其 future 收到 TaskCancelledError。
+// 只丢弃确已过期的任务，不按耗时预测提前丢弃。
+//
+// 线程数可在运行期调整：缩容时被选中的工作线程执行完当前任务后把本地队列
+// 转交注入队列并退出，setThreadCount 等待其退出（join）后槽位可被扩容复用。
 
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <array>
 #include <thread>
-#include <functional>
+#include <tuple>
 #include <future>
 #include <memory>
 #include <atomic>
@@ -16,19 +33,83 @@
 #include <cstdint>
 
 #include "common.h"
+#include "ev_task.h"
+#include "task_telemetry.h"
 
-// ===== 任务结构体（带优先级）=====
+// ===== 任务结构体（带优先级与流量类别）=====
 struct ThreadTask
 {
     int priority{0}; // 越大优先级越高
-    std::function<void()> func;
+    TrafficClass traffic_class{ TrafficClass::CONTROL };
+    TaskFunction func;
+    int64_t enqueue_ns{0}; // 入队时间，用于统计排队等待
+    int64_t deadline_ns{0}; // 截止时间（steady_clock），0 表示不过期
+    CancellationToken token;
+};
+
+// 提交任务的调度参数
+struct TaskOptions
+{
+    int priority{ 5 };
+    TrafficClass traffic_class{ TrafficClass::CONTROL };
+    int64_t deadline_ns{ 0 };     // steady_clock 纳秒，0 表示不过期
+    CancellationToken token;
+
+    // 截止时间设为当前时间 + timeout
+    TaskOptions& expiresAfter(std::chrono::nanoseconds timeout)
+    {
+        deadline_ns = TaskContext::nowNs() + timeout.count();
+        return *this;
+    }
+    // 截止时间设为给定的 steady_clock 时刻（如按请求到达时间推算）
+    TaskOptions& expiresAt(int64_t steady_deadline_ns)
+    {
+        deadline_ns = steady_deadline_ns;
+        return *this;
+    }
+};
+
+// ===== 任务环形队列 =====
+// 容量按2的幂增长且只增不减，稳定运行后入队/出队不再分配内存
+// （std::deque 在头部出队时会释放节点，持续收发任务会反复申请/释放）。
+class TaskRing
+{
+public:
+    bool empty() const { return head_ == tail_; }
+    size_t size() const { return tail_ - head_; }
+
+    void push_back(ThreadTask&& task)
+    {
+        if (size() == buffer_.size())
+            grow();
+        buffer_[tail_++ & (buffer_.size() - 1)] = std::move(task);
+    }
+
+    ThreadTask pop_back()
+    {
+        return std::move(buffer_[--tail_ & (buffer_.size() - 1)]);
+    }
+
+    ThreadTask pop_front()
+    {
+        return std::move(buffer_[head_++ & (buffer_.size() - 1)]);
+    }
 
-    // 支持优先队列比较
-    bool operator<(const ThreadTask& other) const
+private:
+    void grow()
     {
-        // priority越大越优先，所以小于号反向
-        return priority < other.priority;
+        std::vector<ThreadTask> bigger(buffer_.empty() ? 16 : buffer_.size() * 2);
+        size_t count = size();
+        for (size_t i = 0; i < count; ++i)
+            bigger[i] = std::move(buffer_[(head_ + i) & (buffer_.size() - 1)]);
+        buffer_.swap(bigger);
+        head_ = 0;
+        tail_ = count;
     }
+
+    std::vector<ThreadTask> buffer_;
+    size_t head_{ 0 };
+    size_t tail_{ 0 };
 };
 
 // ===== 线程池 =====
@@ -37,7 +118,30 @@ class ThreadPool
 public:
     using Task = ThreadTask;
 
-    explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+    // 每个流量类别一个通道，下标即 TrafficClass 的值
+    static constexpr size_t LANE_COUNT = TRAFFIC_CLASS_COUNT;
+
+    // 类别调度参数：weight 为加权公平调度的权重，max_wait_ms 为老化阈值
+    struct ClassPolicy
+    {
+        uint32_t weight{ 1 };
+        int64_t max_wait_ms{ 1000 };
+    };
+
+    struct ClassStats
+    {
+        size_t pending{ 0 };
+        uint64_t dispatched{ 0 };
+        uint64_t aged{ 0 };   // 因老化被优先调度的次数
+        uint64_t dropped{ 0 }; // 因过期或取消被丢弃的任务数
+    };
+
+    // 工作线程数上限（工作线程槽位预先分配，窃取时无需加锁遍历）
+    static constexpr size_t MAX_WORKERS = 256;
+
+    // cpus 为工作线程的 CPU 亲和集合，为空时不绑定
+    explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency(),
+                        std::vector<int> cpus = {});
     ~ThreadPool();
 
     ThreadPool(const ThreadPool&) = delete;
@@ -45,64 +149,232 @@ public:
     ThreadPool(ThreadPool&&) = delete;
     ThreadPool& operator=(ThreadPool&&) = delete;
 
-    // C++11/14/17: 提交带优先级任务（返回future）
+    // 提交带优先级任务（返回future），共享状态是唯一的一次分配
     template<class F, class... Args>
     auto submit(int priority, F&& func, Args&&... args)
-        -> std::future<std::invoke_result_t<F, Args...>>
+        -> TaskFuture<std::invoke_result_t<F, Args...>>
     {
         using return_type = std::invoke_result_t<F, Args...>;
-        auto task_ptr = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<F>(func), std::forward<Args>(args)...));
-        std::future<return_type> res = task_ptr->get_future();
+        TaskPromise<return_type> promise;
+        TaskFuture<return_type> res = promise.getFuture();
+
+        post(priority, [promise = std::move(promise), func = std::forward<F>(func),
+                        args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            promise.fulfill([&]() -> return_type {
+                return std::apply(std::move(func), std::move(args));
+            });
+        });
+        return res;
+    }
 
+    // 投递不需要结果的任务；可调用对象不超过 TaskFunction::INLINE_SIZE 时无堆分配
+    template<class F>
+    void post(int priority, F&& func)
+    {
+        if (stop_)
         {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
-            if (stop_)
-            {
-                LOG(ERROR) << "ThreadPool is stopped! Can't submit new task.";
-                throw std::runtime_error("ThreadPool stopped");
-            }
-            tasks_.emplace(Task{priority, [task_ptr]() { (*task_ptr)(); }});
-            ++total_enqueued_;
+            LOG(ERROR) << "ThreadPool is stopped! Can't submit new task.";
+            throw std::runtime_error("ThreadPool stopped");
         }
-        condition_.notify_one();
+        TaskOptions options;
+        options.priority = priority;
+        options.traffic_class = classOf(priority);
+        post(std::move(options), std::forward<F>(func));
+    }
+
+    // 按流量类别提交
+    template<class F, class... Args>
+    auto submit(TrafficClass cls, F&& func, Args&&... args)
+        -> TaskFuture<std::invoke_result_t<F, Args...>>
+    {
+        using return_type = std::invoke_result_t<F, Args...>;
+        TaskPromise<return_type> promise;
+        TaskFuture<return_type> res = promise.getFuture();
+
+        post(cls, [promise = std::move(promise), func = std::forward<F>(func),
+                   args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            promise.fulfill([&]() -> return_type {
+                return std::apply(std::move(func), std::move(args));
+            });
+        });
         return res;
     }
 
-    // 修改: 实现setThreadCount方法
-    void setThreadCount(size_t n); 
+    template<class F>
+    void post(TrafficClass cls, F&& func)
+    {
+        TaskOptions options;
+        options.priority = priorityOf(cls);
+        options.traffic_class = cls;
+        post(std::move(options), std::forward<F>(func));
+    }
+
+    // 按完整的调度参数提交（截止时间、取消令牌）
+    template<class F, class... Args>
+    auto submit(TaskOptions options, F&& func, Args&&... args)
+        -> TaskFuture<std::invoke_result_t<F, Args...>>
+    {
+        using return_type = std::invoke_result_t<F, Args...>;
+        TaskPromise<return_type> promise;
+        TaskFuture<return_type> res = promise.getFuture();
+
+        post(std::move(options), [promise = std::move(promise), func = std::forward<F>(func),
+                                  args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            promise.fulfill([&]() -> return_type {
+                return std::apply(std::move(func), std::move(args));
+            });
+        });
+        return res;
+    }
+
+    template<class F>
+    void post(TaskOptions options, F&& func)
+    {
+        if (stop_)
+        {
+            LOG(ERROR) << "ThreadPool is stopped! Can't submit new task.";
+            throw std::runtime_error("ThreadPool stopped");
+        }
+        Task task;
+        task.priority = options.priority;
+        task.traffic_class = options.traffic_class;
+        task.func = TaskFunction(std::forward<F>(func));
+        task.deadline_ns = options.deadline_ns;
+        task.token = std::move(options.token);
+        enqueue(std::move(task));
+    }
+
+    // 调整工作线程数；缩容时阻塞到被移除的线程执行完当前任务并退出
+    void setThreadCount(size_t n);
     size_t size() const;
     bool isRunning() const;
 
     // 统计信息
     uint64_t totalTasks() const { return total_enqueued_; }
     uint64_t completedTasks() const { return total_completed_; }
+    uint64_t stolenTasks() const { return total_stolen_; }
+    uint64_t expiredTasks() const { return total_expired_; }
+    uint64_t cancelledTasks() const { return total_cancelled_; }
     size_t pendingTasks() const;
     size_t activeThreads() const;
 
+    // 修改工作线程的 CPU 亲和集合（对已运行与新建的线程都生效）
+    void setAffinity(const std::vector<int>& cpus);
+
+    // 汇总各工作线程的任务记录环：最近 max_recent 条任务与排队/执行耗时直方图
+    TaskTelemetrySnapshot telemetry(size_t max_recent = 64) const;
+
+    void setClassPolicy(TrafficClass cls, const ClassPolicy& policy);
+    ClassPolicy classPolicy(TrafficClass cls) const;
+    std::array<ClassStats, LANE_COUNT> classStats() const;
+
     void shutdown();
 
+    // 整数优先级到流量类别：>5 信令，==5 控制，0~4 批量，<0 后台
+    static TrafficClass classOf(int priority)
+    {
+        if (priority > 5) return TrafficClass::SIGNALING;
+        if (priority == 5) return TrafficClass::CONTROL;
+        return priority >= 0 ? TrafficClass::BULK : TrafficClass::BACKGROUND;
+    }
+
+    static int priorityOf(TrafficClass cls)
+    {
+        switch (cls)
+        {
+            case TrafficClass::SIGNALING: return 10;
+            case TrafficClass::CONTROL:   return 5;
+            case TrafficClass::BULK:      return 0;
+            default:                      return -1;
+        }
+    }
+
 private:
-    void worker_loop();
-    void addWorker();
-    
-    // 修改: 添加移除工作线程方法
-    void removeWorker(size_t count = 1);
+    // 分优先级的任务队列，由各自的互斥锁保护（只有所属线程与窃取者会竞争）
+    struct LaneQueues
+    {
+        std::mutex mutex;
+        std::array<TaskRing, LANE_COUNT> lanes;
+    };
+
+    // 槽位状态：thread 可 join 且 exit_flag 为假时在运行；exit_flag 为真时正在退出
+    // （缩容时 thread 已移交给调用方 join）；join 后清除 exit_flag，thread 不可 join 且
+    // exit_flag 为假的槽位空闲（只在持有 resize_mutex_ 时修改）
+    struct Worker
+    {
+        LaneQueues queues;
+        std::thread thread;
+        std::atomic<bool> exit_flag{ false };
+        // 由工作线程在绑定 CPU 后自行分配（NUMA 本地内存），槽位复用时沿用，析构时释放
+        std::atomic<TaskTelemetryRing*> telemetry{ nullptr };
+    };
+
+    void enqueue(Task&& task);
+    void worker_loop(size_t worker_id);
+    void retireWorker(Worker& self, size_t worker_id);
+    // 缩容时从槽位移出、待 join 的线程
+    struct RetiredWorker
+    {
+        size_t id;
+        std::thread thread;
+    };
 
-    std::vector<std::thread> workers_;
-    std::priority_queue<Task> tasks_;
+    // 以下两个方法调用前必须已持有 resize_mutex_
+    bool addWorker();
+    // 通知末尾的 count 个工作线程退出，返回移出的线程，由调用方释放锁后交给 joinRetired
+    std::vector<RetiredWorker> removeWorker(size_t count = 1);
+    // 调用前不能持有 resize_mutex_：join 移出的线程后归还其槽位
+    void joinRetired(std::vector<RetiredWorker>& retired);
 
-    mutable std::mutex queue_mutex_;
+    // 按调度顺序选择类别，每个类别依次尝试 本地 -> 注入队列 -> 窃取
+    bool tryDequeue(size_t worker_id, Task& task);
+    bool popLocal(Worker& self, size_t lane, Task& task);
+    bool popInjection(size_t lane, Task& task);
+    bool steal(size_t thief_id, size_t lane, Task& task);
+
+    // 唤醒一个休眠的工作线程（没有休眠线程时不加锁）
+    void wakeOne();
+
+    std::unique_ptr<Worker[]> workers_;
+    std::atomic<size_t> worker_count_{ 0 };   // 已使用过的槽位数（含空闲槽位）
+    std::atomic<size_t> live_count_{ 0 };     // 运行中且未被要求退出的线程数
+    std::mutex resize_mutex_;
+    std::vector<int> cpus_;   // 受 resize_mutex_ 保护
+    size_t retiring_{ 0 };    // 已移出槽位尚未 join 的线程数，受 resize_mutex_ 保护
+    std::condition_variable retired_cv_;
+
+    // 全局注入队列：非工作线程提交的任务
+    LaneQueues injection_;
+
+    // 各类别的调度状态，多个工作线程并发读写，只要求近似公平
+    struct alignas(64) ClassState
+    {
+        std::atomic<int64_t> pending{ 0 };          // 排队任务数，空通道直接跳过
+        std::atomic<uint64_t> pass{ 0 };            // 虚拟时间
+        std::atomic<uint64_t> stride{ 1 };          // STRIDE_SCALE / weight
+        std::atomic<int64_t> max_wait_ns{ 0 };
+        std::atomic<int64_t> progress_ns{ 0 };      // 开始积压或最近一次出队的时间
+        std::atomic<uint64_t> dispatched{ 0 };
+        std::atomic<uint64_t> aged{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+    };
+    static constexpr uint64_t STRIDE_SCALE = 1 << 20;
+
+    std::array<ClassState, LANE_COUNT> classes_;
+    std::atomic<uint64_t> global_pass_{ 0 };        // 最近被调度类别的虚拟时间
+    std::atomic<int64_t> pending_{ 0 };
+
+    // 空闲线程休眠
+    std::mutex sleep_mutex_;
     std::condition_variable condition_;
+    std::atomic<size_t> sleepers_{ 0 };
+
     std::atomic<bool> stop_{ false };
 
     std::atomic<uint64_t> total_enqueued_{0};
     std::atomic<uint64_t> total_completed_{0};
+    std::atomic<uint64_t> total_stolen_{0};
+    std::atomic<uint64_t> total_expired_{0};
+    std::atomic<uint64_t> total_cancelled_{0};
     std::atomic<size_t> active_thread_count_{0};
-    
-    // 修改: 用vector<bool>替代atomic<bool>的vector
-    std::vector<bool> worker_exit_flags_;
-    // 存储线程ID到索引的映射
-    std::mutex thread_map_mutex_;
-    std::unordered_map<std::thread::id, size_t> thread_to_index_;
-};
\ No newline at end of file
+};
@@ -39,6 +39,8 @@ public:
 
     std::vector<DomainInfo>& getDomainInfoList() override { return domain_info_list_; }
 
+    RegRegistry& getRegRegistry() override { return reg_registry_; }
+
    
 private:
     GlobalCtl() = default;
@@ -46,6 +48,15 @@ private:
     GlobalCtl(const GlobalCtl&) = delete;
     GlobalCtl& operator=(const GlobalCtl&) = delete;
 
+    // 注册线程池与域注册表的拉取式指标
+    void registerMetrics();
+    // 注册管理接口的 /debug/domains
+    void registerAdminRoutes();
+
+    // 管理接口读取的域注册表副本：只尝试获取读锁，写者持锁时返回上一次的副本，
+    // 不让抓取请求排在信令线程之前。fresh 表示本次是否重新复制
+    std::shared_ptr<const std::vector<DomainInfo>> domainSnapshot(bool* fresh = nullptr) const;
+
     // 使用读写锁替代互斥锁，提高并发性
     mutable std::shared_mutex domain_mutex_; 
     // 添加原子操作计数器
@@ -56,6 +67,11 @@ private:
     std::shared_ptr<ISipCore> g_sip_core_;
 
     std::vector<DomainInfo> domain_info_list_;
+
+    mutable std::mutex snapshot_mutex_;
+    mutable std::shared_ptr<const std::vector<DomainInfo>> domain_snapshot_;
+    // 槽位数组地址稳定，重建域列表时旧句柄通过代数失效
+    RegRegistry reg_registry_;
     
 
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "node_info.h"
+#include "reg_registry.h"
 #include <string>
 #include <string_view>
 #include <vector>
@@ -20,4 +21,7 @@ public:
 
     virtual std::shared_mutex& getMutex() = 0; // 获取互斥锁
 
+    // 注册状态登记表，回调通过句柄无锁访问
+    virtual RegRegistry& getRegRegistry() = 0;
+
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glog/logging.h>   // Google日志库
+#include "async_log.h"        // 替换 glog 的 LOG 宏，须在 glog 之后包含
 #include <gflags/gflags.h>  // Google命令行标志库
 #include <signal.h>         // 信号处理
 
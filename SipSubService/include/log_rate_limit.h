@@ -0,0 +1,152 @@
+// log_rate_limit.h - 按调用点与 key 限流、按比例采样的日志
+//
+// 设备反复用错误凭证注册、重连风暴时，同一行 ERROR 会以请求速率重复输出，日志本身成为负担。
+//   LOG_LIMITED(severity, key) << ...;
+//     每个（调用点, key）一个令牌桶，每秒补充 rate_per_sec 个令牌、最多积累 burst 个，
+//     没有令牌的行不格式化、不提交，只计数；key 通常是设备 ID，一台设备刷屏不影响其他设备的日志。
+//     被抑制的行数每 summary_interval_ms 汇总为一行
+//     "Suppressed N similar messages for key ... in the last T s"，以原调用点的文件与行号输出。
+//   LOG_SAMPLED(severity) << ...;
+//     每个请求都会输出的 INFO 轨迹按 1/sample_every 的概率随机采样（线程局部随机数，无共享写）。
+// 限流与采样都在级别判断之后进行，被编译期或运行期级别过滤的语句不进入令牌桶。
+// 单个调用点跟踪的 key 超过 max_keys 后，新 key 共用一个溢出桶；空闲的 key 在汇总时回收。
+
+#pragma once
+
+#include "async_log.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct LogRateLimitOptions
+{
+    double rate_per_sec{ 0.2 };          // 每个（调用点, key）每秒放行的行数
+    double burst{ 5.0 };                 // 令牌桶容量
+    int summary_interval_ms{ 10000 };    // 被抑制行数的汇总周期
+    size_t max_keys{ 1024 };             // 每个调用点跟踪的 key 上限
+    uint32_t sample_every{ 100 };        // LOG_SAMPLED 平均每 N 行输出 1 行，1 表示不采样
+};
+
+// 单个调用点的统计
+struct LogRateSiteStats
+{
+    std::string file;
+    int line{ 0 };
+    size_t keys{ 0 };
+    uint64_t passed{ 0 };
+    uint64_t suppressed{ 0 };
+};
+
+class LogRateSite
+{
+public:
+    LogRateSite(const char* file, int line, int level);
+
+    LogRateSite(const LogRateSite&) = delete;
+    LogRateSite& operator=(const LogRateSite&) = delete;
+
+    // 取一个令牌，没有令牌时计入被抑制行数并返回 false
+    bool allow(std::string_view key);
+
+    // 输出到期的汇总行并回收空闲 key，由 LogRateLimiter::sweep 调用
+    void sweep(int64_t now_ns, int64_t interval_ns, int64_t idle_ns);
+    LogRateSiteStats stats() const;
+
+private:
+    struct Bucket
+    {
+        double tokens{ 0.0 };
+        int64_t last_ns{ 0 };            // 上次补充令牌的时间
+        int64_t summary_ns{ 0 };         // 上次汇总（或开始计数）的时间
+        uint64_t suppressed{ 0 };        // 自上次汇总以来被抑制的行数
+    };
+
+    // key 查找不构造临时 std::string
+    struct KeyHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+    };
+
+    static constexpr size_t SHARDS = 8;
+
+    struct alignas(64) Shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Bucket, KeyHash, std::equal_to<>> buckets;
+        Bucket overflow;                 // key 数达到上限后新 key 共用
+        uint64_t passed{ 0 };
+        uint64_t suppressed_total{ 0 };
+    };
+
+    bool take(Bucket& bucket, int64_t now_ns);
+
+    const char* file_;
+    int line_;
+    int level_;
+    std::array<Shard, SHARDS> shards_;
+};
+
+class LogRateLimiter
+{
+public:
+    static std::shared_ptr<LogRateLimiter> getInstance();
+
+    LogRateLimiter(const LogRateLimiter&) = delete;
+    LogRateLimiter& operator=(const LogRateLimiter&) = delete;
+
+    void configure(const LogRateLimitOptions& options);
+    LogRateLimitOptions options() const;
+
+    // 热路径读取的参数，configure 之后立即生效
+    static double ratePerSec() { return rate_per_sec_.load(std::memory_order_relaxed); }
+    static double burst() { return burst_.load(std::memory_order_relaxed); }
+    static size_t maxKeys() { return max_keys_.load(std::memory_order_relaxed); }
+    static bool sample();
+
+    // 到了汇总周期才真正执行；限流的日志调用顺带触发，AsyncLog 后台线程也会定期调用
+    static void maybeSweep(int64_t now_ns);
+    void sweep();
+
+    void addSite(LogRateSite* site);
+    std::vector<LogRateSiteStats> siteStats() const;
+    uint64_t suppressedTotal() const;
+
+    static int64_t nowNs();
+
+private:
+    LogRateLimiter() = default;
+
+    static std::atomic<double> rate_per_sec_;
+    static std::atomic<double> burst_;
+    static std::atomic<size_t> max_keys_;
+    static std::atomic<uint32_t> sample_every_;
+    static std::atomic<int64_t> interval_ns_;
+    static std::atomic<int64_t> next_sweep_ns_;
+
+    mutable std::mutex sites_mutex_;
+    std::vector<LogRateSite*> sites_;
+    std::mutex sweep_mutex_;
+
+    static std::shared_ptr<LogRateLimiter> instance_;
+    static std::mutex instance_mutex_;
+};
+
+// 每个展开位置一个调用点对象，有意不析构：退出过程中后台线程仍可能汇总
+#define SIP_LOG_RATE_SITE(level) \
+    ([]() -> LogRateSite& { static LogRateSite& site = *new LogRateSite(__FILE__, __LINE__, (level)); return site; }())
+
+#define LOG_LIMITED(severity, key) \
+    !((SIP_LOG_LEVEL_##severity) >= SIP_LOG_MIN_LEVEL && AsyncLog::enabled(SIP_LOG_LEVEL_##severity) \
+      && SIP_LOG_RATE_SITE(SIP_LOG_LEVEL_##severity).allow(key)) ? (void)0 : LOG(severity)
+
+#define LOG_SAMPLED(severity) \
+    !((SIP_LOG_LEVEL_##severity) >= SIP_LOG_MIN_LEVEL && AsyncLog::enabled(SIP_LOG_LEVEL_##severity) \
+      && LogRateLimiter::sample()) ? (void)0 : LOG(severity)
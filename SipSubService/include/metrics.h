@@ -0,0 +1,159 @@
+// metrics.h - 进程内指标注册表
+//
+// 计数器与直方图按线程分片：每个线程首次写入时分到一个分片（缓存行对齐），之后只对
+// 该分片做 relaxed 原子加，不与其他线程争用缓存行，单次写入只有几纳秒。
+// 快照逐个读取分片求和，不加锁、不暂停写入者；各分片的读取时刻略有先后，
+// 计数器的快照值介于开始读取与读取结束时的真实值之间，前后两次快照不会回退。
+// 仪表（Gauge）通常只被少数地方设置，使用单个原子量；队列深度、线程数、在线域数等
+// 已有统计的值通过拉取式回调（gaugeFn / counterFn）在快照时读取，不在热路径上维护。
+//
+// 注册接口返回的引用在进程生命周期内有效，热路径应在首次使用时缓存（函数内 static）。
+// 同名同标签重复注册返回同一个对象。
+
+#pragma once
+
+#include "task_telemetry.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class MetricType { COUNTER, GAUGE, HISTOGRAM };
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+namespace detail {
+    constexpr size_t METRIC_SHARDS = 32;   // 必须是2的幂
+
+    size_t assignMetricShard();
+
+    // 当前线程使用的分片
+    inline size_t metricShard()
+    {
+        static thread_local size_t shard = assignMetricShard();
+        return shard;
+    }
+}
+
+class Counter
+{
+public:
+    void inc(uint64_t n = 1) { cells_[detail::metricShard()].value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Cell
+    {
+        std::atomic<uint64_t> value{ 0 };
+    };
+    std::array<Cell, detail::METRIC_SHARDS> cells_;
+};
+
+class Gauge
+{
+public:
+    void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{ 0 };
+};
+
+// 耗时直方图，桶划分与 LatencyHistogram 相同（第 i 个桶为 [2^(i-1), 2^i) 纳秒）
+class Histogram
+{
+public:
+    void observeNs(int64_t ns)
+    {
+        Shard& shard = shards_[detail::metricShard()];
+        shard.buckets[LatencyHistogram::bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum_ns.fetch_add(static_cast<uint64_t>(ns > 0 ? ns : 0), std::memory_order_relaxed);
+    }
+
+    template<class Rep, class Period>
+    void observe(std::chrono::duration<Rep, Period> d)
+    {
+        observeNs(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    }
+
+    // 合并各分片；sum_ns 为所有观测值之和
+    LatencyHistogram load(uint64_t* sum_ns = nullptr) const;
+
+private:
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKETS> buckets{};
+        std::atomic<uint64_t> sum_ns{ 0 };
+    };
+    std::array<Shard, detail::METRIC_SHARDS> shards_;
+};
+
+// 快照中的一条指标
+struct MetricSample
+{
+    std::string name;
+    std::string help;
+    MetricType type{ MetricType::COUNTER };
+    MetricLabels labels;
+    double value{ 0 };               // 计数器、仪表
+    LatencyHistogram histogram;      // 直方图
+    uint64_t sum_ns{ 0 };
+};
+
+// 按 Prometheus 文本格式（0.0.4）输出快照；直方图换算为秒，桶上界为 2^i 纳秒
+std::string formatPrometheus(const std::vector<MetricSample>& samples);
+
+class MetricsRegistry
+{
+public:
+    static std::shared_ptr<MetricsRegistry> getInstance();
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    // 名称或标签相同但类型不同时抛出 std::invalid_argument
+    Counter& counter(const std::string& name, const std::string& help, MetricLabels labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, MetricLabels labels = {});
+    Histogram& histogram(const std::string& name, const std::string& help, MetricLabels labels = {});
+
+    // 拉取式指标：快照时调用 fn 取值；fn 在调用 snapshot() 的线程上执行，不能再注册指标。
+    // 同名同标签重复注册时替换原回调
+    void gaugeFn(const std::string& name, const std::string& help, std::function<double()> fn, MetricLabels labels = {});
+    void counterFn(const std::string& name, const std::string& help, std::function<double()> fn, MetricLabels labels = {});
+
+    // 按名称排序（同名指标相邻），同名内保持注册顺序
+    std::vector<MetricSample> snapshot() const;
+
+private:
+    MetricsRegistry() = default;
+
+    struct Entry
+    {
+        std::string name;
+        std::string help;
+        MetricType type;
+        MetricLabels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        std::shared_ptr<std::function<double()>> fn;
+    };
+
+    // 调用时须持有 mutex_；不存在时创建
+    Entry& findOrAdd(const std::string& name, const std::string& help, MetricType type, MetricLabels&& labels);
+
+    // 条目只增不删，快照可以在释放锁之后读取条目中的指标对象
+    std::vector<std::unique_ptr<Entry>> entries_;
+    mutable std::mutex mutex_;
+
+    static std::shared_ptr<MetricsRegistry> instance_;
+    static std::mutex instance_mutex_;
+};
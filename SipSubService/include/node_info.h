@@ -3,6 +3,7 @@
 #pragma once
 
 #include "common.h"
+#include "reg_registry.h"
 #include <string>
 #include <string_view>
 
@@ -52,7 +53,8 @@ struct DomainInfo
     int sip_port { 0 };
     int proto { 0 };
     int expires { 60 };
-    bool registered { false };
+    // 注册状态保存在 RegRegistry 中，这里只保存句柄
+    RegHandle reg_handle;
     bool isAuth { false }; // 是否需要认证
     std::string usr;
     std::string pwd;
@@ -65,7 +67,6 @@ struct DomainInfo
         , sip_port(node.port)
         , proto(node.proto)
         , expires(node.expires)
-        , registered(false)
         , isAuth(node.auth)
         , usr(node.usr)
         , pwd(node.pwd)
@@ -0,0 +1,99 @@
+// pool_autoscaler.h - 线程池弹性伸缩
+//
+// 周期性采样线程池的排队任务数与本周期内的排队等待 p99（来自任务遥测直方图的增量），
+// 超过阈值时按当前线程数成倍扩容（注册风暴期间快速追上负载），负载回落并持续
+// 一个冷却期后再逐步缩容到下限。控制循环运行在独立的服务线程上，每次伸缩都会
+// 记录事件并累计计数，可通过 stats() 查询。
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "service_thread.h"
+#include "task_telemetry.h"
+
+class ThreadPool;
+
+struct PoolAutoscalerOptions
+{
+    bool enabled{ false };
+    size_t min_threads{ 0 };                  // 0 表示 CPU 核数
+    size_t max_threads{ 0 };                  // 0 表示 min_threads 的4倍
+    size_t grow_queue_per_thread{ 4 };        // 排队任务数超过 线程数*该值 时扩容
+    int64_t grow_wait_p99_ms{ 50 };           // 周期内排队等待 p99 超过该值时扩容
+    int64_t shrink_wait_p99_ms{ 5 };          // 低于该值且队列为空视为空闲
+    int64_t shrink_cooldown_ms{ 30000 };      // 持续空闲且距上次伸缩超过该时间才缩容
+    int64_t interval_ms{ 200 };               // 采样周期
+};
+
+// 一次伸缩事件
+struct PoolResizeEvent
+{
+    int64_t time_ns{ 0 };        // steady_clock 时间戳
+    size_t from{ 0 };
+    size_t to{ 0 };
+    size_t queue_depth{ 0 };
+    int64_t wait_p99_ns{ 0 };
+    const char* reason{ "" };    // "queue_depth" / "queue_wait" / "idle"
+};
+
+struct PoolAutoscalerStats
+{
+    size_t threads{ 0 };
+    size_t min_threads{ 0 };
+    size_t max_threads{ 0 };
+    size_t peak_threads{ 0 };
+    uint64_t grow_events{ 0 };
+    uint64_t shrink_events{ 0 };
+    size_t last_queue_depth{ 0 };
+    int64_t last_wait_p99_ns{ 0 };
+    std::deque<PoolResizeEvent> recent;   // 最近的伸缩事件，从旧到新
+};
+
+class PoolAutoscaler
+{
+public:
+    static constexpr size_t MAX_RECENT_EVENTS = 32;
+
+    PoolAutoscaler(ThreadPool& pool, PoolAutoscalerOptions options, std::string name = "pool-scaler");
+    ~PoolAutoscaler();
+
+    PoolAutoscaler(const PoolAutoscaler&) = delete;
+    PoolAutoscaler& operator=(const PoolAutoscaler&) = delete;
+
+    // 先把线程数收敛到 [min, max]，再启动控制线程
+    bool start();
+    void stop();
+
+    // 执行一次采样与伸缩决策（控制线程每个周期调用一次）
+    void tick();
+
+    PoolAutoscalerStats stats() const;
+    const PoolAutoscalerOptions& options() const { return options_; }
+
+private:
+    void run(ServiceThread& self);
+    void resize(size_t target, size_t depth, int64_t wait_p99_ns, const char* reason);
+
+    ThreadPool& pool_;
+    PoolAutoscalerOptions options_;
+    std::string name_;
+    std::unique_ptr<ServiceThread> thread_;
+
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+
+    // 只由 tick() 访问
+    LatencyHistogram last_queue_wait_;
+    int64_t last_resize_ns_{ 0 };
+    int64_t idle_since_ns_{ 0 };
+
+    mutable std::mutex stats_mutex_;
+    PoolAutoscalerStats stats_;
+};
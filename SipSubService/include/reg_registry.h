@@ -0,0 +1,95 @@
+// reg_registry.h
+// 注册令牌登记表：pjsip_regc 回调令牌使用“槽位索引 + 代数”句柄，
+// 槽位数组一次分配、地址稳定，回调线程可以无锁地校验并更新注册状态。
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// 注册状态
+enum class RegState : uint8_t
+{
+    UNREGISTERED = 0,   // 未注册，等待下一次注册
+    REGISTERING,        // 注册请求已发出，等待回调
+    REGISTERED,         // 注册成功
+    FAILED              // 注册失败，等待下一次重试
+};
+
+const char* regStateName(RegState state);
+
+// 注册句柄：槽位索引 + 代数，代数为0表示无效句柄
+struct RegHandle
+{
+    uint32_t index { 0 };
+    uint32_t generation { 0 };
+
+    bool valid() const { return generation != 0; }
+
+    // 编码为 pjsip_regc 的 void* 令牌（代数非0，保证令牌非空）
+    void* toToken() const;
+    static RegHandle fromToken(const void* token);
+};
+
+class RegRegistry
+{
+public:
+    explicit RegRegistry(size_t capacity = 1024);
+    ~RegRegistry() = default;
+
+    RegRegistry(const RegRegistry&) = delete;
+    RegRegistry& operator=(const RegRegistry&) = delete;
+
+    // 分配/释放槽位（仅在构建域列表时调用，使用互斥锁）
+    RegHandle acquire(const std::string& sip_id);
+    void release(RegHandle handle);
+    void releaseAll();
+
+    // 以下接口无锁，句柄过期时返回失败
+    std::optional<RegState> state(RegHandle handle) const;
+    // 原子状态迁移：仅当当前状态为 expected 时改为 desired
+    bool transition(RegHandle handle, RegState expected, RegState desired);
+    // 不关心原状态，直接写入新状态
+    bool store(RegHandle handle, RegState desired);
+    // 获取槽位对应的域ID（句柄过期时返回空）
+    std::shared_ptr<const std::string> sipId(RegHandle handle) const;
+
+    size_t capacity() const { return capacity_; }
+    size_t inUse() const { return in_use_.load(std::memory_order_relaxed); }
+    // 因句柄过期被丢弃的回调次数
+    uint64_t staleCount() const { return stale_count_.load(std::memory_order_relaxed); }
+
+private:
+    // 代数与状态打包在同一个64位原子量中，一次CAS同时校验两者
+    static uint64_t pack(uint32_t generation, RegState state)
+    {
+        return (static_cast<uint64_t>(generation) << 8) | static_cast<uint8_t>(state);
+    }
+    static uint32_t genOf(uint64_t word) { return static_cast<uint32_t>(word >> 8); }
+    static RegState stateOf(uint64_t word) { return static_cast<RegState>(word & 0xff); }
+
+    struct Slot
+    {
+        std::atomic<uint64_t> word { 0 };
+        // 只经 std::atomic_load / std::atomic_store 访问（GCC 11 的 libstdc++ 尚无 atomic<shared_ptr>）
+        std::shared_ptr<const std::string> sip_id;
+    };
+
+    const Slot* lookup(RegHandle handle) const;
+    Slot* lookup(RegHandle handle);
+
+    const size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+
+    std::mutex free_mutex_;
+    std::vector<uint32_t> free_list_;
+    std::vector<RegHandle> live_;
+
+    std::atomic<size_t> in_use_ { 0 };
+    mutable std::atomic<uint64_t> stale_count_ { 0 };
+};
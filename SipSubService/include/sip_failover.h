@@ -0,0 +1,76 @@
+// sip_failover.h
+// 多上级主备切换：按 supnode 顺序排定优先级，只向活动上级注册。
+// 每个上级用短超时的 OPTIONS 探测，同时吸收注册/心跳事务结果，
+// 活动上级在判定窗口内无成功响应即切到最优的健康备用上级；
+// 更高优先级的上级持续健康超过保持时间后再回切（滞回）。
+
+#pragma once
+
+#include "common.h"
+#include "task_timer.h"
+#include "interfaces/idomain_manager.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class SipFailover : public std::enable_shared_from_this<SipFailover>
+{
+public:
+    // 单例工厂
+    static std::shared_ptr<SipFailover> getInstance(IDomainManager& domain_manager);
+
+    SipFailover(const SipFailover&) = delete;
+    SipFailover& operator=(const SipFailover&) = delete;
+    ~SipFailover();
+
+    // 仅在 active_standby 模式下启动探测定时器
+    void startFailoverService();
+
+    // 域列表下标对应的上级是否应当注册（independent 模式下恒为 true）
+    bool isActive(size_t index) const;
+    bool isActive(const std::string& domain_id) const;
+
+    // 注册、心跳等事务的最终结果，作为健康度的补充信号。responded 表示收到了对端的
+    // 最终响应（任何响应码都说明对端存活，包括对端返回的 503）；超时、传输错误等
+    // 由 pjsip 本地生成的结果为 false
+    void onTransactionResult(const std::string& domain_id, bool responded);
+
+private:
+    explicit SipFailover(IDomainManager& domain_manager);
+
+    struct NodeHealth
+    {
+        std::string id;
+        std::atomic<int64_t> last_ok_ms { 0 };
+        std::atomic<int64_t> first_fail_ms { 0 };     // 0 表示自上次成功后没有失败
+        std::atomic<int64_t> healthy_since_ms { 0 };  // 0 表示当前不健康
+        std::atomic<bool> probing { false };
+    };
+
+    void tickProc();
+    void sendProbe(size_t index, const DomainInfo& domain);
+    static void onProbeResponse(void* token, pjsip_event* e);
+
+    void markResult(size_t index, bool ok);
+    bool isDown(size_t index, int64_t now) const;
+    void switchTo(size_t index, const char* reason);
+    int findNode(const std::string& domain_id) const;
+
+    static int64_t nowMs();
+
+    std::shared_ptr<TaskTimer> probe_timer_;
+    IDomainManager& domain_manager_;
+
+    bool active_standby_ { false };
+    std::unique_ptr<NodeHealth[]> nodes_;
+    size_t node_count_ { 0 };
+    std::atomic<size_t> active_ { 0 };
+
+    std::mutex switch_mutex_;
+
+    static std::shared_ptr<SipFailover> instance_;
+    static std::mutex instance_mutex_;
+};
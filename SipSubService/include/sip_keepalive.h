@@ -0,0 +1,79 @@
+// sip_keepalive.h
+// GB28181 心跳发送：时间轮调度，每个tick把所有到期的上级域合并成一批发送
+
+#pragma once
+
+#include "common.h"
+#include "co_task.h"
+#include "sip_types.h"
+#include "task_timer.h"
+#include "timing_wheel.h"
+#include "interfaces/idomain_manager.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class SipKeepalive : public std::enable_shared_from_this<SipKeepalive>
+{
+public:
+    // 单例工厂
+    static std::shared_ptr<SipKeepalive> getInstance(IDomainManager& domain_manager);
+
+    SipKeepalive(const SipKeepalive&) = delete;
+    SipKeepalive& operator=(const SipKeepalive&) = delete;
+    ~SipKeepalive();
+
+    void startKeepaliveService();
+
+    // 注册成功后加入时间轮，重复调用只会调度一次
+    void track(RegHandle handle);
+
+private:
+    explicit SipKeepalive(IDomainManager& domain_manager);
+
+    // 定时器每秒推进一格，收集到期的上级并批量发送
+    void tickProc();
+    pj_status_t sendKeepalive(const DomainInfo& domain, uint32_t sn);
+
+    // 发出心跳并挂起等待事务结束（200/超时/错误），在线程池中恢复后处理结果
+    static CoTask<void> keepaliveTransaction(std::weak_ptr<SipKeepalive> weak_this, RegHandle handle,
+                                             SipTypes::EndpointPtr endpt, pjsip_tx_data* tdata);
+    // received 表示响应来自对端（见 SipResponse::received）
+    void handleKeepaliveResult(RegHandle handle, int status_code, bool received);
+
+    // 移出时间轮：递增纪元，轮中残留的旧条目到期时被丢弃
+    void untrack(RegHandle handle);
+
+    // 句柄对应的域在域列表中的位置：先按缓存下标 O(1) 校验，未命中时查找一次并回填；
+    // 调用时须持有域列表的读锁
+    const DomainInfo* findDomain(const std::vector<DomainInfo>& domains, RegHandle handle);
+
+    // 时间轮条目：句柄 + 调度纪元
+    struct WheelEntry
+    {
+        RegHandle handle;
+        uint64_t epoch { 0 };
+    };
+
+    static constexpr unsigned int TICK_MS = 1000;
+
+    std::shared_ptr<TaskTimer> ka_timer_;
+    IDomainManager& domain_manager_;
+
+    std::mutex wheel_mutex_;
+    TimingWheel<WheelEntry> wheel_;
+
+    // 按槽位索引保存：已调度的代数、调度纪元、连续丢失次数
+    size_t slot_count_ { 0 };
+    std::unique_ptr<std::atomic<uint32_t>[]> tracked_gen_;
+    std::unique_ptr<std::atomic<uint64_t>[]> epoch_;
+    std::unique_ptr<std::atomic<uint32_t>[]> missed_;
+    std::unique_ptr<std::atomic<size_t>[]> domain_index_;   // 域列表下标缓存
+
+    std::atomic<uint32_t> sn_ { 1 };
+
+    static std::shared_ptr<SipKeepalive> instance_;
+    static std::mutex instance_mutex_;
+};
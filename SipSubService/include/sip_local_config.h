@@ -21,19 +21,39 @@ public:
     // 实现IConfigProvider接口
     bool readConf() override;
     const std::string& getLocalIp() const override { return local_ip_; }
+    const std::string& getAdminIp() const override { return admin_ip_; }
+    int getLocalPort() const override { return local_port_; }
     const std::string& getSipId() const override { return sip_id_; }
     const std::string& getSipIp() const override { return sip_ip_; }
     int getSipPort() const override { return sip_port_; }
     const std::string& getNodeRealm() const override { return node_realm_; }
     const std::vector<NodeInfo>& getNodeInfoList() const override { return node_info_list_; }
+    int getKeepaliveInterval() const override { return keepalive_interval_; }
+    int getKeepaliveMaxMissed() const override { return keepalive_max_missed_; }
+    int getTcpIdleTimeout() const override { return tcp_idle_timeout_; }
+    bool getActiveStandby() const override { return active_standby_; }
+    int getFailoverDetectMs() const override { return failover_detect_ms_; }
+    int getProbeIntervalMs() const override { return probe_interval_ms_; }
+    int getFailbackHoldSec() const override { return failback_hold_sec_; }
+    const ThreadPlacementConfig& getThreadPlacement() const override { return thread_placement_; }
+    const PoolAutoscalerOptions& getPoolAutoscale() const override { return pool_autoscale_; }
+    const LogRateLimitOptions& getLogRateLimit() const override { return log_rate_limit_; }
+    const PoolStatsOptions& getPoolStats() const override { return pool_stats_; }
     
     // 非const版本用于内部修改
     std::vector<NodeInfo>& getNodeInfoList() { return node_info_list_; }
     
 private:
+    bool readThreadPlacement();
+    bool readPoolAutoscale();
+    void readLogRateLimit();
+    void readPoolStats();
+
     ConfReader conf_reader_;
 
     std::string local_ip_;
+    std::string admin_ip_{ "127.0.0.1" };
+    int local_port_{ 0 };
     std::string sip_id_;
     std::string sip_ip_;
     int sip_port_{ 0 }; 
@@ -42,6 +62,20 @@ private:
 
     int supnode_num_{ 0 };
 
+    int keepalive_interval_{ 60 };
+    int keepalive_max_missed_{ 3 };
+    int tcp_idle_timeout_{ 300 };
+
+    bool active_standby_{ false };
+    int failover_detect_ms_{ 3000 };
+    int probe_interval_ms_{ 1000 };
+    int failback_hold_sec_{ 30 };
+
+    ThreadPlacementConfig thread_placement_;
+    PoolAutoscalerOptions pool_autoscale_;
+    LogRateLimitOptions log_rate_limit_;
+    PoolStatsOptions pool_stats_;
+
     std::mutex node_mutex_;
 
     std::vector<NodeInfo> node_info_list_;
@@ -8,9 +8,12 @@
 #include "interfaces/idomain_manager.h"
 #include "sip_msg.h"
 
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <atomic>
+#include <string>
+#include <unordered_map>
 
 
 
@@ -29,15 +32,26 @@ public:
 
     void startRegService() override;
     bool extractAuthInfo(pjsip_rx_data* rdata, const std::string& domain_id);
+    // 立即执行一次注册检查（主备切换后调用，不等待定时器）
+    void registerNow();
+    // 注销并销毁该域的 regc，停止其自动刷新（主备切换时用于原活动上级）。
+    // 两者都投递到注册定时器所在的事件循环线程执行，返回时尚未完成
+    void unregisterNow(const std::string& domain_id);
 
 private:
     explicit SipRegister(IDomainManager& domain_manager);
 
     void registerProc();
-    pj_status_t gbRegister(DomainInfo& domains);
+    pj_status_t gbRegister(const DomainInfo& domains);
+    // 销毁该域上一次注册使用的 regc，unregister 为真时先发送注销（调用时须持有 register_mutex_）
+    void releaseRegc(const std::string& domain_id, bool unregister = false);
+    // 在注册定时器的线程上执行一次 task
+    void runOnRegisterThread(std::function<void(SipRegister&)> task);
 
     std::shared_ptr<TaskTimer> reg_timer_;
     std::mutex register_mutex_;
+    // 每个上级域当前的 regc：注册成功后由它自动刷新，重新注册前销毁，受 register_mutex_ 保护
+    std::unordered_map<std::string, pjsip_regc*> regcs_;
     IDomainManager& domain_manager_;
 
     // 单例相关
@@ -0,0 +1,96 @@
+// sip_transaction.h
+// 协程式的 SIP 客户端事务：
+//     SipResponse resp = co_await SipTransaction::send(endpt, tdata, options);
+// 基于 pjsip_endpt_send_request 发出请求后挂起当前协程，收到最终响应、事务超时
+// 或取消令牌触发时，在线程池中恢复协程并返回结果。挂起期间只占用协程帧和一条
+// 待决记录，不阻塞任何线程，原先 token + 静态回调的写法可以改成顺序代码。
+
+#pragma once
+
+#include "common.h"
+#include "co_task.h"
+#include "ev_task.h"
+#include "sip_types.h"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+struct SipRequestOptions
+{
+    int timeout_ms { -1 };                        // 事务超时，-1 使用 pjsip 默认（64*T1）
+    CancellationToken token;                      // 取消后立即恢复，迟到的响应被忽略
+    bool keep_message { false };                  // 保留最终响应报文（需要读取响应头时）
+    TrafficClass resume_class { TrafficClass::CONTROL };  // 恢复协程时使用的流量类别
+};
+
+struct SipResponse
+{
+    pj_status_t status { PJ_SUCCESS };   // 发送失败或取消时的错误码
+    int status_code { 0 };               // 最终响应码：超时 408，传输错误 503，取消 487
+    std::string reason;
+    bool cancelled { false };
+    bool received { false };             // 最终响应来自对端（否则为本地生成的超时/传输错误）
+    SipTypes::RxDataPtr rdata;           // keep_message 时为最终响应的副本
+
+    bool ok() const { return status_code >= 200 && status_code < 300; }
+};
+
+class SipTransaction
+{
+    struct Pending;
+
+public:
+    class Awaiter
+    {
+    public:
+        Awaiter(SipTypes::EndpointPtr endpt, pjsip_tx_data* tdata, SipRequestOptions options)
+            : endpt_(std::move(endpt)), tdata_(tdata), options_(std::move(options))
+        {
+        }
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        SipResponse await_resume();
+
+    private:
+        SipTypes::EndpointPtr endpt_;
+        pjsip_tx_data* tdata_;
+        SipRequestOptions options_;
+        std::shared_ptr<Pending> pending_;
+    };
+
+    // 发送请求（tdata 的所有权交给 pjsip，失败时由 pjsip 释放）
+    static Awaiter send(SipTypes::EndpointPtr endpt, pjsip_tx_data* tdata, SipRequestOptions options = {})
+    {
+        return Awaiter(std::move(endpt), tdata, std::move(options));
+    }
+
+    // 当前挂起等待响应的事务数
+    static size_t inFlight();
+
+private:
+    // 待决记录：completed 决定由谁（响应回调/取消/同步失败）恢复协程
+    struct Pending
+    {
+        uint64_t id { 0 };
+        std::coroutine_handle<> handle;
+        std::atomic<bool> completed { false };
+        SipResponse response;
+        bool keep_message { false };
+        TrafficClass resume_class { TrafficClass::CONTROL };
+        std::atomic<uint64_t> cancel_id { 0 };
+    };
+
+    static void onTsxComplete(void* token, pjsip_event* e);
+    static bool complete(const std::shared_ptr<Pending>& pending, SipResponse&& response, bool schedule);
+    static void resume(const std::shared_ptr<Pending>& pending);
+
+    // 待决表：pjsip 回调的 token 是记录 id，回调与取消/同步失败各自摘除，不会重复释放
+    struct Table;
+    static Table& table();
+    static uint64_t add(const std::shared_ptr<Pending>& pending);
+    static std::shared_ptr<Pending> take(uint64_t id);
+};
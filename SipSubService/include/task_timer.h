@@ -1,57 +1,194 @@
-// task_timer.h
+// task_timer.h - 分层时间轮定时器
+//
+// 4 层、每层 256 槽的分层时间轮（默认 1ms 一格，覆盖约 49 天）。定时器节点保存在
+// 按下标寻址的节点池中，每个槽位是侵入式双向链表，插入、取消、重新调度都是 O(1)；
+// 高层槽位在低层转完一圈时整体下沉（cascade），每个节点最多下沉 3 次。
+// 句柄由节点下标 + 代数组成，节点复用后旧句柄自动失效。
+//
+// 定时器线程只负责推进时间轮和派发：到期任务投递到执行器（默认 EVThread 的线程池）
+// 运行；周期任务在上一次执行尚未结束时跳过本次，不会重叠执行。
+// 空闲时只在下一个非空槽位或本圈结束时醒来，没有定时器时一直休眠到有新的调度。
+//
+// 另有 PJSIP 端点后端（setEndpoint）：定时器通过 pjsip_endpt_schedule_timer 挂在端点的
+// 定时器堆上，回调直接在事件循环线程执行，不需要额外线程，也没有跨线程投递。
+// 只适合会调用 PJSIP 的短小信令任务（注册、刷新等），不涉及 PJSIP 的工作仍使用线程后端。
 #pragma once
 #include "common.h"
+#include "sip_types.h"
+#include "service_thread.h"
+#include "task_telemetry.h"
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 #include <condition_variable>
-#include <future>
+#include <string>
+
+class ThreadPool;
+
+// 定时器句柄，默认构造的句柄无效
+struct TimerHandle
+{
+    uint32_t index { UINT32_MAX };
+    uint32_t generation { 0 };
+
+    bool valid() const { return index != UINT32_MAX; }
+};
+
+struct TaskTimerStats
+{
+    std::string name;
+    bool endpoint { false };           // 是否使用 PJSIP 端点后端
+    size_t pending { 0 };              // 时间轮中的定时器数
+    uint64_t scheduled { 0 };
+    uint64_t fired { 0 };              // 已派发到执行器的次数
+    uint64_t cancelled { 0 };
+    uint64_t skipped { 0 };            // 周期任务因上一次仍在执行而跳过的次数
+    LatencyHistogram dispatch_lag;     // 派发时刻相对到期时刻的延迟
+};
 
 class TaskTimer : public std::enable_shared_from_this<TaskTimer> {
 public:
     using Task = std::function<void()>;
-    
-    TaskTimer();
+    using Duration = std::chrono::milliseconds;
+
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOTS = 256;
+
+    // executor 为空时使用 EVThread::getThreadPool()
+    explicit TaskTimer(std::string name = "task-timer", ThreadPool* executor = nullptr);
     ~TaskTimer();
-    
+
     // 禁用拷贝和移动
     TaskTimer(const TaskTimer&) = delete;
     TaskTimer& operator=(const TaskTimer&) = delete;
     TaskTimer(TaskTimer&&) = delete;
     TaskTimer& operator=(TaskTimer&&) = delete;
-    
+
     // 启动定时器线程
     bool start();
-    // 安全停止定时器线程
+    // 安全停止定时器线程，并清空所有定时器
     void stop();
-    
-    // 添加任务
+
+    // delay 之后执行一次
+    TimerHandle scheduleOnce(Duration delay, Task task);
+    // 每隔 period 执行一次，首次在 first_delay 之后（负值表示等于 period）；按固定速率排期，不累积漂移
+    TimerHandle scheduleEvery(Duration period, Task task, Duration first_delay = Duration(-1));
+    // 取消定时器；已派发正在执行的那一次不受影响。句柄已失效时返回 false
+    bool cancel(TimerHandle handle);
+    // 把定时器的下一次到期改为 delay 之后，周期不变
+    bool reschedule(TimerHandle handle, Duration delay);
+
+    // 兼容旧接口：按 setInterval 设置的间隔周期执行，启动后立即执行第一次
     void addTask(Task task);
-    // 设置时间间隔
+    // 设置 addTask 使用的时间间隔
     void setInterval(unsigned int ms);
-    
+    // 时间轮一格的长度，只能在调度任何定时器之前设置
+    void setResolution(unsigned int ms);
+    // 改用 PJSIP 端点的定时器堆，须在调度任何定时器之前调用；此后 start() 不再创建线程。
+    // 该后端要求 TaskTimer 由 shared_ptr 持有（回调通过 weak_ptr 找回定时器）。
+    // wake 在其他线程挂上定时器之后调用，用于唤醒阻塞中的事件循环（通常为 ISipCore::wakeup）
+    bool setEndpoint(SipTypes::EndpointPtr endpt, Task wake = nullptr);
+    bool usesEndpoint() const { return endpt_ != nullptr; }
+    // 派发到执行器时使用的流量类别
+    void setTrafficClass(TrafficClass cls) { traffic_class_ = cls; }
+
     // 获取当前状态
     bool isRunning() const { return running_; }
+    size_t pending() const;
+    TaskTimerStats stats() const;
+    // 进程内所有定时器的统计（按创建顺序）
+    static std::vector<TaskTimerStats> allStats();
 
 private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    // 到期后派发的任务，周期定时器每次派发共享同一个 Job
+    struct Job
+    {
+        Task task;
+        std::atomic<bool> running { false };
+    };
+
+    // 端点后端的定时器项：pj_timer_entry 必须是第一个成员。
+    // 取消时若回调已在途，由回调发现代数不符后释放
+    struct EndpointTimer
+    {
+        pj_timer_entry entry;
+        std::weak_ptr<TaskTimer> owner;
+        uint32_t index { 0 };
+        uint32_t generation { 0 };
+        uint64_t due_ns { 0 };
+    };
+
+    struct Node
+    {
+        uint64_t expire_tick { 0 };
+        uint64_t period_ticks { 0 };     // 0 表示一次性
+        std::shared_ptr<Job> job;
+        uint32_t generation { 0 };
+        uint32_t prev { NIL };
+        uint32_t next { NIL };
+        uint32_t slot { NIL };           // level * SLOTS + 槽位下标，NIL 表示不在轮中
+        EndpointTimer* entry { nullptr }; // 端点后端：挂在 PJSIP 定时器堆上的项
+    };
+
+    struct Due
+    {
+        std::shared_ptr<Job> job;
+        uint64_t expire_tick;
+    };
+
     // 定时器线程主循环
     void timerLoop();
-    
-    std::vector<Task> tasks_;
-    std::mutex task_mutex_;          // 保护任务列表
+
+    // 以下函数调用时须持有 wheel_mutex_
+    uint32_t allocNode();
+    void freeNode(uint32_t index);
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    void cascade(size_t level, size_t slot);
+    void advanceOne(std::vector<Due>& due, uint64_t now_ns);
+    uint64_t nextWakeTick() const;
+    uint64_t elapsedNs() const;
+    uint64_t dueTick(Duration delay) const;
+    uint64_t periodTicks(Duration period) const;
+    TimerHandle insert(Duration delay, uint64_t period_ticks, Task task);
+
+    void dispatch(Due& due);
+    // 端点后端：调度/撤下定时器项（持有 wheel_mutex_ 调用）
+    bool scheduleEntry(uint32_t index, uint64_t delay_ms);
+    void releaseEntry(uint32_t index);
+    static void onEndpointTimer(pj_timer_heap_t* heap, pj_timer_entry* entry);
+    static void runJob(const std::shared_ptr<Job>& job);
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_nodes_;
+    std::vector<uint32_t> heads_;        // LEVELS * SLOTS 个链表头
+    uint64_t now_tick_ { 0 };            // 已处理到的格
+    uint64_t wake_tick_ { UINT64_MAX };  // 定时器线程计划醒来的格
+    size_t size_ { 0 };
+    TaskTimerStats stats_;
+    mutable std::mutex wheel_mutex_;     // 保护时间轮与统计
+
+    std::chrono::steady_clock::time_point epoch_;
+    unsigned int resolution_ms_ { 1 };
+    ThreadPool* executor_;
+    SipTypes::EndpointPtr endpt_;
+    Task endpt_wake_;
+    TrafficClass traffic_class_ { TrafficClass::CONTROL };
+
     std::mutex thread_mutex_;        // 保护线程状态
     std::condition_variable cv_;
     std::atomic<bool> running_{false};
     std::atomic<bool> stop_requested_{false};
     unsigned int interval_ms_{3000}; // 默认3秒
-    
-    // 线程ID存储
-    std::shared_ptr<std::atomic<std::thread::id>> timer_thread_id_;
-    
-    // 保存future以便管理线程生命周期
-    std::shared_ptr<std::future<void>> timer_future_;
-};
\ No newline at end of file
+
+    // 独立的定时器线程，不占用请求处理线程池
+    std::string name_;
+    std::unique_ptr<ServiceThread> thread_;
+};
@@ -0,0 +1,87 @@
+// tcp_conn_manager.h
+// 按对端复用长连接 TCP 传输：每个对端只保持一条被引用的 pjsip_transport，
+// REGISTER / MESSAGE / INVITE 等请求通过 tpselector 绑定到同一连接，
+// 避免重复握手与 TIME_WAIT；空闲超时且没有其他引用（regc、在途请求）的连接由定时器回收。
+
+#pragma once
+
+#include "common.h"
+#include "task_timer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class TcpConnManager : public std::enable_shared_from_this<TcpConnManager>
+{
+public:
+    // 连接计数指标
+    struct Metrics
+    {
+        size_t active { 0 };      // 当前持有的连接数
+        uint64_t created { 0 };   // 新建连接次数
+        uint64_t reused { 0 };    // 复用已有连接次数
+        uint64_t adopted { 0 };   // 接管的对端主动连接数
+        uint64_t reaped { 0 };    // 空闲回收次数
+        uint64_t closed { 0 };    // 对端断开或出错次数
+        uint64_t failed { 0 };    // 建立连接失败次数
+    };
+
+    // 单例工厂
+    static std::shared_ptr<TcpConnManager> getInstance();
+
+    TcpConnManager(const TcpConnManager&) = delete;
+    TcpConnManager& operator=(const TcpConnManager&) = delete;
+    ~TcpConnManager();
+
+    // 启动空闲回收定时器
+    void startReaper(unsigned int idle_timeout_sec);
+
+    // 获取到对端的连接（不存在则建立），返回的传输由管理器持有引用，调用方不要 dec_ref
+    pjsip_transport* acquire(const std::string& peer_id, const std::string& ip, int port);
+
+    // 接管对端主动建立的连接（如下级通过 TCP 注册），供之后向该对端发请求时复用
+    void adopt(const std::string& peer_id, pjsip_transport* tp);
+
+    // 把请求绑定到对端连接；失败时不修改请求，由 pjsip 按请求 URI 自行选择传输
+    pj_status_t bindTxData(pjsip_tx_data* tdata, const std::string& peer_id, const std::string& ip, int port);
+    pj_status_t bindRegc(pjsip_regc* regc, const std::string& peer_id, const std::string& ip, int port);
+
+    Metrics metrics() const;
+
+private:
+    TcpConnManager();
+
+    struct Conn
+    {
+        pjsip_transport* tp { nullptr };
+        pjsip_tp_state_listener_key* listener { nullptr };
+        int64_t last_used_ms { 0 };
+    };
+
+    void reapIdle();
+    // 移除监听器并释放引用；会取传输锁，调用时不能持有 conn_mutex_
+    void release(const std::string& peer_id, Conn& conn);
+    static void onTransportState(pjsip_transport* tp, pjsip_transport_state state,
+                                 const pjsip_transport_state_info* info);
+    static int64_t nowMs();
+
+    std::shared_ptr<TaskTimer> reap_timer_;
+    std::atomic<int64_t> idle_timeout_ms_ { 300000 };
+
+    mutable std::mutex conn_mutex_;
+    std::unordered_map<std::string, Conn> conns_;
+
+    std::atomic<uint64_t> created_ { 0 };
+    std::atomic<uint64_t> reused_ { 0 };
+    std::atomic<uint64_t> adopted_ { 0 };
+    std::atomic<uint64_t> reaped_ { 0 };
+    std::atomic<uint64_t> closed_ { 0 };
+    std::atomic<uint64_t> failed_ { 0 };
+
+    static std::shared_ptr<TcpConnManager> instance_;
+    static std::mutex instance_mutex_;
+};
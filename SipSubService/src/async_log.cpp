@@ -0,0 +1,717 @@
+// async_log.cpp
+#include "async_log.h"
+#include "service_thread.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+    constexpr size_t LINE_CAPACITY = 8192;           // 单行上限，超出部分截断
+    constexpr size_t MIN_THREAD_BUFFER = 64u << 10;
+    constexpr size_t BATCH_BYTES = 64u << 10;        // 攒够该大小即写一次文件
+    // 线程缓冲区满时等待后台线程腾出空间的上限，超时后丢弃该行
+    constexpr int FULL_WAIT_US = 1000;
+    constexpr int FULL_WAIT_WARNING_US = 10000;      // WARNING 及以上
+
+    const char SEVERITY_CHAR[] = { 'D', 'I', 'W', 'E' };
+
+    struct RecordHeader
+    {
+        uint32_t len;
+        uint32_t level;
+    };
+
+    // 单生产者（所属线程）/单消费者（log-writer）字节环形缓冲区，记录为 RecordHeader + 行内容，
+    // 回绕处分两段拷贝
+    class LineRing
+    {
+    public:
+        explicit LineRing(size_t capacity)
+            : capacity_(capacity), mask_(capacity - 1), data_(new char[capacity]) {}
+
+        bool push(int level, const char* line, size_t len)
+        {
+            size_t need = sizeof(RecordHeader) + len;
+            uint64_t tail = tail_.load(std::memory_order_relaxed);
+            uint64_t head = head_.load(std::memory_order_acquire);
+            if (need > capacity_ - (tail - head))
+            {
+                return false;
+            }
+            RecordHeader header{ static_cast<uint32_t>(len), static_cast<uint32_t>(level) };
+            copyIn(tail, reinterpret_cast<const char*>(&header), sizeof(header));
+            copyIn(tail + sizeof(header), line, len);
+            tail_.store(tail + need, std::memory_order_release);
+            return true;
+        }
+
+        // 已用字节超过一半，提示后台线程尽快取走
+        bool pressured() const
+        {
+            return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed) > capacity_ / 2;
+        }
+
+        bool empty() const
+        {
+            return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_relaxed);
+        }
+
+        // 取出全部记录，追加到 out；stderr_level 及以上的同时追加到 err。返回取出的行数
+        uint64_t drain(std::string& out, std::string& err, int stderr_level)
+        {
+            uint64_t head = head_.load(std::memory_order_relaxed);
+            uint64_t tail = tail_.load(std::memory_order_acquire);
+            uint64_t lines = 0;
+            while (head < tail)
+            {
+                RecordHeader header;
+                copyOut(head, reinterpret_cast<char*>(&header), sizeof(header));
+                head += sizeof(header);
+                size_t offset = out.size();
+                out.resize(offset + header.len);
+                copyOut(head, &out[offset], header.len);
+                head += header.len;
+                if (static_cast<int>(header.level) >= stderr_level)
+                {
+                    err.append(out, offset, header.len);
+                }
+                ++lines;
+            }
+            head_.store(head, std::memory_order_release);
+            return lines;
+        }
+
+    private:
+        void copyIn(uint64_t pos, const char* src, size_t len)
+        {
+            size_t offset = pos & mask_;
+            size_t first = std::min(len, capacity_ - offset);
+            std::memcpy(data_.get() + offset, src, first);
+            std::memcpy(data_.get(), src + first, len - first);
+        }
+
+        void copyOut(uint64_t pos, char* dst, size_t len) const
+        {
+            size_t offset = pos & mask_;
+            size_t first = std::min(len, capacity_ - offset);
+            std::memcpy(dst, data_.get() + offset, first);
+            std::memcpy(dst + first, data_.get(), len - first);
+        }
+
+        const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<char[]> data_;
+        alignas(64) std::atomic<uint64_t> head_{ 0 };
+        alignas(64) std::atomic<uint64_t> tail_{ 0 };
+    };
+
+    struct ThreadBuffer
+    {
+        explicit ThreadBuffer(size_t capacity) : ring(capacity) {}
+        LineRing ring;
+        std::atomic<bool> orphaned{ false };   // 所属线程已退出，取空后由后台线程移除
+    };
+
+    // 线程退出时标记缓冲区，剩余内容仍由后台线程写出
+    thread_local bool t_slot_released = false;
+
+    struct ThreadBufferSlot
+    {
+        std::shared_ptr<ThreadBuffer> buffer;
+        ~ThreadBufferSlot()
+        {
+            if (buffer) buffer->orphaned.store(true, std::memory_order_release);
+            t_slot_released = true;
+        }
+    };
+
+    thread_local ThreadBufferSlot t_slot;
+
+    size_t roundUpPow2(size_t value)
+    {
+        size_t result = MIN_THREAD_BUFFER;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    bool writeAll(int fd, const char* data, size_t len)
+    {
+        while (len > 0)
+        {
+            ssize_t n = ::write(fd, data, len);
+            if (n < 0)
+            {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // 后台线程未运行时的同步输出
+    std::mutex sync_mutex;
+
+    void writeSync(const char* line, size_t len)
+    {
+        std::lock_guard<std::mutex> lock(sync_mutex);
+        writeAll(STDERR_FILENO, line, len);
+    }
+
+    char* appendUInt(char* p, uint64_t value, int width)
+    {
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (n < width) digits[n++] = '0';
+        while (n > 0) *p++ = digits[--n];
+        return p;
+    }
+}
+
+class AsyncLog::Impl
+{
+public:
+    bool start(const AsyncLogOptions& options);
+    void stop();
+    bool flush(int timeout_ms);
+    AsyncLogStats stats() const;
+    void submit(int level, const char* line, size_t len);
+    void addHousekeeping(std::function<void()> fn);
+
+    static std::atomic<Impl*> active_;
+
+private:
+    ThreadBuffer* localBuffer();
+    void run(ServiceThread& self);
+    bool drainAll();
+    void writeBatch();
+    bool openFile();
+    void rotate();
+    void wake();
+    void signal();
+
+    AsyncLogOptions options_;
+    std::string path_;
+    int fd_{ -1 };
+    size_t file_bytes_{ 0 };
+    std::unique_ptr<ServiceThread> writer_;
+    std::mutex state_mutex_;
+
+    std::mutex housekeeping_mutex_;
+    std::vector<std::function<void()>> housekeeping_;
+
+    mutable std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+    // 后台线程私有
+    std::string batch_;
+    std::string stderr_batch_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    bool wake_pending_{ false };
+    std::atomic<bool> signalled_{ false };
+    uint64_t flush_requested_{ 0 };
+    uint64_t flush_done_{ 0 };
+    std::condition_variable flush_cv_;
+
+    std::atomic<uint64_t> written_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+    std::atomic<uint64_t> bytes_{ 0 };
+    std::atomic<uint64_t> rotations_{ 0 };
+};
+
+std::atomic<AsyncLog::Impl*> AsyncLog::Impl::active_{ nullptr };
+
+bool AsyncLog::Impl::start(const AsyncLogOptions& options)
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (writer_)
+    {
+        return true;
+    }
+    options_ = options;
+    options_.thread_buffer_bytes = roundUpPow2(options.thread_buffer_bytes);
+    options_.keep_files = std::max<size_t>(1, options.keep_files);
+    options_.flush_ms = std::max(1, options.flush_ms);
+
+    std::error_code ec;
+    std::filesystem::create_directories(options_.dir, ec);
+    path_ = (std::filesystem::path(options_.dir) / options_.name).string();
+    if (!openFile())
+    {
+        return false;
+    }
+
+    writer_ = std::make_unique<ServiceThread>(ServiceThreadOptions{ "log-writer" },
+        [this](ServiceThread& self) { run(self); });
+    writer_->setWakeup([this] { wake(); });
+    active_.store(this, std::memory_order_release);
+    if (!writer_->start())
+    {
+        active_.store(nullptr, std::memory_order_release);
+        writer_.reset();
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+void AsyncLog::Impl::stop()
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (!writer_)
+    {
+        return;
+    }
+    writer_->stop();
+    // 之后的日志同步写到 stderr；后台线程退出前提交的内容在这里补写
+    active_.store(nullptr, std::memory_order_release);
+    writer_.reset();
+    drainAll();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+bool AsyncLog::Impl::flush(int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    if (active_.load(std::memory_order_acquire) != this)
+    {
+        return true;
+    }
+    uint64_t target = ++flush_requested_;
+    wake_pending_ = true;
+    wake_cv_.notify_one();
+    return flush_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+        [this, target] { return flush_done_ >= target; });
+}
+
+AsyncLogStats AsyncLog::Impl::stats() const
+{
+    AsyncLogStats stats;
+    stats.written = written_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.rotations = rotations_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    stats.threads = buffers_.size();
+    return stats;
+}
+
+void AsyncLog::Impl::addHousekeeping(std::function<void()> fn)
+{
+    std::lock_guard<std::mutex> lock(housekeeping_mutex_);
+    housekeeping_.push_back(std::move(fn));
+}
+
+ThreadBuffer* AsyncLog::Impl::localBuffer()
+{
+    // 其他线程局部对象析构时写的日志
+    if (t_slot_released)
+    {
+        return nullptr;
+    }
+    if (!t_slot.buffer)
+    {
+        t_slot.buffer = std::make_shared<ThreadBuffer>(options_.thread_buffer_bytes);
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers_.push_back(t_slot.buffer);
+    }
+    return t_slot.buffer.get();
+}
+
+void AsyncLog::Impl::submit(int level, const char* line, size_t len)
+{
+    ThreadBuffer* buffer = localBuffer();
+    if (!buffer)
+    {
+        writeSync(line, len);
+        return;
+    }
+    if (buffer->ring.push(level, line, len))
+    {
+        if (level >= SIP_LOG_LEVEL_WARNING || buffer->ring.pressured())
+        {
+            signal();
+        }
+        return;
+    }
+    // 缓冲区满：让出 CPU 给后台线程（单核时它可能一直没有机会运行），超时仍满则丢弃
+    int max_wait_us = level >= SIP_LOG_LEVEL_WARNING ? FULL_WAIT_WARNING_US : FULL_WAIT_US;
+    for (int waited = 0; waited < max_wait_us; waited += 50)
+    {
+        signal();
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        if (buffer->ring.push(level, line, len))
+        {
+            return;
+        }
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncLog::Impl::signal()
+{
+    // 后台线程取走通知前不再重复加锁
+    if (!signalled_.exchange(true, std::memory_order_acq_rel))
+    {
+        wake();
+    }
+}
+
+void AsyncLog::Impl::wake()
+{
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_pending_ = true;
+    }
+    wake_cv_.notify_one();
+}
+
+void AsyncLog::Impl::run(ServiceThread& self)
+{
+    while (!self.stopRequested())
+    {
+        uint64_t flush_target;
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            wake_pending_ = false;
+            flush_target = flush_requested_;
+        }
+        signalled_.store(false, std::memory_order_release);
+        drainAll();
+        {
+            std::lock_guard<std::mutex> lock(housekeeping_mutex_);
+            for (const auto& fn : housekeeping_) fn();
+        }
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            if (flush_target > flush_done_)
+            {
+                flush_done_ = flush_target;
+                flush_cv_.notify_all();
+            }
+            wake_cv_.wait_for(lock, std::chrono::milliseconds(options_.flush_ms),
+                [this, &self] { return wake_pending_ || self.stopRequested(); });
+        }
+    }
+    drainAll();
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    flush_done_ = flush_requested_;
+    flush_cv_.notify_all();
+}
+
+bool AsyncLog::Impl::drainAll()
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers = buffers_;
+    }
+
+    uint64_t lines = 0;
+    bool has_orphans = false;
+    for (const auto& buffer : buffers)
+    {
+        // 先读标记再取数据，保证移除时缓冲区已空
+        bool orphaned = buffer->orphaned.load(std::memory_order_acquire);
+        lines += buffer->ring.drain(batch_, stderr_batch_, options_.stderr_level);
+        has_orphans = has_orphans || orphaned;
+        if (batch_.size() >= BATCH_BYTES)
+        {
+            writeBatch();
+        }
+    }
+    writeBatch();
+    written_.fetch_add(lines, std::memory_order_relaxed);
+
+    if (has_orphans)
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(), [](const std::shared_ptr<ThreadBuffer>& buffer) {
+            return buffer->orphaned.load(std::memory_order_acquire) && buffer->ring.empty();
+        }), buffers_.end());
+    }
+    return lines > 0;
+}
+
+void AsyncLog::Impl::writeBatch()
+{
+    if (!stderr_batch_.empty())
+    {
+        writeAll(STDERR_FILENO, stderr_batch_.data(), stderr_batch_.size());
+        stderr_batch_.clear();
+    }
+    if (batch_.empty())
+    {
+        return;
+    }
+    if (fd_ >= 0 && !writeAll(fd_, batch_.data(), batch_.size()))
+    {
+        std::string error = "AsyncLog: write " + path_ + " failed: " + std::strerror(errno) + "\n";
+        writeAll(STDERR_FILENO, error.data(), error.size());
+    }
+    bytes_.fetch_add(batch_.size(), std::memory_order_relaxed);
+    file_bytes_ += batch_.size();
+    batch_.clear();
+    if (file_bytes_ >= options_.max_file_bytes)
+    {
+        rotate();
+    }
+}
+
+bool AsyncLog::Impl::openFile()
+{
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        std::string error = "AsyncLog: open " + path_ + " failed: " + std::strerror(errno) + "\n";
+        writeAll(STDERR_FILENO, error.data(), error.size());
+        return false;
+    }
+    struct stat st;
+    file_bytes_ = ::fstat(fd_, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+    return true;
+}
+
+// name.log → name.log.1 → ... → name.log.<keep_files>，最旧的被覆盖
+void AsyncLog::Impl::rotate()
+{
+    ::close(fd_);
+    fd_ = -1;
+    for (size_t i = options_.keep_files; i > 1; --i)
+    {
+        std::string from = path_ + "." + std::to_string(i - 1);
+        std::string to = path_ + "." + std::to_string(i);
+        ::rename(from.c_str(), to.c_str());
+    }
+    ::rename(path_.c_str(), (path_ + ".1").c_str());
+    rotations_.fetch_add(1, std::memory_order_relaxed);
+    openFile();
+}
+
+std::atomic<int> AsyncLog::level_{ SIP_LOG_MIN_LEVEL };
+std::shared_ptr<AsyncLog> AsyncLog::instance_ = nullptr;
+std::mutex AsyncLog::instance_mutex_;
+
+std::shared_ptr<AsyncLog> AsyncLog::getInstance()
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+        instance_ = std::shared_ptr<AsyncLog>(new AsyncLog());
+    return instance_;
+}
+
+AsyncLog::AsyncLog()
+    : impl_(std::make_unique<Impl>())
+{
+}
+
+AsyncLog::~AsyncLog()
+{
+    impl_->stop();
+}
+
+bool AsyncLog::start(const AsyncLogOptions& options)
+{
+    return impl_->start(options);
+}
+
+void AsyncLog::stop()
+{
+    impl_->stop();
+}
+
+bool AsyncLog::flush(int timeout_ms)
+{
+    return impl_->flush(timeout_ms);
+}
+
+AsyncLogStats AsyncLog::stats() const
+{
+    return impl_->stats();
+}
+
+void AsyncLog::addHousekeeping(std::function<void()> fn)
+{
+    impl_->addHousekeeping(std::move(fn));
+}
+
+void AsyncLog::submit(int level, const char* line, size_t len)
+{
+    Impl* impl = Impl::active_.load(std::memory_order_acquire);
+    if (impl)
+        impl->submit(level, line, len);
+    else
+        writeSync(line, len);
+}
+
+// 定长行缓冲区，写满后丢弃多余字符，保留一字节放换行
+class AsyncLogMessage::LineBuffer : public std::streambuf
+{
+public:
+    LineBuffer() : stream_(this)
+    {
+        setp(data_, data_ + LINE_CAPACITY - 1);
+    }
+
+    std::ostream& begin()
+    {
+        setp(data_, data_ + LINE_CAPACITY - 1);
+        // 线程局部复用的流，清除上一条日志留下的格式状态
+        stream_.clear();
+        stream_.flags(std::ios_base::dec | std::ios_base::skipws);
+        stream_.precision(6);
+        stream_.width(0);
+        stream_.fill(' ');
+        return stream_;
+    }
+
+    void append(const char* data, size_t len) { sputn(data, static_cast<std::streamsize>(len)); }
+    char* cursor() { return pptr(); }
+    void advance(char* to) { pbump(static_cast<int>(to - pptr())); }
+    size_t room() const { return static_cast<size_t>(epptr() - pptr()); }
+
+    // 补上换行并返回整行
+    const char* finish(size_t& len)
+    {
+        char* end = pptr();
+        if (end > data_ && end[-1] == '\n') --end;
+        *end++ = '\n';
+        len = static_cast<size_t>(end - data_);
+        return data_;
+    }
+
+    bool in_use{ false };
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        return traits_type::not_eof(ch);
+    }
+
+private:
+    char data_[LINE_CAPACITY];
+    std::ostream stream_;
+};
+
+namespace {
+    thread_local AsyncLogMessage::LineBuffer* t_line = nullptr;
+    thread_local bool t_line_released = false;
+    thread_local time_t t_prefix_sec = -1;
+    thread_local char t_prefix_time[18];      // "YYYYMMDD HH:MM:SS"
+    thread_local char t_tid[16];
+    thread_local size_t t_tid_len = 0;
+
+    // 线程首次写日志时分配，线程退出时释放
+    struct LineBufferOwner
+    {
+        std::unique_ptr<AsyncLogMessage::LineBuffer> buffer;
+        ~LineBufferOwner()
+        {
+            t_line = nullptr;
+            t_line_released = true;
+        }
+    };
+    thread_local LineBufferOwner t_line_owner;
+
+    // glog 格式前缀："I20261019 03:19:20.123456 12345 file.cpp:123] "
+    void writePrefix(AsyncLogMessage::LineBuffer& buffer, int level, const char* file, int line)
+    {
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        if (tv.tv_sec != t_prefix_sec)
+        {
+            struct tm tm_time;
+            localtime_r(&tv.tv_sec, &tm_time);
+            std::strftime(t_prefix_time, sizeof(t_prefix_time), "%Y%m%d %H:%M:%S", &tm_time);
+            t_prefix_sec = tv.tv_sec;
+        }
+        if (t_tid_len == 0)
+        {
+            char* end = appendUInt(t_tid, static_cast<uint64_t>(::syscall(SYS_gettid)), 0);
+            t_tid_len = static_cast<size_t>(end - t_tid);
+        }
+        const char* base = std::strrchr(file, '/');
+        base = base ? base + 1 : file;
+        size_t base_len = std::strlen(base);
+
+        // 前缀总长有界（文件名除外），行缓冲区为空时一定放得下
+        if (buffer.room() < 64 + base_len)
+        {
+            return;
+        }
+        char* p = buffer.cursor();
+        *p++ = SEVERITY_CHAR[std::clamp(level, 0, 3)];
+        std::memcpy(p, t_prefix_time, 17);
+        p += 17;
+        *p++ = '.';
+        p = appendUInt(p, static_cast<uint64_t>(tv.tv_usec), 6);
+        *p++ = ' ';
+        std::memcpy(p, t_tid, t_tid_len);
+        p += t_tid_len;
+        *p++ = ' ';
+        std::memcpy(p, base, base_len);
+        p += base_len;
+        if (line > 0)
+        {
+            *p++ = ':';
+            p = appendUInt(p, static_cast<uint64_t>(line), 0);
+        }
+        *p++ = ']';
+        *p++ = ' ';
+        buffer.advance(p);
+    }
+}
+
+AsyncLogMessage::AsyncLogMessage(const char* file, int line, int level)
+    : level_(level)
+{
+    if (!t_line && !t_line_released)
+    {
+        t_line_owner.buffer = std::make_unique<LineBuffer>();
+        t_line = t_line_owner.buffer.get();
+    }
+    if (!t_line || t_line->in_use)
+    {
+        // 格式化参数的过程中又写了日志，或线程局部缓冲区已随线程退出释放
+        nested_ = std::make_unique<LineBuffer>();
+        buffer_ = nested_.get();
+    }
+    else
+    {
+        buffer_ = t_line;
+        buffer_->in_use = true;
+    }
+    stream_ = &buffer_->begin();
+    writePrefix(*buffer_, level, file, line);
+}
+
+AsyncLogMessage::~AsyncLogMessage()
+{
+    size_t len = 0;
+    const char* data = buffer_->finish(len);
+    AsyncLog::submit(level_, data, len);
+    buffer_->in_use = false;
+}
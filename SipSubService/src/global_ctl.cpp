@@ -2,6 +2,15 @@
 
 #include "global_ctl.h"
 #include "sip_core.h"
+#include "thread_placement.h"
+#include "ev_thread.h"
+#include "metrics.h"
+#include "admin_server.h"
+#include "log_rate_limit.h"
+#include "pool_monitor.h"
+#include "tcp_conn_manager.h"
+
+#include <algorithm>
 
 
 
@@ -31,6 +40,21 @@ bool GlobalCtl::init(std::unique_ptr<IConfigProvider> config)
         return false;
     }
 
+    // 日志限流尽早生效，之后的初始化日志也受其约束
+    LogRateLimiter::getInstance()->configure(g_config_->getLogRateLimit());
+
+    // 线程布局需在创建任何工作线程/服务线程之前生效
+    ThreadPlacement::getInstance()->configure(g_config_->getThreadPlacement());
+    ThreadPlacement::getInstance()->logTopology();
+
+    // 请求处理线程池按排队深度与等待时间自动伸缩
+    if (g_config_->getPoolAutoscale().enabled)
+    {
+        EVThread::enableAutoscale(g_config_->getPoolAutoscale());
+    }
+
+    // 缓存池创建后由 SipCore 启动采集
+    PoolMonitor::getInstance()->configure(g_config_->getPoolStats());
     
     buildDomainInfoList();
     if (domain_info_list_.empty()) 
@@ -39,12 +63,16 @@ bool GlobalCtl::init(std::unique_ptr<IConfigProvider> config)
         return false;
     }
 
+    registerMetrics();
+    registerAdminRoutes();
+
     // 在初始化ThreadPool前添加调试输出
     LOG(INFO) << "About to initialize ThreadPool";
     if (!g_thread_pool_) 
     {
         try {
-            g_thread_pool_ = std::make_unique<ThreadPool>(2); // 尝试使用更少的线程
+            g_thread_pool_ = std::make_unique<ThreadPool>(2, // 尝试使用更少的线程
+                ThreadPlacement::getInstance()->cpusFor(ThreadRole::WORKER));
             LOG(INFO) << "ThreadPool initialized successfully";
         } catch (const std::bad_alloc& e) {
             LOG(ERROR) << "ThreadPool initialization failed: " << e.what();
@@ -84,6 +112,8 @@ void GlobalCtl::buildDomainInfoList()
     LOG(INFO) << "Building DomainInfo list...";
     std::unique_lock<std::shared_mutex> lock(domain_mutex_);
     const auto& nodes = g_config_->getNodeInfoList();
+    // 释放旧句柄，尚未返回的 regc 回调会因代数不匹配被丢弃
+    reg_registry_.releaseAll();
     domain_info_list_.clear();
     if (nodes.size() > 1000) // 假设 100,000 是最大允许值
     {
@@ -98,8 +128,120 @@ void GlobalCtl::buildDomainInfoList()
     }
     for(const auto& node : nodes)
     {
-        domain_info_list_.emplace_back(node);
+        auto& domain = domain_info_list_.emplace_back(node);
+        domain.reg_handle = reg_registry_.acquire(domain.sip_id);
+        if (!domain.reg_handle.valid())
+        {
+            LOG(ERROR) << "Failed to acquire registration handle for domain: " << domain.sip_id;
+        }
     }
     LOG(INFO) << "Built " << domain_info_list_.size() << " domain entries";
 }
 
+void GlobalCtl::registerMetrics()
+{
+    auto registry = MetricsRegistry::getInstance();
+
+    // 请求处理线程池：线程数与排队深度在抓取时读取
+    registry->gaugeFn("thread_pool_threads", "Worker threads of the request pool",
+        [] { return static_cast<double>(EVThread::getThreadPool().size()); });
+    registry->gaugeFn("thread_pool_active_threads", "Worker threads currently running a task",
+        [] { return static_cast<double>(EVThread::getThreadPool().activeThreads()); });
+    for (size_t i = 0; i < TRAFFIC_CLASS_COUNT; ++i)
+    {
+        TrafficClass cls = static_cast<TrafficClass>(i);
+        registry->gaugeFn("thread_pool_queue_depth", "Queued tasks of the request pool by traffic class",
+            [i] { return static_cast<double>(EVThread::getThreadPool().classStats()[i].pending); },
+            {{"class", trafficClassName(cls)}});
+    }
+    registry->counterFn("thread_pool_tasks_total", "Tasks submitted to the request pool",
+        [] { return static_cast<double>(EVThread::getThreadPool().totalTasks()); });
+    registry->counterFn("thread_pool_tasks_completed_total", "Tasks completed by the request pool",
+        [] { return static_cast<double>(EVThread::getThreadPool().completedTasks()); });
+    registry->counterFn("thread_pool_tasks_dropped_total", "Tasks dropped at dequeue because they expired or were cancelled",
+        [] {
+            const ThreadPool& pool = EVThread::getThreadPool();
+            return static_cast<double>(pool.expiredTasks() + pool.cancelledTasks());
+        });
+
+    // 日志：已写入、线程缓冲区满而丢弃、被限流抑制的行数
+    registry->counterFn("log_lines_total", "Log lines by outcome",
+        [] { return static_cast<double>(AsyncLog::getInstance()->stats().written); }, {{"result", "written"}});
+    registry->counterFn("log_lines_total", "Log lines by outcome",
+        [] { return static_cast<double>(AsyncLog::getInstance()->stats().dropped); }, {{"result", "dropped"}});
+    registry->counterFn("log_lines_total", "Log lines by outcome",
+        [] { return static_cast<double>(LogRateLimiter::getInstance()->suppressedTotal()); }, {{"result", "suppressed"}});
+
+    // TCP 长连接：当前持有的连接数与各类事件计数
+    registry->gaugeFn("tcp_conn_open", "TCP connections held by the connection manager",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().active); });
+    registry->counterFn("tcp_conn_created_total", "TCP connections opened to peers",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().created); });
+    registry->counterFn("tcp_conn_reused_total", "Requests bound to an existing TCP connection",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().reused); });
+    registry->counterFn("tcp_conn_adopted_total", "Peer-initiated TCP connections adopted for reuse",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().adopted); });
+    registry->counterFn("tcp_conn_reaped_total", "Idle TCP connections released by the reaper",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().reaped); });
+    registry->counterFn("tcp_conn_closed_total", "TCP connections closed by the peer or on error",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().closed); });
+    registry->counterFn("tcp_conn_failed_total", "Failed attempts to open a TCP connection",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().failed); });
+
+    // 上级域注册状态：域列表取 domainSnapshot，不阻塞等待 domain_mutex_；
+    // 注册状态从注册表无锁读取，快照中的句柄过期时不计入
+    registry->gaugeFn("domains_configured", "Upper domains in the configuration", [this] {
+        return static_cast<double>(domainSnapshot()->size());
+    });
+    registry->gaugeFn("domains_online", "Upper domains this service is registered with", [this] {
+        auto domains = domainSnapshot();
+        return static_cast<double>(std::count_if(domains->begin(), domains->end(),
+            [this](const DomainInfo& domain) {
+                return reg_registry_.state(domain.reg_handle) == RegState::REGISTERED;
+            }));
+    });
+}
+
+std::shared_ptr<const std::vector<DomainInfo>> GlobalCtl::domainSnapshot(bool* fresh) const
+{
+    std::lock_guard<std::mutex> guard(snapshot_mutex_);
+    std::shared_lock<std::shared_mutex> lock(domain_mutex_, std::try_to_lock);
+    if (lock.owns_lock())
+    {
+        domain_snapshot_ = std::make_shared<const std::vector<DomainInfo>>(domain_info_list_);
+    }
+    else if (!domain_snapshot_)
+    {
+        domain_snapshot_ = std::make_shared<const std::vector<DomainInfo>>();
+    }
+    if (fresh) *fresh = lock.owns_lock();
+    return domain_snapshot_;
+}
+
+void GlobalCtl::registerAdminRoutes()
+{
+    AdminServer::getInstance()->addRoute("/debug/domains", [this](AdminResponse& response) {
+        bool fresh = false;
+        auto domains = domainSnapshot(&fresh);
+
+        Json::Value root;
+        root["fresh"] = fresh;
+        Json::Value& list = root["domains"];
+        list = Json::Value(Json::arrayValue);
+        for (const auto& domain : *domains)
+        {
+            // 注册状态从 RegRegistry 原子读取；副本中的句柄在域列表重建后失效
+            auto state = reg_registry_.state(domain.reg_handle);
+            Json::Value item;
+            item["sip_id"] = domain.sip_id;
+            item["addr_ip"] = domain.addr_ip;
+            item["sip_port"] = domain.sip_port;
+            item["proto"] = domain.proto;
+            item["auth"] = domain.isAuth;
+            item["expires"] = domain.expires;
+            item["state"] = state ? regStateName(*state) : "stale";
+            list.append(item);
+        }
+        response.setJson(root);
+    });
+}
@@ -6,7 +6,7 @@
  
  
  #define LOG_DIR "/mnt/hgfs/share/log"  
- #define LOG_FILE_NAME "SipSupService.log"
+ #define LOG_FILE_NAME "SipSubService.log"
  
  bool SetLogLevel::is_initialized_ = false;  
  
@@ -45,12 +45,28 @@
      google::SetLogDestination(google::GLOG_WARNING, "");
      google::SetLogDestination(google::GLOG_ERROR, "");
      signal(SIGPIPE, SIG_IGN);  // 需明确是否全局需要
+ 
+     // LOG 宏由 AsyncLog 处理：后台线程批量写 LOG_DIR 下的日志文件并轮转，
+     // 不低于设定级别的日志仍同时输出到 stderr（与原 stderrthreshold 一致）
+     int level = static_cast<int>(loglevel_) + SIP_LOG_LEVEL_INFO;
+     AsyncLog::setLevel(level);
+     AsyncLogOptions options;
+     options.dir = LOG_DIR;
+     options.name = LOG_FILE_NAME;
+     options.max_file_bytes = static_cast<size_t>(FLAGS_max_log_size) << 20;
+     options.stderr_level = level;
+     if (!AsyncLog::getInstance()->start(options))
+     {
+         LOG(WARNING) << "Async log writer not started, logging to stderr only";
+     }
  }
  
  SetLogLevel::~SetLogLevel() 
  {
      if (is_initialized_) 
      {
+         // 先写完各线程缓冲区中的日志
+         AsyncLog::getInstance()->stop();
          google::ShutdownGoogleLogging();
          is_initialized_ = false;
      }
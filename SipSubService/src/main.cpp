@@ -19,6 +19,10 @@
 #include "global_ctl.h"        // 依赖于 SipLocalConfig 的定义
 #include "sip_local_config.h"  // 必须在使用 SipLocalConfig 之前包含
 #include "sip_register.h"  // SipRegister 依赖于 SipLocalConfig
+#include "sip_keepalive.h"
+#include "sip_failover.h"
+#include "admin_server.h"
+#include "tcp_conn_manager.h"
 #include "common.h"
 
 
@@ -36,6 +40,18 @@ int main(int argc, char* argv[])
 
     LOG(INFO) << "local_ip is: " << GCONF(getLocalIp);
 
+    // 管理/指标 HTTP 接口；监听失败不影响信令服务
+    if (!AdminServer::getInstance()->start(GCONF(getAdminIp), GCONF(getLocalPort)))
+    {
+        LOG(ERROR) << "Admin HTTP endpoint disabled";
+    }
+
+    // TCP 长连接空闲回收
+    TcpConnManager::getInstance()->startReaper(GCONF(getTcpIdleTimeout));
+
+    // 主备切换需在注册服务之前确定模式与活动上级
+    SipFailover::getInstance(GlobalCtl::getInstance())->startFailoverService();
+
     // 使用单例工厂获取注册器
     auto reg = SipRegister::getInstance(GlobalCtl::getInstance());
     if (!reg)
@@ -45,6 +61,10 @@ int main(int argc, char* argv[])
     }
     reg->startRegService();
 
+    // 心跳服务：注册成功的上级按周期发送 Keepalive
+    auto keepalive = SipKeepalive::getInstance(GlobalCtl::getInstance());
+    keepalive->startKeepaliveService();
+
     while (true)
     {
         std::this_thread::sleep_for(std::chrono::seconds(30));
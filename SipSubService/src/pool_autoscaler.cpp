@@ -0,0 +1,200 @@
+// pool_autoscaler.cpp
+#include "pool_autoscaler.h"
+#include "common.h"
+#include "ev_thread_pool.h"
+#include "thread_placement.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+    constexpr int64_t NS_PER_MS = 1000000;
+
+    // 本周期的直方图 = 当前累计值 - 上次累计值
+    LatencyHistogram histogramSince(const LatencyHistogram& now, const LatencyHistogram& before)
+    {
+        LatencyHistogram window;
+        for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i)
+        {
+            uint64_t n = now.buckets[i] >= before.buckets[i] ? now.buckets[i] - before.buckets[i] : 0;
+            window.buckets[i] = n;
+            window.count += n;
+        }
+        return window;
+    }
+}
+
+PoolAutoscaler::PoolAutoscaler(ThreadPool& pool, PoolAutoscalerOptions options, std::string name)
+    : pool_(pool)
+    , options_(std::move(options))
+    , name_(std::move(name))
+{
+    if (options_.min_threads == 0)
+        options_.min_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (options_.max_threads == 0)
+        options_.max_threads = options_.min_threads * 4;
+    options_.max_threads = std::min(std::max(options_.max_threads, options_.min_threads), ThreadPool::MAX_WORKERS);
+    options_.min_threads = std::min(options_.min_threads, options_.max_threads);
+    if (options_.interval_ms <= 0)
+        options_.interval_ms = 200;
+
+    stats_.min_threads = options_.min_threads;
+    stats_.max_threads = options_.max_threads;
+}
+
+PoolAutoscaler::~PoolAutoscaler()
+{
+    stop();
+}
+
+bool PoolAutoscaler::start()
+{
+    if (thread_) return true;
+
+    size_t current = pool_.size();
+    size_t target = std::clamp(current, options_.min_threads, options_.max_threads);
+    if (target != current)
+    {
+        pool_.setThreadCount(target);
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.threads = pool_.size();
+        stats_.peak_threads = stats_.threads;
+    }
+    last_queue_wait_ = pool_.telemetry(0).queue_wait;
+    last_resize_ns_ = TaskTelemetry::nowNs();
+    idle_since_ns_ = 0;
+
+    ServiceThreadOptions thread_options;
+    thread_options.name = name_;
+    thread_options.cpus = ThreadPlacement::getInstance()->cpusFor(ThreadRole::TIMER);
+    thread_ = std::make_unique<ServiceThread>(std::move(thread_options), [this](ServiceThread& self) {
+        run(self);
+    });
+    thread_->setWakeup([this]() {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        wait_cv_.notify_all();
+    });
+    if (!thread_->start())
+    {
+        thread_.reset();
+        return false;
+    }
+
+    LOG(INFO) << fmt::format("Pool autoscaler {} started: threads {}..{}, grow at depth > {}/thread or wait p99 > {} ms, "
+        "shrink after {} ms idle", name_, options_.min_threads, options_.max_threads,
+        options_.grow_queue_per_thread, options_.grow_wait_p99_ms, options_.shrink_cooldown_ms);
+    return true;
+}
+
+void PoolAutoscaler::stop()
+{
+    if (!thread_) return;
+    thread_->stop();
+    thread_.reset();
+}
+
+void PoolAutoscaler::run(ServiceThread& self)
+{
+    const auto interval = std::chrono::milliseconds(options_.interval_ms);
+    while (!self.stopRequested())
+    {
+        {
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            wait_cv_.wait_for(lock, interval, [&self] { return self.stopRequested(); });
+        }
+        if (self.stopRequested() || !pool_.isRunning()) break;
+        tick();
+    }
+}
+
+void PoolAutoscaler::tick()
+{
+    int64_t now = TaskTelemetry::nowNs();
+    size_t threads = pool_.size();
+    size_t depth = pool_.pendingTasks();
+
+    LatencyHistogram queue_wait = pool_.telemetry(0).queue_wait;
+    LatencyHistogram window = histogramSince(queue_wait, last_queue_wait_);
+    last_queue_wait_ = queue_wait;
+    int64_t wait_p99 = window.count ? window.percentileNs(0.99) : 0;
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.threads = threads;
+        stats_.last_queue_depth = depth;
+        stats_.last_wait_p99_ns = wait_p99;
+    }
+
+    const char* grow_reason = nullptr;
+    if (depth > threads * options_.grow_queue_per_thread)
+        grow_reason = "queue_depth";
+    else if (wait_p99 > options_.grow_wait_p99_ms * NS_PER_MS)
+        grow_reason = "queue_wait";
+
+    if (grow_reason)
+    {
+        idle_since_ns_ = 0;
+        if (threads < options_.max_threads)
+        {
+            // 成倍扩容，风暴期间几个周期内即可追上负载
+            resize(std::min(options_.max_threads, threads * 2), depth, wait_p99, grow_reason);
+        }
+        return;
+    }
+
+    bool idle = depth == 0 && wait_p99 <= options_.shrink_wait_p99_ms * NS_PER_MS;
+    if (!idle)
+    {
+        idle_since_ns_ = 0;
+        return;
+    }
+    if (idle_since_ns_ == 0)
+        idle_since_ns_ = now;
+
+    int64_t cooldown = options_.shrink_cooldown_ms * NS_PER_MS;
+    if (threads > options_.min_threads && now - idle_since_ns_ >= cooldown && now - last_resize_ns_ >= cooldown)
+    {
+        // 每个冷却期回收一半多余线程，避免负载反复时来回抖动
+        size_t excess = threads - options_.min_threads;
+        resize(threads - std::max<size_t>(1, excess / 2), depth, wait_p99, "idle");
+    }
+}
+
+void PoolAutoscaler::resize(size_t target, size_t depth, int64_t wait_p99_ns, const char* reason)
+{
+    size_t from = pool_.size();
+    pool_.setThreadCount(target);
+    size_t to = pool_.size();
+    last_resize_ns_ = TaskTelemetry::nowNs();
+    if (to == from) return;
+
+    PoolResizeEvent event;
+    event.time_ns = last_resize_ns_;
+    event.from = from;
+    event.to = to;
+    event.queue_depth = depth;
+    event.wait_p99_ns = wait_p99_ns;
+    event.reason = reason;
+
+    LOG(INFO) << fmt::format("Pool autoscaler {}: {} -> {} threads ({}, depth {}, wait p99 {:.2f} ms)",
+        name_, from, to, reason, depth, wait_p99_ns / 1e6);
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.threads = to;
+    stats_.peak_threads = std::max(stats_.peak_threads, to);
+    if (to > from)
+        ++stats_.grow_events;
+    else
+        ++stats_.shrink_events;
+    stats_.recent.push_back(event);
+    if (stats_.recent.size() > MAX_RECENT_EVENTS)
+        stats_.recent.pop_front();
+}
+
+PoolAutoscalerStats PoolAutoscaler::stats() const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
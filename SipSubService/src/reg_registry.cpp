@@ -0,0 +1,192 @@
+// reg_registry.cpp
+
+#include "reg_registry.h"
+#include "common.h"
+
+#include <algorithm>
+
+static_assert(sizeof(void*) >= sizeof(uint64_t), "RegHandle token requires 64-bit pointers");
+
+const char* regStateName(RegState state)
+{
+    switch (state)
+    {
+        case RegState::UNREGISTERED: return "UNREGISTERED";
+        case RegState::REGISTERING:  return "REGISTERING";
+        case RegState::REGISTERED:   return "REGISTERED";
+        case RegState::FAILED:       return "FAILED";
+        default:                     return "UNKNOWN";
+    }
+}
+
+void* RegHandle::toToken() const
+{
+    uint64_t raw = (static_cast<uint64_t>(generation) << 32) | index;
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(raw));
+}
+
+RegHandle RegHandle::fromToken(const void* token)
+{
+    uint64_t raw = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(token));
+    RegHandle handle;
+    handle.index = static_cast<uint32_t>(raw & 0xffffffffu);
+    handle.generation = static_cast<uint32_t>(raw >> 32);
+    return handle;
+}
+
+RegRegistry::RegRegistry(size_t capacity)
+    : capacity_(capacity)
+    , slots_(std::make_unique<Slot[]>(capacity))
+{
+    free_list_.reserve(capacity_);
+    // 倒序压栈，保证先分配低索引槽位
+    for (size_t i = capacity_; i > 0; --i)
+    {
+        free_list_.push_back(static_cast<uint32_t>(i - 1));
+    }
+    for (size_t i = 0; i < capacity_; ++i)
+    {
+        slots_[i].word.store(pack(1, RegState::UNREGISTERED), std::memory_order_relaxed);
+    }
+}
+
+RegHandle RegRegistry::acquire(const std::string& sip_id)
+{
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    if (free_list_.empty())
+    {
+        LOG(ERROR) << "RegRegistry is full, capacity: " << capacity_;
+        return RegHandle{};
+    }
+    uint32_t index = free_list_.back();
+    free_list_.pop_back();
+
+    Slot& slot = slots_[index];
+    std::atomic_store(&slot.sip_id, std::make_shared<const std::string>(sip_id));
+
+    RegHandle handle;
+    handle.index = index;
+    handle.generation = genOf(slot.word.load(std::memory_order_acquire));
+    slot.word.store(pack(handle.generation, RegState::UNREGISTERED), std::memory_order_release);
+
+    live_.push_back(handle);
+    in_use_.fetch_add(1, std::memory_order_relaxed);
+    return handle;
+}
+
+void RegRegistry::release(RegHandle handle)
+{
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    Slot* slot = lookup(handle);
+    if (!slot)
+    {
+        return;
+    }
+    // 代数加一，之后所有持有旧句柄的回调都会被拒绝
+    uint32_t next_gen = handle.generation + 1;
+    if (next_gen == 0) next_gen = 1;
+    slot->word.store(pack(next_gen, RegState::UNREGISTERED), std::memory_order_release);
+    std::atomic_store(&slot->sip_id, std::shared_ptr<const std::string>());
+
+    live_.erase(std::remove_if(live_.begin(), live_.end(), [&handle](const RegHandle& h) {
+        return h.index == handle.index;
+    }), live_.end());
+    free_list_.push_back(handle.index);
+    in_use_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void RegRegistry::releaseAll()
+{
+    std::vector<RegHandle> live;
+    {
+        std::lock_guard<std::mutex> lock(free_mutex_);
+        live = live_;
+    }
+    for (const auto& handle : live)
+    {
+        release(handle);
+    }
+}
+
+const RegRegistry::Slot* RegRegistry::lookup(RegHandle handle) const
+{
+    if (!handle.valid() || handle.index >= capacity_)
+    {
+        return nullptr;
+    }
+    const Slot& slot = slots_[handle.index];
+    if (genOf(slot.word.load(std::memory_order_acquire)) != handle.generation)
+    {
+        stale_count_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return &slot;
+}
+
+RegRegistry::Slot* RegRegistry::lookup(RegHandle handle)
+{
+    return const_cast<Slot*>(static_cast<const RegRegistry*>(this)->lookup(handle));
+}
+
+std::optional<RegState> RegRegistry::state(RegHandle handle) const
+{
+    if (!handle.valid() || handle.index >= capacity_)
+    {
+        return std::nullopt;
+    }
+    uint64_t word = slots_[handle.index].word.load(std::memory_order_acquire);
+    if (genOf(word) != handle.generation)
+    {
+        stale_count_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    return stateOf(word);
+}
+
+bool RegRegistry::transition(RegHandle handle, RegState expected, RegState desired)
+{
+    if (!handle.valid() || handle.index >= capacity_)
+    {
+        return false;
+    }
+    uint64_t expected_word = pack(handle.generation, expected);
+    return slots_[handle.index].word.compare_exchange_strong(
+        expected_word, pack(handle.generation, desired),
+        std::memory_order_acq_rel, std::memory_order_acquire);
+}
+
+bool RegRegistry::store(RegHandle handle, RegState desired)
+{
+    if (!handle.valid() || handle.index >= capacity_)
+    {
+        return false;
+    }
+    auto& word = slots_[handle.index].word;
+    uint64_t current = word.load(std::memory_order_acquire);
+    do {
+        if (genOf(current) != handle.generation)
+        {
+            stale_count_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!word.compare_exchange_weak(current, pack(handle.generation, desired),
+                std::memory_order_acq_rel, std::memory_order_acquire));
+    return true;
+}
+
+std::shared_ptr<const std::string> RegRegistry::sipId(RegHandle handle) const
+{
+    const Slot* slot = lookup(handle);
+    if (!slot)
+    {
+        return nullptr;
+    }
+    auto id = std::atomic_load(&slot->sip_id);
+    // 读取后再次校验代数，防止读到已被复用槽位的ID
+    if (genOf(slot->word.load(std::memory_order_acquire)) != handle.generation)
+    {
+        stale_count_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return id;
+}
@@ -0,0 +1,196 @@
+// service_thread.cpp
+#include "service_thread.h"
+#include "common.h"
+#include "thread_placement.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    // 全局服务线程登记表，仅用于统计查询
+    std::mutex registry_mutex;
+    std::vector<ServiceThread*> registry;
+
+    int64_t readCpuClock(clockid_t clock)
+    {
+        struct timespec ts;
+        if (clock_gettime(clock, &ts) != 0) return -1;
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+}
+
+ServiceThread::ServiceThread(ServiceThreadOptions options, Body body)
+    : options_(std::move(options))
+    , body_(std::move(body))
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.push_back(this);
+}
+
+ServiceThread::~ServiceThread()
+{
+    stop();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+}
+
+bool ServiceThread::start()
+{
+    if (thread_.joinable())
+    {
+        LOG(WARNING) << "Service thread " << options_.name << " already started";
+        return false;
+    }
+
+    stop_requested_ = false;
+    {
+        std::lock_guard<std::mutex> lock(exit_mutex_);
+        exited_ = false;
+    }
+    running_ = true;
+    try {
+        thread_ = std::thread([this] { run(); });
+    } catch (const std::exception& e) {
+        running_ = false;
+        LOG(ERROR) << "Failed to start service thread " << options_.name << ": " << e.what();
+        return false;
+    }
+    if (pthread_getcpuclockid(thread_.native_handle(), &cpu_clock_) != 0)
+    {
+        cpu_clock_ = CLOCK_THREAD_CPUTIME_ID;
+    }
+    LOG(INFO) << "Service thread " << options_.name << " started";
+    return true;
+}
+
+void ServiceThread::applyOptions()
+{
+    pthread_t self = pthread_self();
+
+    if (!options_.name.empty())
+    {
+        std::string short_name = options_.name.substr(0, 15);
+        pthread_setname_np(self, short_name.c_str());
+    }
+
+    if (!options_.cpus.empty() && ThreadPlacement::pinCurrentThread(options_.cpus))
+    {
+        ThreadPlacement::getInstance()->preferLocalMemory();
+    }
+
+    if (options_.sched_policy != SCHED_OTHER || options_.sched_priority != 0)
+    {
+        struct sched_param param;
+        param.sched_priority = options_.sched_priority;
+        int rc = pthread_setschedparam(self, options_.sched_policy, &param);
+        if (rc != 0)
+        {
+            // 实时调度通常需要 CAP_SYS_NICE，失败时保持默认策略继续运行
+            LOG(WARNING) << "Service thread " << options_.name << " failed to set scheduling policy "
+                         << options_.sched_policy << ": " << std::strerror(rc);
+        }
+    }
+}
+
+void ServiceThread::run()
+{
+    tid_ = static_cast<int>(syscall(SYS_gettid));
+    applyOptions();
+
+    try {
+        body_(*this);
+    } catch (const std::exception& e) {
+        LOG(ERROR) << "Exception in service thread " << options_.name << ": " << e.what();
+    } catch (...) {
+        LOG(ERROR) << "Unknown exception in service thread " << options_.name;
+    }
+
+    final_cpu_ns_ = readCpuClock(CLOCK_THREAD_CPUTIME_ID);
+    running_ = false;
+    LOG(INFO) << "Service thread " << options_.name << " exited, cpu time: "
+              << final_cpu_ns_.load() / 1000000 << " ms";
+
+    std::lock_guard<std::mutex> lock(exit_mutex_);
+    exited_ = true;
+    exit_cv_.notify_all();
+}
+
+void ServiceThread::setWakeup(std::function<void()> wakeup)
+{
+    std::lock_guard<std::mutex> lock(exit_mutex_);
+    wakeup_ = std::move(wakeup);
+}
+
+void ServiceThread::requestStop()
+{
+    stop_requested_.store(true, std::memory_order_release);
+    std::function<void()> wakeup;
+    {
+        std::lock_guard<std::mutex> lock(exit_mutex_);
+        wakeup = wakeup_;
+    }
+    if (wakeup) wakeup();
+}
+
+bool ServiceThread::join(std::chrono::milliseconds timeout)
+{
+    if (!thread_.joinable()) return true;
+
+    // 在线程自身内部调用（例如线程主体释放了拥有者）时不能 join
+    if (thread_.get_id() == std::this_thread::get_id())
+    {
+        thread_.detach();
+        return true;
+    }
+
+    if (timeout.count() > 0)
+    {
+        std::unique_lock<std::mutex> lock(exit_mutex_);
+        if (!exit_cv_.wait_for(lock, timeout, [this] { return exited_; }))
+        {
+            LOG(WARNING) << "Service thread " << options_.name << " did not exit within "
+                         << timeout.count() << " ms";
+            return false;
+        }
+    }
+    thread_.join();
+    return true;
+}
+
+bool ServiceThread::stop(std::chrono::milliseconds timeout)
+{
+    requestStop();
+    return join(timeout);
+}
+
+int64_t ServiceThread::cpuTimeNs() const
+{
+    if (running_)
+    {
+        int64_t ns = readCpuClock(cpu_clock_);
+        if (ns >= 0) return ns;
+    }
+    return final_cpu_ns_;
+}
+
+std::vector<ServiceThreadStats> ServiceThread::stats()
+{
+    std::vector<ServiceThreadStats> result;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    result.reserve(registry.size());
+    for (const ServiceThread* thread : registry)
+    {
+        ServiceThreadStats stat;
+        stat.name = thread->options_.name;
+        stat.tid = thread->tid_;
+        stat.running = thread->running_;
+        stat.cpus = thread->options_.cpus;
+        stat.cpu_time_ns = thread->cpuTimeNs();
+        result.push_back(std::move(stat));
+    }
+    return result;
+}
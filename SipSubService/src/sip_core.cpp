@@ -2,6 +2,8 @@
 
 #include "sip_core.h"
 #include "sip_register.h"
+#include "thread_placement.h"
+#include "pool_monitor.h"
 
 std::atomic<bool> SipCore::stop_pool_{false};
 
@@ -37,9 +39,15 @@ SipCore::~SipCore()
 {
     LOG(INFO) << "Releasing SipCore...";
     stop_pool_ = true;
+    waker_.wake();
     
-    // 增加足够的等待时间，确保pollingEventLoop安全退出
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    // 等待pollingEventLoop退出（已被唤醒，不必等到本轮阻塞超时）
+    if (polling_thread_)
+    {
+        polling_thread_->stop(std::chrono::milliseconds(2000));
+    }
+    waker_.close();
+    PoolMonitor::getInstance()->stop();
     
     // 直接使用 PjSipUtils 的清理函数
     PjSipUtils::cleanupCore(caching_pool_, endpt_);
@@ -57,9 +65,13 @@ void SipCore::pollingEventLoop(SipTypes::EndpointPtr endpt)
         return;
     }
     LOG(INFO) << "pollingEventLoop started";
+    waker_.attachLoopThread();
     while (!stop_pool_) 
     {
-        pj_time_val timeout = {0, 500};
+        // 阻塞到 I/O 就绪、端点定时器堆的下一个到期时刻或跨线程唤醒，最长 MAX_BLOCK_MS；
+        // 刚被唤醒时只短暂等待一轮，让发起线程随后挂上的事务定时器参与下一次等待时长的计算
+        unsigned wait_ms = waker_.consumeWake() ? SETTLE_MS : MAX_BLOCK_MS;
+        pj_time_val timeout = {static_cast<long>(wait_ms / 1000), static_cast<long>(wait_ms % 1000)};
         pj_status_t status = pjsip_endpt_handle_events(endpt.get(), &timeout);
         // 正确处理超时状态，PJ_ETIMEDOUT是正常的超时返回
         if (status != PJ_SUCCESS && status != PJ_ETIMEDOUT)
@@ -75,7 +87,7 @@ void SipCore::pollingEventLoop(SipTypes::EndpointPtr endpt)
 pj_status_t SipCore::initSip(int sip_port) 
 {  
     LOG(INFO) << "Initializing SipCore...";
-    pj_log_set_level(6);
+    PjSipUtils::routePjLog();
     pj_status_t status;
 
     if (!caching_pool_) 
@@ -97,6 +109,9 @@ pj_status_t SipCore::initSip(int sip_port)
         return PJ_ENOMEM;
     }
 
+    // 端点与传输层的池都从该缓存池分配
+    PoolMonitor::getInstance()->start(caching_pool_.get());
+
     status = PjSipUtils::initTransports(endpt_, sip_port);
     if (status != PJ_SUCCESS) 
     {
@@ -125,27 +140,31 @@ pj_status_t SipCore::initSip(int sip_port)
         return PJ_ENOMEM;
     }
 
-    // 安全创建线程
-    auto self = shared_from_this();
+    status = waker_.init(endpt_, pool_.get());
+    if (status != PJ_SUCCESS)
+    {
+        LOG(ERROR) << "LoopWaker::init failed, code: " << status;
+        return status;
+    }
+
+    // 事件循环运行在独立线程上，不占用请求处理线程池；
+    // 析构时先停止并等待该线程，因此可以直接捕获 this
     auto endpt_copy = endpt_;
-    
-    try {
-        // 使用适当超时时间创建线程
-        auto thread_future = EVThread::createThread(
-            [self, endpt_copy]() {
-                try {
-                    self->pollingEventLoop(endpt_copy);
-                } catch (const std::exception& e) {
-                    LOG(ERROR) << "Exception in pollingEventLoop: " << e.what();
-                }
-            },
-            std::tuple<>{},
-            nullptr,
-            ThreadPriority::NORMAL,
-            std::chrono::milliseconds{30000} 
-        );
-    } catch (const std::exception& e) {
-        LOG(ERROR) << "Failed to create polling thread: " << e.what();
+    ServiceThreadOptions options;
+    options.name = "sip-polling";
+    options.cpus = ThreadPlacement::getInstance()->cpusFor(ThreadRole::SIP_IO);
+    polling_thread_ = std::make_unique<ServiceThread>(std::move(options),
+        [this, endpt_copy](ServiceThread&) {
+            pollingEventLoop(endpt_copy);
+        });
+    polling_thread_->setWakeup([this]() {
+        stop_pool_ = true;
+        waker_.wake();
+    });
+    if (!polling_thread_->start())
+    {
+        LOG(ERROR) << "Failed to create polling thread";
+        polling_thread_.reset();
         return PJ_EINVAL;
     }
     
@@ -175,7 +194,7 @@ pj_bool_t SipCore::onRxRequestRaw(pjsip_rx_data* rdata)
 
 pj_bool_t SipCore::onRxRequest(SipTypes::RxDataPtr rdata)
 {
-    LOG(INFO) << "onRxRequest called with rdata=" << (void*)rdata.get();
+    LOG(DEBUG) << "onRxRequest called with rdata=" << (void*)rdata.get();
     // 添加线程注册，因为这是处理接收SIP请求的回调
     PjSipUtils::ThreadRegistrar thread_registrar;
 
@@ -0,0 +1,282 @@
+// sip_failover.cpp
+#include "sip_failover.h"
+#include "global_ctl.h"
+#include "pjsip_utils.h"
+#include "sip_register.h"
+#include "tcp_conn_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <shared_mutex>
+
+std::shared_ptr<SipFailover> SipFailover::instance_ = nullptr;
+std::mutex SipFailover::instance_mutex_;
+
+std::shared_ptr<SipFailover> SipFailover::getInstance(IDomainManager& domain_manager)
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+        instance_ = std::shared_ptr<SipFailover>(new SipFailover(domain_manager));
+    return instance_;
+}
+
+SipFailover::SipFailover(IDomainManager& domain_manager)
+    : probe_timer_(std::make_shared<TaskTimer>("sub-failover"))
+    , domain_manager_(domain_manager)
+    , active_standby_(GCONF(getActiveStandby))
+{
+    std::shared_lock<std::shared_mutex> domain_lock(domain_manager_.getMutex());
+    const auto& domains = domain_manager_.getDomainInfoList();
+    node_count_ = domains.size();
+    nodes_ = std::make_unique<NodeHealth[]>(node_count_);
+    for (size_t i = 0; i < node_count_; ++i)
+    {
+        nodes_[i].id = domains[i].sip_id;
+    }
+    probe_timer_->setInterval(static_cast<unsigned int>(GCONF(getProbeIntervalMs)));
+}
+
+SipFailover::~SipFailover()
+{
+    LOG(INFO) << "Destroying SipFailover";
+    if (probe_timer_)
+    {
+        probe_timer_->stop();
+    }
+}
+
+void SipFailover::startFailoverService()
+{
+    if (!active_standby_ || node_count_ < 2)
+    {
+        LOG(INFO) << "Failover disabled, registering to all " << node_count_ << " superior(s)";
+        active_standby_ = false;
+        return;
+    }
+    LOG(INFO) << "Starting failover service, active: " << nodes_[0].id
+              << ", detect window: " << GCONF(getFailoverDetectMs) << "ms"
+              << ", probe interval: " << GCONF(getProbeIntervalMs) << "ms"
+              << ", failback hold: " << GCONF(getFailbackHoldSec) << "s";
+    probe_timer_->addTask([weak_this = std::weak_ptr<SipFailover>(shared_from_this())]() {
+        if (auto shared_this = weak_this.lock())
+        {
+            try {
+                shared_this->tickProc();
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Error in failover task: " << e.what();
+            }
+        }
+    });
+    probe_timer_->start();
+}
+
+bool SipFailover::isActive(size_t index) const
+{
+    return !active_standby_ || index == active_.load(std::memory_order_acquire);
+}
+
+bool SipFailover::isActive(const std::string& domain_id) const
+{
+    if (!active_standby_)
+    {
+        return true;
+    }
+    int index = findNode(domain_id);
+    return index >= 0 && isActive(static_cast<size_t>(index));
+}
+
+int64_t SipFailover::nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int SipFailover::findNode(const std::string& domain_id) const
+{
+    for (size_t i = 0; i < node_count_; ++i)
+    {
+        if (nodes_[i].id == domain_id) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void SipFailover::onTransactionResult(const std::string& domain_id, bool responded)
+{
+    if (!active_standby_)
+    {
+        return;
+    }
+    int index = findNode(domain_id);
+    if (index >= 0)
+    {
+        markResult(static_cast<size_t>(index), responded);
+    }
+}
+
+void SipFailover::markResult(size_t index, bool ok)
+{
+    NodeHealth& node = nodes_[index];
+    int64_t now = nowMs();
+    if (ok)
+    {
+        node.last_ok_ms.store(now, std::memory_order_relaxed);
+        node.first_fail_ms.store(0, std::memory_order_relaxed);
+        int64_t expected = 0;
+        node.healthy_since_ms.compare_exchange_strong(expected, now);
+    }
+    else
+    {
+        int64_t expected = 0;
+        node.first_fail_ms.compare_exchange_strong(expected, now);
+        node.healthy_since_ms.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool SipFailover::isDown(size_t index, int64_t now) const
+{
+    const NodeHealth& node = nodes_[index];
+    // 至少观察到一次失败，且判定窗口内没有任何成功响应
+    return node.first_fail_ms.load(std::memory_order_relaxed) != 0
+        && now - node.last_ok_ms.load(std::memory_order_relaxed) >= GCONF(getFailoverDetectMs);
+}
+
+void SipFailover::tickProc()
+{
+    PjSipUtils::ThreadRegistrar thread_registrar;
+    {
+        std::shared_lock<std::shared_mutex> domain_lock(domain_manager_.getMutex());
+        const auto& domains = domain_manager_.getDomainInfoList();
+        for (size_t i = 0; i < node_count_ && i < domains.size(); ++i)
+        {
+            // 上一次探测未结束时不重复发送
+            if (!nodes_[i].probing.exchange(true))
+            {
+                sendProbe(i, domains[i]);
+            }
+        }
+    }
+
+    int64_t now = nowMs();
+    size_t active = active_.load(std::memory_order_acquire);
+
+    if (isDown(active, now))
+    {
+        // 选择优先级最高的健康备用上级
+        for (size_t i = 0; i < node_count_; ++i)
+        {
+            if (i != active && nodes_[i].healthy_since_ms.load(std::memory_order_relaxed) != 0
+                && !isDown(i, now))
+            {
+                switchTo(i, "failover");
+                return;
+            }
+        }
+        LOG(WARNING) << "Active superior " << nodes_[active].id << " is down, no healthy standby";
+        return;
+    }
+
+    // 回切：更高优先级的上级需持续健康超过保持时间
+    int64_t hold_ms = static_cast<int64_t>(GCONF(getFailbackHoldSec)) * 1000;
+    for (size_t i = 0; i < active; ++i)
+    {
+        int64_t since = nodes_[i].healthy_since_ms.load(std::memory_order_relaxed);
+        if (since != 0 && now - since >= hold_ms && !isDown(i, now))
+        {
+            switchTo(i, "failback");
+            return;
+        }
+    }
+}
+
+void SipFailover::switchTo(size_t index, const char* reason)
+{
+    std::lock_guard<std::mutex> lock(switch_mutex_);
+    size_t old = active_.exchange(index, std::memory_order_acq_rel);
+    if (old == index)
+    {
+        return;
+    }
+    LOG(WARNING) << "Superior " << reason << ": " << nodes_[old].id << " -> " << nodes_[index].id;
+
+    auto& registry = domain_manager_.getRegRegistry();
+    {
+        std::shared_lock<std::shared_mutex> domain_lock(domain_manager_.getMutex());
+        const auto& domains = domain_manager_.getDomainInfoList();
+        if (old < domains.size())
+        {
+            // 心跳在下一次到期时因状态不是 REGISTERED 自动移出
+            registry.store(domains[old].reg_handle, RegState::UNREGISTERED);
+        }
+        if (index < domains.size())
+        {
+            registry.store(domains[index].reg_handle, RegState::UNREGISTERED);
+        }
+    }
+    // 旧上级的 regc 开启了自动刷新，不注销就会继续刷新并在成功后被重新标记为已注册，
+    // 因此先注销并销毁它，再立即向新的活动上级注册（不等待注册定时器）
+    auto sip_register = SipRegister::getInstance(domain_manager_);
+    sip_register->unregisterNow(nodes_[old].id);
+    sip_register->registerNow();
+}
+
+void SipFailover::sendProbe(size_t index, const DomainInfo& domain)
+{
+    auto& config = GlobalCtl::getInstance().getConfig();
+    auto endpt = GlobalCtl::getInstance().getSipCore().getEndPoint();
+    if (!endpt)
+    {
+        nodes_[index].probing = false;
+        return;
+    }
+
+    std::string from_hdr = fmt::format("<sip:{}@{}:{}>", config.getSipId(), config.getSipIp(), config.getSipPort());
+    std::string to_hdr = fmt::format("<sip:{}@{}:{}>", domain.sip_id, domain.addr_ip, domain.sip_port);
+    std::string req_uri = fmt::format("sip:{}@{}:{};transport={}", domain.sip_id, domain.addr_ip, domain.sip_port, domain.proto == 1 ? "tcp" : "udp");
+    pj_str_t from = pj_str(from_hdr.data());
+    pj_str_t to = pj_str(to_hdr.data());
+    pj_str_t target = pj_str(req_uri.data());
+
+    pjsip_tx_data* tdata { nullptr };
+    pj_status_t status = pjsip_endpt_create_request(endpt.get(), &pjsip_options_method,
+        &target, &from, &to, nullptr, nullptr, -1, nullptr, &tdata);
+    if (status != PJ_SUCCESS || !tdata)
+    {
+        LOG(ERROR) << "Failed to create OPTIONS probe for " << domain.sip_id
+                   << ", error: " << PjSipUtils::getPjStatusString(status);
+        nodes_[index].probing = false;
+        return;
+    }
+
+    if (domain.proto == 1)
+    {
+        TcpConnManager::getInstance()->bindTxData(tdata, domain.sip_id, domain.addr_ip, domain.sip_port);
+    }
+
+    // 事务超时取判定窗口的一半，保证窗口内至少能得到一次结果
+    pj_int32_t timeout_ms = std::max(500, GCONF(getFailoverDetectMs) / 2);
+    void* token = reinterpret_cast<void*>(static_cast<uintptr_t>(index + 1));
+    status = pjsip_endpt_send_request(endpt.get(), tdata, timeout_ms, token, &SipFailover::onProbeResponse);
+    if (status != PJ_SUCCESS)
+    {
+        // 本地发送失败同样视为一次失败
+        nodes_[index].probing = false;
+        markResult(index, false);
+    }
+}
+
+void SipFailover::onProbeResponse(void* token, pjsip_event* e)
+{
+    if (!e || e->type != PJSIP_EVENT_TSX_STATE)
+    {
+        return;
+    }
+    auto self = getInstance(GlobalCtl::getInstance());
+    size_t index = static_cast<size_t>(reinterpret_cast<uintptr_t>(token)) - 1;
+    if (index >= self->node_count_)
+    {
+        return;
+    }
+    // 事务因收到响应而结束才说明对端存活；超时与传输错误的最终状态由定时器或传输层触发
+    self->nodes_[index].probing = false;
+    self->markResult(index, e->body.tsx_state.tsx && e->body.tsx_state.type == PJSIP_EVENT_RX_MSG);
+}
@@ -0,0 +1,272 @@
+// sip_keepalive.cpp
+#include "sip_keepalive.h"
+#include "global_ctl.h"
+#include "pjsip_utils.h"
+#include "sip_failover.h"
+#include "sip_transaction.h"
+#include "tcp_conn_manager.h"
+
+#include <algorithm>
+#include <shared_mutex>
+
+std::shared_ptr<SipKeepalive> SipKeepalive::instance_ = nullptr;
+std::mutex SipKeepalive::instance_mutex_;
+
+// GB28181 MESSAGE 方法（pjsip 没有内置常量）
+static const pjsip_method s_message_method = {
+    PJSIP_OTHER_METHOD, { const_cast<char*>("MESSAGE"), 7 }
+};
+
+std::shared_ptr<SipKeepalive> SipKeepalive::getInstance(IDomainManager& domain_manager)
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+        instance_ = std::shared_ptr<SipKeepalive>(new SipKeepalive(domain_manager));
+    return instance_;
+}
+
+SipKeepalive::SipKeepalive(IDomainManager& domain_manager)
+    : ka_timer_(std::make_shared<TaskTimer>("sub-keepalive"))
+    , domain_manager_(domain_manager)
+    , slot_count_(domain_manager.getRegRegistry().capacity())
+    , tracked_gen_(std::make_unique<std::atomic<uint32_t>[]>(slot_count_))
+    , epoch_(std::make_unique<std::atomic<uint64_t>[]>(slot_count_))
+    , missed_(std::make_unique<std::atomic<uint32_t>[]>(slot_count_))
+    , domain_index_(std::make_unique<std::atomic<size_t>[]>(slot_count_))
+{
+    ka_timer_->setInterval(TICK_MS);
+}
+
+SipKeepalive::~SipKeepalive()
+{
+    LOG(INFO) << "Destroying SipKeepalive";
+    if (ka_timer_)
+    {
+        ka_timer_->stop();
+    }
+}
+
+void SipKeepalive::startKeepaliveService()
+{
+    LOG(INFO) << "Starting keepalive service, interval: "
+              << GCONF(getKeepaliveInterval) << "s, max missed: " << GCONF(getKeepaliveMaxMissed);
+    ka_timer_->addTask([weak_this = std::weak_ptr<SipKeepalive>(shared_from_this())]() {
+        if (auto shared_this = weak_this.lock())
+        {
+            try {
+                shared_this->tickProc();
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Error in keepalive task: " << e.what();
+            }
+        }
+    });
+    ka_timer_->start();
+}
+
+void SipKeepalive::track(RegHandle handle)
+{
+    if (!handle.valid() || handle.index >= slot_count_)
+    {
+        return;
+    }
+    // 注册刷新会重复收到200，同一代数只调度一次
+    if (tracked_gen_[handle.index].exchange(handle.generation) == handle.generation)
+    {
+        return;
+    }
+    missed_[handle.index] = 0;
+    uint64_t epoch = epoch_[handle.index].fetch_add(1) + 1;
+
+    uint64_t interval_ticks = static_cast<uint64_t>(GCONF(getKeepaliveInterval)) * 1000 / TICK_MS;
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    wheel_.schedule(interval_ticks, WheelEntry{handle, epoch});
+}
+
+void SipKeepalive::untrack(RegHandle handle)
+{
+    if (!handle.valid() || handle.index >= slot_count_)
+    {
+        return;
+    }
+    uint32_t gen = handle.generation;
+    if (tracked_gen_[handle.index].compare_exchange_strong(gen, 0))
+    {
+        epoch_[handle.index].fetch_add(1);
+    }
+}
+
+void SipKeepalive::tickProc()
+{
+    std::vector<WheelEntry> due;
+    {
+        std::lock_guard<std::mutex> lock(wheel_mutex_);
+        wheel_.advance([&due](WheelEntry&& entry) { due.push_back(entry); });
+    }
+    if (due.empty())
+    {
+        return;
+    }
+
+    PjSipUtils::ThreadRegistrar thread_registrar;
+    auto& registry = domain_manager_.getRegRegistry();
+    std::vector<WheelEntry> resched;
+    resched.reserve(due.size());
+
+    {
+        std::shared_lock<std::shared_mutex> domain_lock(domain_manager_.getMutex());
+        const auto& domains = domain_manager_.getDomainInfoList();
+        for (const auto& entry : due)
+        {
+            const RegHandle& handle = entry.handle;
+            // 纪元不一致：已被重新调度或移出，丢弃旧条目
+            if (epoch_[handle.index].load() != entry.epoch)
+            {
+                continue;
+            }
+            if (registry.state(handle) != RegState::REGISTERED)
+            {
+                untrack(handle);
+                continue;
+            }
+            const DomainInfo* domain = findDomain(domains, handle);
+            if (!domain)
+            {
+                untrack(handle);
+                continue;
+            }
+            if (sendKeepalive(*domain, sn_.fetch_add(1)) != PJ_SUCCESS)
+            {
+                handleKeepaliveResult(handle, PJSIP_SC_SERVICE_UNAVAILABLE, false);
+            }
+            resched.push_back(entry);
+        }
+    }
+
+    LOG(INFO) << "Keepalive batch sent: " << resched.size() << " superior(s)";
+
+    uint64_t interval_ticks = static_cast<uint64_t>(GCONF(getKeepaliveInterval)) * 1000 / TICK_MS;
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    for (auto& entry : resched)
+    {
+        wheel_.schedule(interval_ticks, entry);
+    }
+}
+
+const DomainInfo* SipKeepalive::findDomain(const std::vector<DomainInfo>& domains, RegHandle handle)
+{
+    auto matches = [&handle](const DomainInfo& d) {
+        return d.reg_handle.index == handle.index && d.reg_handle.generation == handle.generation;
+    };
+    size_t index = domain_index_[handle.index].load(std::memory_order_relaxed);
+    if (index < domains.size() && matches(domains[index]))
+    {
+        return &domains[index];
+    }
+    // 首次调度或域列表重新加载后下标失效，查找一次后缓存
+    auto it = std::find_if(domains.begin(), domains.end(), matches);
+    if (it == domains.end())
+    {
+        return nullptr;
+    }
+    domain_index_[handle.index].store(static_cast<size_t>(it - domains.begin()), std::memory_order_relaxed);
+    return &*it;
+}
+
+pj_status_t SipKeepalive::sendKeepalive(const DomainInfo& domain, uint32_t sn)
+{
+    auto& config = GlobalCtl::getInstance().getConfig();
+    auto endpt = GlobalCtl::getInstance().getSipCore().getEndPoint();
+    if (!endpt)
+    {
+        LOG(ERROR) << "sendKeepalive: endpoint is null";
+        return PJ_EINVAL;
+    }
+
+    std::string from_hdr = fmt::format("<sip:{}@{}:{}>", config.getSipId(), config.getSipIp(), config.getSipPort());
+    std::string to_hdr = fmt::format("<sip:{}@{}:{}>", domain.sip_id, domain.addr_ip, domain.sip_port);
+    std::string req_uri = fmt::format("sip:{}@{}:{};transport={}", domain.sip_id, domain.addr_ip, domain.sip_port, domain.proto == 1 ? "tcp" : "udp");
+    std::string body = fmt::format(
+        "<?xml version=\"1.0\" encoding=\"GB2312\"?>\r\n"
+        "<Notify>\r\n"
+        "<CmdType>Keepalive</CmdType>\r\n"
+        "<SN>{}</SN>\r\n"
+        "<DeviceID>{}</DeviceID>\r\n"
+        "<Status>OK</Status>\r\n"
+        "</Notify>\r\n", sn, config.getSipId());
+
+    pj_str_t from = pj_str(from_hdr.data());
+    pj_str_t to = pj_str(to_hdr.data());
+    pj_str_t target = pj_str(req_uri.data());
+
+    pjsip_tx_data* tdata { nullptr };
+    pj_status_t status = pjsip_endpt_create_request(endpt.get(), &s_message_method,
+        &target, &from, &to, nullptr, nullptr, -1, nullptr, &tdata);
+    if (status != PJ_SUCCESS || !tdata)
+    {
+        LOG(ERROR) << "Failed to create keepalive MESSAGE for domain: " << domain.sip_id
+                   << ", error: " << PjSipUtils::getPjStatusString(status);
+        return status;
+    }
+
+    pj_str_t type = pj_str(const_cast<char*>("Application"));
+    pj_str_t subtype = pj_str(const_cast<char*>("MANSCDP+xml"));
+    pj_str_t text;
+    pj_strdup2(tdata->pool, &text, body.c_str());
+    tdata->msg->body = pjsip_msg_body_create(tdata->pool, &type, &subtype, &text);
+
+    if (domain.proto == 1)
+    {
+        TcpConnManager::getInstance()->bindTxData(tdata, domain.sip_id, domain.addr_ip, domain.sip_port);
+    }
+
+    // 在当前（已注册到 PJSIP 的）线程上发出请求，响应到达后协程在线程池中继续
+    coStart(keepaliveTransaction(weak_from_this(), domain.reg_handle, endpt, tdata));
+    return PJ_SUCCESS;
+}
+
+CoTask<void> SipKeepalive::keepaliveTransaction(std::weak_ptr<SipKeepalive> weak_this, RegHandle handle,
+                                                SipTypes::EndpointPtr endpt, pjsip_tx_data* tdata)
+{
+    // 发送失败时 pjsip 内部会释放 tdata，结果以 503 返回
+    SipResponse response = co_await SipTransaction::send(endpt, tdata);
+    if (response.status_code == PJSIP_SC_SERVICE_UNAVAILABLE && response.status != PJ_SUCCESS)
+    {
+        LOG(ERROR) << "Failed to send keepalive, error: " << PjSipUtils::getPjStatusString(response.status);
+    }
+    if (auto shared_this = weak_this.lock())
+    {
+        shared_this->handleKeepaliveResult(handle, response.status_code, response.received);
+    }
+}
+
+void SipKeepalive::handleKeepaliveResult(RegHandle handle, int status_code, bool received)
+{
+    auto& registry = domain_manager_.getRegRegistry();
+    auto domain_id = registry.sipId(handle);
+    if (!domain_id || handle.index >= slot_count_)
+    {
+        return;
+    }
+
+    SipFailover::getInstance(domain_manager_)->onTransactionResult(*domain_id, received);
+
+    if (status_code == PJSIP_SC_OK)
+    {
+        missed_[handle.index] = 0;
+        return;
+    }
+
+    uint32_t missed = missed_[handle.index].fetch_add(1) + 1;
+    LOG(WARNING) << "Keepalive to " << *domain_id << " failed with code " << status_code
+                 << ", missed: " << missed;
+    if (missed >= static_cast<uint32_t>(GCONF(getKeepaliveMaxMissed)))
+    {
+        // 连续丢失达到上限，认为上级已失联，交给 registerProc 重新注册
+        if (registry.transition(handle, RegState::REGISTERED, RegState::UNREGISTERED))
+        {
+            LOG(WARNING) << "Superior " << *domain_id << " missed " << missed
+                         << " keepalives, marked unregistered";
+        }
+        untrack(handle);
+    }
+}
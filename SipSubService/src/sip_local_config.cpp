@@ -22,6 +22,12 @@ bool SipLocalConfig::readConf()
     
     // 保存本地服务器配置
     local_ip_ = *local_ip_opt;
+    local_port_ = *local_port_opt;
+    // 管理接口默认只监听回环地址
+    if (auto admin_ip_opt = conf_reader_.getString("local_server", "admin_ip"))
+    {
+        admin_ip_ = *admin_ip_opt;
+    }
     
     // 读取并校验 SIP 服务配置
     auto sip_id_opt = conf_reader_.getString("sip_server", "sip_id", &err);
@@ -41,6 +47,44 @@ bool SipLocalConfig::readConf()
     sip_port_ = *sip_port_opt;
     supnode_num_ = *supnode_num_opt;
 
+    // 心跳配置为可选项，缺省时使用 GB28181 推荐值
+    if (auto interval_opt = conf_reader_.getInt("sip_server", "keepalive_interval"))
+    {
+        keepalive_interval_ = *interval_opt > 0 ? *interval_opt : keepalive_interval_;
+    }
+    if (auto missed_opt = conf_reader_.getInt("sip_server", "keepalive_max_missed"))
+    {
+        keepalive_max_missed_ = *missed_opt > 0 ? *missed_opt : keepalive_max_missed_;
+    }
+    if (auto idle_opt = conf_reader_.getInt("sip_server", "tcp_idle_timeout"))
+    {
+        tcp_idle_timeout_ = *idle_opt > 0 ? *idle_opt : tcp_idle_timeout_;
+    }
+
+    // 主备切换配置（可选）：failover_mode = active_standby | independent
+    if (auto mode_opt = conf_reader_.getString("sip_server", "failover_mode"))
+    {
+        active_standby_ = (*mode_opt == "active_standby");
+    }
+    if (auto detect_opt = conf_reader_.getInt("sip_server", "failover_detect_ms"))
+    {
+        failover_detect_ms_ = *detect_opt > 0 ? *detect_opt : failover_detect_ms_;
+    }
+    if (auto probe_opt = conf_reader_.getInt("sip_server", "probe_interval_ms"))
+    {
+        probe_interval_ms_ = *probe_opt > 0 ? *probe_opt : probe_interval_ms_;
+    }
+    if (auto hold_opt = conf_reader_.getInt("sip_server", "failback_hold_sec"))
+    {
+        failback_hold_sec_ = *hold_opt >= 0 ? *hold_opt : failback_hold_sec_;
+    }
+    if (!readThreadPlacement() || !readPoolAutoscale())
+    {
+        return false;
+    }
+    readLogRateLimit();
+    readPoolStats();
+
     int num = *supnode_num_opt;
     if (num <= 0) 
     {
@@ -110,3 +154,79 @@ bool SipLocalConfig::readConf()
     return true;
 }
 
+bool SipLocalConfig::readThreadPlacement()
+{
+    // [thread_placement] 为可选段，缺省时所有线程不绑定 CPU
+    for (size_t i = 0; i < static_cast<size_t>(ThreadRole::COUNT); ++i)
+    {
+        auto role = static_cast<ThreadRole>(i);
+        auto cpus_opt = conf_reader_.getString("thread_placement", ThreadPlacement::roleName(role));
+        if (!cpus_opt)
+        {
+            continue;
+        }
+        std::string err;
+        if (!ThreadPlacement::parseCpuList(*cpus_opt, thread_placement_.cpusFor(role), &err))
+        {
+            LOG(ERROR) << "Failed to load thread_placement." << ThreadPlacement::roleName(role) << ": " << err;
+            return false;
+        }
+    }
+    if (auto numa_opt = conf_reader_.getInt("thread_placement", "numa_local_alloc"))
+    {
+        thread_placement_.numa_local_alloc = *numa_opt != 0;
+    }
+    return true;
+}
+
+bool SipLocalConfig::readPoolAutoscale()
+{
+    // [thread_pool] 为可选段，缺省时线程池大小固定
+    if (auto opt = conf_reader_.getInt("thread_pool", "autoscale"))
+        pool_autoscale_.enabled = *opt != 0;
+    if (auto opt = conf_reader_.getInt("thread_pool", "min_threads"))
+        pool_autoscale_.min_threads = *opt > 0 ? static_cast<size_t>(*opt) : 0;
+    if (auto opt = conf_reader_.getInt("thread_pool", "max_threads"))
+        pool_autoscale_.max_threads = *opt > 0 ? static_cast<size_t>(*opt) : 0;
+    if (auto opt = conf_reader_.getInt("thread_pool", "grow_queue_per_thread"))
+        pool_autoscale_.grow_queue_per_thread = *opt > 0 ? static_cast<size_t>(*opt) : pool_autoscale_.grow_queue_per_thread;
+    if (auto opt = conf_reader_.getInt("thread_pool", "grow_wait_p99_ms"))
+        pool_autoscale_.grow_wait_p99_ms = *opt;
+    if (auto opt = conf_reader_.getInt("thread_pool", "shrink_wait_p99_ms"))
+        pool_autoscale_.shrink_wait_p99_ms = *opt;
+    if (auto opt = conf_reader_.getInt("thread_pool", "shrink_cooldown_ms"))
+        pool_autoscale_.shrink_cooldown_ms = *opt;
+    if (auto opt = conf_reader_.getInt("thread_pool", "interval_ms"))
+        pool_autoscale_.interval_ms = *opt;
+
+    if (pool_autoscale_.max_threads != 0 && pool_autoscale_.max_threads < pool_autoscale_.min_threads)
+    {
+        LOG(ERROR) << "thread_pool.max_threads must not be less than min_threads";
+        return false;
+    }
+    return true;
+}
+
+void SipLocalConfig::readLogRateLimit()
+{
+    // [log] 为可选段：限流按每分钟行数配置，汇总周期以秒为单位
+    if (auto opt = conf_reader_.getInt("log", "rate_per_min"))
+        log_rate_limit_.rate_per_sec = *opt >= 0 ? *opt / 60.0 : log_rate_limit_.rate_per_sec;
+    if (auto opt = conf_reader_.getInt("log", "burst"))
+        log_rate_limit_.burst = *opt > 0 ? *opt : log_rate_limit_.burst;
+    if (auto opt = conf_reader_.getInt("log", "summary_sec"))
+        log_rate_limit_.summary_interval_ms = *opt > 0 ? *opt * 1000 : log_rate_limit_.summary_interval_ms;
+    if (auto opt = conf_reader_.getInt("log", "max_keys"))
+        log_rate_limit_.max_keys = *opt > 0 ? static_cast<size_t>(*opt) : log_rate_limit_.max_keys;
+    if (auto opt = conf_reader_.getInt("log", "info_sample"))
+        log_rate_limit_.sample_every = *opt > 0 ? static_cast<uint32_t>(*opt) : log_rate_limit_.sample_every;
+}
+
+void SipLocalConfig::readPoolStats()
+{
+    // [pool_stats] 为可选段，采集周期以秒为单位，0 关闭
+    if (auto opt = conf_reader_.getInt("pool_stats", "interval_sec"))
+        pool_stats_.interval_ms = *opt >= 0 ? *opt * 1000 : pool_stats_.interval_ms;
+    if (auto opt = conf_reader_.getInt("pool_stats", "top_pools"))
+        pool_stats_.top_pools = *opt > 0 ? static_cast<size_t>(*opt) : pool_stats_.top_pools;
+}
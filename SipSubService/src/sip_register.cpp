@@ -2,12 +2,18 @@
 #include "sip_register.h"
 #include "global_ctl.h"
 #include "pjsip_utils.h"
+#include "sip_keepalive.h"
+#include "sip_failover.h"
+#include "tcp_conn_manager.h"
+#include "metrics.h"
+#include "log_rate_limit.h"
 #include <array>
 #include <chrono>
 #include <ctime>
 #include <sys/sysinfo.h>
 #include <exception>
 #include <unordered_map>
+#include <shared_mutex>
 
 // 新增 AuthCache 结构体：
 // 用于存储每个域的认证信息，包括从401响应中提取的realm。
@@ -20,6 +26,32 @@ struct AuthCache
     time_t last_update { 0 };
 };
 
+namespace {
+    // 向上级发起注册的指标，首次使用时注册
+    struct RegisterMetrics
+    {
+        Counter& sent;
+        Counter& accepted;
+        Counter& challenged;
+        Counter& rejected;
+    };
+
+    RegisterMetrics& registerMetrics()
+    {
+        static RegisterMetrics metrics = [] {
+            auto registry = MetricsRegistry::getInstance();
+            const std::string help = "REGISTER responses from upper domains by result";
+            return RegisterMetrics{
+                registry->counter("sip_register_sent_total", "REGISTER requests sent to upper domains"),
+                registry->counter("sip_register_responses_total", help, {{"result", "accepted"}}),
+                registry->counter("sip_register_responses_total", help, {{"result", "challenged"}}),
+                registry->counter("sip_register_responses_total", help, {{"result", "rejected"}}),
+            };
+        }();
+        return metrics;
+    }
+}
+
 std::shared_ptr<SipRegister> SipRegister::instance_ = nullptr;
 std::mutex SipRegister::instance_mutex_;
 
@@ -36,11 +68,10 @@ std::shared_ptr<SipRegister> SipRegister::getInstance(IDomainManager& domain_man
 }
 
 SipRegister::SipRegister(IDomainManager& domain_manager)
-    : reg_timer_(std::make_shared<TaskTimer>())
+    : reg_timer_(std::make_shared<TaskTimer>("sub-register"))
     , domain_manager_(domain_manager)
 {
     reg_timer_->setInterval(3000);
-    reg_timer_->start();
 }
 
 SipRegister::~SipRegister()
@@ -76,7 +107,7 @@ bool SipRegister::extractAuthInfo(pjsip_rx_data* rdata, const std::string& domai
     if (auth_hdr->challenge.digest.realm.slen > 0) {
         auth_cache.realm = std::string(auth_hdr->challenge.digest.realm.ptr, 
                                       auth_hdr->challenge.digest.realm.slen);
-        LOG(INFO) << "Extracted realm: " << auth_cache.realm << " for domain: " << domain_id;
+        LOG(DEBUG) << "Extracted realm: " << auth_cache.realm << " for domain: " << domain_id;
     } else {
         LOG(WARNING) << "No realm in WWW-Authenticate header for domain: " << domain_id;
         return false;
@@ -86,14 +117,14 @@ bool SipRegister::extractAuthInfo(pjsip_rx_data* rdata, const std::string& domai
     if (auth_hdr->challenge.digest.nonce.slen > 0) {
         auth_cache.nonce = std::string(auth_hdr->challenge.digest.nonce.ptr, 
                                       auth_hdr->challenge.digest.nonce.slen);
-        LOG(INFO) << "Extracted nonce: " << auth_cache.nonce << " for domain: " << domain_id;
+        LOG(DEBUG) << "Extracted nonce: " << auth_cache.nonce << " for domain: " << domain_id;
     }
 
     // 提取opaque
     if (auth_hdr->challenge.digest.opaque.slen > 0) {
         auth_cache.opaque = std::string(auth_hdr->challenge.digest.opaque.ptr, 
                                        auth_hdr->challenge.digest.opaque.slen);
-        LOG(INFO) << "Extracted opaque: " << auth_cache.opaque << " for domain: " << domain_id;
+        LOG(DEBUG) << "Extracted opaque: " << auth_cache.opaque << " for domain: " << domain_id;
     }
 
     auth_cache.has_auth_info = true;
@@ -107,19 +138,24 @@ void SipRegister::startRegService()
     LOG(INFO) << "Starting registration service";
     if (reg_timer_)
     {
+        // 注册处理需要调用 PJSIP：挂在端点定时器堆上，直接在事件循环线程执行，
+        // 端点不可用时退回独立的定时器线程
+        reg_timer_->setEndpoint(GlobalCtl::getInstance().getSipCore().getEndPoint(),
+            []() { GlobalCtl::getInstance().getSipCore().wakeup(); });
         auto self = shared_from_this();
         reg_timer_->addTask([weak_this = std::weak_ptr<SipRegister>(self)]() {
             if (auto shared_this = weak_this.lock())
             {
                 try {
                     shared_this->registerProc();
-                    LOG(INFO) << "Registration task executed";
+                    LOG(DEBUG) << "Registration task executed";
                 } catch (const std::exception& e) {
                     LOG(ERROR) << "Error in registration task: " << e.what();
                     throw;
                 }
             }
         });
+        reg_timer_->start();
         LOG(INFO) << "Registration timer started successfully";
     }
     else
@@ -129,64 +165,96 @@ void SipRegister::startRegService()
 }
 
 // 回调函数增加对401响应的处理
+// 令牌是 RegHandle 编码，回调在PJSIP线程中无锁校验代数并迁移状态
 static void client_cb(struct pjsip_regc_cbparam *param)
 {
     LOG(INFO) << "Registration response code: " << param->code;
-    
-    auto* domain = (DomainInfo*)param->token;
-    if (!domain) {
-        LOG(ERROR) << "Invalid domain token in registration callback";
+
+    auto& registry = GlobalCtl::getInstance().getRegRegistry();
+    RegHandle handle = RegHandle::fromToken(param->token);
+    auto domain_id_ptr = registry.sipId(handle);
+    if (!domain_id_ptr) {
+        LOG(WARNING) << "Stale or invalid registration token in callback, dropped"
+                     << " (index=" << handle.index << ", generation=" << handle.generation << ")";
         return;
     }
-    
-    std::string domain_id = domain->sip_id;
-    
+
+    const std::string& domain_id = *domain_id_ptr;
+    auto failover = SipFailover::getInstance(GlobalCtl::getInstance());
+    // 有 rdata 说明收到了对端的响应，否则是本地生成的超时或传输错误
+    failover->onTransactionResult(domain_id, param->rdata != nullptr);
+
     if (param->code == 200) {
-        domain->registered = true;
-        LOG(INFO) << "domain.registered = true";
-        LOG(INFO) << "Registered successfully for domain: " << domain_id;
+        registerMetrics().accepted.inc();
+        // 主备切换前已在途的刷新：该上级已不是活动上级，不再视为已注册
+        RegState next = (param->is_unreg || param->expiration == 0 || !failover->isActive(domain_id))
+            ? RegState::UNREGISTERED : RegState::REGISTERED;
+        registry.store(handle, next);
+        LOG(INFO) << "Registration state of domain " << domain_id << " -> " << regStateName(next);
+        if (next == RegState::REGISTERED)
+        {
+            // 注册成功后开始按周期发送心跳
+            SipKeepalive::getInstance(GlobalCtl::getInstance())->track(handle);
+        }
     } 
     else if (param->code == 401) {
         LOG(INFO) << "Received 401 Unauthorized for domain: " << domain_id;
+        registerMetrics().challenged.inc();
         LOG(INFO) << "Will extract authentication information for next attempt";
         
         // 修改这里的调用方式
         auto sipRegister = SipRegister::getInstance(GlobalCtl::getInstance());
         sipRegister->extractAuthInfo(param->rdata, domain_id);
+        registry.store(handle, RegState::UNREGISTERED);
     }else {
-        LOG(WARNING) << "Registration failed with code " << param->code 
+        registerMetrics().rejected.inc();
+        // 上级不可达或拒绝时每个注册周期都会失败，按域限流
+        LOG_LIMITED(WARNING, domain_id) << "Registration failed with code " << param->code 
                    << " for domain: " << domain_id;
+        registry.store(handle, RegState::FAILED);
     }
 }
 
 void SipRegister::registerProc()
 {
-    LOG(INFO) << "registerProc called";
+    LOG(DEBUG) << "registerProc called";
     PjSipUtils::ThreadRegistrar thread_registrar;
     std::lock_guard<std::mutex> lock(register_mutex_);
-    auto& domains = GlobalCtl::getInstance().getDomainInfoList();
-    LOG(INFO) << "DomainInfoList size: " << domains.size();
+    std::shared_lock<std::shared_mutex> domain_lock(domain_manager_.getMutex());
+    auto& domains = domain_manager_.getDomainInfoList();
+    auto& registry = domain_manager_.getRegRegistry();
+    auto failover = SipFailover::getInstance(domain_manager_);
+    LOG(DEBUG) << "DomainInfoList size: " << domains.size();
     if (domains.empty())
     {
         LOG(WARNING) << "No domains to register. Check configuration.";
         return;
     }
-    for (auto& domain : domains)
+    for (size_t i = 0; i < domains.size(); ++i)
     {
-        if (!domain.registered)
+        auto& domain = domains[i];
+        // 主备模式下只向活动上级注册
+        if (!failover->isActive(i))
         {
-            LOG(INFO) << "Registering domain: " << domain.sip_id;
+            continue;
+        }
+        // 只有 UNREGISTERED/FAILED 状态才发起注册，CAS 保证同一域不会重复发送
+        if (registry.transition(domain.reg_handle, RegState::UNREGISTERED, RegState::REGISTERING) ||
+            registry.transition(domain.reg_handle, RegState::FAILED, RegState::REGISTERING))
+        {
+            LOG(DEBUG) << "Registering domain: " << domain.sip_id;
             if (gbRegister(domain) != PJ_SUCCESS)
             {
-                LOG(ERROR) << "gbRegister failed for domain: " << domain.sip_id;
+                LOG_LIMITED(ERROR, domain.sip_id) << "gbRegister failed for domain: " << domain.sip_id;
+                registry.transition(domain.reg_handle, RegState::REGISTERING, RegState::FAILED);
             }
         }
     }
 }
 
-pj_status_t SipRegister::gbRegister(DomainInfo& domains)
+pj_status_t SipRegister::gbRegister(const DomainInfo& domains)
 {
-    LOG(INFO) << "gbRegister called for domains: " << domains.sip_id;
+    LOG(DEBUG) << "gbRegister called for domains: " << domains.sip_id;
     auto& config = GlobalCtl::getInstance().getConfig();
     pj_status_t status = PJ_SUCCESS;
     
@@ -229,16 +297,21 @@ pj_status_t SipRegister::gbRegister(DomainInfo& domains)
         pj_str_t contact = pj_str(contact_buf);
         pj_str_t req_line = pj_str(req_buf);
 
-        if (domains.expires <= 0)
+        // registerProc 只持有读锁，这里不回写 domains.expires
+        int expires = domains.expires;
+        if (expires <= 0)
         {
             LOG(WARNING) << "Domain expires is invalid or zero, using default 3600";
-            domains.expires = 3600;
+            expires = 3600;
         }
 
+        // 每次注册都新建 regc，上一次的 regc（及其池和自动刷新定时器）在这里释放
+        releaseRegc(domains.sip_id);
+
         pjsip_regc* regc;
         status = pjsip_regc_create(
             GlobalCtl::getInstance().getSipCore().getEndPoint().get(),
-            &domains, // 传递domains指针作为token
+            domains.reg_handle.toToken(), // 传递槽位句柄作为token，避免悬空指针
             &client_cb,
             &regc);
         if (status != PJ_SUCCESS || !regc)
@@ -248,7 +321,7 @@ pj_status_t SipRegister::gbRegister(DomainInfo& domains)
             break;
         }
 
-        status = pjsip_regc_init(regc, &req_line, &from, &to, 1, &contact, domains.expires);
+        status = pjsip_regc_init(regc, &req_line, &from, &to, 1, &contact, expires);
         if (status != PJ_SUCCESS)
         {
             LOG(ERROR) << "pjsip_regc_init failed, code: " << status
@@ -257,6 +330,12 @@ pj_status_t SipRegister::gbRegister(DomainInfo& domains)
             break;
         }
 
+        // TCP 上级复用同一条长连接
+        if (domains.proto == 1)
+        {
+            TcpConnManager::getInstance()->bindRegc(regc, domains.sip_id, domains.addr_ip, domains.sip_port);
+        }
+
         if(domains.isAuth)
         {
             pjsip_cred_info cred;
@@ -273,7 +352,7 @@ pj_status_t SipRegister::gbRegister(DomainInfo& domains)
                 auto it = g_auth_cache.find(domains.sip_id);
                 if (it != g_auth_cache.end() && it->second.has_auth_info) {
                     realm_to_use = it->second.realm;
-                    LOG(INFO) << "Using cached realm: " << realm_to_use << " for domain: " << domains.sip_id;
+                    LOG(DEBUG) << "Using cached realm: " << realm_to_use << " for domain: " << domains.sip_id;
                 }
             }
             
@@ -285,7 +364,7 @@ pj_status_t SipRegister::gbRegister(DomainInfo& domains)
                     realm_to_use = "11000000002000000001";
                     LOG(WARNING) << "Using default realm: " << realm_to_use << " for domain: " << domains.sip_id;
                 } else {
-                    LOG(INFO) << "Using configured realm: " << realm_to_use << " for domain: " << domains.sip_id;
+                    LOG(DEBUG) << "Using configured realm: " << realm_to_use << " for domain: " << domains.sip_id;
                 }
             }
             
@@ -317,8 +396,8 @@ pj_status_t SipRegister::gbRegister(DomainInfo& domains)
             cred.data_type = PJSIP_CRED_DATA_PLAIN_PASSWD;
             cred.data = pj_str(password_buf.data());
             
-            LOG(INFO) << "Setting auth credentials for domain: " << domains.sip_id;
-            LOG(INFO) << "Realm: " << realm_to_use << ", Username: " << username;
+            LOG(DEBUG) << "Setting auth credentials for domain: " << domains.sip_id;
+            LOG(DEBUG) << "Realm: " << realm_to_use << ", Username: " << username;
 
             status = pjsip_regc_set_credentials(regc, 1, &cred);
             if(status != PJ_SUCCESS)
@@ -352,12 +431,76 @@ pj_status_t SipRegister::gbRegister(DomainInfo& domains)
             break;
         }
         
+        regcs_[domains.sip_id] = regc;
+        registerMetrics().sent.inc();
         LOG(INFO) << "REGISTER sent successfully for domain: " << domains.sip_id;
     } while (0);
     
     return status;
 }
 
+void SipRegister::releaseRegc(const std::string& domain_id, bool unregister)
+{
+    auto it = regcs_.find(domain_id);
+    if (it == regcs_.end())
+    {
+        return;
+    }
+    pjsip_regc* regc = it->second;
+    regcs_.erase(it);
+    if (unregister)
+    {
+        // 注销同时撤下自动刷新定时器；有事务在途时 pjsip 返回忙，直接销毁即可
+        pjsip_tx_data* tdata { nullptr };
+        pj_status_t status = pjsip_regc_unregister(regc, &tdata);
+        if (status == PJ_SUCCESS)
+        {
+            status = pjsip_regc_send(regc, tdata);
+        }
+        if (status != PJ_SUCCESS)
+        {
+            LOG(WARNING) << "Failed to unregister from domain: " << domain_id
+                         << ", error: " << PjSipUtils::getPjStatusString(status);
+        }
+        else
+        {
+            LOG(INFO) << "Unregister sent for domain: " << domain_id;
+        }
+    }
+    // 事务仍在进行（回调尚未返回）时 pjsip 只做标记，等事务结束后再释放
+    pjsip_regc_destroy(regc);
+}
+
+void SipRegister::runOnRegisterThread(std::function<void(SipRegister&)> task)
+{
+    // 注册定时器使用端点后端时任务直接在事件循环线程执行，regcs_ 只在该线程上修改
+    reg_timer_->scheduleOnce(TaskTimer::Duration(0),
+        [weak_this = weak_from_this(), task = std::move(task)]() {
+            if (auto shared_this = weak_this.lock())
+            {
+                try {
+                    task(*shared_this);
+                } catch (const std::exception& e) {
+                    LOG(ERROR) << "Error in registration task: " << e.what();
+                }
+            }
+        });
+}
+
+void SipRegister::registerNow()
+{
+    runOnRegisterThread([](SipRegister& self) { self.registerProc(); });
+}
+
+void SipRegister::unregisterNow(const std::string& domain_id)
+{
+    runOnRegisterThread([domain_id](SipRegister& self) {
+        PjSipUtils::ThreadRegistrar thread_registrar;
+        std::lock_guard<std::mutex> lock(self.register_mutex_);
+        self.releaseRegc(domain_id, true);
+    });
+}
+
 // 新增：将PJSIP错误码转换为字符串描述的实用方法
 std::string PjSipUtils::getPjStatusString(pj_status_t status) {
     static char buf[PJ_ERR_MSG_SIZE];
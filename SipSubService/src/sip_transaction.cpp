@@ -0,0 +1,199 @@
+// sip_transaction.cpp
+#include "sip_transaction.h"
+#include "ev_thread.h"
+#include "pjsip_utils.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    SipResponse cancelledResponse()
+    {
+        SipResponse response;
+        response.status = PJ_ECANCELLED;
+        response.status_code = PJSIP_SC_REQUEST_TERMINATED;
+        response.reason = "Request Terminated";
+        response.cancelled = true;
+        return response;
+    }
+}
+
+struct SipTransaction::Table
+{
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<Pending>> pending;
+    uint64_t next_id { 0 };
+};
+
+SipTransaction::Table& SipTransaction::table()
+{
+    static Table instance;
+    return instance;
+}
+
+uint64_t SipTransaction::add(const std::shared_ptr<Pending>& pending)
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    pending->id = ++t.next_id;
+    t.pending.emplace(pending->id, pending);
+    return pending->id;
+}
+
+std::shared_ptr<SipTransaction::Pending> SipTransaction::take(uint64_t id)
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    auto it = t.pending.find(id);
+    if (it == t.pending.end())
+    {
+        return nullptr;
+    }
+    auto pending = std::move(it->second);
+    t.pending.erase(it);
+    return pending;
+}
+
+size_t SipTransaction::inFlight()
+{
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    return t.pending.size();
+}
+
+bool SipTransaction::Awaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    pending_ = std::make_shared<Pending>();
+    pending_->handle = handle;
+    pending_->keep_message = options_.keep_message;
+    pending_->resume_class = options_.resume_class;
+
+    if (!endpt_ || !tdata_)
+    {
+        LOG(ERROR) << "SipTransaction::send: endpoint or tdata is null";
+        if (tdata_)
+        {
+            pjsip_tx_data_dec_ref(tdata_);
+        }
+        SipResponse response;
+        response.status = PJ_EINVAL;
+        response.status_code = PJSIP_SC_SERVICE_UNAVAILABLE;
+        complete(pending_, std::move(response), false);
+        return false;
+    }
+    if (options_.token.isCancelled())
+    {
+        pjsip_tx_data_dec_ref(tdata_);
+        complete(pending_, cancelledResponse(), false);
+        return false;
+    }
+
+    // 以下只使用局部副本：取消回调或响应回调可能在其他线程恢复协程，awaiter 随时失效
+    std::shared_ptr<Pending> pending = pending_;
+    SipTypes::EndpointPtr endpt = endpt_;
+    pjsip_tx_data* tdata = tdata_;
+    int timeout_ms = options_.timeout_ms;
+    CancellationToken token = options_.token;
+
+    uint64_t id = add(pending);
+    if (token.cancellable())
+    {
+        pending->cancel_id = token.onCancel([pending]() {
+            take(pending->id);
+            complete(pending, cancelledResponse(), true);
+        });
+        if (pending->completed.load(std::memory_order_acquire))
+        {
+            // 注册时已被取消，协程已由取消回调恢复，请求不再发出
+            pjsip_tx_data_dec_ref(tdata);
+            return true;
+        }
+    }
+
+    pj_status_t status = pjsip_endpt_send_request(endpt.get(), tdata, timeout_ms,
+        reinterpret_cast<void*>(static_cast<uintptr_t>(id)), &SipTransaction::onTsxComplete);
+    if (status == PJ_SUCCESS)
+    {
+        return true;
+    }
+
+    // 发送失败时 pjsip 已释放 tdata，且可能已经以传输错误调用过回调；
+    // 回调或取消抢先完成时由它们恢复协程，否则不挂起直接返回错误
+    LOG(ERROR) << "SipTransaction::send failed: " << PjSipUtils::getPjStatusString(status);
+    take(id);
+    SipResponse response;
+    response.status = status;
+    response.status_code = PJSIP_SC_SERVICE_UNAVAILABLE;
+    return !complete(pending, std::move(response), false);
+}
+
+SipResponse SipTransaction::Awaiter::await_resume()
+{
+    uint64_t cancel_id = pending_->cancel_id.load(std::memory_order_acquire);
+    if (cancel_id)
+    {
+        options_.token.removeCallback(cancel_id);
+    }
+    return std::move(pending_->response);
+}
+
+void SipTransaction::onTsxComplete(void* token, pjsip_event* e)
+{
+    auto pending = take(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(token)));
+    if (!pending)
+    {
+        // 已被取消或已按同步失败处理，迟到的结果直接忽略
+        return;
+    }
+
+    SipResponse response;
+    pjsip_transaction* tsx = (e && e->type == PJSIP_EVENT_TSX_STATE) ? e->body.tsx_state.tsx : nullptr;
+    if (tsx)
+    {
+        response.status_code = tsx->status_code;
+        if (tsx->status_text.ptr && tsx->status_text.slen > 0)
+        {
+            response.reason.assign(tsx->status_text.ptr, tsx->status_text.slen);
+        }
+        response.received = e->body.tsx_state.type == PJSIP_EVENT_RX_MSG;
+        if (pending->keep_message && response.received)
+        {
+            response.rdata = PjSipUtils::cloneRxData(e->body.tsx_state.src.rdata);
+        }
+    }
+    else
+    {
+        response.status_code = PJSIP_SC_REQUEST_TIMEOUT;
+    }
+    if (response.status_code == PJSIP_SC_REQUEST_TIMEOUT)
+    {
+        response.status = PJ_ETIMEDOUT;
+    }
+    complete(pending, std::move(response), true);
+}
+
+bool SipTransaction::complete(const std::shared_ptr<Pending>& pending, SipResponse&& response, bool schedule)
+{
+    if (pending->completed.exchange(true, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+    pending->response = std::move(response);
+    if (schedule)
+    {
+        resume(pending);
+    }
+    return true;
+}
+
+void SipTransaction::resume(const std::shared_ptr<Pending>& pending)
+{
+    std::coroutine_handle<> handle = pending->handle;
+    try {
+        EVThread::getThreadPool().post(pending->resume_class, [handle]() { handle.resume(); });
+    } catch (const std::exception& e) {
+        // 线程池已停止（进程退出过程中），直接在当前线程恢复
+        LOG(WARNING) << "SipTransaction: resume inline, " << e.what();
+        handle.resume();
+    }
+}
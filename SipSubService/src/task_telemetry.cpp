@@ -0,0 +1,150 @@
+// task_telemetry.cpp
+#include "task_telemetry.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+    thread_local TaskRecord* tls_current_record = nullptr;
+}
+
+const char* trafficClassName(TrafficClass cls)
+{
+    switch (cls)
+    {
+        case TrafficClass::SIGNALING:  return "signaling";
+        case TrafficClass::CONTROL:    return "control";
+        case TrafficClass::BULK:       return "bulk";
+        case TrafficClass::BACKGROUND: return "background";
+        default:                       return "unknown";
+    }
+}
+
+size_t LatencyHistogram::bucketOf(int64_t ns)
+{
+    if (ns <= 0) return 0;
+    size_t bucket = 64 - static_cast<size_t>(__builtin_clzll(static_cast<uint64_t>(ns)));
+    return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (size_t i = 0; i < BUCKETS; ++i)
+    {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+}
+
+int64_t LatencyHistogram::percentileNs(double p) const
+{
+    if (count == 0) return 0;
+    uint64_t target = static_cast<uint64_t>(p * static_cast<double>(count));
+    if (target >= count) target = count - 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i)
+    {
+        seen += buckets[i];
+        if (seen > target)
+        {
+            return i == 0 ? 0 : (int64_t(1) << i) - 1;
+        }
+    }
+    return (int64_t(1) << (BUCKETS - 1)) - 1;
+}
+
+void TaskTelemetryRing::AtomicHistogram::add(int64_t ns)
+{
+    // 单写者，relaxed 即可
+    auto& bucket = buckets[LatencyHistogram::bucketOf(ns)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void TaskTelemetryRing::AtomicHistogram::load(LatencyHistogram& out) const
+{
+    for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i)
+    {
+        uint64_t n = buckets[i].load(std::memory_order_relaxed);
+        out.buckets[i] += n;
+        out.count += n;
+    }
+}
+
+void TaskTelemetryRing::record(const TaskRecord& record)
+{
+    uint64_t index = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index & (CAPACITY - 1)];
+
+    uint64_t version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.record = record;
+    slot.record.seq = index + 1;
+    slot.version.store(version + 2, std::memory_order_release);
+
+    head_.store(index + 1, std::memory_order_release);
+
+    queue_wait_.add(record.queueWaitNs());
+    class_queue_wait_[static_cast<size_t>(record.traffic_class) % TRAFFIC_CLASS_COUNT].add(record.queueWaitNs());
+    if (record.state == ThreadState::CANCELLED)
+    {
+        // 被丢弃的任务没有执行，不计入执行耗时
+        cancelled_.store(cancelled_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    run_time_.add(record.runNs());
+    auto& counter = record.state == ThreadState::FAILED ? failed_ : completed_;
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void TaskTelemetryRing::collect(TaskTelemetrySnapshot& snapshot, size_t max_records) const
+{
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t available = head < CAPACITY ? head : CAPACITY;
+    uint64_t wanted = available < max_records ? available : max_records;
+
+    for (uint64_t n = 0; n < wanted; ++n)
+    {
+        uint64_t seq = head - n;
+        const Slot& slot = slots_[(seq - 1) & (CAPACITY - 1)];
+
+        uint64_t before = slot.version.load(std::memory_order_acquire);
+        if (before & 1) continue;   // 正在写入
+        TaskRecord copy = slot.record;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.version.load(std::memory_order_relaxed);
+        // 版本变化或已被更新的记录覆盖，丢弃
+        if (before != after || copy.seq != seq) continue;
+        snapshot.recent.push_back(copy);
+    }
+
+    queue_wait_.load(snapshot.queue_wait);
+    run_time_.load(snapshot.run_time);
+    for (size_t cls = 0; cls < TRAFFIC_CLASS_COUNT; ++cls)
+    {
+        class_queue_wait_[cls].load(snapshot.class_queue_wait[cls]);
+    }
+    snapshot.completed += completed_.load(std::memory_order_relaxed);
+    snapshot.failed += failed_.load(std::memory_order_relaxed);
+    snapshot.cancelled += cancelled_.load(std::memory_order_relaxed);
+}
+
+void TaskTelemetry::setCurrent(TaskRecord* record)
+{
+    tls_current_record = record;
+}
+
+void TaskTelemetry::reportError(const char* what)
+{
+    TaskRecord* record = tls_current_record;
+    if (!record) return;
+    record->state = ThreadState::FAILED;
+    std::strncpy(record->error, what ? what : "", TaskRecord::ERROR_SIZE - 1);
+    record->error[TaskRecord::ERROR_SIZE - 1] = '\0';
+}
+
+int64_t TaskTelemetry::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
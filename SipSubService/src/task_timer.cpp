@@ -1,149 +1,568 @@
-// task_timer.cpp - 使用EVThread修改版
+// task_timer.cpp - 定时器运行在独立的服务线程上，到期任务在执行器中运行
 #include "task_timer.h"
-#include "pjsip_utils.h"
-#include "ev_thread.h" // 引入EVThread
+#include "ev_thread.h"
+#include "ev_thread_pool.h"
+#include "thread_placement.h"
+#include <algorithm>
 #include <chrono>
 
-TaskTimer::TaskTimer()
-    : timer_thread_id_(std::make_shared<std::atomic<std::thread::id>>()), 
-      timer_future_(std::make_shared<std::future<void>>())
+namespace {
+    constexpr uint64_t NS_PER_MS = 1000000;
+    constexpr unsigned int LEVEL_BITS = 8;
+
+    // 全局定时器登记表，仅用于统计查询
+    std::mutex registry_mutex;
+    std::vector<TaskTimer*> registry;
+}
+
+TaskTimer::TaskTimer(std::string name, ThreadPool* executor)
+    : heads_(LEVELS * SLOTS, NIL)
+    , epoch_(std::chrono::steady_clock::now())
+    , executor_(executor)
+    , name_(std::move(name))
 {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.push_back(this);
 }
 
 TaskTimer::~TaskTimer() {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+    }
     stop();
 }
 
 bool TaskTimer::start() {
-    LOG(INFO) << "Starting TaskTimer...";
     // 使用互斥锁保护线程创建
     std::lock_guard<std::mutex> lock(thread_mutex_);
-    
+
     // 检查线程是否已在运行
     if (running_) {
         LOG(INFO) << "TaskTimer already running";
         return true;
     }
-    
-    // 重置停止标志
-    stop_requested_ = false;
-    
-    try {
-        // 使用EVThread创建定时器线程
-        *timer_future_ = EVThread::createThread(
-            &TaskTimer::timerLoop,
-            std::make_tuple(this),
-            timer_thread_id_,
-            ThreadPriority::NORMAL
-        );
-        
+
+    // 端点后端由 PJSIP 事件循环驱动，不需要定时器线程
+    if (endpt_) {
         running_ = true;
-        LOG(INFO) << "TaskTimer started successfully with thread ID: " << timer_thread_id_->load();
+        LOG(INFO) << "TaskTimer " << name_ << " running on PJSIP endpoint timer heap";
         return true;
-    } catch (const std::exception& e) {
-        LOG(ERROR) << "Failed to start TaskTimer: " << e.what();
+    }
+
+    // 重置停止标志
+    stop_requested_ = false;
+
+    // 创建独立的定时器线程
+    ServiceThreadOptions options;
+    options.name = name_;
+    options.cpus = ThreadPlacement::getInstance()->cpusFor(ThreadRole::TIMER);
+    thread_ = std::make_unique<ServiceThread>(std::move(options), [this](ServiceThread&) {
+        timerLoop();
+    });
+    thread_->setWakeup([this]() {
+        std::lock_guard<std::mutex> lock(wheel_mutex_);
+        stop_requested_ = true;
+        cv_.notify_all();
+    });
+    if (!thread_->start()) {
+        LOG(ERROR) << "Failed to start TaskTimer " << name_;
+        thread_.reset();
         return false;
     }
+
+    running_ = true;
+    LOG(INFO) << "TaskTimer " << name_ << " started successfully";
+    return true;
 }
 
-void TaskTimer::stop() 
+void TaskTimer::stop()
 {
     LOG(INFO) << "Stopping TaskTimer...";
-    
-    // 只有在运行时才需要停止
-    if (!running_)
-    {
-        LOG(INFO) << "TaskTimer not running, no need to stop";
-        return;
-    }
-    
-    // 发出停止信号
-    stop_requested_ = true;
-    cv_.notify_all();
-    
-    // 等待线程结束或超时
-    try {
-        if (timer_future_ && timer_future_->valid()) {
-            // 等待最多2秒
-            std::chrono::milliseconds timeout(2000);
-            auto status = timer_future_->wait_for(timeout);
-            
-            if (status == std::future_status::timeout) {
-                LOG(WARNING) << "TaskTimer thread did not exit within timeout";
-            } else {
-                LOG(INFO) << "TaskTimer thread exited normally";
-            }
+
+    // 发出停止信号并等待线程结束，最多2秒
+    if (running_ && thread_) {
+        if (thread_->stop(std::chrono::milliseconds(2000))) {
+            LOG(INFO) << "TaskTimer thread exited normally";
+            thread_.reset();
+        } else {
+            LOG(WARNING) << "TaskTimer thread did not exit within timeout";
         }
-    } catch (const std::exception& e) {
-        LOG(ERROR) << "Exception when waiting for timer thread: " << e.what();
     }
-    
-    // 清空任务队列
+
+    // 释放时间轮中的全部定时器，旧句柄随代数递增失效
     {
-        std::lock_guard<std::mutex> lock(task_mutex_);
-        tasks_.clear();
-        LOG(INFO) << "Task queue cleared";
+        std::lock_guard<std::mutex> lock(wheel_mutex_);
+        for (uint32_t i = 0; i < nodes_.size(); ++i) {
+            if (nodes_[i].entry) {
+                releaseEntry(i);
+                freeNode(i);
+            } else if (nodes_[i].slot != NIL) {
+                unlink(i);
+                freeNode(i);
+            }
+        }
+        LOG(INFO) << "Timer wheel cleared";
     }
-    
+
     // 标记为未运行
     running_ = false;
     LOG(INFO) << "TaskTimer stopped successfully";
 }
 
-void TaskTimer::timerLoop() 
+void TaskTimer::timerLoop()
 {
     LOG(INFO) << "Timer thread started, id=" << std::this_thread::get_id();
-    
-    // registerProc处理SIP注册请求，需要线程注册以正确处理SIP协议栈操作
-    PjSipUtils::ThreadRegistrar thread_registrar;
-    
-    // 主定时器循环
+
+    std::vector<Due> due;
+    std::unique_lock<std::mutex> lock(wheel_mutex_);
     while (!stop_requested_) {
-        // 执行所有任务
-        std::vector<Task> current_tasks;
-        {
-            // 复制任务列表以避免长时间持有锁
-            std::lock_guard<std::mutex> lock(task_mutex_);
-            current_tasks = tasks_;
+        // 追到当前时刻：跳过空槽位，只在非空槽位和每圈边界处推进
+        uint64_t now_ns = elapsedNs();
+        uint64_t target = now_ns / (resolution_ms_ * NS_PER_MS);
+        while (now_tick_ < target) {
+            uint64_t next = nextWakeTick();
+            if (next > target) {
+                now_tick_ = target;
+                break;
+            }
+            now_tick_ = next - 1;
+            advanceOne(due, now_ns);
         }
-        
-        // 执行任务
-        for (const auto& task : current_tasks) {
-            if (task && !stop_requested_) 
-            {
-                try {
-                    task();
-                } catch (const std::exception& e) {
-                    LOG(ERROR) << "Exception in timer task: " << e.what();
-                }
+
+        // 派发时不持有锁，任务可以在执行器中再次调度定时器
+        if (!due.empty()) {
+            lock.unlock();
+            for (auto& entry : due) {
+                dispatch(entry);
             }
+            due.clear();
+            lock.lock();
+            continue;
         }
-        
-        // 使用条件变量等待，可快速响应停止请求
-        {
-            std::unique_lock<std::mutex> lock(task_mutex_);
-            cv_.wait_for(lock, std::chrono::milliseconds(interval_ms_),
-                         [this]() { return stop_requested_.load(); });
+
+        wake_tick_ = nextWakeTick();
+        if (wake_tick_ == UINT64_MAX) {
+            cv_.wait(lock);
+        } else {
+            cv_.wait_until(lock, epoch_ + std::chrono::milliseconds(wake_tick_ * resolution_ms_));
         }
+        wake_tick_ = UINT64_MAX;
     }
-    
+
     LOG(INFO) << "Timer thread exiting";
 }
 
-void TaskTimer::addTask(Task task) 
+TimerHandle TaskTimer::scheduleOnce(Duration delay, Task task)
+{
+    return insert(delay, 0, std::move(task));
+}
+
+TimerHandle TaskTimer::scheduleEvery(Duration period, Task task, Duration first_delay)
+{
+    return insert(first_delay.count() < 0 ? period : first_delay, periodTicks(period), std::move(task));
+}
+
+TimerHandle TaskTimer::insert(Duration delay, uint64_t period_ticks, Task task)
+{
+    if (!task) {
+        LOG(WARNING) << "Attempted to schedule empty task on TaskTimer " << name_;
+        return TimerHandle{};
+    }
+    auto job = std::make_shared<Job>();
+    job->task = std::move(task);
+
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    uint32_t index = allocNode();
+    Node& node = nodes_[index];
+    node.period_ticks = period_ticks;
+    node.job = std::move(job);
+    ++size_;
+    if (endpt_) {
+        if (!scheduleEntry(index, delay.count() > 0 ? static_cast<uint64_t>(delay.count()) : 0)) {
+            freeNode(index);
+            return TimerHandle{};
+        }
+        ++stats_.scheduled;
+        if (endpt_wake_) {
+            endpt_wake_();
+        }
+        return TimerHandle{ index, node.generation };
+    }
+    node.expire_tick = std::max(dueTick(delay), now_tick_ + 1);
+    link(index);
+    ++stats_.scheduled;
+    if (node.expire_tick < wake_tick_) {
+        cv_.notify_one();
+    }
+    return TimerHandle{ index, node.generation };
+}
+
+bool TaskTimer::cancel(TimerHandle handle)
+{
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    if (handle.index >= nodes_.size()) return false;
+    Node& node = nodes_[handle.index];
+    if (node.generation != handle.generation) return false;
+    if (node.entry) {
+        releaseEntry(handle.index);
+    } else if (node.slot != NIL) {
+        unlink(handle.index);
+    } else {
+        return false;
+    }
+    freeNode(handle.index);
+    ++stats_.cancelled;
+    return true;
+}
+
+bool TaskTimer::reschedule(TimerHandle handle, Duration delay)
+{
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    if (handle.index >= nodes_.size()) return false;
+    Node& node = nodes_[handle.index];
+    if (node.generation != handle.generation) return false;
+    if (node.entry) {
+        releaseEntry(handle.index);
+        if (!scheduleEntry(handle.index, delay.count() > 0 ? static_cast<uint64_t>(delay.count()) : 0)) {
+            freeNode(handle.index);
+            return false;
+        }
+        if (endpt_wake_) {
+            endpt_wake_();
+        }
+        return true;
+    }
+    if (node.slot == NIL) return false;
+    unlink(handle.index);
+    node.expire_tick = std::max(dueTick(delay), now_tick_ + 1);
+    link(handle.index);
+    if (node.expire_tick < wake_tick_) {
+        cv_.notify_one();
+    }
+    return true;
+}
+
+void TaskTimer::addTask(Task task)
 {
     if (!task) {
         LOG(WARNING) << "Attempted to add empty task to TaskTimer";
         return;
     }
-    
-    std::lock_guard<std::mutex> lock(task_mutex_);
-    tasks_.push_back(std::move(task));
+
+    scheduleEvery(Duration(interval_ms_), std::move(task), Duration(0));
     LOG(INFO) << "Task added to TaskTimer";
 }
 
-void TaskTimer::setInterval(unsigned int ms) 
+void TaskTimer::setInterval(unsigned int ms)
 {
     interval_ms_ = ms;
     LOG(INFO) << "TaskTimer interval set to " << ms << " ms";
-}
\ No newline at end of file
+}
+
+bool TaskTimer::setEndpoint(SipTypes::EndpointPtr endpt, Task wake)
+{
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    if (!endpt || size_ != 0 || running_) {
+        LOG(WARNING) << "TaskTimer " << name_ << ": endpoint backend must be selected before start and scheduling";
+        return false;
+    }
+    if (weak_from_this().expired()) {
+        LOG(ERROR) << "TaskTimer " << name_ << ": endpoint backend requires shared_ptr ownership";
+        return false;
+    }
+    endpt_ = std::move(endpt);
+    endpt_wake_ = std::move(wake);
+    return true;
+}
+
+void TaskTimer::setResolution(unsigned int ms)
+{
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    if (size_ != 0 || ms == 0) {
+        LOG(WARNING) << "TaskTimer resolution can only be changed while empty";
+        return;
+    }
+    resolution_ms_ = ms;
+    now_tick_ = elapsedNs() / (resolution_ms_ * NS_PER_MS);
+}
+
+size_t TaskTimer::pending() const
+{
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    return size_;
+}
+
+TaskTimerStats TaskTimer::stats() const
+{
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    TaskTimerStats stats = stats_;
+    stats.name = name_;
+    stats.endpoint = endpt_ != nullptr;
+    stats.pending = size_;
+    return stats;
+}
+
+std::vector<TaskTimerStats> TaskTimer::allStats()
+{
+    std::vector<TaskTimerStats> result;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    result.reserve(registry.size());
+    for (const TaskTimer* timer : registry)
+    {
+        result.push_back(timer->stats());
+    }
+    return result;
+}
+
+uint32_t TaskTimer::allocNode()
+{
+    if (!free_nodes_.empty()) {
+        uint32_t index = free_nodes_.back();
+        free_nodes_.pop_back();
+        return index;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void TaskTimer::freeNode(uint32_t index)
+{
+    Node& node = nodes_[index];
+    node.job.reset();
+    node.period_ticks = 0;
+    ++node.generation;
+    free_nodes_.push_back(index);
+    --size_;
+}
+
+void TaskTimer::link(uint32_t index)
+{
+    Node& node = nodes_[index];
+    // 按距当前格的跨度选择层级；超出最高层范围的先放在最高层，下沉时重新计算
+    uint64_t delta = node.expire_tick - now_tick_;
+    uint64_t expire = node.expire_tick;
+    size_t level = 0;
+    while (level + 1 < LEVELS && delta >= (uint64_t(1) << (LEVEL_BITS * (level + 1)))) {
+        ++level;
+    }
+    uint64_t span = uint64_t(1) << (LEVEL_BITS * LEVELS);
+    if (delta >= span) {
+        expire = now_tick_ + span - 1;
+    }
+    uint32_t slot = static_cast<uint32_t>(level * SLOTS + ((expire >> (LEVEL_BITS * level)) & (SLOTS - 1)));
+
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = heads_[slot];
+    if (node.next != NIL) {
+        nodes_[node.next].prev = index;
+    }
+    heads_[slot] = index;
+}
+
+void TaskTimer::unlink(uint32_t index)
+{
+    Node& node = nodes_[index];
+    if (node.prev != NIL) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[node.slot] = node.next;
+    }
+    if (node.next != NIL) {
+        nodes_[node.next].prev = node.prev;
+    }
+    node.prev = NIL;
+    node.next = NIL;
+    node.slot = NIL;
+}
+
+void TaskTimer::cascade(size_t level, size_t slot)
+{
+    uint32_t index = heads_[level * SLOTS + slot];
+    heads_[level * SLOTS + slot] = NIL;
+    while (index != NIL) {
+        uint32_t next = nodes_[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+void TaskTimer::advanceOne(std::vector<Due>& due, uint64_t now_ns)
+{
+    ++now_tick_;
+    // 低层转完一圈时，把高层对应槽位下沉
+    if ((now_tick_ & (SLOTS - 1)) == 0) {
+        for (size_t level = 1; level < LEVELS; ++level) {
+            size_t slot = (now_tick_ >> (LEVEL_BITS * level)) & (SLOTS - 1);
+            cascade(level, slot);
+            if (slot != 0) break;
+        }
+    }
+
+    uint32_t slot = static_cast<uint32_t>(now_tick_ & (SLOTS - 1));
+    uint32_t index = heads_[slot];
+    heads_[slot] = NIL;
+    uint64_t tick_ns = resolution_ms_ * NS_PER_MS;
+    while (index != NIL) {
+        Node& node = nodes_[index];
+        uint32_t next = node.next;
+        node.prev = NIL;
+        node.next = NIL;
+        node.slot = NIL;
+
+        uint64_t lag = now_ns > node.expire_tick * tick_ns ? now_ns - node.expire_tick * tick_ns : 0;
+        stats_.dispatch_lag.buckets[LatencyHistogram::bucketOf(static_cast<int64_t>(lag))]++;
+        stats_.dispatch_lag.count++;
+
+        // 周期任务上一次还在执行：跳过本次，不重叠执行
+        if (node.job->running.exchange(true, std::memory_order_acq_rel)) {
+            ++stats_.skipped;
+        } else {
+            ++stats_.fired;
+            due.push_back(Due{ node.job, node.expire_tick });
+        }
+
+        if (node.period_ticks) {
+            // 固定速率排期；错过多个周期时只补最近的一次
+            node.expire_tick = std::max(node.expire_tick + node.period_ticks, now_tick_ + 1);
+            link(index);
+        } else {
+            freeNode(index);
+        }
+        index = next;
+    }
+}
+
+uint64_t TaskTimer::nextWakeTick() const
+{
+    if (size_ == 0) return UINT64_MAX;
+    // 本圈内第一个非空的最低层槽位；没有则在本圈结束（下沉）时醒来
+    uint64_t boundary = (now_tick_ | (SLOTS - 1)) + 1;
+    for (uint64_t tick = now_tick_ + 1; tick < boundary; ++tick) {
+        if (heads_[tick & (SLOTS - 1)] != NIL) return tick;
+    }
+    return boundary;
+}
+
+uint64_t TaskTimer::elapsedNs() const
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch_).count());
+}
+
+uint64_t TaskTimer::dueTick(Duration delay) const
+{
+    // 向上取整，保证不会早于请求的时间触发
+    uint64_t delay_ns = delay.count() > 0 ? static_cast<uint64_t>(delay.count()) * NS_PER_MS : 0;
+    uint64_t tick_ns = resolution_ms_ * NS_PER_MS;
+    return (elapsedNs() + delay_ns + tick_ns - 1) / tick_ns;
+}
+
+uint64_t TaskTimer::periodTicks(Duration period) const
+{
+    uint64_t ms = period.count() > 0 ? static_cast<uint64_t>(period.count()) : 0;
+    return std::max<uint64_t>(1, (ms + resolution_ms_ - 1) / resolution_ms_);
+}
+
+void TaskTimer::dispatch(Due& due)
+{
+    ThreadPool& pool = executor_ ? *executor_ : EVThread::getThreadPool();
+    try {
+        pool.post(traffic_class_, [job = due.job]() { runJob(job); });
+    } catch (const std::exception& e) {
+        // 执行器已停止（进程退出过程中），在定时器线程上直接执行
+        LOG(WARNING) << "TaskTimer " << name_ << " executor unavailable, running inline: " << e.what();
+        runJob(due.job);
+    }
+}
+
+void TaskTimer::runJob(const std::shared_ptr<Job>& job)
+{
+    if (!job) return;
+    try {
+        job->task();
+    } catch (const std::exception& e) {
+        LOG(ERROR) << "Exception in timer task: " << e.what();
+    }
+    job->running.store(false, std::memory_order_release);
+}
+
+bool TaskTimer::scheduleEntry(uint32_t index, uint64_t delay_ms)
+{
+    Node& node = nodes_[index];
+    EndpointTimer* timer = node.entry ? node.entry : new EndpointTimer();
+    timer->owner = weak_from_this();
+    timer->index = index;
+    timer->generation = node.generation;
+    timer->due_ns = elapsedNs() + delay_ms * NS_PER_MS;
+    pj_timer_entry_init(&timer->entry, 0, timer, &TaskTimer::onEndpointTimer);
+
+    pj_time_val delay;
+    delay.sec = static_cast<long>(delay_ms / 1000);
+    delay.msec = static_cast<long>(delay_ms % 1000);
+    pj_status_t status = pjsip_endpt_schedule_timer(endpt_.get(), &timer->entry, &delay);
+    if (status != PJ_SUCCESS) {
+        LOG(ERROR) << "TaskTimer " << name_ << ": pjsip_endpt_schedule_timer failed, code: " << status;
+        node.entry = nullptr;
+        delete timer;
+        return false;
+    }
+    node.entry = timer;
+    return true;
+}
+
+void TaskTimer::releaseEntry(uint32_t index)
+{
+    EndpointTimer* timer = nodes_[index].entry;
+    if (!timer) return;
+    nodes_[index].entry = nullptr;
+    // 仍在定时器堆中则直接释放；否则回调已在途，由回调发现失效后释放
+    if (pj_timer_heap_cancel(pjsip_endpt_get_timer_heap(endpt_.get()), &timer->entry) > 0) {
+        delete timer;
+    }
+}
+
+void TaskTimer::onEndpointTimer(pj_timer_heap_t* heap, pj_timer_entry* entry)
+{
+    (void)heap;
+    auto* timer = static_cast<EndpointTimer*>(entry->user_data);
+    auto owner = timer->owner.lock();
+    if (!owner) {
+        delete timer;
+        return;
+    }
+
+    std::shared_ptr<Job> job;
+    {
+        std::lock_guard<std::mutex> lock(owner->wheel_mutex_);
+        uint32_t index = timer->index;
+        if (index >= owner->nodes_.size() || owner->nodes_[index].entry != timer
+            || owner->nodes_[index].generation != timer->generation) {
+            // 已被取消或重新调度
+            delete timer;
+            return;
+        }
+        Node& node = owner->nodes_[index];
+        uint64_t now_ns = owner->elapsedNs();
+        uint64_t lag = now_ns > timer->due_ns ? now_ns - timer->due_ns : 0;
+        owner->stats_.dispatch_lag.buckets[LatencyHistogram::bucketOf(static_cast<int64_t>(lag))]++;
+        owner->stats_.dispatch_lag.count++;
+        ++owner->stats_.fired;
+        job = node.job;
+
+        if (node.period_ticks) {
+            if (!owner->scheduleEntry(index, node.period_ticks * owner->resolution_ms_)) {
+                owner->freeNode(index);
+            }
+        } else {
+            node.entry = nullptr;
+            delete timer;
+            owner->freeNode(index);
+        }
+    }
+
+    // 直接在事件循环线程上执行
+    job->running.store(true, std::memory_order_release);
+    runJob(job);
+}
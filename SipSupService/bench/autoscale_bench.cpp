@@ -0,0 +1,194 @@
+// autoscale_bench.cpp
+// 注册风暴下的线程池弹性伸缩：固定线程数 vs PoolAutoscaler
+//
+// 投递线程先以基线速率发送请求，随后在 burst 阶段提高到数倍速率，最后回到基线。
+// 每个请求在工作线程内阻塞 --work-ms 毫秒（模拟注册处理中的鉴权/存储等待），
+// 因此固定线程数时 burst 期间的请求会持续积压。记录每个请求的排队等待
+// （投递到开始执行）p50 / p99，以及伸缩事件次数与峰值线程数；burst 结束并经过
+// 冷却期后检查线程数是否回落到下限。
+// 伸缩后的 burst p99 超过 --p99-budget-ms 或未能回落时以非零状态退出。
+//
+// 用法: autoscale_bench [--min N] [--max N] [--work-ms N] [--base-rate N] [--burst-rate N]
+//                       [--burst-ms N] [--p99-budget-ms N] [--out result.json]
+
+#include "bench_util.h"
+#include "ev_thread_pool.h"
+#include "pool_autoscaler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    struct LoadProfile
+    {
+        int64_t work_ms{ 2 };
+        uint64_t base_rate{ 200 };     // 每秒请求数
+        uint64_t burst_rate{ 4000 };
+        int64_t base_ms{ 500 };
+        int64_t burst_ms{ 1000 };
+    };
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    double percentileMs(std::vector<int64_t>& samples, double p)
+    {
+        if (samples.empty()) return 0.0;
+        size_t idx = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+        return static_cast<double>(samples[idx]) / 1e6;
+    }
+
+    // 按速率投递 duration_ms 毫秒，每1毫秒补齐一次应投递的数量
+    void drive(ThreadPool& pool, const LoadProfile& profile, uint64_t rate, int64_t duration_ms,
+               std::vector<int64_t>& waits, std::mutex& waits_mutex, std::atomic<uint64_t>& submitted)
+    {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t sent = 0;
+        for (int64_t tick = 1; tick <= duration_ms; ++tick)
+        {
+            std::this_thread::sleep_until(start + std::chrono::milliseconds(tick));
+            uint64_t due = rate * static_cast<uint64_t>(tick) / 1000;
+            for (; sent < due; ++sent)
+            {
+                int64_t posted = nowNs();
+                pool.post(5, [posted, &waits, &waits_mutex, work_ms = profile.work_ms] {
+                    int64_t wait = nowNs() - posted;
+                    {
+                        std::lock_guard<std::mutex> lock(waits_mutex);
+                        waits.push_back(wait);
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(work_ms));
+                });
+                submitted.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void drain(ThreadPool& pool)
+    {
+        while (pool.pendingTasks() > 0 || pool.activeThreads() > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    Bench::Result runScenario(const std::string& name, ThreadPool& pool, const LoadProfile& profile,
+                              PoolAutoscaler* autoscaler)
+    {
+        std::mutex waits_mutex;
+        std::vector<int64_t> base_waits;
+        std::vector<int64_t> burst_waits;
+        std::atomic<uint64_t> submitted{0};
+
+        int64_t start = nowNs();
+        drive(pool, profile, profile.base_rate, profile.base_ms, base_waits, waits_mutex, submitted);
+        drive(pool, profile, profile.burst_rate, profile.burst_ms, burst_waits, waits_mutex, submitted);
+        drive(pool, profile, profile.base_rate, profile.base_ms, base_waits, waits_mutex, submitted);
+        drain(pool);
+
+        std::lock_guard<std::mutex> lock(waits_mutex);
+        Bench::Result result = Bench::makeResult(name, submitted.load(), static_cast<double>(nowNs() - start));
+        result.metrics.emplace_back("base_wait_p99_ms", percentileMs(base_waits, 0.99));
+        result.metrics.emplace_back("burst_wait_p50_ms", percentileMs(burst_waits, 0.50));
+        result.metrics.emplace_back("burst_wait_p99_ms", percentileMs(burst_waits, 0.99));
+        if (autoscaler)
+        {
+            PoolAutoscalerStats stats = autoscaler->stats();
+            result.metrics.emplace_back("grow_events", static_cast<double>(stats.grow_events));
+            result.metrics.emplace_back("shrink_events", static_cast<double>(stats.shrink_events));
+            result.metrics.emplace_back("peak_threads", static_cast<double>(stats.peak_threads));
+        }
+        else
+        {
+            result.metrics.emplace_back("peak_threads", static_cast<double>(pool.size()));
+        }
+        return result;
+    }
+
+    double metric(const Bench::Result& result, const std::string& key)
+    {
+        for (const auto& [name, value] : result.metrics)
+        {
+            if (name == key) return value;
+        }
+        return 0.0;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    LoadProfile profile;
+    PoolAutoscalerOptions options;
+    options.enabled = true;
+    options.min_threads = 2;
+    options.max_threads = 64;
+    options.interval_ms = 20;
+    options.shrink_cooldown_ms = 300;
+    double p99_budget_ms = 250.0;
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        long long value = std::strtoll(argv[i + 1], nullptr, 10);
+        if (arg == "--min") options.min_threads = static_cast<size_t>(value);
+        else if (arg == "--max") options.max_threads = static_cast<size_t>(value);
+        else if (arg == "--work-ms") profile.work_ms = value;
+        else if (arg == "--base-rate") profile.base_rate = static_cast<uint64_t>(value);
+        else if (arg == "--burst-rate") profile.burst_rate = static_cast<uint64_t>(value);
+        else if (arg == "--burst-ms") profile.burst_ms = value;
+        else if (arg == "--p99-budget-ms") p99_budget_ms = static_cast<double>(value);
+    }
+
+    Bench::Reporter reporter("autoscale", argc, argv);
+    int rc = 0;
+    {
+        ThreadPool pool(options.min_threads);
+        reporter.add(runScenario("burst/fixed", pool, profile, nullptr));
+    }
+    {
+        ThreadPool pool(options.min_threads);
+        PoolAutoscaler autoscaler(pool, options, "bench-scaler");
+        autoscaler.start();
+        Bench::Result result = runScenario("burst/autoscale", pool, profile, &autoscaler);
+
+        // 负载结束后等待冷却，线程数应逐步回落到下限
+        auto deadline = std::chrono::steady_clock::now()
+            + std::chrono::milliseconds(options.shrink_cooldown_ms * 20 + 1000);
+        while (pool.size() > options.min_threads && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.interval_ms));
+        }
+        autoscaler.stop();
+        result.metrics.emplace_back("settled_threads", static_cast<double>(pool.size()));
+
+        double p99 = metric(result, "burst_wait_p99_ms");
+        if (p99 > p99_budget_ms)
+        {
+            std::fprintf(stderr, "burst wait p99 %.1f ms exceeds budget %.1f ms\n", p99, p99_budget_ms);
+            rc = 1;
+        }
+        if (pool.size() != options.min_threads)
+        {
+            std::fprintf(stderr, "pool did not shrink back to %zu threads (now %zu)\n",
+                options.min_threads, pool.size());
+            rc = 1;
+        }
+        reporter.add(std::move(result));
+    }
+
+    int out = reporter.finish();
+    return rc != 0 ? rc : out;
+}
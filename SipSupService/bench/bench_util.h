@@ -0,0 +1,141 @@
+// bench_util.h
+// 基准测试公共工具：计时、防优化屏障与 JSON 结果输出。
+// 每个基准程序汇总若干 Result，结束时以一个 JSON 对象打印到标准输出，
+// 也可通过 --out <file> 写入文件，便于脚本对比不同版本的结果。
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Bench {
+
+    // 阻止编译器把被测结果优化掉
+    template <typename T>
+    inline void doNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    struct Result
+    {
+        std::string name;
+        uint64_t iterations { 0 };
+        double total_ms { 0.0 };
+        double ns_per_op { 0.0 };
+        double ops_per_sec { 0.0 };
+        // 附加指标（例如 p99 延迟、分配次数）
+        std::vector<std::pair<std::string, double>> metrics;
+    };
+
+    // 由总耗时（纳秒）换算单次耗时与吞吐
+    inline Result makeResult(const std::string& name, uint64_t iterations, double elapsed_ns)
+    {
+        Result result;
+        result.name = name;
+        result.iterations = iterations;
+        result.total_ms = elapsed_ns / 1e6;
+        result.ns_per_op = iterations ? elapsed_ns / static_cast<double>(iterations) : 0.0;
+        result.ops_per_sec = elapsed_ns > 0 ? static_cast<double>(iterations) * 1e9 / elapsed_ns : 0.0;
+        return result;
+    }
+
+    // 运行 f() 共 iterations 次，先预热约 1/10 次数
+    template <typename F>
+    Result run(const std::string& name, uint64_t iterations, F&& f)
+    {
+        for (uint64_t i = 0; i < iterations / 10; ++i)
+        {
+            f();
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            f();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return makeResult(name, iterations, std::chrono::duration<double, std::nano>(elapsed).count());
+    }
+
+    class Reporter
+    {
+    public:
+        Reporter(std::string suite, int argc, char* argv[])
+            : suite_(std::move(suite))
+        {
+            for (int i = 1; i + 1 < argc; ++i)
+            {
+                if (std::strcmp(argv[i], "--out") == 0)
+                {
+                    out_path_ = argv[i + 1];
+                }
+            }
+        }
+
+        void add(Result result)
+        {
+            std::fprintf(stderr, "%-40s %12.1f ns/op %14.0f ops/s\n",
+                result.name.c_str(), result.ns_per_op, result.ops_per_sec);
+            results_.push_back(std::move(result));
+        }
+
+        std::string toJson() const
+        {
+            std::string json = "{\"suite\":\"" + suite_ + "\",\"results\":[";
+            for (size_t i = 0; i < results_.size(); ++i)
+            {
+                const auto& r = results_[i];
+                if (i) json += ",";
+                json += "{\"name\":\"" + r.name + "\""
+                      + ",\"iterations\":" + std::to_string(r.iterations)
+                      + ",\"total_ms\":" + number(r.total_ms)
+                      + ",\"ns_per_op\":" + number(r.ns_per_op)
+                      + ",\"ops_per_sec\":" + number(r.ops_per_sec);
+                for (const auto& [key, value] : r.metrics)
+                {
+                    json += ",\"" + key + "\":" + number(value);
+                }
+                json += "}";
+            }
+            json += "]}";
+            return json;
+        }
+
+        // 输出结果，返回进程退出码
+        int finish() const
+        {
+            std::string json = toJson();
+            std::printf("%s\n", json.c_str());
+            if (!out_path_.empty())
+            {
+                FILE* fp = std::fopen(out_path_.c_str(), "w");
+                if (!fp)
+                {
+                    std::fprintf(stderr, "failed to open %s\n", out_path_.c_str());
+                    return 1;
+                }
+                std::fprintf(fp, "%s\n", json.c_str());
+                std::fclose(fp);
+            }
+            return 0;
+        }
+
+    private:
+        static std::string number(double value)
+        {
+            char buf[64];
+            std::snprintf(buf, sizeof(buf), "%.3f", value);
+            return buf;
+        }
+
+        std::string suite_;
+        std::string out_path_;
+        std::vector<Result> results_;
+    };
+
+} // namespace Bench
@@ -0,0 +1,312 @@
+// coroutine_bench.cpp
+// 待决事务的开销：协程挂起 vs 每个事务阻塞一个线程
+//
+// 用一个应答线程模拟 PJSIP 事件线程：请求登记后经过 --delay-ms 毫秒由应答线程
+// 调用完成回调，与 SipTransaction 的做法一致，回调把恢复动作投递到线程池。
+//   coroutine: 同时挂起 --count 个 CoTask，统计发起阶段的堆分配字节数
+//              （协程帧 + 待决记录 + 应答队列条目）与 RSS 增量，换算为每个事务的开销；
+//   thread:    --threads 个线程各自阻塞等待一个应答，统计 RSS 增量与默认线程栈大小。
+// 每个挂起事务的分配字节数超过 --max-bytes，或有事务未完成时以非零状态退出。
+//
+// 用法: coroutine_bench [--count N] [--threads N] [--delay-ms N] [--max-bytes N] [--out result.json]
+
+#include "bench_util.h"
+#include "co_task.h"
+#include "ev_thread_pool.h"
+
+#include <pthread.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    std::atomic<uint64_t> g_alloc_bytes{0};
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 当前进程常驻内存（KB）
+    long rssKb()
+    {
+        FILE* fp = std::fopen("/proc/self/status", "r");
+        if (!fp) return 0;
+        char line[256];
+        long kb = 0;
+        while (std::fgets(line, sizeof(line), fp))
+        {
+            if (std::strncmp(line, "VmRSS:", 6) == 0)
+            {
+                kb = std::strtol(line + 6, nullptr, 10);
+                break;
+            }
+        }
+        std::fclose(fp);
+        return kb;
+    }
+
+    // 模拟事务层：到期后在应答线程上调用完成回调
+    class FakeTransport
+    {
+    public:
+        FakeTransport()
+            : thread_([this] { run(); })
+        {
+        }
+
+        ~FakeTransport()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            thread_.join();
+        }
+
+        // 请求按登记顺序到期，队列保持有序
+        void send(int64_t delay_ns, std::function<void(int)> on_complete)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(Entry{ nowNs() + delay_ns, std::move(on_complete) });
+            cv_.notify_one();
+        }
+
+    private:
+        struct Entry
+        {
+            int64_t due_ns;
+            std::function<void(int)> on_complete;
+        };
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stop_)
+            {
+                if (queue_.empty())
+                {
+                    cv_.wait(lock);
+                    continue;
+                }
+                int64_t wait = queue_.front().due_ns - nowNs();
+                if (wait > 0)
+                {
+                    cv_.wait_for(lock, std::chrono::nanoseconds(wait));
+                    continue;
+                }
+                Entry entry = std::move(queue_.front());
+                queue_.pop_front();
+                lock.unlock();
+                entry.on_complete(200);
+                lock.lock();
+            }
+        }
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<Entry> queue_;
+        bool stop_{ false };
+        std::thread thread_;
+    };
+
+    // 与 SipTransaction::Awaiter 相同的结构：挂起后登记请求，完成回调投递到线程池恢复
+    struct FakeRequest
+    {
+        FakeTransport& transport;
+        ThreadPool& pool;
+        int64_t delay_ns;
+        int status_code{ 0 };
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            transport.send(delay_ns, [this, handle](int code) {
+                status_code = code;
+                pool.post(TrafficClass::CONTROL, [handle]() { handle.resume(); });
+            });
+        }
+        int await_resume() const noexcept { return status_code; }
+    };
+
+    CoTask<int> sendOne(FakeTransport& transport, ThreadPool& pool, int64_t delay_ns)
+    {
+        int code = co_await FakeRequest{ transport, pool, delay_ns };
+        co_return code;
+    }
+
+    CoTask<void> transaction(FakeTransport& transport, ThreadPool& pool, int64_t delay_ns,
+                             std::atomic<uint64_t>& ok, std::atomic<uint64_t>& done)
+    {
+        int code = co_await sendOne(transport, pool, delay_ns);
+        if (code == 200) ok.fetch_add(1, std::memory_order_relaxed);
+        done.fetch_add(1, std::memory_order_release);
+    }
+
+    void waitFor(const std::atomic<uint64_t>& done, uint64_t target, int64_t timeout_ms)
+    {
+        int64_t deadline = nowNs() + timeout_ms * 1000000;
+        while (done.load(std::memory_order_acquire) < target && nowNs() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    Bench::Result runCoroutines(uint64_t count, int64_t delay_ms)
+    {
+        ThreadPool pool(2);
+        FakeTransport transport;
+        std::atomic<uint64_t> ok{0};
+        std::atomic<uint64_t> done{0};
+
+        long rss_before = rssKb();
+        uint64_t bytes_before = g_alloc_bytes.load();
+        int64_t start = nowNs();
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            coStart(transaction(transport, pool, delay_ms * 1000000, ok, done));
+        }
+        // 此时全部事务都处于挂起状态
+        uint64_t suspended_bytes = g_alloc_bytes.load() - bytes_before;
+        long rss_suspended = rssKb();
+
+        waitFor(done, count, delay_ms + 30000);
+        Bench::Result result = Bench::makeResult("pending/coroutine", done.load(), static_cast<double>(nowNs() - start));
+        result.metrics.emplace_back("in_flight", static_cast<double>(count));
+        result.metrics.emplace_back("completed_ok", static_cast<double>(ok.load()));
+        result.metrics.emplace_back("bytes_per_pending", static_cast<double>(suspended_bytes) / static_cast<double>(count));
+        result.metrics.emplace_back("rss_kb_per_pending",
+            static_cast<double>(rss_suspended - rss_before) / static_cast<double>(count));
+        return result;
+    }
+
+    Bench::Result runThreads(uint64_t count, int64_t delay_ms)
+    {
+        FakeTransport transport;
+        std::atomic<uint64_t> ok{0};
+        std::atomic<uint64_t> done{0};
+        std::atomic<uint64_t> waiting{0};
+
+        long rss_before = rssKb();
+        int64_t start = nowNs();
+        std::vector<std::thread> threads;
+        threads.reserve(count);
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            threads.emplace_back([&transport, &ok, &done, &waiting, delay_ms] {
+                std::promise<int> promise;
+                auto future = promise.get_future();
+                transport.send(delay_ms * 1000000, [&promise](int code) { promise.set_value(code); });
+                waiting.fetch_add(1, std::memory_order_release);
+                if (future.get() == 200) ok.fetch_add(1, std::memory_order_relaxed);
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        waitFor(waiting, count, delay_ms);
+        long rss_blocked = rssKb();
+
+        waitFor(done, count, delay_ms + 30000);
+        for (auto& t : threads) t.join();
+        Bench::Result result = Bench::makeResult("pending/thread", done.load(), static_cast<double>(nowNs() - start));
+
+        size_t stack_size = 0;
+        pthread_attr_t attr;
+        if (pthread_attr_init(&attr) == 0)
+        {
+            pthread_attr_getstacksize(&attr, &stack_size);
+            pthread_attr_destroy(&attr);
+        }
+        result.metrics.emplace_back("in_flight", static_cast<double>(count));
+        result.metrics.emplace_back("completed_ok", static_cast<double>(ok.load()));
+        result.metrics.emplace_back("stack_bytes_per_pending", static_cast<double>(stack_size));
+        result.metrics.emplace_back("rss_kb_per_pending",
+            static_cast<double>(rss_blocked - rss_before) / static_cast<double>(count));
+        return result;
+    }
+
+    double metric(const Bench::Result& result, const std::string& key)
+    {
+        for (const auto& [name, value] : result.metrics)
+        {
+            if (name == key) return value;
+        }
+        return 0.0;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    uint64_t count = 20000;
+    uint64_t thread_count = 500;
+    int64_t delay_ms = 200;
+    double max_bytes = 1024.0;
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        long long value = std::strtoll(argv[i + 1], nullptr, 10);
+        if (arg == "--count") count = static_cast<uint64_t>(value);
+        else if (arg == "--threads") thread_count = static_cast<uint64_t>(value);
+        else if (arg == "--delay-ms") delay_ms = value;
+        else if (arg == "--max-bytes") max_bytes = static_cast<double>(value);
+    }
+
+    Bench::Reporter reporter("coroutine", argc, argv);
+    int rc = 0;
+
+    Bench::Result coro = runCoroutines(count, delay_ms);
+    double bytes = metric(coro, "bytes_per_pending");
+    if (bytes > max_bytes)
+    {
+        std::fprintf(stderr, "%.0f bytes per pending coroutine exceeds budget %.0f\n", bytes, max_bytes);
+        rc = 1;
+    }
+    if (coro.iterations != count || metric(coro, "completed_ok") != static_cast<double>(count))
+    {
+        std::fprintf(stderr, "only %llu of %llu coroutine transactions completed\n",
+            static_cast<unsigned long long>(coro.iterations), static_cast<unsigned long long>(count));
+        rc = 1;
+    }
+    reporter.add(std::move(coro));
+    reporter.add(runThreads(thread_count, delay_ms));
+
+    int out = reporter.finish();
+    return rc != 0 ? rc : out;
+}
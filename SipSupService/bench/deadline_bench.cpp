@@ -0,0 +1,121 @@
+// deadline_bench.cpp
+// 过载时按截止时间丢弃排队过久的请求：有效吞吐（goodput）对比
+//
+// 投递线程以容量的 --load 倍持续投递请求，每个请求阻塞 --work-us 微秒，
+// 对端只在 --deadline-ms 内等待响应。没有截止时间时所有请求都会执行，
+// 积压越来越长，后来的请求全部在对端放弃之后才完成；设置截止时间后过期请求
+// 在出队时被丢弃，线程只处理仍可按时响应的请求。
+// 结果记录按时完成数（goodput）、超时完成数、丢弃数与按时完成请求的排队 p99。
+//
+// 用法: deadline_bench [--threads N] [--work-us N] [--load X] [--deadline-ms N]
+//                      [--duration-ms N] [--out result.json]
+
+#include "bench_util.h"
+#include "ev_thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    struct Profile
+    {
+        size_t threads{ 4 };
+        int64_t work_us{ 1000 };
+        double load{ 1.5 };
+        int64_t deadline_ms{ 200 };
+        int64_t duration_ms{ 2000 };
+    };
+
+    Bench::Result runScenario(const std::string& name, const Profile& profile, bool use_deadline)
+    {
+        std::atomic<uint64_t> on_time{0};
+        std::atomic<uint64_t> late{0};
+        std::mutex waits_mutex;
+        std::vector<int64_t> waits;
+        const int64_t deadline_ns = profile.deadline_ms * 1000000;
+
+        uint64_t sent = 0;
+        uint64_t dropped = 0;
+        auto start = std::chrono::steady_clock::now();
+        {
+            ThreadPool pool(profile.threads);
+            double capacity = static_cast<double>(profile.threads) * 1e6 / static_cast<double>(profile.work_us);
+            auto rate = static_cast<uint64_t>(capacity * profile.load);
+            for (int64_t tick = 1; tick <= profile.duration_ms; ++tick)
+            {
+                std::this_thread::sleep_until(start + std::chrono::milliseconds(tick));
+                uint64_t due = rate * static_cast<uint64_t>(tick) / 1000;
+                for (; sent < due; ++sent)
+                {
+                    int64_t posted = TaskContext::nowNs();
+                    TaskOptions options;
+                    options.traffic_class = TrafficClass::SIGNALING;
+                    if (use_deadline)
+                        options.deadline_ns = posted + deadline_ns;
+                    pool.post(std::move(options), [&, posted] {
+                        int64_t wait = TaskContext::nowNs() - posted;
+                        std::this_thread::sleep_for(std::chrono::microseconds(profile.work_us));
+                        if (TaskContext::nowNs() - posted <= deadline_ns)
+                        {
+                            on_time.fetch_add(1, std::memory_order_relaxed);
+                            std::lock_guard<std::mutex> lock(waits_mutex);
+                            waits.push_back(wait);
+                        }
+                        else
+                        {
+                            late.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    });
+                }
+            }
+            // 析构时执行完剩余任务（有截止时间时大部分被丢弃）
+            pool.shutdown();
+            dropped = pool.expiredTasks();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        Bench::Result result = Bench::makeResult(name, sent, std::chrono::duration<double, std::nano>(elapsed).count());
+        result.metrics.emplace_back("on_time", static_cast<double>(on_time.load()));
+        result.metrics.emplace_back("late", static_cast<double>(late.load()));
+        result.metrics.emplace_back("dropped", static_cast<double>(dropped));
+        result.metrics.emplace_back("goodput_per_sec",
+            static_cast<double>(on_time.load()) * 1000.0 / static_cast<double>(profile.duration_ms));
+        double p99 = 0.0;
+        if (!waits.empty())
+        {
+            size_t idx = static_cast<size_t>(0.99 * static_cast<double>(waits.size() - 1));
+            std::nth_element(waits.begin(), waits.begin() + idx, waits.end());
+            p99 = static_cast<double>(waits[idx]) / 1e6;
+        }
+        result.metrics.emplace_back("on_time_wait_p99_ms", p99);
+        return result;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Profile profile;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        const char* value = argv[i + 1];
+        if (arg == "--threads") profile.threads = std::strtoul(value, nullptr, 10);
+        else if (arg == "--work-us") profile.work_us = std::strtoll(value, nullptr, 10);
+        else if (arg == "--load") profile.load = std::strtod(value, nullptr);
+        else if (arg == "--deadline-ms") profile.deadline_ms = std::strtoll(value, nullptr, 10);
+        else if (arg == "--duration-ms") profile.duration_ms = std::strtoll(value, nullptr, 10);
+    }
+
+    Bench::Reporter reporter("deadline", argc, argv);
+    reporter.add(runScenario("overload/no_deadline", profile, false));
+    reporter.add(runScenario("overload/deadline", profile, true));
+    return reporter.finish();
+}
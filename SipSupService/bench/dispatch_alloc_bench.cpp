@@ -0,0 +1,160 @@
+// dispatch_alloc_bench.cpp
+// 任务投递的堆分配次数：替换全局 operator new 计数，统计每次投递的平均分配数。
+//
+// 预算（超出时返回非0，可作为回归检查）：
+//   post          - 0 次（可调用对象放入 TaskFunction 内联缓冲区）
+//   submit        - 1 次（TaskFuture 共享状态）
+//   createThread  - 1 次（与 SipCore::onRxRequest 的投递方式一致）
+// legacy 为改造前 packaged_task + std::function 的投递方式，仅作对比。
+//
+// 用法: dispatch_alloc_bench [--out result.json]
+
+#include "bench_util.h"
+#include "ev_thread.h"
+#include "ev_thread_pool.h"
+#include "legacy_thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+
+namespace {
+
+    std::atomic<uint64_t> g_allocs{0};
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+    constexpr uint64_t kDispatches = 20000;
+
+    // 模拟 onRxRequest 中的 ThRxParams
+    struct FakeParams
+    {
+        int value { 0 };
+    };
+
+    void waitFor(const std::atomic<uint64_t>& done, uint64_t target)
+    {
+        while (done.load(std::memory_order_acquire) < target)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // 预热后统计 dispatch() 执行 kDispatches 次的分配数与耗时
+    template <typename F>
+    Bench::Result measure(const std::string& name, F&& dispatch)
+    {
+        for (uint64_t i = 0; i < kDispatches / 10; ++i)
+        {
+            dispatch();
+        }
+        uint64_t before = g_allocs.load();
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < kDispatches; ++i)
+        {
+            dispatch();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        uint64_t allocs = g_allocs.load() - before;
+
+        Bench::Result result = Bench::makeResult(name, kDispatches,
+            std::chrono::duration<double, std::nano>(elapsed).count());
+        result.metrics.emplace_back("allocs_per_op",
+            static_cast<double>(allocs) / static_cast<double>(kDispatches));
+        return result;
+    }
+
+    bool withinBudget(const Bench::Result& result, double budget)
+    {
+        double allocs = result.metrics.front().second;
+        if (allocs > budget)
+        {
+            std::fprintf(stderr, "FAIL %s: %.3f allocs/op, budget %.0f\n",
+                result.name.c_str(), allocs, budget);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Bench::Reporter reporter("dispatch_alloc", argc, argv);
+    auto params = std::make_shared<FakeParams>();
+    bool ok = true;
+
+    {
+        ThreadPool pool(2);
+        std::atomic<uint64_t> done{0};
+        uint64_t posted = 0;
+        Bench::Result post = measure("post", [&] {
+            pool.post(5, [params, &done] {
+                Bench::doNotOptimize(params->value);
+                done.fetch_add(1, std::memory_order_release);
+            });
+            waitFor(done, ++posted);
+        });
+        ok = withinBudget(post, 0) && ok;
+        reporter.add(std::move(post));
+
+        Bench::Result submit = measure("submit", [&] {
+            auto fut = pool.submit(5, [params] { return params->value; });
+            Bench::doNotOptimize(fut.get());
+        });
+        ok = withinBudget(submit, 1) && ok;
+        reporter.add(std::move(submit));
+    }
+
+    {
+        Bench::Result create = measure("createThread", [&] {
+            auto fut = EVThread::createThread(
+                [params]() -> int { return params->value; },
+                std::tuple<>{},
+                nullptr,
+                ThreadPriority::NORMAL,
+                std::chrono::milliseconds{5000});
+            Bench::doNotOptimize(fut.get());
+        });
+        ok = withinBudget(create, 1) && ok;
+        reporter.add(std::move(create));
+    }
+
+    {
+        // 改造前：EVThread 内一层 packaged_task，线程池 submit 再包一层
+        LegacyThreadPool pool(2);
+        reporter.add(measure("legacy", [&] {
+            auto task = std::make_shared<std::packaged_task<int()>>([params] { return params->value; });
+            std::future<int> fut = task->get_future();
+            pool.submit(5, [task] { (*task)(); });
+            Bench::doNotOptimize(fut.get());
+        }));
+    }
+
+    int rc = reporter.finish();
+    return ok ? rc : 1;
+}
@@ -0,0 +1,296 @@
+// event_loop_bench.cpp
+// 事件循环的空闲开销与跨线程唤醒延迟
+//
+// 用 select() + 套接字对模拟 pjsip 的 select ioqueue，用加锁的最小堆模拟端点定时器堆：
+// 每轮等待时长 = min(循环上限, 最近的定时器到期时刻)，与 pjsip_endpt_handle_events 一致。
+//   current:   原事件循环，上限 500ms（pj_time_val{0, 500}），没有跨线程唤醒；
+//   poll-500us: 上限 0.5ms 的轮询循环，作为对照；
+//   blocking:  上限 --max-block-ms，其他线程通过套接字对唤醒，被唤醒后的一轮只等待 --settle-ms。
+// 每种循环依次测量：
+//   idle:     --idle-ms 内没有任何事件时的醒来次数与循环线程 CPU 时间；
+//   post:     另一线程每隔 2~4ms 挂一个 1~20ms 后到期的定时器（blocking 先唤醒再挂，
+//             对应发送观察模块先于事务层挂定时器的最坏顺序），统计实际触发相对到期时刻的延迟；
+//   shutdown: 请求停止到循环线程退出的耗时。
+// blocking 的触发延迟 p99 超过 --p99-budget-ms、空闲醒来次数超过每秒 1000/max-block-ms + 1
+// 或停止耗时超过 10ms 时以非零状态退出。
+//
+// 用法: event_loop_bench [--idle-ms N] [--posts N] [--max-block-ms N] [--settle-ms N]
+//                        [--p99-budget-ms N] [--out result.json]
+
+#include "bench_util.h"
+
+#include <pthread.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    double percentileMs(std::vector<int64_t>& samples, double p)
+    {
+        if (samples.empty()) return 0.0;
+        size_t idx = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+        return static_cast<double>(samples[idx]) / 1e6;
+    }
+
+    struct LoopConfig
+    {
+        std::string name;
+        int64_t max_block_us;
+        bool wake;
+        int64_t settle_us;
+    };
+
+    class SimLoop
+    {
+    public:
+        explicit SimLoop(const LoopConfig& config)
+            : config_(config)
+        {
+            if (::socketpair(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0, fds_) != 0)
+            {
+                std::perror("socketpair");
+                std::exit(2);
+            }
+            thread_ = std::thread([this] { run(); });
+        }
+
+        ~SimLoop()
+        {
+            if (thread_.joinable()) stop();
+            ::close(fds_[0]);
+            ::close(fds_[1]);
+        }
+
+        // 挂一个 delay_ns 之后到期的定时器，返回到期时刻
+        void schedule(int64_t delay_ns)
+        {
+            if (config_.wake) wake();
+            std::lock_guard<std::mutex> lock(mutex_);
+            heap_.push(nowNs() + delay_ns);
+        }
+
+        // 返回停止耗时
+        int64_t stop()
+        {
+            int64_t start = nowNs();
+            stop_.store(true, std::memory_order_release);
+            if (config_.wake) wake();
+            thread_.join();
+            return nowNs() - start;
+        }
+
+        uint64_t iterations() const { return iterations_.load(std::memory_order_relaxed); }
+
+        int64_t cpuNs()
+        {
+            clockid_t cid;
+            timespec ts{};
+            if (pthread_getcpuclockid(thread_.native_handle(), &cid) != 0 || clock_gettime(cid, &ts) != 0)
+                return 0;
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+
+        std::vector<int64_t> takeLateness()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return std::move(lateness_);
+        }
+
+        size_t fired()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return lateness_.size();
+        }
+
+    private:
+        void wake()
+        {
+            if (pending_.exchange(true, std::memory_order_acq_rel)) return;
+            char byte = 1;
+            (void)::send(fds_[1], &byte, 1, MSG_DONTWAIT);
+        }
+
+        void run()
+        {
+            bool woken = false;
+            while (!stop_.load(std::memory_order_acquire))
+            {
+                int64_t wait_us = woken ? config_.settle_us : config_.max_block_us;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!heap_.empty())
+                    {
+                        // pjsip 定时器堆以毫秒为单位，向上取整
+                        int64_t until = heap_.top() - nowNs();
+                        int64_t until_us = until > 0 ? (until + 999999) / 1000000 * 1000 : 0;
+                        wait_us = std::min(wait_us, until_us);
+                    }
+                }
+                fd_set rset;
+                FD_ZERO(&rset);
+                FD_SET(fds_[0], &rset);
+                timeval tv{ static_cast<time_t>(wait_us / 1000000), static_cast<suseconds_t>(wait_us % 1000000) };
+                int n = ::select(fds_[0] + 1, &rset, nullptr, nullptr, &tv);
+                iterations_.fetch_add(1, std::memory_order_relaxed);
+
+                woken = false;
+                if (n > 0 && FD_ISSET(fds_[0], &rset))
+                {
+                    pending_.store(false, std::memory_order_release);
+                    char drain[16];
+                    while (::recv(fds_[0], drain, sizeof(drain), MSG_DONTWAIT) > 0)
+                    {
+                    }
+                    woken = true;
+                }
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                int64_t now = nowNs();
+                while (!heap_.empty() && heap_.top() <= now)
+                {
+                    lateness_.push_back(now - heap_.top());
+                    heap_.pop();
+                }
+            }
+        }
+
+        LoopConfig config_;
+        int fds_[2]{ -1, -1 };
+        std::mutex mutex_;
+        std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t>> heap_;
+        std::vector<int64_t> lateness_;
+        std::atomic<bool> pending_{ false };
+        std::atomic<bool> stop_{ false };
+        std::atomic<uint64_t> iterations_{ 0 };
+        std::thread thread_;
+    };
+
+    Bench::Result runLoop(const LoopConfig& config, int64_t idle_ms, uint64_t posts)
+    {
+        SimLoop loop(config);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        // 空闲
+        uint64_t iter_before = loop.iterations();
+        int64_t cpu_before = loop.cpuNs();
+        int64_t start = nowNs();
+        std::this_thread::sleep_for(std::chrono::milliseconds(idle_ms));
+        double idle_s = static_cast<double>(nowNs() - start) / 1e9;
+        double idle_wakeups = static_cast<double>(loop.iterations() - iter_before) / idle_s;
+        double idle_cpu_ms = static_cast<double>(loop.cpuNs() - cpu_before) / 1e6 / idle_s;
+
+        // 跨线程挂定时器
+        std::mt19937_64 rng(11);
+        std::uniform_int_distribution<int64_t> delay_dist(1, 20);
+        std::uniform_int_distribution<int64_t> gap_dist(2, 4);
+        int64_t post_start = nowNs();
+        for (uint64_t i = 0; i < posts; ++i)
+        {
+            loop.schedule(delay_dist(rng) * 1000000);
+            std::this_thread::sleep_for(std::chrono::milliseconds(gap_dist(rng)));
+        }
+        int64_t deadline = nowNs() + 2000000000LL;
+        while (loop.fired() < posts && nowNs() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        int64_t post_elapsed = nowNs() - post_start;
+        int64_t shutdown_ns = loop.stop();
+
+        std::vector<int64_t> lateness = loop.takeLateness();
+        Bench::Result result = Bench::makeResult(config.name, lateness.size(), static_cast<double>(post_elapsed));
+        result.metrics.emplace_back("idle_wakeups_per_s", idle_wakeups);
+        result.metrics.emplace_back("idle_cpu_ms_per_s", idle_cpu_ms);
+        result.metrics.emplace_back("late_p50_ms", percentileMs(lateness, 0.50));
+        result.metrics.emplace_back("late_p99_ms", percentileMs(lateness, 0.99));
+        result.metrics.emplace_back("late_max_ms", percentileMs(lateness, 1.0));
+        result.metrics.emplace_back("shutdown_ms", static_cast<double>(shutdown_ns) / 1e6);
+        return result;
+    }
+
+    double metric(const Bench::Result& result, const std::string& key)
+    {
+        for (const auto& [name, value] : result.metrics)
+        {
+            if (name == key) return value;
+        }
+        return 0.0;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int64_t idle_ms = 3000;
+    uint64_t posts = 500;
+    int64_t max_block_ms = 1000;
+    int64_t settle_ms = 1;
+    double p99_budget_ms = 2.0;
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        long long value = std::strtoll(argv[i + 1], nullptr, 10);
+        if (arg == "--idle-ms") idle_ms = value;
+        else if (arg == "--posts") posts = static_cast<uint64_t>(value);
+        else if (arg == "--max-block-ms") max_block_ms = value;
+        else if (arg == "--settle-ms") settle_ms = value;
+        else if (arg == "--p99-budget-ms") p99_budget_ms = static_cast<double>(value);
+    }
+
+    Bench::Reporter reporter("event_loop", argc, argv);
+    int rc = 0;
+
+    reporter.add(runLoop(LoopConfig{ "current", 500000, false, 0 }, idle_ms, posts));
+    reporter.add(runLoop(LoopConfig{ "poll-500us", 500, false, 0 }, idle_ms, posts));
+
+    Bench::Result blocking = runLoop(LoopConfig{ "blocking", max_block_ms * 1000, true, settle_ms * 1000 }, idle_ms, posts);
+    if (blocking.iterations != posts)
+    {
+        std::fprintf(stderr, "only %llu of %llu timers fired\n",
+            static_cast<unsigned long long>(blocking.iterations), static_cast<unsigned long long>(posts));
+        rc = 1;
+    }
+    if (metric(blocking, "late_p99_ms") > p99_budget_ms)
+    {
+        std::fprintf(stderr, "lateness p99 %.2f ms exceeds budget %.2f ms\n", metric(blocking, "late_p99_ms"), p99_budget_ms);
+        rc = 1;
+    }
+    double wakeup_budget = 1000.0 / static_cast<double>(max_block_ms) + 1.0;
+    if (metric(blocking, "idle_wakeups_per_s") > wakeup_budget)
+    {
+        std::fprintf(stderr, "%.1f idle wakeups/s exceeds budget %.1f\n", metric(blocking, "idle_wakeups_per_s"), wakeup_budget);
+        rc = 1;
+    }
+    if (metric(blocking, "shutdown_ms") > 10.0)
+    {
+        std::fprintf(stderr, "shutdown took %.1f ms\n", metric(blocking, "shutdown_ms"));
+        rc = 1;
+    }
+    reporter.add(std::move(blocking));
+
+    int out = reporter.finish();
+    return rc != 0 ? rc : out;
+}
@@ -0,0 +1,90 @@
+// legacy_thread_pool.h
+// 旧版线程池（单一全局锁 + 优先队列），仅供基准测试对比使用。
+// 与改造前的 ThreadPool 行为一致，去掉了动态扩缩容。
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class LegacyThreadPool
+{
+public:
+    struct Task
+    {
+        int priority{0};
+        std::function<void()> func;
+
+        bool operator<(const Task& other) const
+        {
+            return priority < other.priority;
+        }
+    };
+
+    explicit LegacyThreadPool(size_t thread_count)
+    {
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~LegacyThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            stop_ = true;
+        }
+        condition_.notify_all();
+        for (auto& w : workers_)
+        {
+            if (w.joinable()) w.join();
+        }
+    }
+
+    template<class F, class... Args>
+    auto submit(int priority, F&& func, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>>
+    {
+        using return_type = std::invoke_result_t<F, Args...>;
+        auto task_ptr = std::make_shared<std::packaged_task<return_type()>>(
+            std::bind(std::forward<F>(func), std::forward<Args>(args)...));
+        std::future<return_type> res = task_ptr->get_future();
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            tasks_.emplace(Task{priority, [task_ptr]() { (*task_ptr)(); }});
+        }
+        condition_.notify_one();
+        return res;
+    }
+
+private:
+    void worker_loop()
+    {
+        while (true)
+        {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (stop_ && tasks_.empty()) return;
+                task = std::move(const_cast<Task&>(tasks_.top()));
+                tasks_.pop();
+            }
+            task.func();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::priority_queue<Task> tasks_;
+    std::mutex queue_mutex_;
+    std::condition_variable condition_;
+    bool stop_{ false };
+};
@@ -0,0 +1,323 @@
+// log_bench.cpp
+// 开启日志时的 REGISTER 处理吞吐
+//
+// 每个模拟的 REGISTER 做 --work-ns 纳秒的计算（摘要校验、组包等）并写 20 行日志，
+// 与 SipRegister::handleAuthRegister 一次成功注册的日志量相当：
+//   no-log/<T>:     只有计算，作为上限；
+//   sync-flush/<T>: 模拟原来的 glog 配置（logbufsecs = 0）：全局锁 + 格式化前缀 + 每行 fflush，20 行均为 INFO；
+//   async/<T>:      AsyncLog 写文件，20 行均为 INFO；
+//   async-debug/<T>: AsyncLog 写文件，按本次调整只有 5 行保留 INFO，其余 15 行为 LOG(DEBUG)，
+//                   在默认 SIP_LOG_MIN_LEVEL = 1 下被编译期去掉。
+// 另有凭证错误的注册风暴：--devices 台设备轮流发送 REGISTER，每个请求写一行 ERROR：
+//   storm-unlimited/<T>: LOG(ERROR)，每个请求一行；
+//   storm-limited/<T>:   LOG_LIMITED(ERROR, 设备 ID)，按默认参数（每设备 12 行/分钟，突发 5 行）限流。
+// 指标 register_per_sec 为每秒完成的 REGISTER 数（含后台写线程占用的 CPU）。
+// 以下情况以非零状态退出：
+//   async 在最大线程数下慢于 sync-flush，或已写入行数 + 丢弃行数与提交行数不符；
+//   storm-limited 放行 + 抑制的行数与请求数不符，或放行行数超过令牌桶允许的上限。
+//
+// 用法: log_bench [--requests N] [--threads N] [--work-ns N] [--devices N] [--dir path] [--out result.json]
+
+#include "bench_util.h"
+#include "async_log.h"
+#include "log_rate_limit.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+    constexpr int LINES_PER_REQUEST = 20;
+    constexpr int INFO_LINES_AFTER = 5;
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 约 work_ns 纳秒的计算
+    uint64_t work(uint64_t seed, int64_t work_ns)
+    {
+        int64_t end = nowNs() + work_ns;
+        uint64_t hash = seed ^ 1469598103934665603ull;
+        do {
+            for (int i = 0; i < 64; ++i)
+            {
+                hash = (hash ^ static_cast<uint64_t>(i)) * 1099511628211ull;
+            }
+        } while (nowNs() < end);
+        return hash;
+    }
+
+    // 原配置下 glog 的写法：每行在全局锁内格式化前缀、写入并刷新
+    class SyncFlushLog
+    {
+    public:
+        explicit SyncFlushLog(const std::string& path) : file_(std::fopen(path.c_str(), "w")) {}
+        ~SyncFlushLog() { if (file_) std::fclose(file_); }
+
+        void write(const char* file, int line, const std::string& message)
+        {
+            struct timeval tv;
+            gettimeofday(&tv, nullptr);
+            struct tm tm_time;
+            localtime_r(&tv.tv_sec, &tm_time);
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::fprintf(file_, "I%04d%02d%02d %02d:%02d:%02d.%06ld %ld %s:%d] %s\n",
+                tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+                tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec, static_cast<long>(tv.tv_usec),
+                static_cast<long>(::syscall(SYS_gettid)), file, line, message.c_str());
+            std::fflush(file_);
+        }
+
+    private:
+        std::FILE* file_;
+        std::mutex mutex_;
+    };
+
+    const char* const DOMAIN_ID = "34020000002000000001";
+
+    void syncRequest(SyncFlushLog& log, uint64_t i, int64_t work_ns)
+    {
+        Bench::doNotOptimize(work(i, work_ns));
+        for (int line = 0; line < LINES_PER_REQUEST; ++line)
+        {
+            log.write("sip_register.cpp", 300 + line, "Processing auth request for user: " + std::string(DOMAIN_ID)
+                + ", step " + std::to_string(line) + ", rdata=" + std::to_string(i));
+        }
+    }
+
+    template<bool DEMOTED>
+    void asyncRequest(uint64_t i, int64_t work_ns)
+    {
+        Bench::doNotOptimize(work(i, work_ns));
+        for (int line = 0; line < LINES_PER_REQUEST; ++line)
+        {
+            if (DEMOTED && line >= INFO_LINES_AFTER)
+                LOG(DEBUG) << "Processing auth request for user: " << DOMAIN_ID << ", step " << line << ", rdata=" << i;
+            else
+                LOG(INFO) << "Processing auth request for user: " << DOMAIN_ID << ", step " << line << ", rdata=" << i;
+        }
+    }
+
+    void stormRequest(const std::string& device_id, uint64_t i, int64_t work_ns)
+    {
+        Bench::doNotOptimize(work(i, work_ns));
+        LOG(ERROR) << "Username mismatch: " << device_id << ", rdata=" << i;
+    }
+
+    void limitedStormRequest(const std::string& device_id, uint64_t i, int64_t work_ns)
+    {
+        Bench::doNotOptimize(work(i, work_ns));
+        LOG_LIMITED(ERROR, device_id) << "Username mismatch: " << device_id << ", rdata=" << i;
+    }
+
+    LogRateSiteStats limiterTotals()
+    {
+        LogRateSiteStats totals;
+        for (const auto& site : LogRateLimiter::getInstance()->siteStats())
+        {
+            totals.passed += site.passed;
+            totals.suppressed += site.suppressed;
+        }
+        return totals;
+    }
+
+    template<class F>
+    int64_t runThreads(size_t threads, uint64_t requests, F&& body)
+    {
+        std::atomic<size_t> ready{ 0 };
+        std::atomic<bool> go{ false };
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t] {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                for (uint64_t i = t; i < requests; i += threads) body(i);
+            });
+        }
+        while (ready.load() < threads) std::this_thread::yield();
+        int64_t start = nowNs();
+        go.store(true, std::memory_order_release);
+        for (auto& w : workers) w.join();
+        return nowNs() - start;
+    }
+
+    Bench::Result perRequest(const std::string& name, uint64_t requests, int64_t elapsed_ns)
+    {
+        Bench::Result result = Bench::makeResult(name, requests, static_cast<double>(elapsed_ns));
+        result.metrics.emplace_back("register_per_sec", result.ops_per_sec);
+        return result;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    uint64_t requests = 200000;
+    size_t max_threads = std::max<size_t>(2, std::thread::hardware_concurrency());
+    int64_t work_ns = 2000;
+    size_t devices = 200;
+    std::string dir = (std::filesystem::temp_directory_path() / "log_bench").string();
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--dir") { dir = argv[i + 1]; continue; }
+        long long value = std::strtoll(argv[i + 1], nullptr, 10);
+        if (arg == "--requests") requests = static_cast<uint64_t>(value);
+        else if (arg == "--threads") max_threads = static_cast<size_t>(value);
+        else if (arg == "--work-ns") work_ns = value;
+        else if (arg == "--devices") devices = static_cast<size_t>(std::max(1LL, value));
+    }
+
+    Bench::Reporter reporter("log", argc, argv);
+    std::filesystem::create_directories(dir);
+    int rc = 0;
+
+    AsyncLogOptions options;
+    options.dir = dir;
+    options.name = "log_bench.log";
+    options.stderr_level = SIP_LOG_LEVEL_ERROR + 1;   // 不回显到终端
+    options.max_file_bytes = 256u << 20;
+    options.keep_files = 1;
+    auto async_log = AsyncLog::getInstance();
+    LogRateLimitOptions limit_options;
+    LogRateLimiter::getInstance()->configure(limit_options);
+
+    std::vector<size_t> thread_counts{ 1 };
+    if (max_threads > 1) thread_counts.push_back(max_threads);
+
+    for (size_t threads : thread_counts)
+    {
+        std::string suffix = "/" + std::to_string(threads);
+
+        int64_t elapsed = runThreads(threads, requests, [&](uint64_t i) { Bench::doNotOptimize(work(i, work_ns)); });
+        reporter.add(perRequest("no-log" + suffix, requests, elapsed));
+
+        double sync_rate = 0.0;
+        {
+            SyncFlushLog sync_log(dir + "/sync_flush.log");
+            elapsed = runThreads(threads, requests, [&](uint64_t i) { syncRequest(sync_log, i, work_ns); });
+            Bench::Result result = perRequest("sync-flush" + suffix, requests, elapsed);
+            sync_rate = result.ops_per_sec;
+            reporter.add(std::move(result));
+        }
+
+        // 计时包含把缓冲区写完的时间
+        std::filesystem::remove(dir + "/" + options.name);
+        async_log->start(options);
+        async_log->flush();
+        AsyncLogStats before = async_log->stats();
+        int64_t start = nowNs();
+        runThreads(threads, requests, [&](uint64_t i) { asyncRequest<false>(i, work_ns); });
+        async_log->flush(10000);
+        elapsed = nowNs() - start;
+        AsyncLogStats after = async_log->stats();
+        async_log->stop();
+
+        Bench::Result result = perRequest("async" + suffix, requests, elapsed);
+        uint64_t emitted = requests * LINES_PER_REQUEST;
+        uint64_t accounted = (after.written - before.written) + (after.dropped - before.dropped);
+        result.metrics.emplace_back("dropped_lines", static_cast<double>(after.dropped - before.dropped));
+        result.metrics.emplace_back("speedup_vs_sync", sync_rate > 0 ? result.ops_per_sec / sync_rate : 0.0);
+        if (accounted != emitted)
+        {
+            std::fprintf(stderr, "async log accounted %llu of %llu lines\n",
+                static_cast<unsigned long long>(accounted), static_cast<unsigned long long>(emitted));
+            rc = 1;
+        }
+        if (threads == thread_counts.back() && result.ops_per_sec < sync_rate)
+        {
+            std::fprintf(stderr, "async logging (%.0f REGISTER/s) is slower than sync-flush (%.0f REGISTER/s)\n",
+                result.ops_per_sec, sync_rate);
+            rc = 1;
+        }
+        reporter.add(std::move(result));
+
+        std::filesystem::remove(dir + "/" + options.name);
+        async_log->start(options);
+        start = nowNs();
+        runThreads(threads, requests, [&](uint64_t i) { asyncRequest<true>(i, work_ns); });
+        async_log->flush(10000);
+        elapsed = nowNs() - start;
+        async_log->stop();
+        result = perRequest("async-debug" + suffix, requests, elapsed);
+        result.metrics.emplace_back("speedup_vs_sync", sync_rate > 0 ? result.ops_per_sec / sync_rate : 0.0);
+        reporter.add(std::move(result));
+
+        // 每轮使用新的设备 ID，令牌桶从满桶开始
+        std::vector<std::string> device_ids;
+        for (size_t d = 0; d < devices; ++d)
+        {
+            device_ids.push_back("3402000000132" + std::to_string(threads) + "_" + std::to_string(d));
+        }
+
+        std::filesystem::remove(dir + "/" + options.name);
+        async_log->start(options);
+        before = async_log->stats();
+        start = nowNs();
+        runThreads(threads, requests, [&](uint64_t i) { stormRequest(device_ids[i % devices], i, work_ns); });
+        async_log->flush(10000);
+        elapsed = nowNs() - start;
+        after = async_log->stats();
+        async_log->stop();
+        result = perRequest("storm-unlimited" + suffix, requests, elapsed);
+        result.metrics.emplace_back("lines_written", static_cast<double>(after.written - before.written));
+        double unlimited_rate = result.ops_per_sec;
+        reporter.add(std::move(result));
+
+        std::filesystem::remove(dir + "/" + options.name);
+        async_log->start(options);
+        before = async_log->stats();
+        LogRateSiteStats limit_before = limiterTotals();
+        start = nowNs();
+        runThreads(threads, requests, [&](uint64_t i) { limitedStormRequest(device_ids[i % devices], i, work_ns); });
+        async_log->flush(10000);
+        elapsed = nowNs() - start;
+        after = async_log->stats();
+        async_log->stop();
+        LogRateSiteStats limit_after = limiterTotals();
+
+        uint64_t passed = limit_after.passed - limit_before.passed;
+        uint64_t suppressed = limit_after.suppressed - limit_before.suppressed;
+        // 每台设备最多放行满桶的 burst 行加上期间补充的令牌
+        double allowed = static_cast<double>(devices)
+            * (limit_options.burst + limit_options.rate_per_sec * (static_cast<double>(elapsed) / 1e9) + 1.0);
+        result = perRequest("storm-limited" + suffix, requests, elapsed);
+        result.metrics.emplace_back("lines_written", static_cast<double>(after.written - before.written));
+        result.metrics.emplace_back("lines_suppressed", static_cast<double>(suppressed));
+        result.metrics.emplace_back("speedup_vs_unlimited", unlimited_rate > 0 ? result.ops_per_sec / unlimited_rate : 0.0);
+        if (passed + suppressed != requests)
+        {
+            std::fprintf(stderr, "rate limiter accounted %llu of %llu lines\n",
+                static_cast<unsigned long long>(passed + suppressed), static_cast<unsigned long long>(requests));
+            rc = 1;
+        }
+        if (static_cast<double>(passed) > allowed)
+        {
+            std::fprintf(stderr, "rate limiter passed %llu lines, budget %.0f\n",
+                static_cast<unsigned long long>(passed), allowed);
+            rc = 1;
+        }
+        reporter.add(std::move(result));
+    }
+
+    std::filesystem::remove_all(dir);
+    int out = reporter.finish();
+    return rc != 0 ? rc : out;
+}
@@ -0,0 +1,91 @@
+// manscdp_bench.cpp
+// 心跳消息体分类：流式扫描 vs tinyxml2 DOM 解析
+//
+// 用法: manscdp_bench [--out result.json]
+
+#include "bench_util.h"
+#include "manscdp_scanner.h"
+#include "tinyxml2.h"
+
+#include <cstring>
+#include <string>
+
+namespace {
+
+    const std::string kKeepalive =
+        "<?xml version=\"1.0\" encoding=\"GB2312\"?>\r\n"
+        "<Notify>\r\n"
+        "<CmdType>Keepalive</CmdType>\r\n"
+        "<SN>43</SN>\r\n"
+        "<DeviceID>34020000001320000001</DeviceID>\r\n"
+        "<Status>OK</Status>\r\n"
+        "</Notify>\r\n";
+
+    const std::string kCatalog =
+        "<?xml version=\"1.0\" encoding=\"GB2312\"?>\r\n"
+        "<Response>\r\n"
+        "<CmdType>Catalog</CmdType>\r\n"
+        "<SN>17430</SN>\r\n"
+        "<DeviceID>34020000001110000001</DeviceID>\r\n"
+        "<SumNum>1</SumNum>\r\n"
+        "<DeviceList Num=\"1\">\r\n"
+        "<Item>\r\n"
+        "<DeviceID>34020000001320000001</DeviceID>\r\n"
+        "<Name>Camera 1</Name>\r\n"
+        "<Status>ON</Status>\r\n"
+        "</Item>\r\n"
+        "</DeviceList>\r\n"
+        "</Response>\r\n";
+
+    // 与 SipMessage 中的 DOM 路径一致：解析后读取 CmdType / SN / DeviceID
+    bool domClassify(const std::string& body, bool& is_keepalive)
+    {
+        tinyxml2::XMLDocument doc;
+        if (doc.Parse(body.data(), body.size()) != tinyxml2::XML_SUCCESS) return false;
+        auto root = doc.RootElement();
+        if (!root) return false;
+        auto cmd = root->FirstChildElement("CmdType");
+        auto sn = root->FirstChildElement("SN");
+        auto id = root->FirstChildElement("DeviceID");
+        Bench::doNotOptimize(sn);
+        Bench::doNotOptimize(id);
+        is_keepalive = std::strcmp(root->Name(), "Notify") == 0
+            && cmd && cmd->GetText() && std::strcmp(cmd->GetText(), "Keepalive") == 0;
+        return true;
+    }
+
+    bool scanClassify(const std::string& body, bool& is_keepalive)
+    {
+        ManscdpScanner::Summary summary;
+        if (!ManscdpScanner::scan(body.data(), body.size(), summary)) return false;
+        Bench::doNotOptimize(summary);
+        is_keepalive = summary.isKeepalive();
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    constexpr uint64_t kIterations = 1000000;
+    Bench::Reporter reporter("manscdp", argc, argv);
+
+    bool keepalive = false;
+    reporter.add(Bench::run("keepalive/scanner", kIterations, [&] {
+        scanClassify(kKeepalive, keepalive);
+        Bench::doNotOptimize(keepalive);
+    }));
+    reporter.add(Bench::run("keepalive/tinyxml2", kIterations, [&] {
+        domClassify(kKeepalive, keepalive);
+        Bench::doNotOptimize(keepalive);
+    }));
+    reporter.add(Bench::run("catalog/scanner", kIterations, [&] {
+        scanClassify(kCatalog, keepalive);
+        Bench::doNotOptimize(keepalive);
+    }));
+    reporter.add(Bench::run("catalog/tinyxml2", kIterations, [&] {
+        domClassify(kCatalog, keepalive);
+        Bench::doNotOptimize(keepalive);
+    }));
+    return reporter.finish();
+}
@@ -0,0 +1,189 @@
+// metrics_bench.cpp
+// 指标写入的热路径开销与并发快照
+//
+//   counter/sharded/<T>: T 个线程各自对同一个分片计数器累加 --ops 次，统计每次写入耗时；
+//   counter/shared/<T>:  同样的负载写单个共享原子量，作为对照（缓存行在核间来回迁移）；
+//   histogram/<T>:       T 个线程各写 --ops 次直方图；
+//   snapshot:            写入进行中反复取快照，统计单次快照耗时，写入结束后核对总数。
+// 单次写入开销按线程 CPU 时间计算。分片计数器在最大线程数下的单次写入超过 --max-ns 纳秒，
+// 或快照总数与写入次数不符时以非零状态退出。
+//
+// 用法: metrics_bench [--ops N] [--threads N] [--max-ns N] [--out result.json]
+
+#include "bench_util.h"
+#include "metrics.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int64_t threadCpuNs()
+    {
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    struct RunTime
+    {
+        int64_t elapsed_ns{ 0 };
+        int64_t cpu_ns{ 0 };     // 各线程在写入循环中消耗的 CPU 时间之和
+    };
+
+    // 所有线程就绪后同时开始。按线程 CPU 时间计算单次写入开销，线程数超过核数时不受调度影响
+    template<class F>
+    RunTime runThreads(size_t threads, F&& body)
+    {
+        std::atomic<size_t> ready{ 0 };
+        std::atomic<bool> go{ false };
+        std::atomic<int64_t> cpu{ 0 };
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t] {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                int64_t start = threadCpuNs();
+                body(t);
+                cpu.fetch_add(threadCpuNs() - start);
+            });
+        }
+        while (ready.load() < threads) std::this_thread::yield();
+        int64_t start = nowNs();
+        go.store(true, std::memory_order_release);
+        for (auto& w : workers) w.join();
+        return RunTime{ nowNs() - start, cpu.load() };
+    }
+
+    Bench::Result perOp(const std::string& name, size_t threads, uint64_t ops, const RunTime& run)
+    {
+        uint64_t total = ops * threads;
+        Bench::Result result = Bench::makeResult(name, total, static_cast<double>(run.elapsed_ns));
+        result.metrics.emplace_back("cpu_ns_per_op", static_cast<double>(run.cpu_ns) / static_cast<double>(total));
+        return result;
+    }
+
+    double metric(const Bench::Result& result, const std::string& key)
+    {
+        for (const auto& [name, value] : result.metrics)
+        {
+            if (name == key) return value;
+        }
+        return 0.0;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    uint64_t ops = 10000000;
+    size_t max_threads = std::max<size_t>(2, std::thread::hardware_concurrency());
+    double max_ns = 10.0;
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        long long value = std::strtoll(argv[i + 1], nullptr, 10);
+        if (arg == "--ops") ops = static_cast<uint64_t>(value);
+        else if (arg == "--threads") max_threads = static_cast<size_t>(value);
+        else if (arg == "--max-ns") max_ns = static_cast<double>(value);
+    }
+
+    Bench::Reporter reporter("metrics", argc, argv);
+    auto registry = MetricsRegistry::getInstance();
+    int rc = 0;
+
+    std::vector<size_t> thread_counts{ 1 };
+    for (size_t t = 4; t < max_threads; t *= 2) thread_counts.push_back(t);
+    if (max_threads > 1) thread_counts.push_back(max_threads);
+
+    for (size_t threads : thread_counts)
+    {
+        Counter& counter = registry->counter("bench_sharded_total", "bench", {{"threads", std::to_string(threads)}});
+        RunTime elapsed = runThreads(threads, [&](size_t) {
+            for (uint64_t i = 0; i < ops; ++i) counter.inc();
+        });
+        Bench::Result sharded = perOp("counter/sharded/" + std::to_string(threads), threads, ops, elapsed);
+        if (counter.value() != ops * threads)
+        {
+            std::fprintf(stderr, "sharded counter lost updates: %llu != %llu\n",
+                static_cast<unsigned long long>(counter.value()), static_cast<unsigned long long>(ops * threads));
+            rc = 1;
+        }
+        if (threads == thread_counts.back() && metric(sharded, "cpu_ns_per_op") > max_ns)
+        {
+            std::fprintf(stderr, "sharded counter %.2f ns/op exceeds budget %.2f ns\n",
+                metric(sharded, "cpu_ns_per_op"), max_ns);
+            rc = 1;
+        }
+        reporter.add(std::move(sharded));
+
+        std::atomic<uint64_t> shared{ 0 };
+        elapsed = runThreads(threads, [&](size_t) {
+            for (uint64_t i = 0; i < ops; ++i) shared.fetch_add(1, std::memory_order_relaxed);
+        });
+        reporter.add(perOp("counter/shared/" + std::to_string(threads), threads, ops, elapsed));
+
+        Histogram& histogram = registry->histogram("bench_latency_seconds", "bench", {{"threads", std::to_string(threads)}});
+        elapsed = runThreads(threads, [&](size_t t) {
+            for (uint64_t i = 0; i < ops; ++i) histogram.observeNs(static_cast<int64_t>((i ^ t) & 0xfffff));
+        });
+        reporter.add(perOp("histogram/" + std::to_string(threads), threads, ops, elapsed));
+    }
+
+    // 写入进行中反复取快照
+    {
+        Counter& counter = registry->counter("bench_snapshot_total", "bench");
+        std::atomic<bool> writing{ true };
+        std::vector<int64_t> snapshot_ns;
+        std::thread reader([&] {
+            while (writing.load(std::memory_order_acquire))
+            {
+                int64_t start = nowNs();
+                auto samples = registry->snapshot();
+                snapshot_ns.push_back(nowNs() - start);
+            }
+        });
+        size_t threads = thread_counts.back();
+        RunTime elapsed = runThreads(threads, [&](size_t) {
+            for (uint64_t i = 0; i < ops; ++i) counter.inc();
+        });
+        writing.store(false, std::memory_order_release);
+        reader.join();
+
+        uint64_t total = 0;
+        for (const auto& sample : registry->snapshot())
+        {
+            if (sample.name == "bench_snapshot_total") total = static_cast<uint64_t>(sample.value);
+        }
+        Bench::Result result = perOp("snapshot/" + std::to_string(threads), threads, ops, elapsed);
+        std::sort(snapshot_ns.begin(), snapshot_ns.end());
+        result.metrics.emplace_back("snapshots", static_cast<double>(snapshot_ns.size()));
+        result.metrics.emplace_back("snapshot_p50_us",
+            snapshot_ns.empty() ? 0.0 : static_cast<double>(snapshot_ns[snapshot_ns.size() / 2]) / 1e3);
+        if (total != ops * threads)
+        {
+            std::fprintf(stderr, "snapshot total %llu != %llu\n",
+                static_cast<unsigned long long>(total), static_cast<unsigned long long>(ops * threads));
+            rc = 1;
+        }
+        reporter.add(std::move(result));
+    }
+
+    int out = reporter.finish();
+    return rc != 0 ? rc : out;
+}
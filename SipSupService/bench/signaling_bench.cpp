@@ -0,0 +1,294 @@
+// signaling_bench.cpp
+// 信令热路径上的单个函数的开销，各版本之间对比 JSON 结果即可发现回退
+//
+//   find-domain/<N>, find-domain-miss/<N>: N 个下级域时 GlobalCtl::findDomain 命中 / 未命中（持读锁，与调用方一致）；
+//   random-num/<L>:      GlobalCtl::getRandomNum(L)，nonce / opaque 每次质询生成一次；
+//   parse-from-header:   SipRegister::parseFromHeader 从已解析的 REGISTER 中取设备 ID；
+//   format-sip-date:     SipRegister::formatSIPDate；
+//   add-date-header:     SipRegister::addDateHeader（含取当前 UTC 时间与创建头部）；
+//   pool-round-trip:     ThreadPool::submit 后等待 future（单个任务的投递、唤醒与结果返回）；
+//   timer-schedule-cancel: TaskTimer::scheduleOnce + cancel（不启动定时器线程）；
+//   timer-fire:          TaskTimer::scheduleOnce(0) 到任务在线程池中执行的往返；
+//   conf-get-string/<N>, conf-get-string-miss/<N>: N 个下级域的配置文件上 ConfReader::getString
+//                        命中 / 未命中（未命中时会计算拼写建议）；
+//   read-conf/<N>:       N 个下级域时 SipLocalConfig::readConf 的完整解析。
+// 日志写到临时目录中的文件（与服务运行时一致，经 AsyncLog），不回显到终端。
+//
+// 用法: signaling_bench [--iterations N] [--subnodes N,N,...] [--dir path] [--out result.json]
+
+#include "bench_util.h"
+#include "conf_reader.h"
+#include "ev_thread_pool.h"
+#include "global_ctl.h"
+#include "sip_local_config.h"
+#include "sip_register.h"
+#include "task_timer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// SipRegister 的报文辅助函数为私有成员，由该结构体转发
+struct SipRegisterBench
+{
+    static std::string parseFromHeader(SipRegister& reg, pjsip_msg* msg) { return reg.parseFromHeader(msg); }
+    static std::string formatSIPDate(const std::tm& tm_utc) { return SipRegister::formatSIPDate(tm_utc); }
+    static bool addDateHeader(SipRegister& reg, pjsip_msg* msg, pj_pool_t* pool) { return reg.addDateHeader(msg, pool); }
+};
+
+namespace {
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::string subnodeId(size_t i)
+    {
+        // 20 位国标编码，末尾按序号区分
+        std::string suffix = std::to_string(i);
+        return "1100000000200" + std::string(7 - std::min<size_t>(7, suffix.size()), '0') + suffix;
+    }
+
+    // 生成含 subnodes 个下级域的配置文件
+    std::string writeConf(const std::string& dir, size_t subnodes)
+    {
+        std::string path = dir + "/sup_" + std::to_string(subnodes) + ".conf";
+        std::ofstream out(path);
+        out << "[local_server]\nlocal_ip = 127.0.0.1\nlocal_port = 11300\n\n"
+            << "[sip_server]\nsip_id = 10000000002000000001\nsip_ip = 127.0.0.1\nsip_port = 5061\n"
+            << "sip_realm = 1000000000\nsip_usr = admin\nsip_pwd = 123\n"
+            << "subnode_num = " << subnodes << "\n\n";
+        for (size_t i = 1; i <= subnodes; ++i)
+        {
+            out << "subnode_id" << i << " = " << subnodeId(i) << "\n"
+                << "subnode_ip" << i << " = 127.0.0." << (i % 250 + 1) << "\n"
+                << "subnode_port" << i << " = " << 7100 + i << "\n"
+                << "subnode_proto" << i << " = " << (i % 2) << "\n"
+                << "subnode_auth" << i << " = true\n\n";
+        }
+        return path;
+    }
+
+    std::vector<size_t> parseList(const char* arg)
+    {
+        std::vector<size_t> values;
+        std::stringstream ss(arg);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            long long value = std::strtoll(item.c_str(), nullptr, 10);
+            if (value > 0) values.push_back(static_cast<size_t>(value));
+        }
+        return values;
+    }
+
+    const char REGISTER_MSG[] =
+        "REGISTER sip:10000000002000000001@127.0.0.1:5061 SIP/2.0\r\n"
+        "Via: SIP/2.0/UDP 127.0.0.1:7101;rport;branch=z9hG4bK-bench-1\r\n"
+        "From: <sip:11000000002000000001@127.0.0.1:7101>;tag=bench\r\n"
+        "To: <sip:11000000002000000001@127.0.0.1:7101>\r\n"
+        "Call-ID: signaling-bench-1\r\n"
+        "CSeq: 1 REGISTER\r\n"
+        "Contact: <sip:11000000002000000001@127.0.0.1:7101>\r\n"
+        "Max-Forwards: 70\r\n"
+        "Expires: 3600\r\n"
+        "Content-Length: 0\r\n\r\n";
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    uint64_t iterations = 200000;
+    std::vector<size_t> subnode_counts{ 16, 256, 4096 };
+    std::string dir = (std::filesystem::temp_directory_path() / "signaling_bench").string();
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--iterations") iterations = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (arg == "--subnodes") subnode_counts = parseList(argv[i + 1]);
+        else if (arg == "--dir") dir = argv[i + 1];
+    }
+
+    Bench::Reporter reporter("signaling", argc, argv);
+    std::filesystem::create_directories(dir);
+
+    AsyncLogOptions log_options;
+    log_options.dir = dir;
+    log_options.name = "signaling_bench.log";
+    log_options.stderr_level = SIP_LOG_LEVEL_ERROR + 1;   // 不回显到终端
+    log_options.keep_files = 1;
+    auto async_log = AsyncLog::getInstance();
+    async_log->start(log_options);
+
+    // ===== GlobalCtl =====
+    GlobalCtl& ctl = GlobalCtl::getInstance();
+    for (size_t count : subnode_counts)
+    {
+        std::vector<std::string> ids;
+        {
+            std::unique_lock<std::shared_mutex> lock(ctl.getMutex());
+            auto& domains = ctl.getDomainInfoList();
+            domains.clear();
+            for (size_t i = 1; i <= count; ++i)
+            {
+                DomainInfo domain;
+                domain.sip_id = subnodeId(i);
+                domains.push_back(std::move(domain));
+                ids.push_back(subnodeId(i));
+            }
+        }
+        size_t next = 0;
+        reporter.add(Bench::run("find-domain/" + std::to_string(count), iterations, [&] {
+            std::shared_lock<std::shared_mutex> lock(ctl.getMutex());
+            Bench::doNotOptimize(ctl.findDomain(ids[next]));
+            next = next + 1 == ids.size() ? 0 : next + 1;
+        }));
+        const std::string missing = "34020000001320000001";
+        reporter.add(Bench::run("find-domain-miss/" + std::to_string(count), iterations, [&] {
+            std::shared_lock<std::shared_mutex> lock(ctl.getMutex());
+            Bench::doNotOptimize(ctl.findDomain(missing));
+        }));
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(ctl.getMutex());
+        ctl.getDomainInfoList().clear();
+    }
+
+    // random_device 每次调用都要读内核熵源，迭代数取 1/10
+    reporter.add(Bench::run("random-num/16", iterations / 10, [] {
+        Bench::doNotOptimize(GlobalCtl::getRandomNum(16));
+    }));
+
+    // ===== SipRegister 报文辅助函数 =====
+    pj_init();
+    pj_caching_pool cp;
+    pj_caching_pool_init(&cp, nullptr, SIP_STACK_SIZE);
+    pjsip_endpoint* endpt = nullptr;
+    if (pjsip_endpt_create(&cp.factory, "signaling-bench", &endpt) != PJ_SUCCESS)
+    {
+        std::fprintf(stderr, "pjsip_endpt_create failed\n");
+        return 1;
+    }
+    pj_pool_t* msg_pool = pj_pool_create(&cp.factory, "bench-msg", 4000, 4000, nullptr);
+    std::string raw(REGISTER_MSG);
+    pjsip_msg* msg = pjsip_parse_msg(msg_pool, raw.data(), raw.size(), nullptr);
+    if (!msg)
+    {
+        std::fprintf(stderr, "failed to parse REGISTER\n");
+        return 1;
+    }
+
+    SipRegister reg(ctl);
+    reporter.add(Bench::run("parse-from-header", iterations, [&] {
+        Bench::doNotOptimize(SipRegisterBench::parseFromHeader(reg, msg));
+    }));
+
+    std::time_t fixed_time = 1760000000;
+    std::tm tm_utc{};
+    gmtime_r(&fixed_time, &tm_utc);
+    reporter.add(Bench::run("format-sip-date", iterations, [&] {
+        Bench::doNotOptimize(SipRegisterBench::formatSIPDate(tm_utc));
+    }));
+
+    // 每次都加到新的响应消息上，定期清空内存池
+    pj_pool_t* hdr_pool = pj_pool_create(&cp.factory, "bench-hdr", 64 * 1024, 64 * 1024, nullptr);
+    uint64_t added = 0;
+    reporter.add(Bench::run("add-date-header", iterations, [&] {
+        if (++added % 256 == 0)
+        {
+            pj_pool_reset(hdr_pool);
+        }
+        pjsip_msg* response = pjsip_msg_create(hdr_pool, PJSIP_RESPONSE_MSG);
+        Bench::doNotOptimize(SipRegisterBench::addDateHeader(reg, response, hdr_pool));
+    }));
+
+    // ===== 线程池与定时器 =====
+    {
+        ThreadPool pool(4);
+        reporter.add(Bench::run("pool-round-trip", iterations / 4, [&] {
+            Bench::doNotOptimize(pool.submit(5, [] { return 1; }).get());
+        }));
+
+        TaskTimer idle_timer("bench-idle", &pool);
+        reporter.add(Bench::run("timer-schedule-cancel", iterations, [&] {
+            TimerHandle handle = idle_timer.scheduleOnce(std::chrono::milliseconds(5000), [] {});
+            idle_timer.cancel(handle);
+        }));
+
+        TaskTimer timer("bench-timer", &pool);
+        timer.start();
+        std::atomic<uint64_t> fired{ 0 };
+        uint64_t expected = 0;
+        int64_t start = nowNs();
+        uint64_t rounds = std::max<uint64_t>(1, iterations / 200);
+        for (uint64_t i = 0; i < rounds; ++i)
+        {
+            timer.scheduleOnce(std::chrono::milliseconds(0), [&fired] { fired.fetch_add(1, std::memory_order_release); });
+            ++expected;
+            while (fired.load(std::memory_order_acquire) < expected)
+            {
+                std::this_thread::yield();
+            }
+        }
+        reporter.add(Bench::makeResult("timer-fire", rounds, static_cast<double>(nowNs() - start)));
+        timer.stop();
+        pool.shutdown();
+    }
+
+    // ===== 配置读取 =====
+    for (size_t count : subnode_counts)
+    {
+        std::string path = writeConf(dir, count);
+        ConfReader reader(path);
+        std::vector<std::string> keys;
+        for (size_t i = 1; i <= count; ++i)
+        {
+            keys.push_back("subnode_ip" + std::to_string(i));
+        }
+        size_t next = 0;
+        reporter.add(Bench::run("conf-get-string/" + std::to_string(count), iterations, [&] {
+            Bench::doNotOptimize(reader.getString("sip_server", keys[next]));
+            next = next + 1 == keys.size() ? 0 : next + 1;
+        }));
+        // 未命中时对段内所有 key 计算编辑距离，开销随 key 数线性增长
+        uint64_t miss_iterations = std::max<uint64_t>(10, iterations / count);
+        reporter.add(Bench::run("conf-get-string-miss/" + std::to_string(count), miss_iterations, [&] {
+            std::string err;
+            Bench::doNotOptimize(reader.getString("sip_server", "subnode_ipx", &err));
+        }));
+
+        uint64_t reads = std::max<uint64_t>(3, 20000 / count);
+        bool ok = true;
+        reporter.add(Bench::run("read-conf/" + std::to_string(count), reads, [&] {
+            SipLocalConfig config(path);
+            ok = config.readConf() && config.getNodeInfoList().size() == count && ok;
+        }));
+        if (!ok)
+        {
+            std::fprintf(stderr, "readConf failed for %zu subnodes\n", count);
+            return 1;
+        }
+    }
+
+    pj_pool_release(hdr_pool);
+    pj_pool_release(msg_pool);
+    pjsip_endpt_destroy(endpt);
+    pj_caching_pool_destroy(&cp);
+
+    async_log->stop();
+    std::filesystem::remove_all(dir);
+    return reporter.finish();
+}
@@ -0,0 +1,120 @@
+// thread_pool_bench.cpp
+// 线程池调度开销：工作窃取 ThreadPool vs 旧版全局锁 LegacyThreadPool
+//
+// 场景：
+//   external - 非工作线程连续提交 N 个空任务（对应 pjsip 接收线程投递请求）
+//   fanout   - 每个根任务在工作线程内再提交若干子任务（对应任务内继续异步派发）
+// 除吞吐外记录 external 场景的排队延迟 p50 / p99（提交到开始执行）。
+//
+// 用法: thread_pool_bench [--tasks N] [--out result.json]
+
+#include "bench_util.h"
+#include "ev_thread_pool.h"
+#include "legacy_thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void waitFor(const std::atomic<uint64_t>& done, uint64_t target)
+    {
+        while (done.load(std::memory_order_acquire) < target)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    double percentile(std::vector<int64_t>& samples, double p)
+    {
+        if (samples.empty()) return 0.0;
+        size_t idx = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+        return static_cast<double>(samples[idx]) / 1000.0;
+    }
+
+    template <typename Pool>
+    Bench::Result external(const std::string& name, Pool& pool, uint64_t tasks)
+    {
+        std::atomic<uint64_t> done{0};
+        std::vector<int64_t> latency(tasks);
+
+        int64_t start = nowNs();
+        for (uint64_t i = 0; i < tasks; ++i)
+        {
+            int64_t submitted = nowNs();
+            pool.submit(5, [&latency, &done, i, submitted] {
+                latency[i] = nowNs() - submitted;
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        waitFor(done, tasks);
+        Bench::Result result = Bench::makeResult(name, tasks, static_cast<double>(nowNs() - start));
+        result.metrics.emplace_back("queue_p50_us", percentile(latency, 0.50));
+        result.metrics.emplace_back("queue_p99_us", percentile(latency, 0.99));
+        return result;
+    }
+
+    template <typename Pool>
+    Bench::Result fanout(const std::string& name, Pool& pool, uint64_t tasks)
+    {
+        constexpr uint64_t kChildren = 15;
+        uint64_t roots = tasks / (kChildren + 1);
+        uint64_t total = roots * (kChildren + 1);
+        std::atomic<uint64_t> done{0};
+
+        int64_t start = nowNs();
+        for (uint64_t i = 0; i < roots; ++i)
+        {
+            pool.submit(5, [&pool, &done] {
+                for (uint64_t c = 0; c < kChildren; ++c)
+                {
+                    pool.submit(5, [&done] { done.fetch_add(1, std::memory_order_release); });
+                }
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        waitFor(done, total);
+        return Bench::makeResult(name, total, static_cast<double>(nowNs() - start));
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    uint64_t tasks = 200000;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--tasks")
+        {
+            tasks = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+    }
+
+    Bench::Reporter reporter("thread_pool", argc, argv);
+    for (size_t threads : {1, 2, 4, 8, 16, 32, 64})
+    {
+        std::string suffix = "/t" + std::to_string(threads);
+        {
+            ThreadPool pool(threads);
+            reporter.add(external("external/stealing" + suffix, pool, tasks));
+            reporter.add(fanout("fanout/stealing" + suffix, pool, tasks));
+        }
+        {
+            LegacyThreadPool pool(threads);
+            reporter.add(external("external/legacy" + suffix, pool, tasks));
+            reporter.add(fanout("fanout/legacy" + suffix, pool, tasks));
+        }
+    }
+    return reporter.finish();
+}
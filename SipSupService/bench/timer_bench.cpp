@@ -0,0 +1,223 @@
+// timer_bench.cpp
+// 分层时间轮定时器的精度、抖动与操作开销
+//
+//   once/<N>:    同时挂起 N 个一次性定时器，延迟在 [10, --spread-ms] 毫秒内均匀分布，
+//                统计实际执行时刻相对请求时刻的延迟 p50 / p99 / max，以及提前触发的个数；
+//   every:       --periodic 个周期定时器按 --period-ms 运行 --run-ms 毫秒，
+//                统计相邻两次执行间隔相对周期的偏差（抖动）p99；
+//   ops/<M>:     M 个定时器的插入与取消耗时（不启动定时器线程）。
+// 任一定时器提前触发、未全部执行或 once 的 p99 延迟超过 --p99-budget-ms 时以非零状态退出。
+//
+// 用法: timer_bench [--count N] [--spread-ms N] [--periodic N] [--period-ms N] [--run-ms N]
+//                   [--ops N] [--p99-budget-ms N] [--out result.json]
+
+#include "bench_util.h"
+#include "ev_thread_pool.h"
+#include "task_timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    double percentileMs(std::vector<int64_t>& samples, double p)
+    {
+        if (samples.empty()) return 0.0;
+        size_t idx = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+        return static_cast<double>(samples[idx]) / 1e6;
+    }
+
+    Bench::Result runOnce(ThreadPool& pool, uint64_t count, int64_t spread_ms, uint64_t& early)
+    {
+        TaskTimer timer("bench-timer", &pool);
+        timer.start();
+
+        // 每个定时器只写自己的槽位，无需加锁
+        std::vector<int64_t> lateness(count, 0);
+        std::atomic<uint64_t> done{0};
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<int64_t> delay_dist(10, spread_ms);
+
+        int64_t start = nowNs();
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            int64_t delay_ms = delay_dist(rng);
+            int64_t due = nowNs() + delay_ms * 1000000;
+            timer.scheduleOnce(std::chrono::milliseconds(delay_ms), [&lateness, &done, i, due] {
+                lateness[i] = nowNs() - due;
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        while (done.load(std::memory_order_acquire) < count && nowNs() - start < (spread_ms + 10000) * 1000000)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        uint64_t fired = done.load(std::memory_order_acquire);
+        TaskTimerStats stats = timer.stats();
+        timer.stop();
+
+        early = static_cast<uint64_t>(std::count_if(lateness.begin(), lateness.end(), [](int64_t v) { return v < 0; }));
+        Bench::Result result = Bench::makeResult("once/" + std::to_string(count), fired, static_cast<double>(nowNs() - start));
+        result.metrics.emplace_back("late_p50_ms", percentileMs(lateness, 0.50));
+        result.metrics.emplace_back("late_p99_ms", percentileMs(lateness, 0.99));
+        result.metrics.emplace_back("late_max_ms", percentileMs(lateness, 1.0));
+        result.metrics.emplace_back("early", static_cast<double>(early));
+        result.metrics.emplace_back("dispatch_lag_p99_ms", stats.dispatch_lag.percentileNs(0.99) / 1e6);
+        return result;
+    }
+
+    Bench::Result runEvery(ThreadPool& pool, uint64_t periodic, int64_t period_ms, int64_t run_ms)
+    {
+        TaskTimer timer("bench-periodic", &pool);
+        timer.start();
+
+        struct Series
+        {
+            int64_t last{ 0 };
+            std::vector<int64_t> deviation;
+        };
+        std::vector<Series> series(periodic);
+        int64_t period_ns = period_ms * 1000000;
+
+        std::vector<TimerHandle> handles;
+        for (uint64_t i = 0; i < periodic; ++i)
+        {
+            Series* s = &series[i];
+            handles.push_back(timer.scheduleEvery(std::chrono::milliseconds(period_ms), [s, period_ns] {
+                int64_t now = nowNs();
+                if (s->last)
+                    s->deviation.push_back(std::abs(now - s->last - period_ns));
+                s->last = now;
+            }));
+        }
+        int64_t start = nowNs();
+        std::this_thread::sleep_for(std::chrono::milliseconds(run_ms));
+        for (auto& handle : handles)
+        {
+            timer.cancel(handle);
+        }
+        // 等待已派发的执行结束
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        TaskTimerStats stats = timer.stats();
+        timer.stop();
+
+        std::vector<int64_t> all;
+        for (auto& s : series)
+        {
+            all.insert(all.end(), s.deviation.begin(), s.deviation.end());
+        }
+        Bench::Result result = Bench::makeResult("every/" + std::to_string(periodic), stats.fired,
+            static_cast<double>(nowNs() - start));
+        result.metrics.emplace_back("jitter_p50_ms", percentileMs(all, 0.50));
+        result.metrics.emplace_back("jitter_p99_ms", percentileMs(all, 0.99));
+        result.metrics.emplace_back("skipped", static_cast<double>(stats.skipped));
+        return result;
+    }
+
+    void runOps(Bench::Reporter& reporter, ThreadPool& pool, uint64_t ops)
+    {
+        TaskTimer timer("bench-ops", &pool);
+        std::mt19937_64 rng(7);
+        std::uniform_int_distribution<int64_t> delay_dist(1, 3600 * 1000);
+        std::vector<TimerHandle> handles;
+        handles.reserve(ops);
+
+        int64_t start = nowNs();
+        for (uint64_t i = 0; i < ops; ++i)
+        {
+            handles.push_back(timer.scheduleOnce(std::chrono::milliseconds(delay_dist(rng)), [] {}));
+        }
+        Bench::Result insert = Bench::makeResult("ops/insert/" + std::to_string(ops), ops, static_cast<double>(nowNs() - start));
+        insert.metrics.emplace_back("pending", static_cast<double>(timer.pending()));
+        reporter.add(std::move(insert));
+
+        std::shuffle(handles.begin(), handles.end(), rng);
+        start = nowNs();
+        uint64_t cancelled = 0;
+        for (const auto& handle : handles)
+        {
+            cancelled += timer.cancel(handle) ? 1 : 0;
+        }
+        Bench::Result cancel = Bench::makeResult("ops/cancel/" + std::to_string(ops), ops, static_cast<double>(nowNs() - start));
+        cancel.metrics.emplace_back("cancelled", static_cast<double>(cancelled));
+        reporter.add(std::move(cancel));
+    }
+
+    double metric(const Bench::Result& result, const std::string& key)
+    {
+        for (const auto& [name, value] : result.metrics)
+        {
+            if (name == key) return value;
+        }
+        return 0.0;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    uint64_t count = 100000;
+    int64_t spread_ms = 2000;
+    uint64_t periodic = 1000;
+    int64_t period_ms = 100;
+    int64_t run_ms = 2000;
+    uint64_t ops = 1000000;
+    double p99_budget_ms = 10.0;
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        long long value = std::strtoll(argv[i + 1], nullptr, 10);
+        if (arg == "--count") count = static_cast<uint64_t>(value);
+        else if (arg == "--spread-ms") spread_ms = value;
+        else if (arg == "--periodic") periodic = static_cast<uint64_t>(value);
+        else if (arg == "--period-ms") period_ms = value;
+        else if (arg == "--run-ms") run_ms = value;
+        else if (arg == "--ops") ops = static_cast<uint64_t>(value);
+        else if (arg == "--p99-budget-ms") p99_budget_ms = static_cast<double>(value);
+    }
+
+    Bench::Reporter reporter("timer", argc, argv);
+    ThreadPool pool(2);
+    int rc = 0;
+
+    uint64_t early = 0;
+    Bench::Result once = runOnce(pool, count, spread_ms, early);
+    if (once.iterations != count)
+    {
+        std::fprintf(stderr, "only %llu of %llu timers fired\n",
+            static_cast<unsigned long long>(once.iterations), static_cast<unsigned long long>(count));
+        rc = 1;
+    }
+    if (early != 0)
+    {
+        std::fprintf(stderr, "%llu timers fired early\n", static_cast<unsigned long long>(early));
+        rc = 1;
+    }
+    if (metric(once, "late_p99_ms") > p99_budget_ms)
+    {
+        std::fprintf(stderr, "lateness p99 %.2f ms exceeds budget %.2f ms\n", metric(once, "late_p99_ms"), p99_budget_ms);
+        rc = 1;
+    }
+    reporter.add(std::move(once));
+    reporter.add(runEvery(pool, periodic, period_ms, run_ms));
+    runOps(reporter, pool, ops);
+
+    int out = reporter.finish();
+    return rc != 0 ? rc : out;
+}
@@ -0,0 +1,174 @@
+// trace_bench.cpp
+// REGISTER 分阶段计时的单请求开销
+//
+//   disabled/<T>: 未开启追踪时处理路径上的 6 次 RequestTrace::mark（只有线程局部读取）；
+//   enabled/<T>:  完整的一次追踪：begin、克隆阶段计时、切换当前对象、6 次标记、
+//                 finish 写入 7 个直方图（均未超过慢请求阈值）；
+//   slow/1:       每个请求都进入慢请求缓冲区（slow_ms = 0）的最坏情况。
+// 单请求开销按线程 CPU 时间计算，并换算为相对 --register-us（一次 REGISTER 处理耗时）的比例。
+// enabled 在最大线程数下的开销比例超过 --max-pct 时以非零状态退出。
+//
+// 用法: trace_bench [--ops N] [--threads N] [--register-us N] [--max-pct N] [--out result.json]
+
+#include "bench_util.h"
+#include "request_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int64_t threadCpuNs()
+    {
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    struct RunTime
+    {
+        int64_t elapsed_ns{ 0 };
+        int64_t cpu_ns{ 0 };
+    };
+
+    template<class F>
+    RunTime runThreads(size_t threads, F&& body)
+    {
+        std::atomic<size_t> ready{ 0 };
+        std::atomic<bool> go{ false };
+        std::atomic<int64_t> cpu{ 0 };
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&] {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                int64_t start = threadCpuNs();
+                body();
+                cpu.fetch_add(threadCpuNs() - start);
+            });
+        }
+        while (ready.load() < threads) std::this_thread::yield();
+        int64_t start = nowNs();
+        go.store(true, std::memory_order_release);
+        for (auto& w : workers) w.join();
+        return RunTime{ nowNs() - start, cpu.load() };
+    }
+
+    // 处理路径上的标记，与 SipRegister 中的顺序一致
+    void markStages()
+    {
+        RequestTrace::mark(TraceStage::QUEUE);
+        RequestTrace::mark(TraceStage::AUTH);
+        RequestTrace::status(200);
+        RequestTrace::mark(TraceStage::BUILD);
+        RequestTrace::mark(TraceStage::SEND);
+        RequestTrace::mark(TraceStage::UPDATE);
+    }
+
+    void tracedRequest()
+    {
+        RequestTrace trace;
+        trace.begin("REGISTER");
+        trace.record(TraceStage::CLONE);
+        RequestTrace::Scope scope(&trace);
+        markStages();
+        trace.finish(nullptr);
+    }
+
+    Bench::Result perRequest(const std::string& name, size_t threads, uint64_t ops, const RunTime& run, double register_us)
+    {
+        uint64_t total = ops * threads;
+        double ns = static_cast<double>(run.cpu_ns) / static_cast<double>(total);
+        Bench::Result result = Bench::makeResult(name, total, static_cast<double>(run.elapsed_ns));
+        result.metrics.emplace_back("cpu_ns_per_request", ns);
+        result.metrics.emplace_back("overhead_pct", ns / (register_us * 1000.0) * 100.0);
+        return result;
+    }
+
+    double metric(const Bench::Result& result, const std::string& key)
+    {
+        for (const auto& [name, value] : result.metrics)
+        {
+            if (name == key) return value;
+        }
+        return 0.0;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    uint64_t ops = 2000000;
+    size_t max_threads = std::max<size_t>(2, std::thread::hardware_concurrency());
+    double register_us = 100.0;
+    double max_pct = 1.0;
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        std::string arg = argv[i];
+        long long value = std::strtoll(argv[i + 1], nullptr, 10);
+        if (arg == "--ops") ops = static_cast<uint64_t>(value);
+        else if (arg == "--threads") max_threads = static_cast<size_t>(value);
+        else if (arg == "--register-us") register_us = static_cast<double>(value);
+        else if (arg == "--max-pct") max_pct = static_cast<double>(value);
+    }
+
+    Bench::Reporter reporter("trace", argc, argv);
+    auto tracer = RequestTracer::getInstance();
+    tracer->configure(RequestTraceOptions{ true, 1000000, 128 });
+    int rc = 0;
+
+    std::vector<size_t> thread_counts{ 1 };
+    if (max_threads > 1) thread_counts.push_back(max_threads);
+
+    for (size_t threads : thread_counts)
+    {
+        RunTime run = runThreads(threads, [&] {
+            for (uint64_t i = 0; i < ops; ++i) markStages();
+        });
+        reporter.add(perRequest("disabled/" + std::to_string(threads), threads, ops, run, register_us));
+
+        run = runThreads(threads, [&] {
+            for (uint64_t i = 0; i < ops; ++i) tracedRequest();
+        });
+        Bench::Result enabled = perRequest("enabled/" + std::to_string(threads), threads, ops, run, register_us);
+        if (threads == thread_counts.back() && metric(enabled, "overhead_pct") > max_pct)
+        {
+            std::fprintf(stderr, "tracing costs %.1f ns per request, %.3f%% of a %.0f us REGISTER exceeds %.2f%%\n",
+                metric(enabled, "cpu_ns_per_request"), metric(enabled, "overhead_pct"), register_us, max_pct);
+            rc = 1;
+        }
+        reporter.add(std::move(enabled));
+    }
+
+    // 最坏情况：每个请求都写入慢请求缓冲区
+    tracer->configure(RequestTraceOptions{ true, 0, 128 });
+    uint64_t slow_ops = std::max<uint64_t>(1, ops / 10);
+    RunTime run = runThreads(1, [&] {
+        for (uint64_t i = 0; i < slow_ops; ++i) tracedRequest();
+    });
+    reporter.add(perRequest("slow/1", 1, slow_ops, run, register_us));
+    if (tracer->slowTotal() != slow_ops)
+    {
+        std::fprintf(stderr, "slow ring recorded %llu of %llu requests\n",
+            static_cast<unsigned long long>(tracer->slowTotal()), static_cast<unsigned long long>(slow_ops));
+        rc = 1;
+    }
+
+    int out = reporter.finish();
+    return rc != 0 ? rc : out;
+}
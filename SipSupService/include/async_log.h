@@ -0,0 +1,125 @@
+// async_log.h - 异步日志后端
+//
+// LOG(severity) 不再经过 glog 的全局锁与逐行刷盘：消息在调用线程格式化到线程局部的行缓冲区，
+// 整行写入本线程独占的单生产者环形缓冲区（无锁），由后台服务线程 "log-writer" 轮询各线程的
+// 缓冲区，批量写入日志文件并按大小轮转。
+//   - 编译期最低级别 SIP_LOG_MIN_LEVEL（0 DEBUG, 1 INFO, 2 WARNING, 3 ERROR，默认 1）：
+//     低于该级别的 LOG 语句连同参数求值一起被编译器删除；
+//   - 运行期级别 AsyncLog::setLevel 只能在编译期级别之上进一步过滤；
+//   - 线程缓冲区写满时短暂等待后台线程腾出空间（WARNING 及以上等得更久），仍满则丢弃并计数；
+//   - 后台线程未启动（或已停止）时同步写到 stderr，基准程序等不初始化日志的场合也可直接使用。
+// 新增的 DEBUG 级别只用于每个请求都会经过的热路径。
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#define SIP_LOG_LEVEL_DEBUG   0
+#define SIP_LOG_LEVEL_INFO    1
+#define SIP_LOG_LEVEL_WARNING 2
+#define SIP_LOG_LEVEL_ERROR   3
+
+#ifndef SIP_LOG_MIN_LEVEL
+#define SIP_LOG_MIN_LEVEL SIP_LOG_LEVEL_INFO
+#endif
+
+struct AsyncLogOptions
+{
+    std::string dir;                          // 日志目录
+    std::string name;                         // 文件名（不含目录），轮转后为 name.1 ~ name.N
+    size_t max_file_bytes{ 64u << 20 };       // 单个文件上限
+    size_t keep_files{ 5 };                   // 保留的历史文件数
+    int stderr_level{ SIP_LOG_LEVEL_WARNING };// 不低于该级别的日志同时写到 stderr
+    int flush_ms{ 100 };                      // 后台线程空闲时的轮询周期
+    size_t thread_buffer_bytes{ 256u << 10 }; // 每个线程的环形缓冲区大小（向上取2的幂）
+};
+
+struct AsyncLogStats
+{
+    uint64_t written{ 0 };     // 已写入文件的行数
+    uint64_t dropped{ 0 };     // 因线程缓冲区满而丢弃的行数
+    uint64_t bytes{ 0 };
+    uint64_t rotations{ 0 };
+    size_t threads{ 0 };       // 已登记缓冲区的线程数
+};
+
+class AsyncLog
+{
+public:
+    static std::shared_ptr<AsyncLog> getInstance();
+    ~AsyncLog();
+
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+    // 打开日志文件并启动后台线程；失败时保持同步 stderr 输出
+    bool start(const AsyncLogOptions& options);
+    // 写完所有线程缓冲区中的日志后停止后台线程，之后的日志同步写到 stderr
+    void stop();
+    // 等待调用前提交的日志全部写入文件，超时返回 false
+    bool flush(int timeout_ms = 1000);
+
+    AsyncLogStats stats() const;
+
+    // 后台线程每轮写完后调用（如日志限流的汇总），须尽快返回
+    void addHousekeeping(std::function<void()> fn);
+
+    static bool enabled(int level) { return level >= level_.load(std::memory_order_relaxed); }
+    static void setLevel(int level) { level_.store(level, std::memory_order_relaxed); }
+    static int level() { return level_.load(std::memory_order_relaxed); }
+
+    // 提交一整行（已带前缀与换行）
+    static void submit(int level, const char* line, size_t len);
+
+private:
+    AsyncLog();
+
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+
+    static std::atomic<int> level_;
+    static std::shared_ptr<AsyncLog> instance_;
+    static std::mutex instance_mutex_;
+};
+
+// 一条日志：构造时写入前缀，析构时整行提交
+class AsyncLogMessage
+{
+public:
+    AsyncLogMessage(const char* file, int line, int level);
+    ~AsyncLogMessage();
+
+    AsyncLogMessage(const AsyncLogMessage&) = delete;
+    AsyncLogMessage& operator=(const AsyncLogMessage&) = delete;
+
+    std::ostream& stream() { return *stream_; }
+
+    class LineBuffer;
+
+private:
+    int level_;
+    LineBuffer* buffer_;
+    std::ostream* stream_;
+    std::unique_ptr<LineBuffer> nested_;   // 格式化参数时又写日志（嵌套）才使用
+};
+
+// 使 LOG(...) << ... 整体成为 void 表达式，可用于条件运算符
+struct AsyncLogVoidify
+{
+    void operator&(std::ostream&) {}
+};
+
+#define SIP_LOG_AT(level) \
+    !((level) >= SIP_LOG_MIN_LEVEL && AsyncLog::enabled(level)) \
+        ? (void)0 : AsyncLogVoidify() & AsyncLogMessage(__FILE__, __LINE__, (level)).stream()
+
+// 替换 glog 的 LOG 宏；glog 本身仍保留（InitGoogleLogging 等）
+#undef LOG
+#define LOG(severity) SIP_LOG_AT(SIP_LOG_LEVEL_##severity)
@@ -45,6 +45,8 @@
 constexpr size_t SIP_STACK_SIZE = 1024 * 256;
 // SIP分配池大小
 constexpr size_t SIP_ALLOC_POOL_1M = 1024 * 1024 * 1;
+// TCP 监听并发 accept 数
+constexpr unsigned SIP_TCP_ASYNC_CNT = 8;
 
 
 enum class SipStatusCode
@@ -1,6 +1,7 @@
 // ev_thread.h - 修改版
 #pragma once
 
+#include <algorithm>
 #include <thread>
 #include <future>
 #include <chrono>
@@ -9,33 +10,31 @@
 #include <functional>
 #include <type_traits>
 #include "common.h"
+#include "ev_task.h"
+#include "task_telemetry.h"
 #include "ev_thread_pool.h" // 引入线程池头文件
+#include "pool_autoscaler.h"
 
 // 前置声明
 class ThreadPool;
 
-// 线程优先级
+// 线程优先级；使用线程池时 HIGH / NORMAL / LOW 分别对应
+// TrafficClass::SIGNALING / CONTROL / BULK 通道
 enum class ThreadPriority { LOW, NORMAL, HIGH };
 
-// 线程运行状态
-enum class ThreadState { CREATED, RUNNING, COMPLETED, FAILED };
-
-// 线程状态跟踪
-struct ThreadLogs {
-    std::thread::id thread_id;
-    std::chrono::system_clock::time_point start_time;
-    std::chrono::system_clock::time_point end_time;
-    ThreadState thread_state{ThreadState::CREATED};
-    std::string last_error;
-};
-
 // 线程封装类
 class EVThread {
 public:
     // 获取全局线程池的实例
     static ThreadPool& getThreadPool();
+
+    // 为全局线程池启动弹性伸缩（重复调用时忽略），未启动时 getAutoscaler 返回 nullptr
+    static bool enableAutoscale(const PoolAutoscalerOptions& options);
+    static PoolAutoscaler* getAutoscaler();
     
-    // 创建并启动新线程，支持参数包及优先级、超时设置
+    // 创建并启动新线程，支持参数包及优先级、超时设置。
+    // 使用线程池时 timeout 作为任务的截止时间：排队超过 timeout 仍未开始执行的任务
+    // 被丢弃（future 收到 TaskCancelledError），执行中可通过 TaskContext 检查剩余时间
     template <typename Func, typename... Args>
     static auto createThread(
         Func&& func,
@@ -43,27 +42,38 @@ public:
         std::shared_ptr<std::atomic<std::thread::id>> thread_id_out = nullptr,
         ThreadPriority priority = ThreadPriority::NORMAL,
         std::chrono::milliseconds timeout = std::chrono::milliseconds{0}
-    ) -> std::future<std::invoke_result_t<Func, Args...>>
+    ) -> TaskFuture<std::invoke_result_t<Func, Args...>>
+    {
+        int64_t deadline_ns = 0;
+        if (timeout.count() > 0) {
+            deadline_ns = TaskContext::nowNs() + std::chrono::nanoseconds(timeout).count();
+        }
+        return createThreadUntil(std::forward<Func>(func), std::move(args), std::move(thread_id_out),
+                                 priority, deadline_ns);
+    }
+
+    // 同 createThread，截止时间直接给出 steady_clock 时刻（TaskContext::nowNs 的时基），
+    // 0 表示不设时限。用于按请求到达时间等外部时刻推算截止时间的场景
+    template <typename Func, typename... Args>
+    static auto createThreadUntil(
+        Func&& func,
+        std::tuple<Args...> args,
+        std::shared_ptr<std::atomic<std::thread::id>> thread_id_out,
+        ThreadPriority priority,
+        int64_t deadline_ns
+    ) -> TaskFuture<std::invoke_result_t<Func, Args...>>
     {
         using ReturnType = std::invoke_result_t<Func, Args...>;
         
-        // 创建一个共享的任务对象
-        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
-            [func = std::forward<Func>(func), args = std::move(args)]() mutable {
-                return std::apply(std::move(func), std::move(args));
-            }
-        );
+        // 共享状态是唯一的堆分配，执行体整体存放在 TaskFunction 的内联缓冲区中
+        TaskPromise<ReturnType> promise;
         
         // 获取future用于返回结果
-        std::future<ReturnType> future = task->get_future();
+        TaskFuture<ReturnType> future = promise.getFuture();
         
         // 创建执行任务的lambda
-        auto thread_func = [task, thread_id_out]() {
-            ThreadLogs logs;
-            logs.start_time = std::chrono::system_clock::now();
-            logs.thread_id = std::this_thread::get_id();
-            logs.thread_state = ThreadState::RUNNING;
-            
+        auto thread_func = [func = std::forward<Func>(func), args = std::move(args),
+                            promise = std::move(promise), thread_id_out]() mutable {
             // 如果需要，输出线程ID
             if (thread_id_out) {
                 *thread_id_out = std::this_thread::get_id();
@@ -71,32 +81,38 @@ public:
             
             try {
                 // 执行任务
-                (*task)();
-                logs.thread_state = ThreadState::COMPLETED;
+                if constexpr (std::is_void_v<ReturnType>) {
+                    std::apply(std::move(func), std::move(args));
+                    promise.setValue();
+                } else {
+                    promise.setValue(std::apply(std::move(func), std::move(args)));
+                }
             } catch (const std::exception& e) {
-                logs.thread_state = ThreadState::FAILED;
-                logs.last_error = e.what();
                 LOG(ERROR) << "Thread execution failed: " << e.what();
+                // 记入线程池任务遥测（线程池外执行时忽略）
+                TaskTelemetry::reportError(e.what());
+                promise.setException(std::current_exception());
             } catch (...) {
-                logs.thread_state = ThreadState::FAILED;
-                logs.last_error = "Unknown exception";
                 LOG(ERROR) << "Thread execution failed with unknown exception";
+                TaskTelemetry::reportError("Unknown exception");
+                promise.setException(std::current_exception());
             }
-            
-            logs.end_time = std::chrono::system_clock::now();
-            // 存储线程日志
-            storeThreadLog(logs);
         };
         
         // 创建新线程并启动
         // 判断是否使用线程池
         if (shouldUseThreadPool()) {
             // 任务提交给线程池处理，优先级基于ThreadPriority
-            int task_priority = getPriorityValue(priority);
-            getThreadPool().submit(task_priority, thread_func);
+            TaskOptions options;
+            options.priority = getPriorityValue(priority);
+            options.traffic_class = ThreadPool::classOf(options.priority);
+            if (deadline_ns) {
+                options.expiresAt(deadline_ns);
+            }
+            getThreadPool().post(std::move(options), std::move(thread_func));
         } else {
             // 直接创建线程
-            std::shared_ptr<std::thread> thread_ptr = std::make_shared<std::thread>(thread_func);
+            std::shared_ptr<std::thread> thread_ptr = std::make_shared<std::thread>(std::move(thread_func));
             
             // 尝试设置优先级（忽略失败）
             try {
@@ -105,8 +121,11 @@ public:
                 LOG(WARNING) << "Failed to set thread priority: " << e.what();
             }
             
-            // 如果设置了超时，创建监控线程
-            if (timeout.count() > 0) {
+            // 如果设置了超时，创建监控线程；已过截止时间的按 1ms 计
+            if (deadline_ns) {
+                auto timeout = std::max(std::chrono::milliseconds{1},
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::nanoseconds(deadline_ns - TaskContext::nowNs())));
                 std::thread monitor_thread([timeout, thread = thread_ptr]() {
                     if (joinWithTimeout(*thread, timeout)) {
                         LOG(INFO) << "Thread completed within timeout";
@@ -148,9 +167,6 @@ public:
     static bool isThreadPoolEnabled();
 
 private:
-    // 存储线程日志
-    static void storeThreadLog(const ThreadLogs& logs);
-    
     // 决定是否应该使用线程池
     static bool shouldUseThreadPool();
     
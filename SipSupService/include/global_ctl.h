@@ -61,6 +61,15 @@ private:
     GlobalCtl(const GlobalCtl&) = delete;
     GlobalCtl& operator=(const GlobalCtl&) = delete;
 
+    // 注册线程池与域注册表的拉取式指标
+    void registerMetrics();
+    // 注册管理接口的 /debug/domains
+    void registerAdminRoutes();
+
+    // 管理接口读取的域注册表副本：只尝试获取读锁，写者持锁时返回上一次的副本，
+    // 不让抓取请求排在信令线程之前。fresh 表示本次是否重新复制
+    std::shared_ptr<const std::vector<DomainInfo>> domainSnapshot(bool* fresh = nullptr) const;
+
     // 使用读写锁替代互斥锁，提高并发性
     // 域信息映射表，使用共享互斥锁保护
     mutable std::shared_mutex domain_mutex_;
@@ -79,4 +88,7 @@ private:
     // 域信息列表，所有操作用 domain_mutex_保护（保持不变）
     std::vector<DomainInfo> domain_info_list_;
 
+    mutable std::mutex snapshot_mutex_;
+    mutable std::shared_ptr<const std::vector<DomainInfo>> domain_snapshot_;
+
 };
\ No newline at end of file
@@ -3,6 +3,11 @@
 #pragma once
 
 #include "node_info.h"
+#include "thread_placement.h"
+#include "pool_autoscaler.h"
+#include "request_trace.h"
+#include "log_rate_limit.h"
+#include "pool_monitor.h"
 #include <string>
 #include <vector>
 
@@ -12,6 +17,9 @@ class IConfigProvider
 public:
     virtual ~IConfigProvider() = default;
     virtual const std::string& getLocalIp() const = 0;
+    // [local_server] 管理/指标 HTTP 接口的监听地址与端口
+    virtual const std::string& getAdminIp() const = 0;
+    virtual int getLocalPort() const = 0;
     virtual const std::string& getSipId() const = 0;
     virtual const std::string& getSipIp() const = 0;
     virtual int getSipPort() const = 0;
@@ -19,5 +27,20 @@ public:
     virtual const std::string& getSipUsr() const = 0;
     virtual const std::string& getSipPwd() const = 0;
     virtual const std::vector<NodeInfo>& getNodeInfoList() const = 0;
+    // GB28181 心跳周期（秒）与最大允许丢失次数
+    virtual int getKeepaliveInterval() const = 0;
+    virtual int getKeepaliveMaxMissed() const = 0;
+    // TCP 长连接空闲回收时间（秒）
+    virtual int getTcpIdleTimeout() const = 0;
+    // [thread_placement] 各线程角色的 CPU 亲和集合
+    virtual const ThreadPlacementConfig& getThreadPlacement() const = 0;
+    // [thread_pool] 请求处理线程池的弹性伸缩参数
+    virtual const PoolAutoscalerOptions& getPoolAutoscale() const = 0;
+    // [trace] 请求分阶段计时与慢请求记录
+    virtual const RequestTraceOptions& getRequestTrace() const = 0;
+    // [log] 日志限流与 INFO 采样
+    virtual const LogRateLimitOptions& getLogRateLimit() const = 0;
+    // [pool_stats] PJSIP 内存池用量采集
+    virtual const PoolStatsOptions& getPoolStats() const = 0;
     virtual bool readConf() = 0; // 添加读取配置的接口方法
 };
\ No newline at end of file
@@ -13,5 +13,7 @@ public:
     virtual ~ISipCore() = default;
     virtual pj_status_t initSip(int sip_port) = 0;
     virtual SipTypes::EndpointPtr getEndPoint() const = 0;
+    // 唤醒阻塞中的事件循环（跨线程调度定时器、请求停止之后调用）
+    virtual void wakeup() = 0;
     // 添加其他必要的接口方法
 };
\ No newline at end of file
@@ -13,7 +13,6 @@ public:
     
     // 使用智能指针作为参数
     virtual pj_status_t runRxTask(SipTypes::RxDataPtr rdata) = 0;
-    virtual pj_status_t registerReqMsg(SipTypes::RxDataPtr rdata) = 0;
 
 protected:
     virtual std::string parseFromHeader(pjsip_msg* msg) = 0;
@@ -0,0 +1,64 @@
+// loop_waker.h - pjsip 事件循环的跨线程唤醒
+//
+// 事件循环阻塞在 pjsip_endpt_handle_events 里，等待的时长由端点定时器堆中最近的
+// 到期时刻和循环自身的上限决定。其他线程新调度的定时器、新发出的消息、停止请求
+// 在事件循环下一次醒来之前都不会被注意到。
+//
+// LoopWaker 把一对 AF_UNIX 数据报套接字的读端注册到端点的 ioqueue：wake() 往写端
+// 写 1 字节，阻塞中的 ioqueue 轮询立即返回。连续的唤醒在被事件循环消费之前只写一次。
+// 用套接字对而不是 eventfd：pjsip 的 ioqueue 以 recv() 读取注册的句柄，eventfd 不支持。
+//
+// 另注册一个只观察发送的模块：非事件循环线程发出请求/响应时自动唤醒，事务层随后
+// 挂上的重传、超时定时器因此能被事件循环及时看到（见 consumeWake()）。
+#pragma once
+
+#include "common.h"
+#include "sip_types.h"
+
+#include <atomic>
+
+class LoopWaker
+{
+public:
+    LoopWaker() = default;
+    ~LoopWaker();
+
+    LoopWaker(const LoopWaker&) = delete;
+    LoopWaker& operator=(const LoopWaker&) = delete;
+
+    // 创建套接字对并注册到端点的 ioqueue，同时注册发送观察模块；pool 须比 LoopWaker 活得久
+    pj_status_t init(SipTypes::EndpointPtr endpt, pj_pool_t* pool);
+    // 注销模块与 ioqueue 句柄并关闭套接字，须在事件循环线程退出之后调用
+    void close();
+
+    // 唤醒阻塞中的事件循环，任意线程可调用；事件循环线程自身调用时什么都不做
+    void wake() noexcept;
+
+    // 由事件循环线程调用：本线程即事件循环
+    void attachLoopThread();
+    // 由事件循环线程调用：上一轮是否被 wake() 唤醒，同时清除该标记
+    bool consumeWake() noexcept { return woken_.exchange(false, std::memory_order_acq_rel); }
+
+    uint64_t wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+
+private:
+    static void onReadComplete(pj_ioqueue_key_t* key, pj_ioqueue_op_key_t* op_key, pj_ssize_t bytes_read);
+    static pj_status_t onTxMessage(pjsip_tx_data* tdata);
+
+    // 重新挂上异步读
+    void arm();
+
+    SipTypes::EndpointPtr endpt_;
+    int fds_[2] { -1, -1 };
+    pj_ioqueue_key_t* key_ { nullptr };
+    pj_ioqueue_op_key_t op_key_;
+    char buf_[16];
+    bool module_registered_ { false };
+
+    std::atomic<bool> pending_ { false };   // 已写入、尚未被读走
+    std::atomic<bool> woken_ { false };     // 事件循环尚未处理的唤醒
+    std::atomic<uint64_t> wakeups_ { 0 };
+
+    static pjsip_module tx_mod;
+    static std::atomic<LoopWaker*> current_;
+};
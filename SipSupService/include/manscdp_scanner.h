@@ -0,0 +1,31 @@
+// manscdp_scanner.h
+// MANSCDP 消息体的流式扫描：不构建 DOM，直接在原始缓冲区中定位根元素
+// 和 CmdType / SN / DeviceID 三个字段，用于心跳等高频消息的快速分类。
+// 扫描结果只是指向原缓冲区的视图，缓冲区释放后不可再使用。
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace ManscdpScanner {
+
+    // 扫描结果（均为原缓冲区上的视图，已去除首尾空白）
+    struct Summary
+    {
+        std::string_view root;        // 根元素名：Notify / Query / Response / Control
+        std::string_view cmd_type;
+        std::string_view sn;
+        std::string_view device_id;
+
+        bool isKeepalive() const { return root == "Notify" && cmd_type == "Keepalive"; }
+    };
+
+    // 扫描消息体。成功返回 true；遇到实体引用、CDATA 或格式异常时返回 false，
+    // 调用方应回退到 tinyxml2 完整解析。
+    bool scan(const char* data, size_t len, Summary& out);
+
+    // 在 [p, end) 中查找字符 c，支持 SSE2 时按16字节块比较
+    const char* findChar(const char* p, const char* end, char c);
+
+} // namespace ManscdpScanner
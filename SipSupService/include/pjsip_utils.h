@@ -51,6 +51,10 @@ namespace PjSipUtils {
     // ===== 线程管理 =====
     pj_status_t registerThread();
 
+    // ===== 日志 =====
+    // 把 PJSIP 内部日志转到 AsyncLog，并按当前日志级别设置 pj_log 级别
+    void routePjLog();
+
     // RAII线程注册器
     class ThreadRegistrar 
     {
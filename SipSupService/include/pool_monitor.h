@@ -0,0 +1,122 @@
+// pool_monitor.h - PJSIP 内存池用量统计
+//
+// 定期遍历 pj_caching_pool 的使用中池链表，得到：
+//   整体    使用中的池数、池容量合计（used_size）与历史峰值、缓存池留作复用的空闲内存；
+//   按前缀  池数与容量。PJSIP 的池名多为“类型前缀 + 地址”（tdta0x..、regc0x..、tsx0x..），
+//           截去第一个数字及之后的部分即为前缀，同类池归为一组。
+// 结果导出为 pjsip_pool_* 指标；容量最大的 top_pools 个池保留在快照中，供 /debug/pools 查看。
+// 某个前缀的池数只增不减通常意味着泄漏。
+//
+// 遍历期间持有缓存池的锁，其他线程创建 / 释放池会短暂等待。该锁只保护使用中池的链表，
+// 不阻止池的所属线程继续分配，因此只读取池名与容量这两个字段，不遍历池内的块链表
+// （pj_pool_get_used_size 会遍历，分配时块链表可能正被修改）；容量可能与所属线程的
+// 扩容并发，按近似值看待。采集由定时器驱动，不在信令线程上执行。
+
+#pragma once
+
+#include "common.h"
+#include "task_timer.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Gauge;
+
+struct PoolStatsOptions
+{
+    int interval_ms{ 10000 };        // 采集周期，0 表示关闭
+    size_t top_pools{ 20 };          // 快照中保留的最大池个数
+};
+
+// 单个池
+struct PoolInfo
+{
+    std::string name;
+    size_t capacity{ 0 };            // 已向缓存池申请的字节数
+};
+
+// 同一名称前缀的池
+struct PoolPrefixStats
+{
+    std::string prefix;
+    size_t pools{ 0 };
+    size_t capacity{ 0 };
+};
+
+struct PoolSnapshot
+{
+    int64_t collected_ns{ 0 };       // steady_clock 时刻，0 表示尚未采集
+    int64_t collect_ns{ 0 };         // 本次采集耗时
+    size_t pools{ 0 };               // 使用中的池数（used_count）
+    size_t peak_pools{ 0 };          // 历次采集中的最大池数
+    size_t used_size{ 0 };           // 使用中的池容量合计
+    size_t peak_used_size{ 0 };      // used_size 的历史峰值（由 pjlib 维护）
+    size_t cached_size{ 0 };         // 缓存池保留的空闲内存
+    size_t max_cached_size{ 0 };     // 空闲内存上限
+    std::vector<PoolPrefixStats> prefixes;   // 按容量从大到小
+    std::vector<PoolInfo> largest;           // 容量最大的池，按容量从大到小
+};
+
+class PoolMonitor : public std::enable_shared_from_this<PoolMonitor>
+{
+public:
+    static std::shared_ptr<PoolMonitor> getInstance();
+
+    PoolMonitor(const PoolMonitor&) = delete;
+    PoolMonitor& operator=(const PoolMonitor&) = delete;
+    ~PoolMonitor();
+
+    void configure(const PoolStatsOptions& options);
+
+    // 开始统计缓存池（端点创建之后由 SipCore 调用），interval_ms 大于0时启动定时采集
+    void start(pj_caching_pool* caching_pool);
+    // 停止采集并放开缓存池，须在缓存池销毁之前调用
+    void stop();
+
+    // 立即采集一次（定时器调用）；尚未 start 或已经 stop 时返回上一次的结果
+    std::shared_ptr<const PoolSnapshot> collect();
+    // 上一次采集的结果
+    std::shared_ptr<const PoolSnapshot> snapshot() const;
+
+    // 池名对应的前缀
+    static std::string prefixOf(const char* name);
+
+private:
+    PoolMonitor();
+
+    // 按前缀导出的指标，前缀首次出现时注册
+    struct PrefixGauges
+    {
+        Gauge* pools{ nullptr };
+        Gauge* capacity{ nullptr };
+    };
+
+    // 调用时须持有 collect_mutex_
+    void publish(const PoolSnapshot& snap);
+
+    // 前缀个数上限，超出的前缀计入 "other"，避免指标标签无限增长
+    static constexpr size_t MAX_PREFIXES = 64;
+
+    std::shared_ptr<TaskTimer> timer_;
+    PoolStatsOptions options_;
+
+    std::mutex collect_mutex_;
+    pj_caching_pool* caching_pool_{ nullptr };
+    size_t peak_pools_{ 0 };
+    std::unordered_map<std::string, PrefixGauges> prefix_gauges_;
+
+    mutable std::mutex snapshot_mutex_;
+    std::shared_ptr<const PoolSnapshot> snapshot_;
+
+    Gauge* pools_gauge_{ nullptr };
+    Gauge* used_gauge_{ nullptr };
+    Gauge* peak_used_gauge_{ nullptr };
+    Gauge* cached_gauge_{ nullptr };
+
+    static std::shared_ptr<PoolMonitor> instance_;
+    static std::mutex instance_mutex_;
+};
@@ -0,0 +1,141 @@
+// request_trace.h - 请求分阶段耗时追踪
+//
+// 每个被追踪的请求在 onRxRequestRaw 中创建一个 RequestTrace，随 ThRxParams 传到工作线程，
+// 各处理阶段结束时调用 RequestTrace::mark(stage)，把距上一次标记的耗时计入该阶段：
+//   clone   接收回调入口 → rx_data 克隆完成
+//   queue   投递线程池 → 工作线程开始执行（含排队等待）
+//   auth    处理入口 → 认证/域检查得出结论（含等待 auth_mutex_ 与摘要校验）
+//   build   创建响应、添加头部、解析响应地址
+//   send    pjsip_endpt_send_response
+//   update  更新域注册表、心跳与 TCP 连接
+// 处理函数通过线程局部的当前追踪对象标记，不需要改动接口签名；未开启追踪时当前对象为空，
+// mark 只是一次线程局部读取。
+// 请求结束时各阶段与总耗时计入直方图 sip_request_stage_seconds；总耗时超过 slow_ms 的请求
+// 另存入慢请求环形缓冲区（只有慢请求才复制 Call-ID 等字符串并加锁）。
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct pjsip_rx_data;
+class Histogram;
+
+enum class TraceStage : uint8_t { CLONE = 0, QUEUE, AUTH, BUILD, SEND, UPDATE, COUNT };
+
+constexpr size_t TRACE_STAGE_COUNT = static_cast<size_t>(TraceStage::COUNT);
+
+const char* traceStageName(TraceStage stage);
+
+struct RequestTraceOptions
+{
+    bool enabled{ true };
+    int64_t slow_ms{ 50 };           // 总耗时超过该值的请求进入慢请求缓冲区，0 表示全部记录
+    size_t slow_capacity{ 128 };     // 慢请求缓冲区容量
+};
+
+class RequestTrace
+{
+public:
+    RequestTrace() = default;
+
+    // 记录起点；只追踪 REGISTER
+    void begin(const char* method);
+    bool active() const { return method_ != nullptr; }
+
+    // 把距上一次标记的耗时计入 stage
+    void record(TraceStage stage);
+    void setStatus(int status_code) { status_code_ = status_code; }
+
+    // 计入直方图，慢请求写入缓冲区；rdata 仅在慢请求时用于读取 Call-ID 与 From
+    void finish(const pjsip_rx_data* rdata);
+
+    int64_t stageNs(TraceStage stage) const { return stage_ns_[static_cast<size_t>(stage)]; }
+    int64_t totalNs() const { return last_ns_ - start_ns_; }
+
+    // 作用于当前线程的追踪对象，没有时不做任何事
+    static void mark(TraceStage stage);
+    static void status(int status_code);
+    static RequestTrace* current();
+
+    // 在作用域内把 trace 设为当前线程的追踪对象
+    class Scope
+    {
+    public:
+        explicit Scope(RequestTrace* trace);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        RequestTrace* previous_;
+    };
+
+    static int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    const char* method_{ nullptr };
+    int64_t start_ns_{ 0 };
+    int64_t last_ns_{ 0 };
+    std::array<int64_t, TRACE_STAGE_COUNT> stage_ns_{};
+    int status_code_{ 0 };
+};
+
+// 一条慢请求记录
+struct SlowRequest
+{
+    std::string method;
+    std::string call_id;
+    std::string from;
+    int status_code{ 0 };
+    int64_t wall_time_ms{ 0 };       // 结束时的系统时间（毫秒）
+    int64_t total_ns{ 0 };
+    std::array<int64_t, TRACE_STAGE_COUNT> stage_ns{};
+};
+
+class RequestTracer
+{
+public:
+    static std::shared_ptr<RequestTracer> getInstance();
+
+    RequestTracer(const RequestTracer&) = delete;
+    RequestTracer& operator=(const RequestTracer&) = delete;
+
+    void configure(const RequestTraceOptions& options);
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    int64_t slowThresholdMs() const { return slow_ns_.load(std::memory_order_relaxed) / 1000000; }
+
+    // 由 RequestTrace::finish 调用
+    void complete(const RequestTrace& trace, const pjsip_rx_data* rdata, const char* method, int status_code);
+
+    // 按结束时间从新到旧排列
+    std::vector<SlowRequest> slowRequests() const;
+    uint64_t slowTotal() const;
+
+private:
+    RequestTracer();
+
+    std::atomic<bool> enabled_{ true };
+    std::atomic<int64_t> slow_ns_{ 50 * 1000000LL };
+
+    // 目前只追踪 REGISTER，直方图在构造时注册
+    std::array<Histogram*, TRACE_STAGE_COUNT> stage_hist_{};
+    Histogram* total_hist_{ nullptr };
+
+    mutable std::mutex slow_mutex_;
+    std::vector<SlowRequest> slow_ring_;
+    size_t slow_capacity_{ 128 };
+    uint64_t slow_total_{ 0 };
+
+    static std::shared_ptr<RequestTracer> instance_;
+    static std::mutex instance_mutex_;
+};
@@ -0,0 +1,88 @@
+// service_thread.h - 长期运行的服务线程
+//
+// pjsip 事件循环、定时器等常驻循环使用独立线程运行，不再占用处理 SIP 请求的
+// 线程池工作线程。线程可命名、绑定 CPU、设置调度策略，支持停止/等待退出，
+// 并统计线程 CPU 时间。所有服务线程登记在全局列表中，可通过 stats() 查询。
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+
+struct ServiceThreadOptions
+{
+    std::string name;                  // 线程名（Linux 下最长15字节，超出截断）
+    std::vector<int> cpus;             // 绑定的 CPU 编号，为空时不绑定
+    int sched_policy{ SCHED_OTHER };   // SCHED_OTHER / SCHED_FIFO / SCHED_RR
+    int sched_priority{ 0 };           // 实时策略下的优先级
+};
+
+struct ServiceThreadStats
+{
+    std::string name;
+    int tid{ 0 };                      // 内核线程 ID，未启动时为0
+    bool running{ false };
+    std::vector<int> cpus;
+    int64_t cpu_time_ns{ 0 };
+};
+
+class ServiceThread
+{
+public:
+    // 线程主体，应周期性检查 stopRequested() 并及时返回
+    using Body = std::function<void(ServiceThread&)>;
+
+    ServiceThread(ServiceThreadOptions options, Body body);
+    ~ServiceThread();
+
+    ServiceThread(const ServiceThread&) = delete;
+    ServiceThread& operator=(const ServiceThread&) = delete;
+
+    bool start();
+
+    // 设置停止标志，并调用 setWakeup 注册的回调唤醒阻塞中的线程主体
+    void requestStop();
+    // 等待线程退出，timeout 为0时一直等待；超时返回 false（线程仍在运行）
+    bool join(std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
+    // requestStop + join
+    bool stop(std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
+
+    void setWakeup(std::function<void()> wakeup);
+
+    bool stopRequested() const { return stop_requested_.load(std::memory_order_acquire); }
+    bool isRunning() const { return running_.load(); }
+    const std::string& name() const { return options_.name; }
+
+    // 线程累计 CPU 时间（退出后为最终值）
+    int64_t cpuTimeNs() const;
+
+    static std::vector<ServiceThreadStats> stats();
+
+private:
+    void run();
+    void applyOptions();
+
+    ServiceThreadOptions options_;
+    Body body_;
+    std::function<void()> wakeup_;
+    std::thread thread_;
+
+    std::atomic<bool> stop_requested_{ false };
+    std::atomic<bool> running_{ false };
+    std::atomic<int> tid_{ 0 };
+    std::atomic<int64_t> final_cpu_ns_{ 0 };
+    clockid_t cpu_clock_{};
+
+    // 线程主体返回时通知 join
+    std::mutex exit_mutex_;
+    std::condition_variable exit_cv_;
+    bool exited_{ false };
+};
@@ -9,6 +9,8 @@
 #include "common.h"
 #include "pjsip_utils.h"
 #include "ev_thread.h"
+#include "service_thread.h"
+#include "loop_waker.h"
 
 #include "interfaces/isip_core.h"
 #include "interfaces/idomain_manager.h"
@@ -32,6 +34,7 @@ public:
     // 实现ISipCore接口
     pj_status_t initSip(int sip_port) override;
     SipTypes::EndpointPtr getEndPoint() const override { return endpt_; }
+    void wakeup() override { waker_.wake(); }
     
     void pollingEventLoop(SipTypes::EndpointPtr endpt);
 
@@ -42,6 +45,10 @@ public:
     static pj_bool_t onRxRequestRaw(pjsip_rx_data* rdata);
 
     static std::atomic<bool> stop_pool_;
+    // 无 I/O、无定时器到期时事件循环单次最长阻塞时间
+    static constexpr unsigned MAX_BLOCK_MS = 1000;
+    // 被跨线程唤醒后的下一轮只等待这么久，等发起线程挂好事务定时器再按定时器堆重新计算
+    static constexpr unsigned SETTLE_MS = 1;
     static pjsip_module recv_mod;
 
     
@@ -51,5 +58,10 @@ private:
     SipTypes::EndpointPtr endpt_;
     SipTypes::PoolPtr pool_;
 
+    // pjsip 事件循环线程（独立于请求处理线程池）
+    std::unique_ptr<ServiceThread> polling_thread_;
+    // 跨线程唤醒事件循环
+    LoopWaker waker_;
+
 
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+// sip_heartbeat.h
+// 下级设备心跳跟踪：收到 Keepalive 时只原子更新时间戳，
+// 离线判定由时间轮按设备心跳周期惰性检查，不做全表扫描。
+
+#pragma once
+
+#include "common.h"
+#include "task_timer.h"
+#include "timing_wheel.h"
+#include "interfaces/idomain_manager.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class SipHeartbeat : public std::enable_shared_from_this<SipHeartbeat>
+{
+public:
+    // 单例工厂
+    static std::shared_ptr<SipHeartbeat> getInstance(IDomainManager& domain_manager);
+
+    SipHeartbeat(const SipHeartbeat&) = delete;
+    SipHeartbeat& operator=(const SipHeartbeat&) = delete;
+    ~SipHeartbeat();
+
+    void startHeartbeatService();
+
+    // 快速路径：更新设备心跳时间戳，设备未知或不在线时返回 false。
+    // device_id 须取自请求的 From 头，而非消息体中的 DeviceID
+    bool onKeepalive(std::string_view device_id);
+
+    // 注册成功后开始跟踪；注销后停止跟踪
+    void track(const std::string& device_id);
+    void untrack(const std::string& device_id);
+
+    // 接收线程上的心跳快速路径：是 Keepalive 则直接无状态应答并返回 PJ_TRUE，
+    // 其他消息返回 PJ_FALSE 交给常规分发
+    pj_bool_t onRxMessage(pjsip_rx_data* rdata);
+
+    // 是否为 MESSAGE 请求（pjsip 没有内置的 MESSAGE 方法ID）
+    static bool isMessageRequest(const pjsip_msg* msg);
+    // From URI 中的用户部分（设备ID），不复制；没有时返回空
+    static std::string_view fromUser(const pjsip_rx_data* rdata);
+
+private:
+    explicit SipHeartbeat(IDomainManager& domain_manager);
+
+    struct DeviceState
+    {
+        std::string id;
+        std::atomic<int64_t> last_heartbeat_ms { 0 };
+        std::atomic<uint32_t> missed { 0 };
+        std::atomic<bool> online { false };
+        std::atomic<uint64_t> epoch { 0 };
+    };
+
+    struct WheelEntry
+    {
+        DeviceState* device { nullptr };
+        uint64_t epoch { 0 };
+        int64_t checked_ms { 0 };   // 上次检查时的心跳时间戳
+    };
+
+    // 根据当前域列表构建设备表（设备表只增不删，指针在进程内稳定）
+    void buildDeviceTable();
+    DeviceState* findDevice(std::string_view device_id) const;
+
+    void tickProc();
+    void checkDevice(const WheelEntry& entry);
+
+    static int64_t nowMs();
+
+    static constexpr unsigned int TICK_MS = 1000;
+
+    std::shared_ptr<TaskTimer> hb_timer_;
+    IDomainManager& domain_manager_;
+
+    mutable std::shared_mutex device_mutex_;
+    std::unordered_map<std::string_view, std::unique_ptr<DeviceState>> devices_;
+
+    std::mutex wheel_mutex_;
+    TimingWheel<WheelEntry> wheel_;
+
+    static std::shared_ptr<SipHeartbeat> instance_;
+    static std::mutex instance_mutex_;
+};
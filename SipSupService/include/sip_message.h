@@ -0,0 +1,40 @@
+// sip_message.h
+// MESSAGE 请求处理：心跳已在接收线程由 SipHeartbeat 应答，
+// 这里只处理其余 MANSCDP 命令，使用 tinyxml2 完整解析消息体。
+
+#pragma once
+
+#include "common.h"
+#include "interfaces/isip_task_base.h"
+#include "interfaces/idomain_manager.h"
+
+#include <memory>
+#include <mutex>
+
+class SipMessage : public ISipTaskBase,
+                   public std::enable_shared_from_this<SipMessage>
+{
+public:
+    // 单例工厂
+    static std::shared_ptr<SipMessage> getInstance(IDomainManager& domain_manager);
+
+    SipMessage(const SipMessage&) = delete;
+    SipMessage& operator=(const SipMessage&) = delete;
+    ~SipMessage() override = default;
+
+    // ISipTaskBase 接口实现
+    pj_status_t runRxTask(SipTypes::RxDataPtr rdata) override;
+
+protected:
+    std::string parseFromHeader(pjsip_msg* msg) override;
+
+private:
+    explicit SipMessage(IDomainManager& domain_manager);
+
+    pj_status_t respond(SipTypes::RxDataPtr rdata, int status_code);
+
+    IDomainManager& domain_manager_;
+
+    static std::shared_ptr<SipMessage> instance_;
+    static std::mutex instance_mutex_;
+};
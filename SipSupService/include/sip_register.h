@@ -33,7 +33,7 @@ public:
     // ISipTaskBase 接口实现
     // 实现使用智能指针的接口
     pj_status_t runRxTask(SipTypes::RxDataPtr rdata) override;
-    pj_status_t registerReqMsg(SipTypes::RxDataPtr rdata) override;
+    pj_status_t registerReqMsg(SipTypes::RxDataPtr rdata);
     
 protected:
     // ISipTaskBase 接口实现
@@ -51,6 +51,9 @@ private:
 
     void updateRegistrationStatus(const std::string& from_id, pj_int32_t expires_value);
 
+    // 基准程序（bench/signaling_bench.cpp）直接测量报文辅助函数
+    friend struct SipRegisterBench;
+
 private:   
     std::shared_ptr<TaskTimer> reg_timer_;
 
@@ -0,0 +1,124 @@
+// task_telemetry.h - 线程池任务遥测
+//
+// 每个工作线程持有一个固定容量的任务记录环（单写者），记录任务的开始/结束时间、
+// 排队等待时间、执行状态与错误信息，同时累计排队与执行耗时的对数直方图。
+// 写入端不加锁：每个槽位带序号（seqlock），读取端在序号前后一致时才采用该记录，
+// 因此快照不会阻塞工作线程，也不需要全局锁。
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 线程运行状态；CANCELLED 表示任务在出队时因取消或过期被丢弃，未执行
+enum class ThreadState { CREATED, RUNNING, COMPLETED, FAILED, CANCELLED };
+
+// 任务的流量类别，线程池按类别分通道加权公平调度
+//   SIGNALING  - REGISTER、心跳等时延敏感的信令
+//   CONTROL    - 一般 SIP 请求与控制命令
+//   BULK       - 目录同步等批量任务
+//   BACKGROUND - 统计、清理等后台任务
+enum class TrafficClass : uint8_t { SIGNALING = 0, CONTROL, BULK, BACKGROUND };
+constexpr size_t TRAFFIC_CLASS_COUNT = 4;
+
+const char* trafficClassName(TrafficClass cls);
+
+// 单个任务的执行记录
+struct TaskRecord
+{
+    static constexpr size_t ERROR_SIZE = 64;
+
+    uint64_t seq{ 0 };          // 该工作线程上的任务序号（从1开始）
+    size_t worker_id{ 0 };
+    int priority{ 0 };
+    TrafficClass traffic_class{ TrafficClass::CONTROL };
+    ThreadState state{ ThreadState::CREATED };
+    int64_t enqueue_ns{ 0 };    // steady_clock 时间戳
+    int64_t start_ns{ 0 };
+    int64_t end_ns{ 0 };
+    char error[ERROR_SIZE]{};   // 失败时的异常信息（截断）
+
+    int64_t queueWaitNs() const { return start_ns - enqueue_ns; }
+    int64_t runNs() const { return end_ns - start_ns; }
+};
+
+// 以2的幂划分的耗时直方图，第 i 个桶统计 [2^(i-1), 2^i) 纳秒
+struct LatencyHistogram
+{
+    static constexpr size_t BUCKETS = 40;
+
+    std::array<uint64_t, BUCKETS> buckets{};
+    uint64_t count{ 0 };
+
+    static size_t bucketOf(int64_t ns);
+
+    void merge(const LatencyHistogram& other);
+
+    // 百分位估计（取所在桶的上界，单位纳秒），p 取值 0~1
+    int64_t percentileNs(double p) const;
+};
+
+struct TaskTelemetrySnapshot
+{
+    std::vector<TaskRecord> recent;   // 按开始时间从新到旧排列
+    LatencyHistogram queue_wait;
+    LatencyHistogram run_time;
+    std::array<LatencyHistogram, TRAFFIC_CLASS_COUNT> class_queue_wait;   // 按流量类别的排队等待
+    uint64_t completed{ 0 };
+    uint64_t failed{ 0 };
+    uint64_t cancelled{ 0 };
+};
+
+// 单个工作线程的任务记录环，只允许所属工作线程写入
+class TaskTelemetryRing
+{
+public:
+    static constexpr size_t CAPACITY = 256;   // 必须是2的幂
+
+    void record(const TaskRecord& record);
+
+    // 读取最近的记录（最多 max_records 条）并合并直方图，可在任意线程调用
+    void collect(TaskTelemetrySnapshot& snapshot, size_t max_records) const;
+
+    uint64_t nextSeq() const { return head_.load(std::memory_order_relaxed) + 1; }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> version{ 0 };   // 奇数表示正在写入
+        TaskRecord record;
+    };
+
+    struct AtomicHistogram
+    {
+        std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKETS> buckets{};
+
+        void add(int64_t ns);
+        void load(LatencyHistogram& out) const;
+    };
+
+    std::array<Slot, CAPACITY> slots_;
+    std::atomic<uint64_t> head_{ 0 };         // 已写入的记录总数
+    AtomicHistogram queue_wait_;
+    AtomicHistogram run_time_;
+    std::array<AtomicHistogram, TRAFFIC_CLASS_COUNT> class_queue_wait_;
+    std::atomic<uint64_t> completed_{ 0 };
+    std::atomic<uint64_t> failed_{ 0 };
+    std::atomic<uint64_t> cancelled_{ 0 };
+};
+
+// 当前工作线程正在执行的任务，任务内部捕获异常后可通过它上报失败
+class TaskTelemetry
+{
+public:
+    // 由线程池在执行任务前后设置
+    static void setCurrent(TaskRecord* record);
+
+    // 将当前任务标记为失败；不在线程池任务中时忽略
+    static void reportError(const char* what);
+
+    static int64_t nowNs();
+};
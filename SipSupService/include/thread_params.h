@@ -4,6 +4,7 @@
 
 #include "common.h"
 #include "interfaces/isip_task_base.h"
+#include "request_trace.h"
 #include <memory>
 
 // 线程处理参数
@@ -12,6 +13,8 @@ struct ThRxParams
     // 使用智能指针
     SipTypes::RxDataPtr rxdata;
     std::shared_ptr<ISipTaskBase> taskbase;
+    // 接收线程上已开始的分阶段计时，由工作线程接着标记并在处理结束时提交
+    RequestTrace trace;
 
     ThRxParams() 
         : rxdata(nullptr)
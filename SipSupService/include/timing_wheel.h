@@ -0,0 +1,74 @@
+// timing_wheel.h
+// 单层哈希时间轮：插入 O(1)，每次推进一格只访问一个槽位。
+// 非线程安全，由使用者加锁；到期元素通过回调交给调用方批量处理。
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class TimingWheel
+{
+public:
+    explicit TimingWheel(size_t slot_count = 512)
+        : slots_(slot_count)
+    {
+        if (slot_count == 0) throw std::invalid_argument("slot_count must be > 0");
+    }
+
+    // 在 delay_ticks 格之后到期（至少1格）
+    void schedule(uint64_t delay_ticks, T value)
+    {
+        if (delay_ticks == 0) delay_ticks = 1;
+        uint64_t expire_tick = tick_ + delay_ticks;
+        slots_[expire_tick % slots_.size()].push_back(Entry{expire_tick, std::move(value)});
+        ++size_;
+    }
+
+    // 推进一格，对所有到期元素调用 on_expire(T&&)，回调中可以再次 schedule
+    template <typename F>
+    void advance(F&& on_expire)
+    {
+        ++tick_;
+        auto& slot = slots_[tick_ % slots_.size()];
+        if (slot.empty()) return;
+
+        // 先换出当前槽位，回调里重新插入的元素不会影响本次遍历
+        scratch_.clear();
+        scratch_.swap(slot);
+        for (auto& entry : scratch_)
+        {
+            if (entry.expire_tick <= tick_)
+            {
+                --size_;
+                on_expire(std::move(entry.value));
+            }
+            else
+            {
+                // 未到期（需要再转几圈）的元素放回原槽位
+                slot.push_back(std::move(entry));
+            }
+        }
+        scratch_.clear();
+    }
+
+    uint64_t currentTick() const { return tick_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    struct Entry
+    {
+        uint64_t expire_tick;
+        T value;
+    };
+
+    std::vector<std::vector<Entry>> slots_;
+    std::vector<Entry> scratch_;
+    uint64_t tick_ { 0 };
+    size_t size_ { 0 };
+};
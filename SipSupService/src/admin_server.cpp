@@ -0,0 +1,409 @@
+// admin_server.cpp
+#include "admin_server.h"
+#include "ev_thread.h"
+#include "log_rate_limit.h"
+#include "metrics.h"
+#include "pool_monitor.h"
+#include "task_timer.h"
+
+#include <event2/http.h>
+
+#include <chrono>
+
+namespace {
+    // 停止请求早于 event_base_dispatch 开始时，loopbreak 标志会被循环入口清除，
+    // 由该周期检查兜底退出
+    constexpr long STOP_CHECK_MS = 1000;
+
+    double toUs(int64_t ns)
+    {
+        return static_cast<double>(ns) / 1e3;
+    }
+
+    Json::Value latencyJson(const LatencyHistogram& histogram)
+    {
+        Json::Value out;
+        out["count"] = Json::UInt64(histogram.count);
+        out["p50_us"] = toUs(histogram.percentileNs(0.50));
+        out["p99_us"] = toUs(histogram.percentileNs(0.99));
+        return out;
+    }
+
+    struct StopCheck
+    {
+        ServiceThread* thread;
+        event_base* base;
+    };
+
+    void onStopCheck(evutil_socket_t, short, void* arg)
+    {
+        auto* check = static_cast<StopCheck*>(arg);
+        if (check->thread->stopRequested())
+        {
+            event_base_loopbreak(check->base);
+        }
+    }
+
+    const char* methodName(evhttp_cmd_type cmd)
+    {
+        switch (cmd)
+        {
+            case EVHTTP_REQ_GET:  return "GET";
+            case EVHTTP_REQ_HEAD: return "HEAD";
+            case EVHTTP_REQ_POST: return "POST";
+            case EVHTTP_REQ_PUT:  return "PUT";
+            default:              return "OTHER";
+        }
+    }
+}
+
+void AdminResponse::setJson(const Json::Value& value)
+{
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    content_type = "application/json";
+    body = Json::writeString(builder, value);
+    body += '\n';
+}
+
+std::shared_ptr<AdminServer> AdminServer::instance_ = nullptr;
+std::mutex AdminServer::instance_mutex_;
+
+std::shared_ptr<AdminServer> AdminServer::getInstance()
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+        instance_ = std::shared_ptr<AdminServer>(new AdminServer());
+    return instance_;
+}
+
+AdminServer::AdminServer()
+{
+    registerBuiltinRoutes();
+}
+
+AdminServer::~AdminServer()
+{
+    stop();
+}
+
+void AdminServer::addRoute(const std::string& path, Handler handler)
+{
+    std::lock_guard<std::mutex> lock(routes_mutex_);
+    routes_[path] = std::make_shared<Handler>(std::move(handler));
+}
+
+bool AdminServer::start(const std::string& ip, int port)
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (thread_)
+    {
+        LOG(WARNING) << "AdminServer already started";
+        return true;
+    }
+    if (port <= 0 || port > 65535)
+    {
+        LOG(ERROR) << "AdminServer: invalid port " << port;
+        return false;
+    }
+
+    // 其他线程调用 event_base_loopbreak 需要 libevent 的线程支持，且必须在创建 event_base 之前开启
+    static const int threads_enabled = evthread_use_pthreads();
+    if (threads_enabled != 0)
+    {
+        LOG(ERROR) << "AdminServer: evthread_use_pthreads failed";
+        return false;
+    }
+
+    base_ = event_base_new();
+    if (!base_)
+    {
+        LOG(ERROR) << "AdminServer: event_base_new failed";
+        return false;
+    }
+    http_ = evhttp_new(base_);
+    if (!http_ || evhttp_bind_socket(http_, ip.c_str(), static_cast<ev_uint16_t>(port)) != 0)
+    {
+        LOG(ERROR) << "AdminServer: failed to bind " << ip << ":" << port;
+        if (http_) evhttp_free(http_);
+        event_base_free(base_);
+        http_ = nullptr;
+        base_ = nullptr;
+        return false;
+    }
+    evhttp_set_allowed_methods(http_, EVHTTP_REQ_GET | EVHTTP_REQ_HEAD);
+    evhttp_set_gencb(http_, &AdminServer::onRequest, this);
+
+    event_base* base = base_;
+    thread_ = std::make_unique<ServiceThread>(ServiceThreadOptions{ "admin-http" }, [base](ServiceThread& self) {
+        StopCheck check{ &self, base };
+        event* timer = event_new(base, -1, EV_PERSIST, &onStopCheck, &check);
+        timeval interval{ STOP_CHECK_MS / 1000, (STOP_CHECK_MS % 1000) * 1000 };
+        event_add(timer, &interval);
+        while (!self.stopRequested())
+        {
+            if (event_base_dispatch(base) < 0)
+            {
+                LOG(ERROR) << "AdminServer: event_base_dispatch failed";
+                break;
+            }
+        }
+        event_free(timer);
+    });
+    thread_->setWakeup([base] { event_base_loopbreak(base); });
+    if (!thread_->start())
+    {
+        LOG(ERROR) << "AdminServer: failed to start admin-http thread";
+        thread_.reset();
+        evhttp_free(http_);
+        event_base_free(base_);
+        http_ = nullptr;
+        base_ = nullptr;
+        return false;
+    }
+
+    LOG(INFO) << "AdminServer listening on http://" << ip << ":" << port;
+    return true;
+}
+
+void AdminServer::stop()
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (!thread_)
+    {
+        return;
+    }
+    thread_->stop();
+    thread_.reset();
+    evhttp_free(http_);
+    event_base_free(base_);
+    http_ = nullptr;
+    base_ = nullptr;
+    LOG(INFO) << "AdminServer stopped";
+}
+
+bool AdminServer::isRunning() const
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return thread_ && thread_->isRunning();
+}
+
+void AdminServer::onRequest(evhttp_request* req, void* arg)
+{
+    static_cast<AdminServer*>(arg)->handle(req);
+}
+
+void AdminServer::handle(evhttp_request* req)
+{
+    const evhttp_uri* uri = evhttp_request_get_evhttp_uri(req);
+    const char* raw_path = uri ? evhttp_uri_get_path(uri) : nullptr;
+    std::string path = raw_path && *raw_path ? raw_path : "/";
+
+    std::shared_ptr<Handler> handler;
+    {
+        std::lock_guard<std::mutex> lock(routes_mutex_);
+        auto it = routes_.find(path);
+        if (it != routes_.end()) handler = it->second;
+    }
+
+    AdminResponse response;
+    if (!handler)
+    {
+        response.status = HTTP_NOTFOUND;
+        response.content_type = "text/plain";
+        response.body = "not found: " + path + "\n";
+    }
+    else
+    {
+        try {
+            (*handler)(response);
+        } catch (const std::exception& e) {
+            LOG(WARNING) << "AdminServer: " << methodName(evhttp_request_get_command(req))
+                         << " " << path << " failed: " << e.what();
+            response = AdminResponse{};
+            response.status = HTTP_INTERNAL;
+            response.content_type = "text/plain";
+            response.body = std::string("internal error: ") + e.what() + "\n";
+        }
+    }
+
+    evkeyvalq* headers = evhttp_request_get_output_headers(req);
+    evhttp_add_header(headers, "Content-Type", response.content_type.c_str());
+    evhttp_add_header(headers, "Cache-Control", "no-store");
+    evbuffer* out = evbuffer_new();
+    evbuffer_add(out, response.body.data(), response.body.size());
+    evhttp_send_reply(req, response.status, nullptr, out);
+    evbuffer_free(out);
+}
+
+void AdminServer::registerBuiltinRoutes()
+{
+    addRoute("/", [this](AdminResponse& response) {
+        Json::Value root;
+        Json::Value& routes = root["routes"];
+        routes = Json::Value(Json::arrayValue);
+        std::lock_guard<std::mutex> lock(routes_mutex_);
+        for (const auto& entry : routes_)
+        {
+            routes.append(entry.first);
+        }
+        response.setJson(root);
+    });
+
+    addRoute("/metrics", [](AdminResponse& response) {
+        response.content_type = "text/plain; version=0.0.4";
+        response.body = formatPrometheus(MetricsRegistry::getInstance()->snapshot());
+    });
+
+    addRoute("/debug/threads", [](AdminResponse& response) {
+        Json::Value root;
+
+        // 请求处理线程池
+        const ThreadPool& pool = EVThread::getThreadPool();
+        Json::Value& pool_json = root["request_pool"];
+        pool_json["threads"] = Json::UInt64(pool.size());
+        pool_json["active_threads"] = Json::UInt64(pool.activeThreads());
+        pool_json["pending"] = Json::UInt64(pool.pendingTasks());
+        pool_json["tasks_total"] = Json::UInt64(pool.totalTasks());
+        pool_json["tasks_completed"] = Json::UInt64(pool.completedTasks());
+        pool_json["tasks_stolen"] = Json::UInt64(pool.stolenTasks());
+        pool_json["tasks_expired"] = Json::UInt64(pool.expiredTasks());
+        pool_json["tasks_cancelled"] = Json::UInt64(pool.cancelledTasks());
+
+        TaskTelemetrySnapshot telemetry = pool.telemetry(0);
+        pool_json["queue_wait"] = latencyJson(telemetry.queue_wait);
+        pool_json["run_time"] = latencyJson(telemetry.run_time);
+        pool_json["failed"] = Json::UInt64(telemetry.failed);
+
+        auto class_stats = pool.classStats();
+        Json::Value& classes = pool_json["classes"];
+        classes = Json::Value(Json::arrayValue);
+        for (size_t i = 0; i < ThreadPool::LANE_COUNT; ++i)
+        {
+            Json::Value cls;
+            cls["class"] = trafficClassName(static_cast<TrafficClass>(i));
+            cls["pending"] = Json::UInt64(class_stats[i].pending);
+            cls["dispatched"] = Json::UInt64(class_stats[i].dispatched);
+            cls["aged"] = Json::UInt64(class_stats[i].aged);
+            cls["dropped"] = Json::UInt64(class_stats[i].dropped);
+            cls["queue_wait"] = latencyJson(telemetry.class_queue_wait[i]);
+            classes.append(cls);
+        }
+
+        // 常驻服务线程
+        Json::Value& threads = root["service_threads"];
+        threads = Json::Value(Json::arrayValue);
+        for (const auto& stats : ServiceThread::stats())
+        {
+            Json::Value thread;
+            thread["name"] = stats.name;
+            thread["tid"] = stats.tid;
+            thread["running"] = stats.running;
+            Json::Value& cpus = thread["cpus"];
+            cpus = Json::Value(Json::arrayValue);
+            for (int cpu : stats.cpus) cpus.append(cpu);
+            thread["cpu_time_ms"] = static_cast<double>(stats.cpu_time_ns) / 1e6;
+            threads.append(thread);
+        }
+
+        // 定时器
+        Json::Value& timers = root["timers"];
+        timers = Json::Value(Json::arrayValue);
+        for (const auto& stats : TaskTimer::allStats())
+        {
+            Json::Value timer;
+            timer["name"] = stats.name;
+            timer["backend"] = stats.endpoint ? "pjsip-endpoint" : "timing-wheel";
+            timer["pending"] = Json::UInt64(stats.pending);
+            timer["scheduled"] = Json::UInt64(stats.scheduled);
+            timer["fired"] = Json::UInt64(stats.fired);
+            timer["cancelled"] = Json::UInt64(stats.cancelled);
+            timer["skipped"] = Json::UInt64(stats.skipped);
+            timer["dispatch_lag"] = latencyJson(stats.dispatch_lag);
+            timers.append(timer);
+        }
+
+        response.setJson(root);
+    });
+
+    addRoute("/debug/logs", [](AdminResponse& response) {
+        Json::Value root;
+        AsyncLogStats log_stats = AsyncLog::getInstance()->stats();
+        root["level"] = AsyncLog::level();
+        root["min_compiled_level"] = SIP_LOG_MIN_LEVEL;
+        root["written"] = Json::UInt64(log_stats.written);
+        root["dropped"] = Json::UInt64(log_stats.dropped);
+        root["bytes"] = Json::UInt64(log_stats.bytes);
+        root["rotations"] = Json::UInt64(log_stats.rotations);
+        root["threads"] = Json::UInt64(log_stats.threads);
+
+        auto limiter = LogRateLimiter::getInstance();
+        LogRateLimitOptions options = limiter->options();
+        Json::Value& limit = root["rate_limit"];
+        limit["rate_per_sec"] = options.rate_per_sec;
+        limit["burst"] = options.burst;
+        limit["summary_interval_ms"] = options.summary_interval_ms;
+        limit["max_keys"] = Json::UInt64(options.max_keys);
+        limit["info_sample"] = options.sample_every;
+
+        // 按抑制行数从多到少排列
+        auto sites = limiter->siteStats();
+        std::sort(sites.begin(), sites.end(), [](const LogRateSiteStats& a, const LogRateSiteStats& b) {
+            return a.suppressed > b.suppressed;
+        });
+        Json::Value& list = limit["sites"];
+        list = Json::Value(Json::arrayValue);
+        for (const auto& site : sites)
+        {
+            Json::Value item;
+            item["site"] = site.file + ":" + std::to_string(site.line);
+            item["keys"] = Json::UInt64(site.keys);
+            item["passed"] = Json::UInt64(site.passed);
+            item["suppressed"] = Json::UInt64(site.suppressed);
+            list.append(item);
+        }
+        response.setJson(root);
+    });
+
+    // 遍历池链表要持有缓存池的锁，这里只读取定时采集的快照
+    addRoute("/debug/pools", [](AdminResponse& response) {
+        auto snap = PoolMonitor::getInstance()->snapshot();
+        Json::Value root;
+        root["collected"] = snap->collected_ns != 0;
+        if (snap->collected_ns != 0)
+        {
+            int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            root["age_ms"] = Json::Int64((now_ns - snap->collected_ns) / 1000000);
+        }
+        root["collect_us"] = toUs(snap->collect_ns);
+        root["pools"] = Json::UInt64(snap->pools);
+        root["peak_pools"] = Json::UInt64(snap->peak_pools);
+        root["used_bytes"] = Json::UInt64(snap->used_size);
+        root["peak_used_bytes"] = Json::UInt64(snap->peak_used_size);
+        root["cached_bytes"] = Json::UInt64(snap->cached_size);
+        root["max_cached_bytes"] = Json::UInt64(snap->max_cached_size);
+
+        Json::Value& prefixes = root["prefixes"];
+        prefixes = Json::Value(Json::arrayValue);
+        for (const auto& stats : snap->prefixes)
+        {
+            Json::Value item;
+            item["prefix"] = stats.prefix;
+            item["pools"] = Json::UInt64(stats.pools);
+            item["capacity"] = Json::UInt64(stats.capacity);
+            prefixes.append(item);
+        }
+
+        Json::Value& largest = root["largest"];
+        largest = Json::Value(Json::arrayValue);
+        for (const auto& pool : snap->largest)
+        {
+            Json::Value item;
+            item["name"] = pool.name;
+            item["capacity"] = Json::UInt64(pool.capacity);
+            largest.append(item);
+        }
+        response.setJson(root);
+    });
+}
@@ -1,9 +1,9 @@
 // ev_thread.cpp - 修改版
 #include "ev_thread.h"
+#include "thread_placement.h"
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <unordered_map>
 
 // 平台特定的头文件
 #ifdef _WIN32
@@ -15,19 +15,46 @@
 // 初始化静态成员
 std::atomic<bool> EVThread::use_thread_pool_(true); // 默认使用线程池
 
-// 线程日志存储
-namespace {
-    std::mutex logs_mutex;
-    std::unordered_map<std::thread::id, ThreadLogs> thread_logs;
-}
-
 // 获取全局线程池实例
 ThreadPool& EVThread::getThreadPool() {
     // 使用局部静态变量作为单例模式
-    static ThreadPool pool(std::thread::hardware_concurrency());
+    static ThreadPool pool(std::thread::hardware_concurrency(),
+                           ThreadPlacement::getInstance()->cpusFor(ThreadRole::WORKER));
     return pool;
 }
 
+namespace {
+    // 首次访问发生在 getThreadPool() 之后，进程退出时先于线程池析构
+    std::unique_ptr<PoolAutoscaler>& autoscalerSlot() {
+        static std::unique_ptr<PoolAutoscaler> autoscaler;
+        return autoscaler;
+    }
+    std::mutex autoscaler_mutex;
+}
+
+bool EVThread::enableAutoscale(const PoolAutoscalerOptions& options) {
+    ThreadPool& pool = getThreadPool();
+    std::lock_guard<std::mutex> lock(autoscaler_mutex);
+    auto& autoscaler = autoscalerSlot();
+    if (autoscaler) {
+        LOG(WARNING) << "Thread pool autoscaler already enabled";
+        return true;
+    }
+    auto created = std::make_unique<PoolAutoscaler>(pool, options, "pool-scaler");
+    if (!created->start()) {
+        LOG(ERROR) << "Failed to start thread pool autoscaler";
+        return false;
+    }
+    autoscaler = std::move(created);
+    return true;
+}
+
+PoolAutoscaler* EVThread::getAutoscaler() {
+    getThreadPool();
+    std::lock_guard<std::mutex> lock(autoscaler_mutex);
+    return autoscalerSlot().get();
+}
+
 bool EVThread::shouldUseThreadPool() {
     return use_thread_pool_.load();
 }
@@ -93,7 +120,7 @@ bool EVThread::joinWithTimeout(std::thread& thread, std::chrono::milliseconds ti
 void EVThread::detachThread(std::thread& thread) {
     if (thread.joinable()) {
         thread.detach();
-        LOG(INFO) << "Thread detached";
+        LOG(DEBUG) << "Thread detached";
     }
 }
 
@@ -164,9 +191,4 @@ bool EVThread::setThreadPriority(std::thread& thread, ThreadPriority priority) {
         LOG(WARNING) << "Exception when setting thread priority: " << e.what();
         return false;
     }
-}
-
-void EVThread::storeThreadLog(const ThreadLogs& logs) {
-    std::lock_guard<std::mutex> lock(logs_mutex);
-    thread_logs[logs.thread_id] = logs;
 }
\ No newline at end of file
@@ -1,217 +1,552 @@
-// ev_thread_pool.cpp - 修复版
+// ev_thread_pool.cpp - 工作窃取线程池
 
 #include "ev_thread_pool.h"
 #include "common.h"
-#include <unordered_map>
 
-ThreadPool::ThreadPool(size_t thread_count)
+#include <algorithm>
+#include <cstring>
+#include <pthread.h>
+
+#include "thread_placement.h"
+
+namespace {
+    // 当前线程所属的线程池与工作线程下标，用于判断提交来自池内还是池外
+    thread_local ThreadPool* tls_pool = nullptr;
+    thread_local size_t tls_worker_id = 0;
+}
+
+ThreadPool::ThreadPool(size_t thread_count, std::vector<int> cpus)
+    : workers_(std::make_unique<Worker[]>(MAX_WORKERS))
+    , cpus_(std::move(cpus))
 {
     if (thread_count == 0) throw std::invalid_argument("thread_count must be > 0");
-    
-    // 修复: 初始化退出标志为普通布尔值
-    worker_exit_flags_.resize(thread_count, false);
-    
+    if (thread_count > MAX_WORKERS) thread_count = MAX_WORKERS;
+
+    // 默认权重 8:4:2:1，老化阈值按类别的时延要求递增
+    setClassPolicy(TrafficClass::SIGNALING, ClassPolicy{ 8, 20 });
+    setClassPolicy(TrafficClass::CONTROL, ClassPolicy{ 4, 100 });
+    setClassPolicy(TrafficClass::BULK, ClassPolicy{ 2, 500 });
+    setClassPolicy(TrafficClass::BACKGROUND, ClassPolicy{ 1, 2000 });
+
     // 创建工作线程
+    std::lock_guard<std::mutex> lock(resize_mutex_);
     for (size_t i = 0; i < thread_count; ++i)
         addWorker();
-    
+
     LOG(INFO) << "ThreadPool started with " << thread_count << " threads.";
 }
 
 ThreadPool::~ThreadPool()
 {
     shutdown();
+
+    size_t count = worker_count_.load();
+    for (size_t i = 0; i < count; ++i)
+    {
+        delete workers_[i].telemetry.exchange(nullptr);
+    }
 }
 
 void ThreadPool::shutdown()
 {
+    if (stop_.exchange(true)) return;
+
+    // 通知所有线程
     {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        if (stop_) return;
-        stop_ = true;
-        
-        // 修复: 设置所有工作线程的退出标志
-        for (size_t i = 0; i < worker_exit_flags_.size(); ++i) {
-            worker_exit_flags_[i] = true;
-        }
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        condition_.notify_all();
     }
-    
-    // 通知所有线程
-    condition_.notify_all();
-    
-    // 等待所有线程完成
-    for (auto& w : workers_)
+
+    // 等待所有线程完成（剩余任务执行完后退出）
+    std::unique_lock<std::mutex> lock(resize_mutex_);
+    live_count_ = 0;
+    size_t count = worker_count_.load();
+    for (size_t i = 0; i < count; ++i)
     {
-        if (w.joinable())
-            w.join();
+        auto& t = workers_[i].thread;
+        if (t.joinable())
+        {
+            if (t.get_id() == std::this_thread::get_id())
+                t.detach();
+            else
+                t.join();
+        }
     }
-    
+    // 缩容中已移出槽位的线程由发起缩容的调用方 join，等其完成后再返回
+    retired_cv_.wait(lock, [this] { return retiring_ == 0; });
+
     LOG(INFO) << "ThreadPool shutdown complete.";
 }
 
-// 修复: 实现动态调整线程池大小
-void ThreadPool::setThreadCount(size_t n) 
+// 动态调整线程池大小
+void ThreadPool::setThreadCount(size_t n)
 {
     if (n == 0) {
         LOG(ERROR) << "Thread count must be greater than 0";
         return;
     }
-    
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    if (stop_) return;
-    
-    size_t current = workers_.size();
-    
-    if (n > current) {
-        // 扩大线程池
-        size_t to_add = n - current;
-        
-        // 扩展退出标志数组
-        worker_exit_flags_.resize(n, false);
-        
-        // 添加新工作线程
-        for (size_t i = 0; i < to_add; ++i) {
-            addWorker();
+    if (n > MAX_WORKERS) n = MAX_WORKERS;
+
+    std::vector<RetiredWorker> retired;
+    {
+        std::lock_guard<std::mutex> lock(resize_mutex_);
+        if (stop_) return;
+        size_t current = size();
+
+        if (n > current) {
+            // 扩大线程池
+            for (size_t i = current; i < n; ++i) {
+                if (!addWorker()) break;
+            }
+            LOG(INFO) << "ThreadPool expanded from " << current << " to " << size() << " threads";
+        }
+        else if (n < current) {
+            // 减少线程池
+            retired = removeWorker(current - n);
+            LOG(INFO) << "ThreadPool reduced from " << current << " to " << size() << " threads";
         }
-        
-        LOG(INFO) << "ThreadPool expanded from " << current << " to " << n << " threads";
-    }
-    else if (n < current) {
-        // 减少线程池
-        removeWorker(current - n);
-        LOG(INFO) << "ThreadPool reduced from " << current << " to " << n << " threads";
     }
+    // 在锁外等待被移除的线程退出，期间其他调整、setAffinity 与 shutdown 不被阻塞
+    joinRetired(retired);
 }
 
-void ThreadPool::addWorker()
+bool ThreadPool::addWorker()
 {
-    size_t id = workers_.size();
-    
-    // 确保退出标志数组的大小足够
-    if (id >= worker_exit_flags_.size()) {
-        worker_exit_flags_.resize(id + 1, false);
-    }
-    
-    // 创建并启动工作线程
-    workers_.emplace_back([this, id] { 
-        // 注册线程ID到索引的映射
-        {
-            std::lock_guard<std::mutex> lock(thread_map_mutex_);
-            thread_to_index_[std::this_thread::get_id()] = id;
-        }
-        
-        try {
-            this->worker_loop();
-        } catch (const std::exception& e) {
-            LOG(ERROR) << "Worker thread " << id << " exited with exception: " << e.what();
-        }
-        
-        // 线程退出后清理映射
+    // 注意：调用前必须已持有 resize_mutex_
+    // 优先复用已退出线程留下的空闲槽位，其队列在线程退出时已清空；
+    // exit_flag 仍为真的槽位其线程尚未被 join，不能复用
+    size_t count = worker_count_.load();
+    size_t id = count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!workers_[i].thread.joinable() && !workers_[i].exit_flag)
         {
-            std::lock_guard<std::mutex> lock(thread_map_mutex_);
-            thread_to_index_.erase(std::this_thread::get_id());
+            id = i;
+            break;
         }
-    });
+    }
+    if (id >= MAX_WORKERS) {
+        LOG(ERROR) << "ThreadPool reached MAX_WORKERS (" << MAX_WORKERS << ")";
+        return false;
+    }
+
+    Worker& worker = workers_[id];
+    worker.exit_flag = false;
+    try {
+        worker.thread = std::thread([this, id, cpus = cpus_] {
+            tls_pool = this;
+            tls_worker_id = id;
+            // 先绑定 CPU，再分配线程私有的遥测环，使其落在本地 NUMA 节点
+            if (!cpus.empty() && ThreadPlacement::pinCurrentThread(cpus))
+                ThreadPlacement::getInstance()->preferLocalMemory();
+            if (!workers_[id].telemetry.load(std::memory_order_acquire))
+                workers_[id].telemetry.store(new TaskTelemetryRing(), std::memory_order_release);
+            try {
+                this->worker_loop(id);
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Worker thread " << id << " exited with exception: " << e.what();
+            }
+            tls_pool = nullptr;
+        });
+    } catch (const std::system_error& e) {
+        LOG(ERROR) << "Failed to create worker thread: " << e.what();
+        return false;
+    }
+    // 槽位初始化完成后再发布，窃取者只会访问 [0, worker_count_) 的槽位
+    if (id == count)
+        worker_count_.store(id + 1);
+    ++live_count_;
+    return true;
 }
 
-// 修复: 添加移除工作线程的实现
-void ThreadPool::removeWorker(size_t count) 
+// 退出前工作线程会把本地队列中的任务转移到注入队列
+std::vector<ThreadPool::RetiredWorker> ThreadPool::removeWorker(size_t count)
 {
-    // 标记要移除的线程
-    size_t current = workers_.size();
-    size_t to_remove = std::min(count, current);
-    
-    for (size_t i = current - to_remove; i < current; ++i) {
-        if (i < worker_exit_flags_.size()) {
-            worker_exit_flags_[i] = true;
-        }
+    // 注意：调用前必须已持有 resize_mutex_
+    std::vector<RetiredWorker> retired;
+    size_t total = worker_count_.load();
+    for (size_t i = total; i > 0 && retired.size() < count; --i)
+    {
+        // 在池内任务中缩容时不选当前线程，否则无法 join 自身
+        if (tls_pool == this && tls_worker_id == i - 1) continue;
+        Worker& worker = workers_[i - 1];
+        if (worker.thread.joinable() && !worker.exit_flag.exchange(true))
+            retired.push_back(RetiredWorker{ i - 1, std::move(worker.thread) });
     }
-    
+    live_count_ -= retired.size();
+    retiring_ += retired.size();
+
     // 通知所有线程检查退出标志
-    condition_.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        condition_.notify_all();
+    }
+    return retired;
 }
 
-size_t ThreadPool::size() const 
+void ThreadPool::joinRetired(std::vector<RetiredWorker>& retired)
 {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    return workers_.size();
+    if (retired.empty()) return;
+    // 等待被移除的线程执行完当前任务后退出
+    for (auto& worker : retired)
+    {
+        worker.thread.join();
+    }
+    // 线程结束后才清除退出标志，槽位从此可被 addWorker 复用
+    std::lock_guard<std::mutex> lock(resize_mutex_);
+    for (const auto& worker : retired)
+    {
+        workers_[worker.id].exit_flag = false;
+    }
+    retiring_ -= retired.size();
+    retired_cv_.notify_all();
 }
 
-bool ThreadPool::isRunning() const 
+void ThreadPool::setAffinity(const std::vector<int>& cpus)
+{
+    std::lock_guard<std::mutex> lock(resize_mutex_);
+    cpus_ = cpus;
+    if (cpus.empty()) return;
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &cpuset);
+    }
+    size_t count = worker_count_.load();
+    for (size_t i = 0; i < count; ++i)
+    {
+        Worker& worker = workers_[i];
+        if (worker.exit_flag || !worker.thread.joinable()) continue;
+        int rc = pthread_setaffinity_np(worker.thread.native_handle(), sizeof(cpuset), &cpuset);
+        if (rc != 0)
+            LOG(WARNING) << "Failed to set affinity of worker " << i << ", code: " << rc;
+    }
+    LOG(INFO) << "ThreadPool workers pinned to cpus " << ThreadPlacement::formatCpuList(cpus);
+}
+
+size_t ThreadPool::size() const
+{
+    return live_count_.load();
+}
+
+bool ThreadPool::isRunning() const
 {
     return !stop_;
 }
 
-size_t ThreadPool::pendingTasks() const 
+size_t ThreadPool::pendingTasks() const
 {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    return tasks_.size();
+    int64_t pending = pending_.load();
+    return pending > 0 ? static_cast<size_t>(pending) : 0;
 }
 
-size_t ThreadPool::activeThreads() const 
+size_t ThreadPool::activeThreads() const
 {
     return active_thread_count_;
 }
 
-void ThreadPool::worker_loop()
+TaskTelemetrySnapshot ThreadPool::telemetry(size_t max_recent) const
 {
-    // 获取当前线程的索引
-    size_t worker_id;
+    TaskTelemetrySnapshot snapshot;
+    size_t count = worker_count_.load();
+    for (size_t i = 0; i < count; ++i)
     {
-        std::lock_guard<std::mutex> lock(thread_map_mutex_);
-        auto it = thread_to_index_.find(std::this_thread::get_id());
-        if (it == thread_to_index_.end()) {
-            LOG(ERROR) << "Worker thread ID not found in map";
-            return;
+        if (auto ring = workers_[i].telemetry.load(std::memory_order_acquire))
+            ring->collect(snapshot, max_recent);
+    }
+
+    // 各线程的记录合并后按开始时间从新到旧排序
+    std::sort(snapshot.recent.begin(), snapshot.recent.end(),
+        [](const TaskRecord& a, const TaskRecord& b) { return a.start_ns > b.start_ns; });
+    if (snapshot.recent.size() > max_recent)
+        snapshot.recent.resize(max_recent);
+    return snapshot;
+}
+
+void ThreadPool::setClassPolicy(TrafficClass cls, const ClassPolicy& policy)
+{
+    ClassState& state = classes_[static_cast<size_t>(cls) % LANE_COUNT];
+    state.stride.store(STRIDE_SCALE / (policy.weight ? policy.weight : 1));
+    state.max_wait_ns.store(policy.max_wait_ms * 1000000);
+}
+
+ThreadPool::ClassPolicy ThreadPool::classPolicy(TrafficClass cls) const
+{
+    const ClassState& state = classes_[static_cast<size_t>(cls) % LANE_COUNT];
+    ClassPolicy policy;
+    policy.weight = static_cast<uint32_t>(STRIDE_SCALE / state.stride.load());
+    policy.max_wait_ms = state.max_wait_ns.load() / 1000000;
+    return policy;
+}
+
+std::array<ThreadPool::ClassStats, ThreadPool::LANE_COUNT> ThreadPool::classStats() const
+{
+    std::array<ClassStats, LANE_COUNT> stats;
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        int64_t pending = classes_[lane].pending.load();
+        stats[lane].pending = pending > 0 ? static_cast<size_t>(pending) : 0;
+        stats[lane].dispatched = classes_[lane].dispatched.load();
+        stats[lane].aged = classes_[lane].aged.load();
+        stats[lane].dropped = classes_[lane].dropped.load();
+    }
+    return stats;
+}
+
+void ThreadPool::enqueue(Task&& task)
+{
+    size_t lane = static_cast<size_t>(task.traffic_class) % LANE_COUNT;
+    task.enqueue_ns = TaskTelemetry::nowNs();
+    int64_t enqueue_ns = task.enqueue_ns;
+    if (tls_pool == this)
+    {
+        // 池内提交：压入本线程队列尾部
+        LaneQueues& queues = workers_[tls_worker_id].queues;
+        std::lock_guard<std::mutex> lock(queues.mutex);
+        queues.lanes[lane].push_back(std::move(task));
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(injection_.mutex);
+        injection_.lanes[lane].push_back(std::move(task));
+    }
+    ClassState& cls = classes_[lane];
+    if (cls.pending.fetch_add(1) == 0)
+    {
+        // 类别由空转为积压：虚拟时间追平全局进度，空闲期间不积累额度，
+        // 否则长期空闲的类别恢复后会一次性挤占其他类别
+        uint64_t global = global_pass_.load(std::memory_order_relaxed);
+        if (cls.pass.load(std::memory_order_relaxed) < global)
+            cls.pass.store(global, std::memory_order_relaxed);
+        cls.progress_ns.store(enqueue_ns, std::memory_order_relaxed);
+    }
+    pending_.fetch_add(1);
+    ++total_enqueued_;
+    wakeOne();
+}
+
+void ThreadPool::wakeOne()
+{
+    // 与工作线程休眠前的 sleepers_++ / pending_ 检查构成对称的顺序一致性约束，
+    // 不会丢失唤醒
+    if (sleepers_.load() == 0) return;
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    condition_.notify_one();
+}
+
+bool ThreadPool::popLocal(Worker& self, size_t lane, Task& task)
+{
+    std::lock_guard<std::mutex> lock(self.queues.mutex);
+    auto& dq = self.queues.lanes[lane];
+    if (dq.empty()) return false;
+    task = dq.pop_front();
+    return true;
+}
+
+bool ThreadPool::popInjection(size_t lane, Task& task)
+{
+    std::lock_guard<std::mutex> lock(injection_.mutex);
+    auto& dq = injection_.lanes[lane];
+    if (dq.empty()) return false;
+    task = dq.pop_front();
+    return true;
+}
+
+bool ThreadPool::steal(size_t thief_id, size_t lane, Task& task)
+{
+    size_t count = worker_count_.load();
+    for (size_t n = 1; n < count; ++n)
+    {
+        Worker& victim = workers_[(thief_id + n) % count];
+        std::unique_lock<std::mutex> lock(victim.queues.mutex, std::try_to_lock);
+        if (!lock.owns_lock()) continue;
+        auto& dq = victim.queues.lanes[lane];
+        if (dq.empty()) continue;
+        task = dq.pop_front();
+        ++total_stolen_;
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::tryDequeue(size_t worker_id, Task& task)
+{
+    // 收集非空类别，按虚拟时间从小到大排序；积压超过老化阈值的类别排在最前
+    std::array<size_t, LANE_COUNT> order;
+    std::array<uint64_t, LANE_COUNT> pass;
+    size_t count = 0;
+    size_t aged_lane = LANE_COUNT;
+    int64_t aged_wait = 0;
+    int64_t now = 0;
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        const ClassState& cls = classes_[lane];
+        if (cls.pending.load(std::memory_order_relaxed) <= 0) continue;
+        if (now == 0) now = TaskTelemetry::nowNs();
+        int64_t waited = now - cls.progress_ns.load(std::memory_order_relaxed);
+        if (waited > cls.max_wait_ns.load(std::memory_order_relaxed) && waited > aged_wait)
+        {
+            aged_lane = lane;
+            aged_wait = waited;
+        }
+        uint64_t lane_pass = cls.pass.load(std::memory_order_relaxed);
+        size_t i = count++;
+        for (; i > 0 && pass[i - 1] > lane_pass; --i)
+        {
+            order[i] = order[i - 1];
+            pass[i] = pass[i - 1];
         }
-        worker_id = it->second;
+        order[i] = lane;
+        pass[i] = lane_pass;
     }
-    
+    if (count == 0) return false;
+    if (aged_lane != LANE_COUNT)
+    {
+        size_t i = 0;
+        while (order[i] != aged_lane) ++i;
+        for (; i > 0; --i) order[i] = order[i - 1];
+        order[0] = aged_lane;
+    }
+
+    Worker& self = workers_[worker_id];
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t lane = order[i];
+        if (popLocal(self, lane, task) || popInjection(lane, task) || steal(worker_id, lane, task))
+        {
+            ClassState& cls = classes_[lane];
+            cls.pending.fetch_sub(1);
+            pending_.fetch_sub(1);
+
+            uint64_t start_pass = cls.pass.fetch_add(cls.stride.load(std::memory_order_relaxed),
+                                                     std::memory_order_relaxed);
+            uint64_t global = global_pass_.load(std::memory_order_relaxed);
+            while (global < start_pass
+                   && !global_pass_.compare_exchange_weak(global, start_pass, std::memory_order_relaxed))
+            {
+            }
+            cls.progress_ns.store(now, std::memory_order_relaxed);
+            cls.dispatched.fetch_add(1, std::memory_order_relaxed);
+            if (lane == aged_lane)
+                cls.aged.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t worker_id)
+{
+    Worker& self = workers_[worker_id];
+    TaskTelemetryRing* telemetry = self.telemetry.load(std::memory_order_relaxed);
     while (true)
     {
+        // 缩容时先退出，不再继续领取任务，避免任务积压期间迟迟无法退出
+        if (self.exit_flag)
+        {
+            retireWorker(self, worker_id);
+            return;
+        }
+
         Task task;
-        bool got_task = false;
-        
+        if (tryDequeue(worker_id, task))
         {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            
-            // 修复: 获取正确的退出标志
-            bool should_exit = worker_id < worker_exit_flags_.size() && 
-                              worker_exit_flags_[worker_id];
-            
-            condition_.wait(lock, [this, should_exit, &got_task] { 
-                return stop_ || should_exit || !tasks_.empty(); 
-            });
-            
-            if ((stop_ && tasks_.empty()) || should_exit) {
-                // 修复: 识别优雅退出情况
-                if (should_exit) {
-                    LOG(INFO) << "Worker thread " << worker_id << " exiting due to pool resizing";
-                }
-                return;
+            ++active_thread_count_;
+            TaskRecord record;
+            record.worker_id = worker_id;
+            record.priority = task.priority;
+            record.traffic_class = task.traffic_class;
+            record.enqueue_ns = task.enqueue_ns;
+            record.state = ThreadState::RUNNING;
+            record.start_ns = TaskTelemetry::nowNs();
+
+            // 已取消或已过截止时间的任务直接丢弃：对端已重传或放弃，执行也无意义
+            const char* drop_reason = nullptr;
+            if (task.token.isCancelled())
+            {
+                drop_reason = "task cancelled before execution";
+                ++total_cancelled_;
             }
-            
-            if (!tasks_.empty()) {
-                task = std::move(const_cast<Task&>(tasks_.top()));
-                tasks_.pop();
-                got_task = true;
-                ++active_thread_count_;
+            else if (task.deadline_ns && record.start_ns > task.deadline_ns)
+            {
+                drop_reason = "task deadline exceeded in queue";
+                ++total_expired_;
             }
-        }
-        
-        if (got_task) {
+            if (drop_reason)
+            {
+                record.state = ThreadState::CANCELLED;
+                record.end_ns = record.start_ns;
+                std::strncpy(record.error, drop_reason, TaskRecord::ERROR_SIZE - 1);
+                classes_[static_cast<size_t>(task.traffic_class) % LANE_COUNT].dropped.fetch_add(1, std::memory_order_relaxed);
+                // 销毁任务时其中的 TaskPromise 据丢弃原因通知等待方
+                TaskContext::setDropReason(drop_reason);
+                task.func = TaskFunction();
+                TaskContext::setDropReason(nullptr);
+                telemetry->record(record);
+                --active_thread_count_;
+                continue;
+            }
+
+            TaskContext::enter(task.deadline_ns, &task.token);
+            TaskTelemetry::setCurrent(&record);
             try {
                 task.func();
                 ++total_completed_;
             }
             catch (const std::exception& e) {
                 LOG(ERROR) << "Exception in thread pool task: " << e.what();
+                TaskTelemetry::reportError(e.what());
             }
             catch (...) {
                 LOG(ERROR) << "Unknown exception in thread pool task.";
+                TaskTelemetry::reportError("Unknown exception");
             }
-            
+            TaskTelemetry::setCurrent(nullptr);
+            TaskContext::leave();
+            record.end_ns = TaskTelemetry::nowNs();
+            if (record.state == ThreadState::RUNNING)
+                record.state = ThreadState::COMPLETED;
+            telemetry->record(record);
             --active_thread_count_;
+            continue;
         }
+
+        if (stop_ && pending_.load() <= 0)
+            return;
+
+        sleepers_.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            condition_.wait(lock, [this, &self] {
+                return stop_ || self.exit_flag || pending_.load() > 0;
+            });
+        }
+        sleepers_.fetch_sub(1);
     }
-}
\ No newline at end of file
+}
+
+void ThreadPool::retireWorker(Worker& self, size_t worker_id)
+{
+    // 本地队列剩余任务转交注入队列，由其他线程继续执行
+    std::array<TaskRing, LANE_COUNT> leftover;
+    {
+        std::lock_guard<std::mutex> lock(self.queues.mutex);
+        leftover.swap(self.queues.lanes);
+    }
+    bool moved = false;
+    {
+        std::lock_guard<std::mutex> lock(injection_.mutex);
+        for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+        {
+            while (!leftover[lane].empty())
+            {
+                injection_.lanes[lane].push_back(leftover[lane].pop_front());
+                moved = true;
+            }
+        }
+    }
+    if (moved) wakeOne();
+    LOG(INFO) << "Worker thread " << worker_id << " exiting due to pool resizing";
+}
@@ -2,6 +2,14 @@
 
 #include "global_ctl.h"
 #include "sip_core.h"
+#include "thread_placement.h"
+#include "ev_thread.h"
+#include "metrics.h"
+#include "admin_server.h"
+#include "log_rate_limit.h"
+#include "request_trace.h"
+#include "pool_monitor.h"
+#include "tcp_conn_manager.h"
 
 #include <algorithm>
 
@@ -22,6 +30,23 @@ bool GlobalCtl::init(std::unique_ptr<IConfigProvider> config)
         return false;
     }
 
+    // 日志限流尽早生效，之后的初始化日志也受其约束
+    LogRateLimiter::getInstance()->configure(g_config_->getLogRateLimit());
+
+    // 线程布局需在创建任何工作线程/服务线程之前生效
+    ThreadPlacement::getInstance()->configure(g_config_->getThreadPlacement());
+    ThreadPlacement::getInstance()->logTopology();
+
+    // 请求处理线程池按排队深度与等待时间自动伸缩
+    if (g_config_->getPoolAutoscale().enabled)
+    {
+        EVThread::enableAutoscale(g_config_->getPoolAutoscale());
+    }
+
+    RequestTracer::getInstance()->configure(g_config_->getRequestTrace());
+    // 缓存池创建后由 SipCore 启动采集
+    PoolMonitor::getInstance()->configure(g_config_->getPoolStats());
+
     // 构建域信息列表
     buildDomainInfoList();
 
@@ -31,9 +56,13 @@ bool GlobalCtl::init(std::unique_ptr<IConfigProvider> config)
         return false;
     }
 
+    registerMetrics();
+    registerAdminRoutes();
+
     if (!g_thread_pool_) 
     {
-        g_thread_pool_ = std::make_unique<ThreadPool>(4);
+        g_thread_pool_ = std::make_unique<ThreadPool>(4,
+            ThreadPlacement::getInstance()->cpusFor(ThreadRole::WORKER));
     }
     
     if (!g_sip_core_) 
@@ -65,7 +94,7 @@ void GlobalCtl::buildDomainInfoList()
 
 bool GlobalCtl::checkIsValid(const std::string& id) const
 {
-    LOG(INFO) << "Checking if domain is valid: " << id;
+    LOG(DEBUG) << "Checking if domain is valid: " << id;
     // 使用读锁访问域信息映射表
     std::shared_lock<std::shared_mutex> lock(domain_mutex_);
     return std::any_of(
@@ -99,7 +128,7 @@ void GlobalCtl::setExpires(std::string_view id, int expires_value)
     if (domain) 
     {
         domain->expires = expires_value;
-        LOG(INFO) << "Updated expires for domain: " << id 
+        LOG(DEBUG) << "Updated expires for domain: " << id 
             << " to " << expires_value;
     } 
     else 
@@ -114,7 +143,7 @@ void GlobalCtl::setRegistered(std::string_view id, bool registered_value)
     if (domain) 
     {
         domain->registered = registered_value;
-        LOG(INFO) << "Updated registered status for domain: " << id 
+        LOG(DEBUG) << "Updated registered status for domain: " << id 
             << " to " << registered_value;
     } 
     else 
@@ -130,7 +159,7 @@ void GlobalCtl::setLastRegTime(std::string_view id, time_t last_reg_time_value)
     if (domain) 
     {
         domain->last_reg_time = last_reg_time_value;
-        LOG(INFO) << "Updated last registration time for domain: " << id << " to " << last_reg_time_value;
+        LOG(DEBUG) << "Updated last registration time for domain: " << id << " to " << last_reg_time_value;
     } 
     else 
     {
@@ -150,7 +179,7 @@ void GlobalCtl::updateRegistration(std::string_view id, int expires_new, bool re
         domain->expires = expires_new;
         domain->registered = registered_new;
         domain->last_reg_time = last_reg_time_new;
-        LOG(INFO) << "updateRegistration: " << id 
+        LOG(DEBUG) << "updateRegistration: " << id 
             << " expires=" << expires_new 
             << " registered=" << registered_new 
             << " last_reg_time=" << last_reg_time_new;
@@ -170,7 +199,7 @@ bool GlobalCtl::getAuthInfo(std::string_view id)
     auto domain = findDomain(id);
     if (domain) 
     {
-        LOG(INFO) << "Getting auth info for domain: " << id << ", auth=" << domain->auth;
+        LOG(DEBUG) << "Getting auth info for domain: " << id << ", auth=" << domain->auth;
         return domain->auth;
     }  
     LOG(ERROR) << "Domain not found when getting auth info: " << id;
@@ -179,7 +208,7 @@ bool GlobalCtl::getAuthInfo(std::string_view id)
 
 std::string GlobalCtl::getRandomNum(int length)
 {
-    LOG(INFO) << "Generating random number of length: " << length;
+    LOG(DEBUG) << "Generating random number of length: " << length;
 
     srand(time(nullptr));
     std::random_device rd;
@@ -202,4 +231,138 @@ std::string GlobalCtl::getRandomNum(int length)
     }
     
     return result;
-}
\ No newline at end of file
+}
+
+void GlobalCtl::registerMetrics()
+{
+    auto registry = MetricsRegistry::getInstance();
+
+    // 请求处理线程池：线程数与排队深度在抓取时读取
+    registry->gaugeFn("thread_pool_threads", "Worker threads of the request pool",
+        [] { return static_cast<double>(EVThread::getThreadPool().size()); });
+    registry->gaugeFn("thread_pool_active_threads", "Worker threads currently running a task",
+        [] { return static_cast<double>(EVThread::getThreadPool().activeThreads()); });
+    for (size_t i = 0; i < TRAFFIC_CLASS_COUNT; ++i)
+    {
+        TrafficClass cls = static_cast<TrafficClass>(i);
+        registry->gaugeFn("thread_pool_queue_depth", "Queued tasks of the request pool by traffic class",
+            [i] { return static_cast<double>(EVThread::getThreadPool().classStats()[i].pending); },
+            {{"class", trafficClassName(cls)}});
+    }
+    registry->counterFn("thread_pool_tasks_total", "Tasks submitted to the request pool",
+        [] { return static_cast<double>(EVThread::getThreadPool().totalTasks()); });
+    registry->counterFn("thread_pool_tasks_completed_total", "Tasks completed by the request pool",
+        [] { return static_cast<double>(EVThread::getThreadPool().completedTasks()); });
+    registry->counterFn("thread_pool_tasks_dropped_total", "Tasks dropped at dequeue because they expired or were cancelled",
+        [] {
+            const ThreadPool& pool = EVThread::getThreadPool();
+            return static_cast<double>(pool.expiredTasks() + pool.cancelledTasks());
+        });
+
+    // 日志：已写入、线程缓冲区满而丢弃、被限流抑制的行数
+    registry->counterFn("log_lines_total", "Log lines by outcome",
+        [] { return static_cast<double>(AsyncLog::getInstance()->stats().written); }, {{"result", "written"}});
+    registry->counterFn("log_lines_total", "Log lines by outcome",
+        [] { return static_cast<double>(AsyncLog::getInstance()->stats().dropped); }, {{"result", "dropped"}});
+    registry->counterFn("log_lines_total", "Log lines by outcome",
+        [] { return static_cast<double>(LogRateLimiter::getInstance()->suppressedTotal()); }, {{"result", "suppressed"}});
+
+    // TCP 长连接：当前持有的连接数与各类事件计数
+    registry->gaugeFn("tcp_conn_open", "TCP connections held by the connection manager",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().active); });
+    registry->counterFn("tcp_conn_created_total", "TCP connections opened to peers",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().created); });
+    registry->counterFn("tcp_conn_reused_total", "Requests bound to an existing TCP connection",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().reused); });
+    registry->counterFn("tcp_conn_adopted_total", "Peer-initiated TCP connections adopted for reuse",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().adopted); });
+    registry->counterFn("tcp_conn_reaped_total", "Idle TCP connections released by the reaper",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().reaped); });
+    registry->counterFn("tcp_conn_closed_total", "TCP connections closed by the peer or on error",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().closed); });
+    registry->counterFn("tcp_conn_failed_total", "Failed attempts to open a TCP connection",
+        [] { return static_cast<double>(TcpConnManager::getInstance()->metrics().failed); });
+
+    // 域注册表：取 domainSnapshot，不阻塞等待 domain_mutex_，写者持锁时沿用上一份快照
+    registry->gaugeFn("domains_configured", "Lower domains in the configuration", [this] {
+        return static_cast<double>(domainSnapshot()->size());
+    });
+    registry->gaugeFn("domains_online", "Lower domains currently registered", [this] {
+        auto domains = domainSnapshot();
+        return static_cast<double>(std::count_if(domains->begin(), domains->end(),
+            [](const DomainInfo& domain) { return domain.registered; }));
+    });
+    registry->counterFn("domain_registry_updates_total", "Registration updates applied to the domain registry",
+        [this] { return static_cast<double>(update_counter_.load(std::memory_order_relaxed)); });
+}
+
+std::shared_ptr<const std::vector<DomainInfo>> GlobalCtl::domainSnapshot(bool* fresh) const
+{
+    std::lock_guard<std::mutex> guard(snapshot_mutex_);
+    std::shared_lock<std::shared_mutex> lock(domain_mutex_, std::try_to_lock);
+    if (lock.owns_lock())
+    {
+        domain_snapshot_ = std::make_shared<const std::vector<DomainInfo>>(domain_info_list_);
+    }
+    else if (!domain_snapshot_)
+    {
+        domain_snapshot_ = std::make_shared<const std::vector<DomainInfo>>();
+    }
+    if (fresh) *fresh = lock.owns_lock();
+    return domain_snapshot_;
+}
+
+void GlobalCtl::registerAdminRoutes()
+{
+    AdminServer::getInstance()->addRoute("/debug/domains", [this](AdminResponse& response) {
+        bool fresh = false;
+        auto domains = domainSnapshot(&fresh);
+
+        Json::Value root;
+        root["fresh"] = fresh;
+        root["updates"] = Json::UInt64(update_counter_.load(std::memory_order_relaxed));
+        Json::Value& list = root["domains"];
+        list = Json::Value(Json::arrayValue);
+        for (const auto& domain : *domains)
+        {
+            Json::Value item;
+            item["sip_id"] = domain.sip_id;
+            item["addr_ip"] = domain.addr_ip;
+            item["sip_port"] = domain.sip_port;
+            item["proto"] = domain.proto;
+            item["auth"] = domain.auth;
+            item["expires"] = domain.expires;
+            item["registered"] = domain.registered;
+            item["last_reg_time"] = Json::Int64(domain.last_reg_time);
+            list.append(item);
+        }
+        response.setJson(root);
+    });
+
+    AdminServer::getInstance()->addRoute("/debug/traces", [](AdminResponse& response) {
+        auto tracer = RequestTracer::getInstance();
+        Json::Value root;
+        root["enabled"] = tracer->enabled();
+        root["slow_ms"] = Json::Int64(tracer->slowThresholdMs());
+        root["slow_total"] = Json::UInt64(tracer->slowTotal());
+        Json::Value& list = root["slow"];
+        list = Json::Value(Json::arrayValue);
+        for (const auto& slow : tracer->slowRequests())
+        {
+            Json::Value item;
+            item["method"] = slow.method;
+            item["call_id"] = slow.call_id;
+            item["from"] = slow.from;
+            item["status"] = slow.status_code;
+            item["time_ms"] = Json::Int64(slow.wall_time_ms);
+            item["total_us"] = static_cast<double>(slow.total_ns) / 1e3;
+            Json::Value& stages = item["stages_us"];
+            for (size_t i = 0; i < TRACE_STAGE_COUNT; ++i)
+            {
+                stages[traceStageName(static_cast<TraceStage>(i))] = static_cast<double>(slow.stage_ns[i]) / 1e3;
+            }
+            list.append(item);
+        }
+        response.setJson(root);
+    });
+}
@@ -0,0 +1,269 @@
+// log_rate_limit.cpp
+#include "log_rate_limit.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+    constexpr int64_t MIN_SWEEP_PERIOD_NS = 100 * 1000000LL;
+    constexpr int64_t MIN_IDLE_NS = 60 * 1000000000LL;   // key 至少空闲这么久才回收
+
+    int64_t sweepPeriodNs(int64_t interval_ns)
+    {
+        return std::max(MIN_SWEEP_PERIOD_NS, interval_ns / 4);
+    }
+
+    struct Summary
+    {
+        std::string key;
+        uint64_t suppressed;
+        int64_t window_ns;
+    };
+}
+
+LogRateSite::LogRateSite(const char* file, int line, int level)
+    : file_(file)
+    , line_(line)
+    , level_(level)
+{
+    LogRateLimiter::getInstance()->addSite(this);
+}
+
+bool LogRateSite::take(Bucket& bucket, int64_t now_ns)
+{
+    double capacity = std::max(1.0, LogRateLimiter::burst());
+    if (bucket.last_ns == 0)
+    {
+        bucket.tokens = capacity;
+    }
+    else if (now_ns > bucket.last_ns)
+    {
+        double refill = static_cast<double>(now_ns - bucket.last_ns) * LogRateLimiter::ratePerSec() / 1e9;
+        bucket.tokens = std::min(capacity, bucket.tokens + refill);
+    }
+    bucket.last_ns = now_ns;
+    if (bucket.tokens >= 1.0)
+    {
+        bucket.tokens -= 1.0;
+        return true;
+    }
+    if (bucket.suppressed++ == 0)
+    {
+        bucket.summary_ns = now_ns;
+    }
+    return false;
+}
+
+bool LogRateSite::allow(std::string_view key)
+{
+    int64_t now = LogRateLimiter::nowNs();
+    LogRateLimiter::maybeSweep(now);
+
+    Shard& shard = shards_[KeyHash{}(key) % SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Bucket* bucket = &shard.overflow;
+    auto it = shard.buckets.find(key);
+    if (it != shard.buckets.end())
+    {
+        bucket = &it->second;
+    }
+    else if (shard.buckets.size() < std::max<size_t>(1, LogRateLimiter::maxKeys() / SHARDS))
+    {
+        bucket = &shard.buckets.emplace(std::string(key), Bucket{}).first->second;
+    }
+
+    bool passed = take(*bucket, now);
+    if (passed)
+        ++shard.passed;
+    else
+        ++shard.suppressed_total;
+    return passed;
+}
+
+void LogRateSite::sweep(int64_t now_ns, int64_t interval_ns, int64_t idle_ns)
+{
+    std::vector<Summary> summaries;
+    auto due = [&](Bucket& bucket) {
+        return bucket.suppressed > 0 && now_ns - bucket.summary_ns >= interval_ns;
+    };
+
+    for (Shard& shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.buckets.begin(); it != shard.buckets.end();)
+        {
+            Bucket& bucket = it->second;
+            if (due(bucket))
+            {
+                summaries.push_back(Summary{ it->first, bucket.suppressed, now_ns - bucket.summary_ns });
+                bucket.suppressed = 0;
+            }
+            if (bucket.suppressed == 0 && now_ns - bucket.last_ns >= idle_ns)
+                it = shard.buckets.erase(it);
+            else
+                ++it;
+        }
+        if (due(shard.overflow))
+        {
+            summaries.push_back(Summary{ "(other keys)", shard.overflow.suppressed, now_ns - shard.overflow.summary_ns });
+            shard.overflow.suppressed = 0;
+        }
+    }
+
+    // 汇总行在释放分片锁之后输出
+    for (const auto& summary : summaries)
+    {
+        AsyncLogMessage(file_, line_, level_).stream()
+            << "Suppressed " << summary.suppressed << " similar messages for key " << summary.key
+            << " in the last " << (summary.window_ns / 1000000) / 1000.0 << " s";
+    }
+}
+
+LogRateSiteStats LogRateSite::stats() const
+{
+    LogRateSiteStats stats;
+    stats.file = file_;
+    stats.line = line_;
+    for (const Shard& shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.keys += shard.buckets.size();
+        stats.passed += shard.passed;
+        stats.suppressed += shard.suppressed_total;
+    }
+    return stats;
+}
+
+std::atomic<double> LogRateLimiter::rate_per_sec_{ 0.2 };
+std::atomic<double> LogRateLimiter::burst_{ 5.0 };
+std::atomic<size_t> LogRateLimiter::max_keys_{ 1024 };
+std::atomic<uint32_t> LogRateLimiter::sample_every_{ 100 };
+std::atomic<int64_t> LogRateLimiter::interval_ns_{ 10000 * 1000000LL };
+std::atomic<int64_t> LogRateLimiter::next_sweep_ns_{ 0 };
+
+std::shared_ptr<LogRateLimiter> LogRateLimiter::instance_ = nullptr;
+std::mutex LogRateLimiter::instance_mutex_;
+
+std::shared_ptr<LogRateLimiter> LogRateLimiter::getInstance()
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+    {
+        instance_ = std::shared_ptr<LogRateLimiter>(new LogRateLimiter());
+        // 限流的调用点之后不再出现时，由日志后台线程输出剩余的汇总
+        AsyncLog::getInstance()->addHousekeeping([] { maybeSweep(nowNs()); });
+    }
+    return instance_;
+}
+
+void LogRateLimiter::configure(const LogRateLimitOptions& options)
+{
+    rate_per_sec_.store(std::max(0.0, options.rate_per_sec), std::memory_order_relaxed);
+    burst_.store(std::max(1.0, options.burst), std::memory_order_relaxed);
+    max_keys_.store(std::max<size_t>(1, options.max_keys), std::memory_order_relaxed);
+    sample_every_.store(std::max<uint32_t>(1, options.sample_every), std::memory_order_relaxed);
+    interval_ns_.store(std::max<int64_t>(100, options.summary_interval_ms) * 1000000LL, std::memory_order_relaxed);
+    LOG(INFO) << "Log rate limit: " << options.rate_per_sec << "/s per key, burst " << options.burst
+              << ", summary every " << options.summary_interval_ms << " ms, INFO sampling 1/" << options.sample_every;
+}
+
+LogRateLimitOptions LogRateLimiter::options() const
+{
+    LogRateLimitOptions options;
+    options.rate_per_sec = rate_per_sec_.load(std::memory_order_relaxed);
+    options.burst = burst_.load(std::memory_order_relaxed);
+    options.max_keys = max_keys_.load(std::memory_order_relaxed);
+    options.sample_every = sample_every_.load(std::memory_order_relaxed);
+    options.summary_interval_ms = static_cast<int>(interval_ns_.load(std::memory_order_relaxed) / 1000000);
+    return options;
+}
+
+bool LogRateLimiter::sample()
+{
+    uint32_t every = sample_every_.load(std::memory_order_relaxed);
+    if (every <= 1)
+    {
+        return true;
+    }
+    // xorshift64，种子取自线程 ID，各线程互不影响
+    static thread_local uint64_t state = std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (state >> 11) % every == 0;
+}
+
+void LogRateLimiter::maybeSweep(int64_t now_ns)
+{
+    int64_t next = next_sweep_ns_.load(std::memory_order_relaxed);
+    if (now_ns < next)
+    {
+        return;
+    }
+    int64_t period = sweepPeriodNs(interval_ns_.load(std::memory_order_relaxed));
+    if (!next_sweep_ns_.compare_exchange_strong(next, now_ns + period, std::memory_order_relaxed))
+    {
+        return;   // 其他线程正在汇总
+    }
+    getInstance()->sweep();
+}
+
+void LogRateLimiter::sweep()
+{
+    std::unique_lock<std::mutex> sweep_lock(sweep_mutex_, std::try_to_lock);
+    if (!sweep_lock.owns_lock())
+    {
+        return;
+    }
+    std::vector<LogRateSite*> sites;
+    {
+        std::lock_guard<std::mutex> lock(sites_mutex_);
+        sites = sites_;
+    }
+    int64_t now = nowNs();
+    int64_t interval = interval_ns_.load(std::memory_order_relaxed);
+    int64_t idle = std::max(MIN_IDLE_NS, interval * 6);
+    for (LogRateSite* site : sites)
+    {
+        site->sweep(now, interval, idle);
+    }
+}
+
+void LogRateLimiter::addSite(LogRateSite* site)
+{
+    std::lock_guard<std::mutex> lock(sites_mutex_);
+    sites_.push_back(site);
+}
+
+std::vector<LogRateSiteStats> LogRateLimiter::siteStats() const
+{
+    std::vector<LogRateSite*> sites;
+    {
+        std::lock_guard<std::mutex> lock(sites_mutex_);
+        sites = sites_;
+    }
+    std::vector<LogRateSiteStats> out;
+    out.reserve(sites.size());
+    for (const LogRateSite* site : sites)
+    {
+        out.push_back(site->stats());
+    }
+    return out;
+}
+
+uint64_t LogRateLimiter::suppressedTotal() const
+{
+    uint64_t total = 0;
+    for (const auto& stats : siteStats())
+    {
+        total += stats.suppressed;
+    }
+    return total;
+}
+
+int64_t LogRateLimiter::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
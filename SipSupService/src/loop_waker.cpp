@@ -0,0 +1,163 @@
+// loop_waker.cpp
+#include "loop_waker.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+
+namespace {
+    // 当前线程是否为事件循环线程：循环自身发消息、调度定时器时不需要唤醒
+    thread_local bool t_loop_thread = false;
+}
+
+std::atomic<LoopWaker*> LoopWaker::current_{nullptr};
+
+pjsip_module LoopWaker::tx_mod = {
+    nullptr, nullptr,
+    {const_cast<char*>("mod-loop-waker"), 14}, -1,
+    PJSIP_MOD_PRIORITY_TRANSPORT_LAYER + 1,
+    nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr,
+    &LoopWaker::onTxMessage, &LoopWaker::onTxMessage,
+    nullptr
+};
+
+LoopWaker::~LoopWaker()
+{
+    close();
+}
+
+pj_status_t LoopWaker::init(SipTypes::EndpointPtr endpt, pj_pool_t* pool)
+{
+    if (!endpt || !pool)
+    {
+        LOG(ERROR) << "LoopWaker::init: endpoint or pool is null";
+        return PJ_EINVAL;
+    }
+    if (::socketpair(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds_) != 0)
+    {
+        LOG(ERROR) << "LoopWaker::init: socketpair failed, errno: " << errno;
+        return PJ_RETURN_OS_ERROR(errno);
+    }
+
+    pj_ioqueue_callback cb;
+    pj_bzero(&cb, sizeof(cb));
+    cb.on_read_complete = &LoopWaker::onReadComplete;
+    pj_status_t status = pj_ioqueue_register_sock(pool, pjsip_endpt_get_ioqueue(endpt.get()),
+        static_cast<pj_sock_t>(fds_[0]), this, &cb, &key_);
+    if (status != PJ_SUCCESS)
+    {
+        LOG(ERROR) << "LoopWaker::init: pj_ioqueue_register_sock failed, code: " << status;
+        close();
+        return status;
+    }
+    endpt_ = std::move(endpt);
+    pj_ioqueue_op_key_init(&op_key_, sizeof(op_key_));
+    arm();
+
+    status = pjsip_endpt_register_module(endpt_.get(), &tx_mod);
+    if (status != PJ_SUCCESS)
+    {
+        LOG(ERROR) << "LoopWaker::init: pjsip_endpt_register_module failed, code: " << status;
+        close();
+        return status;
+    }
+    module_registered_ = true;
+    current_.store(this, std::memory_order_release);
+    return PJ_SUCCESS;
+}
+
+void LoopWaker::close()
+{
+    LoopWaker* self = this;
+    current_.compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+    if (module_registered_)
+    {
+        pjsip_endpt_unregister_module(endpt_.get(), &tx_mod);
+        module_registered_ = false;
+    }
+    if (key_)
+    {
+        // 注销时 ioqueue 一并关闭读端
+        pj_ioqueue_unregister(key_);
+        key_ = nullptr;
+        fds_[0] = -1;
+    }
+    for (int& fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    endpt_.reset();
+}
+
+void LoopWaker::attachLoopThread()
+{
+    t_loop_thread = true;
+}
+
+void LoopWaker::wake() noexcept
+{
+    if (t_loop_thread || fds_[1] < 0)
+    {
+        return;
+    }
+    // 上一次写入尚未被读走时事件循环必然会醒来，不必再写
+    if (pending_.exchange(true, std::memory_order_acq_rel))
+    {
+        return;
+    }
+    char byte = 1;
+    if (::send(fds_[1], &byte, 1, MSG_DONTWAIT | MSG_NOSIGNAL) != 1 && errno != EAGAIN)
+    {
+        pending_.store(false, std::memory_order_release);
+    }
+}
+
+void LoopWaker::arm()
+{
+    pj_ssize_t len = sizeof(buf_);
+    pj_status_t status = pj_ioqueue_recv(key_, &op_key_, buf_, &len, PJ_IOQUEUE_ALWAYS_ASYNC);
+    if (status != PJ_EPENDING && status != PJ_SUCCESS)
+    {
+        LOG(ERROR) << "LoopWaker: pj_ioqueue_recv failed, code: " << status;
+    }
+}
+
+void LoopWaker::onReadComplete(pj_ioqueue_key_t* key, pj_ioqueue_op_key_t* op_key, pj_ssize_t bytes_read)
+{
+    (void)op_key;
+    auto* self = static_cast<LoopWaker*>(pj_ioqueue_get_user_data(key));
+    if (!self || self->key_ != key)
+    {
+        return;
+    }
+    if (bytes_read < 0)
+    {
+        LOG(WARNING) << "LoopWaker: read failed, code: " << static_cast<pj_status_t>(-bytes_read);
+    }
+
+    // 先清标记再读空：之后的 wake() 会重新写入，不会丢失
+    self->pending_.store(false, std::memory_order_release);
+    char drain[16];
+    while (::recv(self->fds_[0], drain, sizeof(drain), MSG_DONTWAIT) > 0)
+    {
+    }
+    self->woken_.store(true, std::memory_order_release);
+    self->wakeups_.fetch_add(1, std::memory_order_relaxed);
+    self->arm();
+}
+
+pj_status_t LoopWaker::onTxMessage(pjsip_tx_data* tdata)
+{
+    (void)tdata;
+    if (LoopWaker* self = current_.load(std::memory_order_acquire))
+    {
+        self->wake();
+    }
+    return PJ_SUCCESS;
+}
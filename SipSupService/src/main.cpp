@@ -21,6 +21,9 @@
 #include "global_ctl.h"        // 依赖于 SipLocalConfig 的定义
 #include "sip_local_config.h"  // 必须在使用 SipLocalConfig 之前包含
 #include "sip_register.h"  // SipRegister 依赖于 SipLocalConfig
+#include "sip_heartbeat.h"
+#include "admin_server.h"
+#include "tcp_conn_manager.h"
 #include "common.h"
 
 
@@ -41,6 +44,12 @@ int main(int argc, char* argv[])
 
     LOG(INFO) << "local_ip is: " << GCONF(getLocalIp);
 
+    // 管理/指标 HTTP 接口；监听失败不影响信令服务
+    if (!AdminServer::getInstance()->start(GCONF(getAdminIp), GCONF(getLocalPort)))
+    {
+        LOG(ERROR) << "Admin HTTP endpoint disabled";
+    }
+
     // 使用工厂方法获取注册器单例
     auto reg = SipRegister::getInstance(GlobalCtl::getInstance());
     if (!reg) 
@@ -50,6 +59,12 @@ int main(int argc, char* argv[])
     }
     reg->startRegService();
 
+    // 下级 TCP 长连接空闲回收
+    TcpConnManager::getInstance()->startReaper(GCONF(getTcpIdleTimeout));
+
+    // 下级心跳跟踪
+    SipHeartbeat::getInstance(GlobalCtl::getInstance())->startHeartbeatService();
+
     while (true)
     {
         std::this_thread::sleep_for(std::chrono::seconds(30));
@@ -0,0 +1,192 @@
+// manscdp_scanner.cpp
+
+#include "manscdp_scanner.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ManscdpScanner {
+
+namespace {
+
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    bool isNameEnd(char c)
+    {
+        return isSpace(c) || c == '>' || c == '/';
+    }
+
+    std::string_view trim(const char* begin, const char* end)
+    {
+        while (begin < end && isSpace(*begin)) ++begin;
+        while (end > begin && isSpace(end[-1])) --end;
+        return std::string_view(begin, static_cast<size_t>(end - begin));
+    }
+
+    // 读取 p 处开始的元素名，返回名字之后的位置
+    const char* readName(const char* p, const char* end, std::string_view& name)
+    {
+        const char* begin = p;
+        while (p < end && !isNameEnd(*p)) ++p;
+        name = std::string_view(begin, static_cast<size_t>(p - begin));
+        return p;
+    }
+
+    // 跳过 <?...?> 与 <!--...-->，p 指向 '<'，返回跳过后的位置，失败返回 nullptr
+    const char* skipMarkup(const char* p, const char* end)
+    {
+        if (p[1] == '?')
+        {
+            for (const char* q = p + 2; (q = findChar(q, end, '>')) != nullptr; ++q)
+            {
+                if (q[-1] == '?') return q + 1;
+            }
+            return nullptr;
+        }
+        if (end - p >= 4 && std::memcmp(p, "<!--", 4) == 0)
+        {
+            for (const char* q = p + 4; (q = findChar(q, end, '>')) != nullptr; ++q)
+            {
+                if (q - p >= 6 && q[-1] == '-' && q[-2] == '-') return q + 1;
+            }
+            return nullptr;
+        }
+        // DOCTYPE / CDATA 等不在快速路径处理范围内
+        return nullptr;
+    }
+
+} // namespace
+
+const char* findChar(const char* p, const char* end, char c)
+{
+#if defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - p >= 16)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+        p += 16;
+    }
+    for (; p < end; ++p)
+    {
+        if (*p == c) return p;
+    }
+    return nullptr;
+#else
+    if (p >= end) return nullptr;
+    return static_cast<const char*>(std::memchr(p, c, static_cast<size_t>(end - p)));
+#endif
+}
+
+bool scan(const char* data, size_t len, Summary& out)
+{
+    out = Summary{};
+    if (!data || len == 0)
+    {
+        return false;
+    }
+    const char* p = data;
+    const char* end = data + len;
+
+    // 跳过 XML 声明与注释，定位根元素
+    for (;;)
+    {
+        p = findChar(p, end, '<');
+        if (!p || end - p < 2) return false;
+        if (p[1] != '?' && p[1] != '!') break;
+        p = skipMarkup(p, end);
+        if (!p) return false;
+    }
+    p = readName(p + 1, end, out.root);
+    if (out.root.empty()) return false;
+    p = findChar(p, end, '>');
+    if (!p || p[-1] == '/') return false;
+    ++p;
+
+    // 只采集根元素的直接子元素，depth 为当前所在的嵌套层数（根的子元素为0）
+    int depth = 0;
+    int found = 0;
+    while (found < 3)
+    {
+        p = findChar(p, end, '<');
+        if (!p || end - p < 2) return false;
+
+        if (p[1] == '/')
+        {
+            std::string_view name;
+            readName(p + 2, end, name);
+            if (depth == 0)
+            {
+                // 根元素结束
+                return name == out.root && !out.cmd_type.empty();
+            }
+            --depth;
+            p += 2;
+            continue;
+        }
+        if (p[1] == '?' || p[1] == '!')
+        {
+            p = skipMarkup(p, end);
+            if (!p) return false;
+            continue;
+        }
+
+        std::string_view name;
+        const char* q = readName(p + 1, end, name);
+        q = findChar(q, end, '>');
+        if (!q) return false;
+        if (q[-1] == '/')
+        {
+            // 自闭合元素
+            p = q + 1;
+            continue;
+        }
+
+        const char* text_begin = q + 1;
+        const char* text_end = findChar(text_begin, end, '<');
+        if (!text_end || end - text_end < 2) return false;
+
+        // 紧跟同名结束标签：叶子元素
+        bool is_leaf = text_end[1] == '/'
+            && static_cast<size_t>(end - text_end) >= name.size() + 3
+            && std::memcmp(text_end + 2, name.data(), name.size()) == 0
+            && text_end[2 + name.size()] == '>';
+        if (!is_leaf)
+        {
+            // 含子元素（或 CDATA），进入下一层
+            ++depth;
+            p = text_end;
+            continue;
+        }
+
+        if (depth == 0)
+        {
+            std::string_view* field { nullptr };
+            if (name == "CmdType") field = &out.cmd_type;
+            else if (name == "SN") field = &out.sn;
+            else if (name == "DeviceID") field = &out.device_id;
+
+            if (field && field->empty())
+            {
+                // 实体引用需要解码，交给 DOM 解析
+                if (findChar(text_begin, text_end, '&')) return false;
+                *field = trim(text_begin, text_end);
+                ++found;
+            }
+        }
+        p = text_end + name.size() + 3;
+    }
+    return !out.cmd_type.empty();
+}
+
+} // namespace ManscdpScanner
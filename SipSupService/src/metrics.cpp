@@ -0,0 +1,309 @@
+// metrics.cpp
+#include "metrics.h"
+#include "common.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+size_t detail::assignMetricShard()
+{
+    static std::atomic<size_t> next{ 0 };
+    return next.fetch_add(1, std::memory_order_relaxed) & (METRIC_SHARDS - 1);
+}
+
+uint64_t Counter::value() const
+{
+    uint64_t total = 0;
+    for (const auto& cell : cells_)
+    {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+LatencyHistogram Histogram::load(uint64_t* sum_ns) const
+{
+    LatencyHistogram out;
+    uint64_t sum = 0;
+    for (const auto& shard : shards_)
+    {
+        for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i)
+        {
+            uint64_t n = shard.buckets[i].load(std::memory_order_relaxed);
+            out.buckets[i] += n;
+            out.count += n;
+        }
+        sum += shard.sum_ns.load(std::memory_order_relaxed);
+    }
+    if (sum_ns) *sum_ns = sum;
+    return out;
+}
+
+std::shared_ptr<MetricsRegistry> MetricsRegistry::instance_ = nullptr;
+std::mutex MetricsRegistry::instance_mutex_;
+
+std::shared_ptr<MetricsRegistry> MetricsRegistry::getInstance()
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+        instance_ = std::shared_ptr<MetricsRegistry>(new MetricsRegistry());
+    return instance_;
+}
+
+MetricsRegistry::Entry& MetricsRegistry::findOrAdd(const std::string& name, const std::string& help,
+                                                   MetricType type, MetricLabels&& labels)
+{
+    for (auto& entry : entries_)
+    {
+        if (entry->name == name && entry->labels == labels)
+        {
+            if (entry->type != type)
+                throw std::invalid_argument("metric " + name + " already registered with another type");
+            return *entry;
+        }
+        if (entry->name == name && entry->type != type)
+            throw std::invalid_argument("metric " + name + " already registered with another type");
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->type = type;
+    entry->labels = std::move(labels);
+    entries_.push_back(std::move(entry));
+    return *entries_.back();
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, MetricLabels labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = findOrAdd(name, help, MetricType::COUNTER, std::move(labels));
+    if (entry.fn)
+        throw std::invalid_argument("metric " + name + " is a callback counter");
+    if (!entry.counter)
+        entry.counter = std::make_unique<Counter>();
+    return *entry.counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, MetricLabels labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = findOrAdd(name, help, MetricType::GAUGE, std::move(labels));
+    if (entry.fn)
+        throw std::invalid_argument("metric " + name + " is a callback gauge");
+    if (!entry.gauge)
+        entry.gauge = std::make_unique<Gauge>();
+    return *entry.gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, MetricLabels labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = findOrAdd(name, help, MetricType::HISTOGRAM, std::move(labels));
+    if (!entry.histogram)
+        entry.histogram = std::make_unique<Histogram>();
+    return *entry.histogram;
+}
+
+void MetricsRegistry::gaugeFn(const std::string& name, const std::string& help,
+                              std::function<double()> fn, MetricLabels labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = findOrAdd(name, help, MetricType::GAUGE, std::move(labels));
+    if (entry.gauge)
+        throw std::invalid_argument("metric " + name + " is a value gauge");
+    entry.fn = std::make_shared<std::function<double()>>(std::move(fn));
+}
+
+void MetricsRegistry::counterFn(const std::string& name, const std::string& help,
+                                std::function<double()> fn, MetricLabels labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = findOrAdd(name, help, MetricType::COUNTER, std::move(labels));
+    if (entry.counter)
+        throw std::invalid_argument("metric " + name + " is a value counter");
+    entry.fn = std::make_shared<std::function<double()>>(std::move(fn));
+}
+
+std::vector<MetricSample> MetricsRegistry::snapshot() const
+{
+    // 锁内只复制条目描述与回调，读取分片与调用回调都在锁外进行
+    struct Pending
+    {
+        const Entry* entry;
+        std::shared_ptr<std::function<double()>> fn;
+    };
+    std::vector<Pending> pending;
+    std::vector<MetricSample> samples;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending.reserve(entries_.size());
+        samples.reserve(entries_.size());
+        for (const auto& entry : entries_)
+        {
+            pending.push_back(Pending{ entry.get(), entry->fn });
+            MetricSample sample;
+            sample.name = entry->name;
+            sample.help = entry->help;
+            sample.type = entry->type;
+            sample.labels = entry->labels;
+            samples.push_back(std::move(sample));
+        }
+    }
+
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        const Entry* entry = pending[i].entry;
+        MetricSample& sample = samples[i];
+        if (pending[i].fn)
+        {
+            try {
+                sample.value = (*pending[i].fn)();
+            } catch (const std::exception& e) {
+                LOG(WARNING) << "Metric collector " << sample.name << " failed: " << e.what();
+            }
+        }
+        else if (entry->counter)
+        {
+            sample.value = static_cast<double>(entry->counter->value());
+        }
+        else if (entry->gauge)
+        {
+            sample.value = static_cast<double>(entry->gauge->value());
+        }
+        else if (entry->histogram)
+        {
+            sample.histogram = entry->histogram->load(&sample.sum_ns);
+        }
+    }
+
+    std::stable_sort(samples.begin(), samples.end(),
+        [](const MetricSample& a, const MetricSample& b) { return a.name < b.name; });
+    return samples;
+}
+
+namespace {
+    void appendEscaped(std::string& out, const std::string& value, bool quote)
+    {
+        for (char c : value)
+        {
+            if (c == '\\') out += "\\\\";
+            else if (c == '\n') out += "\\n";
+            else if (quote && c == '"') out += "\\\"";
+            else out += c;
+        }
+    }
+
+    // extra 为直方图的 le 标签
+    void appendLabels(std::string& out, const MetricLabels& labels, const char* extra = nullptr)
+    {
+        if (labels.empty() && !extra) return;
+        out += '{';
+        bool first = true;
+        for (const auto& [key, value] : labels)
+        {
+            if (!first) out += ',';
+            first = false;
+            out += key;
+            out += "=\"";
+            appendEscaped(out, value, true);
+            out += '"';
+        }
+        if (extra)
+        {
+            if (!first) out += ',';
+            out += "le=\"";
+            out += extra;
+            out += '"';
+        }
+        out += '}';
+    }
+
+    void appendNumber(std::string& out, double value)
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.17g", value);
+        out += buf;
+    }
+
+    const char* typeName(MetricType type)
+    {
+        switch (type)
+        {
+            case MetricType::COUNTER:   return "counter";
+            case MetricType::GAUGE:     return "gauge";
+            case MetricType::HISTOGRAM: return "histogram";
+            default:                    return "untyped";
+        }
+    }
+}
+
+std::string formatPrometheus(const std::vector<MetricSample>& samples)
+{
+    std::string out;
+    out.reserve(samples.size() * 128);
+    const std::string* family = nullptr;
+    for (const auto& sample : samples)
+    {
+        // 同名指标相邻，HELP/TYPE 每个名称只输出一次
+        if (!family || *family != sample.name)
+        {
+            family = &sample.name;
+            out += "# HELP ";
+            out += sample.name;
+            out += ' ';
+            appendEscaped(out, sample.help, false);
+            out += "\n# TYPE ";
+            out += sample.name;
+            out += ' ';
+            out += typeName(sample.type);
+            out += '\n';
+        }
+
+        if (sample.type != MetricType::HISTOGRAM)
+        {
+            out += sample.name;
+            appendLabels(out, sample.labels);
+            out += ' ';
+            appendNumber(out, sample.value);
+            out += '\n';
+            continue;
+        }
+
+        // 最后一个桶同时收纳溢出的值，对应 +Inf
+        uint64_t cumulative = 0;
+        char le[32];
+        for (size_t i = 0; i + 1 < LatencyHistogram::BUCKETS; ++i)
+        {
+            cumulative += sample.histogram.buckets[i];
+            std::snprintf(le, sizeof(le), "%.9g", static_cast<double>(uint64_t{ 1 } << i) / 1e9);
+            out += sample.name;
+            out += "_bucket";
+            appendLabels(out, sample.labels, le);
+            out += ' ';
+            out += std::to_string(cumulative);
+            out += '\n';
+        }
+        out += sample.name;
+        out += "_bucket";
+        appendLabels(out, sample.labels, "+Inf");
+        out += ' ';
+        out += std::to_string(sample.histogram.count);
+        out += '\n';
+
+        out += sample.name;
+        out += "_sum";
+        appendLabels(out, sample.labels);
+        out += ' ';
+        appendNumber(out, static_cast<double>(sample.sum_ns) / 1e9);
+        out += '\n';
+
+        out += sample.name;
+        out += "_count";
+        appendLabels(out, sample.labels);
+        out += ' ';
+        out += std::to_string(sample.histogram.count);
+        out += '\n';
+    }
+    return out;
+}
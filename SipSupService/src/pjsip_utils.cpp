@@ -1,6 +1,9 @@
 // pjsip_utils.cpp
 #include "pjsip_utils.h"
 
+#include <algorithm>
+#include <string_view>
+
 
 // ===== 资源创建函数实现 =====
 // 使用SipTypes工厂函数创建智能指针
@@ -175,7 +178,7 @@ pj_status_t PjSipUtils::registerThread()
         return status;
     }
     
-    LOG(INFO) << "Thread already registered";
+    LOG(DEBUG) << "Thread already registered";
     return PJ_SUCCESS;
 }
 
@@ -205,7 +208,7 @@ PjSipUtils::ThreadRegistrar::ThreadRegistrar()
     }
     else
     {
-        LOG(INFO) << "Thread already registered with PJSIP";
+        LOG(DEBUG) << "Thread already registered with PJSIP";
     }
 }
 
@@ -298,7 +301,7 @@ pj_status_t PjSipUtils::initTransports(pjsip_endpoint* endpt, int sip_port)
     }
     LOG(INFO) << "sip udp:" << sip_port << " is running ...";
 
-    status = pjsip_tcp_transport_start(endpt, &addr, 1, nullptr);
+    status = pjsip_tcp_transport_start(endpt, &addr, SIP_TCP_ASYNC_CNT, nullptr);
     if(status != PJ_SUCCESS)
     {
         LOG(ERROR) << "pjsip_tcp_transport_start failed, code: " << status;
@@ -323,4 +326,42 @@ void PjSipUtils::cleanupCoreRaw(pj_caching_pool* caching_pool, pjsip_endpoint* e
     }
     pj_shutdown();
     LOG(INFO) << "PJSIP core cleanup completed (raw pointers)";
-}
\ No newline at end of file
+}
+
+
+// ===== PJSIP 日志转发 =====
+namespace {
+    // pj_log 级别：1 错误、2 警告、3 信息、4 及以上为调试/跟踪
+    int fromPjLevel(int level)
+    {
+        if (level <= 1) return SIP_LOG_LEVEL_ERROR;
+        if (level == 2) return SIP_LOG_LEVEL_WARNING;
+        if (level == 3) return SIP_LOG_LEVEL_INFO;
+        return SIP_LOG_LEVEL_DEBUG;
+    }
+
+    void pjLogToAsync(int level, const char* data, int len)
+    {
+        int severity = fromPjLevel(level);
+        if (severity < SIP_LOG_MIN_LEVEL || !AsyncLog::enabled(severity))
+        {
+            return;
+        }
+        while (len > 0 && (data[len - 1] == '\n' || data[len - 1] == '\r'))
+        {
+            --len;
+        }
+        AsyncLogMessage("pjsip", 0, severity).stream() << std::string_view(data, static_cast<size_t>(len));
+    }
+}
+
+void PjSipUtils::routePjLog()
+{
+    pj_log_set_log_func(&pjLogToAsync);
+    // 时间与线程号由 AsyncLog 的前缀给出
+    pj_log_set_decor(PJ_LOG_HAS_SENDER | PJ_LOG_HAS_INDENT);
+    // 编译期去掉了 DEBUG 时不再让 PJSIP 格式化 4~6 级的跟踪日志
+    int level = std::max(SIP_LOG_MIN_LEVEL, AsyncLog::level());
+    pj_log_set_level(level <= SIP_LOG_LEVEL_DEBUG ? 6 : 3);
+    LOG(INFO) << "PJSIP log routed to AsyncLog, pj_log level " << pj_log_get_level();
+}
@@ -0,0 +1,216 @@
+// pool_monitor.cpp
+#include "pool_monitor.h"
+#include "pjsip_utils.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+namespace {
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool byCapacity(size_t a_capacity, size_t b_capacity, const std::string& a_name, const std::string& b_name)
+    {
+        return a_capacity != b_capacity ? a_capacity > b_capacity : a_name < b_name;
+    }
+}
+
+std::shared_ptr<PoolMonitor> PoolMonitor::instance_ = nullptr;
+std::mutex PoolMonitor::instance_mutex_;
+
+std::shared_ptr<PoolMonitor> PoolMonitor::getInstance()
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+    {
+        instance_ = std::shared_ptr<PoolMonitor>(new PoolMonitor());
+    }
+    return instance_;
+}
+
+PoolMonitor::PoolMonitor()
+    : timer_(std::make_shared<TaskTimer>("pool-monitor"))
+    , snapshot_(std::make_shared<PoolSnapshot>())
+{
+    auto registry = MetricsRegistry::getInstance();
+    pools_gauge_ = &registry->gauge("pjsip_pools", "PJSIP pools currently allocated from the caching pool");
+    used_gauge_ = &registry->gauge("pjsip_pool_used_bytes", "Capacity of the PJSIP pools in use");
+    peak_used_gauge_ = &registry->gauge("pjsip_pool_peak_used_bytes", "Peak capacity of the PJSIP pools in use");
+    cached_gauge_ = &registry->gauge("pjsip_pool_cached_bytes", "Free memory kept by the caching pool for reuse");
+}
+
+PoolMonitor::~PoolMonitor()
+{
+    if (timer_)
+    {
+        timer_->stop();
+    }
+}
+
+void PoolMonitor::configure(const PoolStatsOptions& options)
+{
+    std::lock_guard<std::mutex> lock(collect_mutex_);
+    options_ = options;
+    options_.top_pools = std::max<size_t>(1, options_.top_pools);
+    LOG(INFO) << "PJSIP pool stats every " << options_.interval_ms << " ms, top " << options_.top_pools << " pools";
+}
+
+void PoolMonitor::start(pj_caching_pool* caching_pool)
+{
+    int interval_ms = 0;
+    {
+        std::lock_guard<std::mutex> lock(collect_mutex_);
+        caching_pool_ = caching_pool;
+        interval_ms = options_.interval_ms;
+    }
+    if (!caching_pool || interval_ms <= 0 || timer_->isRunning())
+    {
+        return;
+    }
+    timer_->setInterval(static_cast<unsigned int>(interval_ms));
+    timer_->addTask([weak_this = std::weak_ptr<PoolMonitor>(shared_from_this())]() {
+        if (auto shared_this = weak_this.lock())
+        {
+            try {
+                shared_this->collect();
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Error in pool stats task: " << e.what();
+            }
+        }
+    });
+    timer_->start();
+    LOG(INFO) << "PJSIP pool stats started";
+}
+
+void PoolMonitor::stop()
+{
+    timer_->stop();
+    // 等待进行中的采集结束，之后不再访问缓存池
+    std::lock_guard<std::mutex> lock(collect_mutex_);
+    caching_pool_ = nullptr;
+}
+
+std::string PoolMonitor::prefixOf(const char* name)
+{
+    std::string prefix;
+    for (const char* p = name; p && *p && !std::isdigit(static_cast<unsigned char>(*p)); ++p)
+    {
+        prefix.push_back(*p);
+    }
+    return prefix.empty() ? "pool" : prefix;
+}
+
+std::shared_ptr<const PoolSnapshot> PoolMonitor::collect()
+{
+    std::lock_guard<std::mutex> lock(collect_mutex_);
+    if (!caching_pool_)
+    {
+        return snapshot();
+    }
+    // 缓存池的锁是 pj_mutex，调用线程需要注册到 pjlib
+    PjSipUtils::registerThread();
+
+    int64_t start = nowNs();
+    auto snap = std::make_shared<PoolSnapshot>();
+    std::vector<PoolInfo> pools;
+    pj_caching_pool* cp = caching_pool_;
+
+    pj_lock_acquire(cp->lock);
+    snap->pools = cp->used_count;
+    snap->used_size = cp->used_size;
+    snap->peak_used_size = cp->peak_used_size;
+    snap->cached_size = cp->capacity;
+    snap->max_cached_size = cp->max_capacity;
+    pools.reserve(cp->used_count);
+    for (pj_pool_t* pool = static_cast<pj_pool_t*>(cp->used_list.next);
+         pool != reinterpret_cast<pj_pool_t*>(&cp->used_list);
+         pool = pool->next)
+    {
+        // 只读池名与容量，不遍历块链表（所属线程可能正在分配）
+        pools.push_back(PoolInfo{ pj_pool_getobjname(pool), pj_pool_get_capacity(pool) });
+    }
+    pj_lock_release(cp->lock);
+
+    // 以下汇总在锁外进行
+    std::unordered_map<std::string, PoolPrefixStats> by_prefix;
+    for (const auto& pool : pools)
+    {
+        std::string prefix = prefixOf(pool.name.c_str());
+        if (by_prefix.size() >= MAX_PREFIXES && by_prefix.find(prefix) == by_prefix.end())
+        {
+            prefix = "other";
+        }
+        PoolPrefixStats& stats = by_prefix[prefix];
+        stats.prefix = prefix;
+        ++stats.pools;
+        stats.capacity += pool.capacity;
+    }
+    snap->prefixes.reserve(by_prefix.size());
+    for (auto& entry : by_prefix)
+    {
+        snap->prefixes.push_back(std::move(entry.second));
+    }
+    std::sort(snap->prefixes.begin(), snap->prefixes.end(), [](const PoolPrefixStats& a, const PoolPrefixStats& b) {
+        return byCapacity(a.capacity, b.capacity, a.prefix, b.prefix);
+    });
+
+    auto by_pool_capacity = [](const PoolInfo& a, const PoolInfo& b) {
+        return byCapacity(a.capacity, b.capacity, a.name, b.name);
+    };
+    size_t top = std::min(options_.top_pools, pools.size());
+    std::partial_sort(pools.begin(), pools.begin() + top, pools.end(), by_pool_capacity);
+    pools.resize(top);
+    snap->largest = std::move(pools);
+
+    peak_pools_ = std::max(peak_pools_, snap->pools);
+    snap->peak_pools = peak_pools_;
+    snap->collected_ns = nowNs();
+    snap->collect_ns = snap->collected_ns - start;
+    publish(*snap);
+
+    std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex_);
+    snapshot_ = snap;
+    return snap;
+}
+
+void PoolMonitor::publish(const PoolSnapshot& snap)
+{
+    pools_gauge_->set(static_cast<int64_t>(snap.pools));
+    used_gauge_->set(static_cast<int64_t>(snap.used_size));
+    peak_used_gauge_->set(static_cast<int64_t>(snap.peak_used_size));
+    cached_gauge_->set(static_cast<int64_t>(snap.cached_size));
+
+    auto registry = MetricsRegistry::getInstance();
+    std::unordered_map<std::string, const PoolPrefixStats*> current;
+    for (const auto& stats : snap.prefixes)
+    {
+        current.emplace(stats.prefix, &stats);
+        if (prefix_gauges_.find(stats.prefix) == prefix_gauges_.end())
+        {
+            MetricLabels labels{ { "prefix", stats.prefix } };
+            PrefixGauges gauges;
+            gauges.pools = &registry->gauge("pjsip_pool_prefix_pools", "PJSIP pools in use by name prefix", labels);
+            gauges.capacity = &registry->gauge("pjsip_pool_prefix_capacity_bytes", "Capacity of PJSIP pools by name prefix", labels);
+            prefix_gauges_.emplace(stats.prefix, gauges);
+        }
+    }
+    // 已注册的指标不删除，本次没有出现的前缀置0
+    for (auto& [prefix, gauges] : prefix_gauges_)
+    {
+        auto it = current.find(prefix);
+        const PoolPrefixStats* stats = it != current.end() ? it->second : nullptr;
+        gauges.pools->set(stats ? static_cast<int64_t>(stats->pools) : 0);
+        gauges.capacity->set(stats ? static_cast<int64_t>(stats->capacity) : 0);
+    }
+}
+
+std::shared_ptr<const PoolSnapshot> PoolMonitor::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    return snapshot_;
+}
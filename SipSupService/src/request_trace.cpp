@@ -0,0 +1,177 @@
+// request_trace.cpp
+#include "request_trace.h"
+#include "common.h"
+#include "metrics.h"
+
+#include <algorithm>
+
+namespace {
+    thread_local RequestTrace* t_current = nullptr;
+}
+
+const char* traceStageName(TraceStage stage)
+{
+    switch (stage)
+    {
+        case TraceStage::CLONE:  return "clone";
+        case TraceStage::QUEUE:  return "queue";
+        case TraceStage::AUTH:   return "auth";
+        case TraceStage::BUILD:  return "build";
+        case TraceStage::SEND:   return "send";
+        case TraceStage::UPDATE: return "update";
+        default:                 return "unknown";
+    }
+}
+
+void RequestTrace::begin(const char* method)
+{
+    method_ = method;
+    start_ns_ = last_ns_ = nowNs();
+    stage_ns_.fill(0);
+    status_code_ = 0;
+}
+
+void RequestTrace::record(TraceStage stage)
+{
+    if (!method_) return;
+    int64_t now = nowNs();
+    stage_ns_[static_cast<size_t>(stage)] += now - last_ns_;
+    last_ns_ = now;
+}
+
+void RequestTrace::finish(const pjsip_rx_data* rdata)
+{
+    if (!method_) return;
+    last_ns_ = nowNs();
+    // 单例在进程内不销毁，缓存裸指针，避免每个请求都获取 instance_mutex_
+    static RequestTracer* tracer = RequestTracer::getInstance().get();
+    tracer->complete(*this, rdata, method_, status_code_);
+    method_ = nullptr;
+}
+
+void RequestTrace::mark(TraceStage stage)
+{
+    if (t_current) t_current->record(stage);
+}
+
+void RequestTrace::status(int status_code)
+{
+    if (t_current) t_current->setStatus(status_code);
+}
+
+RequestTrace* RequestTrace::current()
+{
+    return t_current;
+}
+
+RequestTrace::Scope::Scope(RequestTrace* trace)
+    : previous_(t_current)
+{
+    t_current = trace && trace->active() ? trace : nullptr;
+}
+
+RequestTrace::Scope::~Scope()
+{
+    t_current = previous_;
+}
+
+std::shared_ptr<RequestTracer> RequestTracer::instance_ = nullptr;
+std::mutex RequestTracer::instance_mutex_;
+
+std::shared_ptr<RequestTracer> RequestTracer::getInstance()
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+        instance_ = std::shared_ptr<RequestTracer>(new RequestTracer());
+    return instance_;
+}
+
+RequestTracer::RequestTracer()
+{
+    auto registry = MetricsRegistry::getInstance();
+    const std::string help = "Time spent in each stage of incoming SIP requests";
+    for (size_t i = 0; i < TRACE_STAGE_COUNT; ++i)
+    {
+        stage_hist_[i] = &registry->histogram("sip_request_stage_seconds", help,
+            {{"method", "REGISTER"}, {"stage", traceStageName(static_cast<TraceStage>(i))}});
+    }
+    total_hist_ = &registry->histogram("sip_request_stage_seconds", help,
+        {{"method", "REGISTER"}, {"stage", "total"}});
+    slow_ring_.reserve(slow_capacity_);
+}
+
+void RequestTracer::configure(const RequestTraceOptions& options)
+{
+    std::lock_guard<std::mutex> lock(slow_mutex_);
+    enabled_.store(options.enabled, std::memory_order_relaxed);
+    slow_ns_.store(std::max<int64_t>(0, options.slow_ms) * 1000000, std::memory_order_relaxed);
+    slow_capacity_ = std::max<size_t>(1, options.slow_capacity);
+    slow_ring_.clear();
+    slow_total_ = 0;
+    slow_ring_.reserve(slow_capacity_);
+    LOG(INFO) << "Request tracing " << (options.enabled ? "enabled" : "disabled")
+              << ", slow threshold " << options.slow_ms << " ms";
+}
+
+void RequestTracer::complete(const RequestTrace& trace, const pjsip_rx_data* rdata, const char* method, int status_code)
+{
+    for (size_t i = 0; i < TRACE_STAGE_COUNT; ++i)
+    {
+        stage_hist_[i]->observeNs(trace.stageNs(static_cast<TraceStage>(i)));
+    }
+    int64_t total = trace.totalNs();
+    total_hist_->observeNs(total);
+    if (total < slow_ns_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    SlowRequest slow;
+    slow.method = method;
+    slow.status_code = status_code;
+    slow.wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    slow.total_ns = total;
+    for (size_t i = 0; i < TRACE_STAGE_COUNT; ++i)
+    {
+        slow.stage_ns[i] = trace.stageNs(static_cast<TraceStage>(i));
+    }
+    if (rdata)
+    {
+        if (rdata->msg_info.cid)
+            slow.call_id.assign(rdata->msg_info.cid->id.ptr, rdata->msg_info.cid->id.slen);
+        if (rdata->msg_info.from && rdata->msg_info.from->uri)
+        {
+            char buf[256];
+            int len = pjsip_uri_print(PJSIP_URI_IN_FROMTO_HDR, rdata->msg_info.from->uri, buf, sizeof(buf));
+            if (len > 0) slow.from.assign(buf, len);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(slow_mutex_);
+    if (slow_ring_.size() < slow_capacity_)
+        slow_ring_.push_back(std::move(slow));
+    else
+        slow_ring_[slow_total_ % slow_capacity_] = std::move(slow);
+    ++slow_total_;
+}
+
+std::vector<SlowRequest> RequestTracer::slowRequests() const
+{
+    std::lock_guard<std::mutex> lock(slow_mutex_);
+    std::vector<SlowRequest> out;
+    out.reserve(slow_ring_.size());
+    // 最新一条位于 (slow_total_ - 1) % 容量
+    for (size_t i = 0; i < slow_ring_.size(); ++i)
+    {
+        size_t idx = (slow_total_ - 1 - i) % slow_capacity_;
+        if (idx < slow_ring_.size()) out.push_back(slow_ring_[idx]);
+    }
+    return out;
+}
+
+uint64_t RequestTracer::slowTotal() const
+{
+    std::lock_guard<std::mutex> lock(slow_mutex_);
+    return slow_total_;
+}
@@ -2,7 +2,75 @@
 
 #include "sip_core.h"
 #include "sip_register.h"
+#include "sip_heartbeat.h"
+#include "sip_message.h"
 #include "global_ctl.h"
+#include "thread_placement.h"
+#include "pool_monitor.h"
+#include "manscdp_scanner.h"
+#include "log_rate_limit.h"
+
+namespace {
+    // 请求任务的截止时间（steady_clock 时刻），由报文到达时间加 SIP 事务定时器推算：
+    // 不可靠传输（UDP）上客户端按 T1 指数退避重传，超过 T2 后队列中的旧副本
+    // 已被后续重传取代；可靠传输不重传，客户端在 Timer F（64*T1）到期后放弃事务。
+    // 到达时间是传输层收包时记录的墙钟时间，换算为已等待时长后折到 steady_clock 上
+    int64_t requestDeadline(const pjsip_rx_data* rdata)
+    {
+        const pjsip_cfg_t* cfg = pjsip_cfg();
+        bool reliable = rdata->tp_info.transport && PJSIP_TRANSPORT_IS_RELIABLE(rdata->tp_info.transport);
+        int64_t budget_ms = reliable ? 64 * static_cast<int64_t>(cfg->tsx.t1) : cfg->tsx.t2;
+
+        pj_time_val now;
+        pj_gettimeofday(&now);
+        const pj_time_val& arrived = rdata->pkt_info.timestamp;
+        int64_t age_ms = (static_cast<int64_t>(now.sec) - arrived.sec) * 1000 + (now.msec - arrived.msec);
+        // 未记录到达时间或时钟回拨时按刚到达处理
+        if (arrived.sec == 0 || age_ms < 0)
+        {
+            age_ms = 0;
+        }
+        return TaskContext::nowNs() + (budget_ms - age_ms) * 1000000;
+    }
+
+    // MANSCDP 消息的流量类别：心跳与报警通知时效性强，走信令通道；
+    // 目录与录像检索的查询及其分批响应体积大、数量多，走批量通道；其余为控制通道
+    ThreadPriority messagePriority(const ManscdpScanner::Summary& summary)
+    {
+        if (summary.isKeepalive() || (summary.root == "Notify" && summary.cmd_type == "Alarm"))
+            return ThreadPriority::HIGH;
+        if (summary.cmd_type == "Catalog" || summary.cmd_type == "RecordInfo")
+            return ThreadPriority::LOW;
+        return ThreadPriority::NORMAL;
+    }
+
+    // 请求任务未执行就被线程池丢弃（过期或取消）时记录日志，任务开始执行时 dismiss。
+    // 异步分发后没有等待方，丢弃只能在任务销毁时得知
+    class DropLogger
+    {
+    public:
+        explicit DropLogger(SipTypes::RxDataPtr rdata) : rdata_(std::move(rdata)) {}
+        DropLogger(DropLogger&&) noexcept = default;
+        DropLogger& operator=(DropLogger&&) noexcept = default;
+
+        ~DropLogger()
+        {
+            if (!rdata_)
+            {
+                return;
+            }
+            PjSipUtils::ThreadRegistrar registrar;
+            const char* reason = TaskContext::dropReason();
+            LOG_LIMITED(WARNING, "sip-drop") << "Dropped stale request " << pjsip_rx_data_get_info(rdata_.get())
+                                             << ": " << (reason ? reason : "not executed");
+        }
+
+        void dismiss() { rdata_.reset(); }
+
+    private:
+        SipTypes::RxDataPtr rdata_;
+    };
+}
 
 std::atomic<bool> SipCore::stop_pool_{false};
 
@@ -29,9 +97,13 @@ void SipCore::pollingEventLoop(SipTypes::EndpointPtr endpt)
         return;
     }
     LOG(INFO) << "pollingEventLoop started";
+    waker_.attachLoopThread();
     while (!stop_pool_) 
     {
-        pj_time_val timeout = {0, 500};
+        // 阻塞到 I/O 就绪、端点定时器堆的下一个到期时刻或跨线程唤醒，最长 MAX_BLOCK_MS；
+        // 刚被唤醒时只短暂等待一轮，让发起线程随后挂上的事务定时器参与下一次等待时长的计算
+        unsigned wait_ms = waker_.consumeWake() ? SETTLE_MS : MAX_BLOCK_MS;
+        pj_time_val timeout = {static_cast<long>(wait_ms / 1000), static_cast<long>(wait_ms % 1000)};
         pj_status_t status = pjsip_endpt_handle_events(endpt.get(), &timeout);
         // 正确处理超时状态，PJ_ETIMEDOUT是正常的超时返回
         if (status != PJ_SUCCESS && status != PJ_ETIMEDOUT)
@@ -58,9 +130,15 @@ SipCore::~SipCore()
 {
     LOG(INFO) << "Releasing SipCore...";
     stop_pool_ = true;
+    waker_.wake();
     
-    // 增加足够的等待时间，确保pollingEventLoop安全退出
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    // 等待pollingEventLoop退出（已被唤醒，不必等到本轮阻塞超时）
+    if (polling_thread_)
+    {
+        polling_thread_->stop(std::chrono::milliseconds(2000));
+    }
+    waker_.close();
+    PoolMonitor::getInstance()->stop();
     
     // 直接使用 PjSipUtils 的清理函数
     PjSipUtils::cleanupCore(caching_pool_, endpt_);
@@ -69,7 +147,7 @@ SipCore::~SipCore()
 pj_status_t SipCore::initSip(int sip_port) 
 {  
     LOG(INFO) << "Initializing SipCore...";
-    pj_log_set_level(6);
+    PjSipUtils::routePjLog();
     pj_status_t status;
 
     if (!caching_pool_) 
@@ -91,6 +169,9 @@ pj_status_t SipCore::initSip(int sip_port)
         return PJ_ENOMEM;
     }
 
+    // 端点与传输层的池都从该缓存池分配
+    PoolMonitor::getInstance()->start(caching_pool_.get());
+
     status = PjSipUtils::initTransports(endpt_, sip_port);
     if (status != PJ_SUCCESS) 
     {
@@ -119,27 +200,31 @@ pj_status_t SipCore::initSip(int sip_port)
         return PJ_ENOMEM;
     }
 
-    // 安全创建线程
-    auto self = shared_from_this();
+    status = waker_.init(endpt_, pool_.get());
+    if (status != PJ_SUCCESS)
+    {
+        LOG(ERROR) << "LoopWaker::init failed, code: " << status;
+        return status;
+    }
+
+    // 事件循环运行在独立线程上，不占用请求处理线程池；
+    // 析构时先停止并等待该线程，因此可以直接捕获 this
     auto endpt_copy = endpt_;
-    
-    try {
-        // 使用适当超时时间创建线程
-        auto thread_future = EVThread::createThread(
-            [self, endpt_copy]() {
-                try {
-                    self->pollingEventLoop(endpt_copy);
-                } catch (const std::exception& e) {
-                    LOG(ERROR) << "Exception in pollingEventLoop: " << e.what();
-                }
-            },
-            std::tuple<>{},
-            nullptr,
-            ThreadPriority::NORMAL,
-            std::chrono::milliseconds{30000} 
-        );
-    } catch (const std::exception& e) {
-        LOG(ERROR) << "Failed to create polling thread: " << e.what();
+    ServiceThreadOptions options;
+    options.name = "sip-polling";
+    options.cpus = ThreadPlacement::getInstance()->cpusFor(ThreadRole::SIP_IO);
+    polling_thread_ = std::make_unique<ServiceThread>(std::move(options),
+        [this, endpt_copy](ServiceThread&) {
+            pollingEventLoop(endpt_copy);
+        });
+    polling_thread_->setWakeup([this]() {
+        stop_pool_ = true;
+        waker_.wake();
+    });
+    if (!polling_thread_->start())
+    {
+        LOG(ERROR) << "Failed to create polling thread";
+        polling_thread_.reset();
         return PJ_EINVAL;
     }
     
@@ -157,6 +242,21 @@ pj_bool_t SipCore::onRxRequestRaw(pjsip_rx_data* rdata)
         return PJ_FALSE;
     }
 
+    // 心跳在接收线程直接应答，不克隆、不切换线程
+    if (SipHeartbeat::getInstance(GlobalCtl::getInstance())->onRxMessage(rdata))
+    {
+        return PJ_TRUE;
+    }
+
+    // REGISTER 从克隆前开始分阶段计时
+    static RequestTracer* tracer = RequestTracer::getInstance().get();
+    RequestTrace trace;
+    if (rdata->msg_info.msg && rdata->msg_info.msg->line.req.method.id == PJSIP_REGISTER_METHOD
+        && tracer->enabled())
+    {
+        trace.begin("REGISTER");
+    }
+
     // 立即克隆数据并转换为智能指针
     auto rdata_ptr = PjSipUtils::cloneRxData(rdata);
     if (!rdata_ptr) 
@@ -164,6 +264,8 @@ pj_bool_t SipCore::onRxRequestRaw(pjsip_rx_data* rdata)
         LOG(ERROR) << "Failed to clone rx_data in onRxRequestRaw";
         return PJ_FALSE;
     }
+    trace.record(TraceStage::CLONE);
+    RequestTrace::Scope trace_scope(&trace);
     
     // 调用智能指针版本的处理函数
     return onRxRequest(rdata_ptr);
@@ -172,7 +274,7 @@ pj_bool_t SipCore::onRxRequestRaw(pjsip_rx_data* rdata)
 // 修改为使用智能指针的实现
 pj_bool_t SipCore::onRxRequest(SipTypes::RxDataPtr rdata)
 {
-    LOG(INFO) << "onRxRequest called with rdata=" << (void*)rdata.get();
+    LOG(DEBUG) << "onRxRequest called with rdata=" << (void*)rdata.get();
     
     // 添加线程注册，因为这是处理接收SIP请求的回调
     PjSipUtils::ThreadRegistrar thread_registrar;
@@ -183,18 +285,36 @@ pj_bool_t SipCore::onRxRequest(SipTypes::RxDataPtr rdata)
         return PJ_FALSE;
     }
 
-    LOG(INFO) << "onRxRequest: " << pjsip_rx_data_get_info(rdata.get());
+    LOG(DEBUG) << "onRxRequest: " << pjsip_rx_data_get_info(rdata.get());
 
     // 创建参数对象
     auto params = std::make_shared<ThRxParams>();
     
     // 这里直接使用智能指针，无需额外的克隆操作
     params->rxdata = rdata;
+    if (RequestTrace* trace = RequestTrace::current())
+    {
+        params->trace = *trace;
+    }
     
-    // 由工厂/单例获取注册器
+    // 由工厂/单例获取注册器；同时确定任务的流量类别：
+    // REGISTER 走信令通道，MESSAGE 按 MANSCDP 命令类型分类（见 messagePriority）
+    ThreadPriority priority = ThreadPriority::NORMAL;
     if (rdata->msg_info.msg->line.req.method.id == PJSIP_REGISTER_METHOD) 
     { 
         params->taskbase = SipRegister::getInstance(GlobalCtl::getInstance());
+        priority = ThreadPriority::HIGH;
+    }
+    else if (SipHeartbeat::isMessageRequest(rdata->msg_info.msg))
+    {
+        params->taskbase = SipMessage::getInstance(GlobalCtl::getInstance());
+        const pjsip_msg_body* body = rdata->msg_info.msg->body;
+        ManscdpScanner::Summary summary;
+        if (body && body->data
+            && ManscdpScanner::scan(static_cast<const char*>(body->data), body->len, summary))
+        {
+            priority = messagePriority(summary);
+        }
     }
     else
     {
@@ -207,45 +327,43 @@ pj_bool_t SipCore::onRxRequest(SipTypes::RxDataPtr rdata)
     // 确保参数在线程执行期间有效
     auto params_copy = params; // 复制shared_ptr，确保引用计数增加
 
-    auto worker = [params_copy]() -> int {
+    auto worker = [params_copy, drop_logger = DropLogger(rdata)]() mutable {
+        drop_logger.dismiss();
         // 确保线程注册到PJSIP
         PjSipUtils::ThreadRegistrar registrar;
-        LOG(INFO) << "Thread started for runRxTask";
+        LOG(DEBUG) << "Thread started for runRxTask";
         if(!params_copy || !params_copy->taskbase) 
         {
             LOG(ERROR) << "params or taskbase null";
-            return -1;
+            return;
         }
         
+        RequestTrace::Scope trace_scope(&params_copy->trace);
+        RequestTrace::mark(TraceStage::QUEUE);
+
         // 增加错误处理
         try {
             // 传递智能指针，而非裸指针
             params_copy->taskbase->runRxTask(params_copy->rxdata);
-            LOG(INFO) << "runRxTask success in PJSIP_REGISTER_METHOD";
-            return 0;
+            LOG(DEBUG) << "runRxTask success";
         } catch (const std::exception& e) {
             LOG(ERROR) << "Exception in runRxTask: " << e.what();
-            return -1;
         }
+        params_copy->trace.finish(params_copy->rxdata.get());
     };
 
     try {
-        // 增加错误处理
-        auto fut = EVThread::createThread(
+        // 异步分发：rdata 已克隆，投递后立即返回，接收线程不等待处理结果，
+        // 请求在线程池中按流量类别排队。截止时间由报文到达时间与 SIP 定时器推算，
+        // 过期的请求在出队时直接丢弃（由 DropLogger 记录）；应答由处理任务自行发送
+        EVThread::createThreadUntil(
             std::move(worker), 
             std::tuple<>{}, 
             nullptr, 
-            ThreadPriority::NORMAL, 
-            std::chrono::milliseconds{5000} // 超时时间
+            priority, 
+            requestDeadline(rdata.get())
         );
-
-        int result = fut.get();
-        if(result != 0) 
-        {
-            LOG(ERROR) << "Thread execution failed with result: " << result;
-            return PJ_FALSE;
-        }
-        return PJ_TRUE; // 成功返回PJ_TRUE而非PJ_SUCCESS
+        return PJ_TRUE; // 已接管该请求
     } catch (const std::exception& e) {
         LOG(ERROR) << "Exception in thread creation: " << e.what();
         return PJ_FALSE;
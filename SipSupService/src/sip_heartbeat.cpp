@@ -0,0 +1,279 @@
+// sip_heartbeat.cpp
+#include "sip_heartbeat.h"
+#include "global_ctl.h"
+#include "pjsip_utils.h"
+#include "manscdp_scanner.h"
+#include "tcp_conn_manager.h"
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+std::shared_ptr<SipHeartbeat> SipHeartbeat::instance_ = nullptr;
+std::mutex SipHeartbeat::instance_mutex_;
+
+std::shared_ptr<SipHeartbeat> SipHeartbeat::getInstance(IDomainManager& domain_manager)
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+        instance_ = std::shared_ptr<SipHeartbeat>(new SipHeartbeat(domain_manager));
+    return instance_;
+}
+
+SipHeartbeat::SipHeartbeat(IDomainManager& domain_manager)
+    : hb_timer_(std::make_shared<TaskTimer>("sup-heartbeat"))
+    , domain_manager_(domain_manager)
+{
+    hb_timer_->setInterval(TICK_MS);
+    buildDeviceTable();
+}
+
+SipHeartbeat::~SipHeartbeat()
+{
+    LOG(INFO) << "Destroying SipHeartbeat";
+    if (hb_timer_)
+    {
+        hb_timer_->stop();
+    }
+}
+
+void SipHeartbeat::startHeartbeatService()
+{
+    LOG(INFO) << "Starting heartbeat service, interval: "
+              << GCONF(getKeepaliveInterval) << "s, max missed: " << GCONF(getKeepaliveMaxMissed);
+    hb_timer_->addTask([weak_this = std::weak_ptr<SipHeartbeat>(shared_from_this())]() {
+        if (auto shared_this = weak_this.lock())
+        {
+            try {
+                shared_this->tickProc();
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Error in heartbeat task: " << e.what();
+            }
+        }
+    });
+    hb_timer_->start();
+}
+
+int64_t SipHeartbeat::nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SipHeartbeat::buildDeviceTable()
+{
+    std::vector<std::string> ids;
+    {
+        std::shared_lock<std::shared_mutex> domain_lock(domain_manager_.getMutex());
+        for (const auto& domain : domain_manager_.getDomainInfoList())
+        {
+            ids.push_back(domain.sip_id);
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(device_mutex_);
+    for (auto& id : ids)
+    {
+        if (findDevice(id))
+        {
+            continue;
+        }
+        auto state = std::make_unique<DeviceState>();
+        state->id = std::move(id);
+        // 键引用 DeviceState 内部的字符串，两者生命周期一致
+        std::string_view key(state->id);
+        devices_.emplace(key, std::move(state));
+    }
+    LOG(INFO) << "Heartbeat device table built: " << devices_.size() << " device(s)";
+}
+
+SipHeartbeat::DeviceState* SipHeartbeat::findDevice(std::string_view device_id) const
+{
+    // 注意：调用此方法前必须已获取 device_mutex_
+    auto it = devices_.find(device_id);
+    return it != devices_.end() ? it->second.get() : nullptr;
+}
+
+bool SipHeartbeat::onKeepalive(std::string_view device_id)
+{
+    DeviceState* device { nullptr };
+    {
+        std::shared_lock<std::shared_mutex> lock(device_mutex_);
+        device = findDevice(device_id);
+    }
+    if (!device || !device->online.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    device->last_heartbeat_ms.store(nowMs(), std::memory_order_relaxed);
+    device->missed.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void SipHeartbeat::track(const std::string& device_id)
+{
+    DeviceState* device { nullptr };
+    {
+        std::shared_lock<std::shared_mutex> lock(device_mutex_);
+        device = findDevice(device_id);
+    }
+    if (!device)
+    {
+        LOG(ERROR) << "Heartbeat track: device not found: " << device_id;
+        return;
+    }
+
+    int64_t now = nowMs();
+    device->last_heartbeat_ms.store(now, std::memory_order_relaxed);
+    device->missed.store(0, std::memory_order_relaxed);
+    // 注册刷新时已在线，不重复调度
+    if (device->online.exchange(true, std::memory_order_acq_rel))
+    {
+        return;
+    }
+    uint64_t epoch = device->epoch.fetch_add(1) + 1;
+
+    uint64_t interval_ticks = static_cast<uint64_t>(GCONF(getKeepaliveInterval)) * 1000 / TICK_MS;
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    wheel_.schedule(interval_ticks, WheelEntry{device, epoch, now});
+    LOG(INFO) << "Heartbeat tracking started for device: " << device_id;
+}
+
+void SipHeartbeat::untrack(const std::string& device_id)
+{
+    DeviceState* device { nullptr };
+    {
+        std::shared_lock<std::shared_mutex> lock(device_mutex_);
+        device = findDevice(device_id);
+    }
+    if (device && device->online.exchange(false, std::memory_order_acq_rel))
+    {
+        device->epoch.fetch_add(1);
+    }
+}
+
+void SipHeartbeat::tickProc()
+{
+    std::vector<WheelEntry> due;
+    {
+        std::lock_guard<std::mutex> lock(wheel_mutex_);
+        wheel_.advance([&due](WheelEntry&& entry) { due.push_back(entry); });
+    }
+    for (const auto& entry : due)
+    {
+        checkDevice(entry);
+    }
+}
+
+void SipHeartbeat::checkDevice(const WheelEntry& entry)
+{
+    DeviceState* device = entry.device;
+    // 纪元不一致：设备已注销或重新注册，丢弃旧条目
+    if (device->epoch.load() != entry.epoch || !device->online.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    // 只比较时间戳是否前进：周期内收到过心跳即视为正常
+    int64_t last = device->last_heartbeat_ms.load(std::memory_order_relaxed);
+    if (last == entry.checked_ms)
+    {
+        uint32_t missed = device->missed.fetch_add(1) + 1;
+        LOG(WARNING) << "Device " << device->id << " missed keepalive, missed: " << missed;
+        if (missed >= static_cast<uint32_t>(GCONF(getKeepaliveMaxMissed)))
+        {
+            if (device->online.exchange(false, std::memory_order_acq_rel))
+            {
+                device->epoch.fetch_add(1);
+                domain_manager_.updateRegistration(device->id, 0, false, 0);
+                LOG(WARNING) << "Device " << device->id << " missed " << missed
+                             << " keepalives, marked offline";
+            }
+            return;
+        }
+    }
+
+    uint64_t interval_ticks = static_cast<uint64_t>(GCONF(getKeepaliveInterval)) * 1000 / TICK_MS;
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    wheel_.schedule(interval_ticks, WheelEntry{device, entry.epoch, last});
+}
+
+bool SipHeartbeat::isMessageRequest(const pjsip_msg* msg)
+{
+    if (!msg || msg->type != PJSIP_REQUEST_MSG)
+    {
+        return false;
+    }
+    const pjsip_method& method = msg->line.req.method;
+    return method.id == PJSIP_OTHER_METHOD
+        && method.name.slen == 7
+        && std::strncmp(method.name.ptr, "MESSAGE", 7) == 0;
+}
+
+std::string_view SipHeartbeat::fromUser(const pjsip_rx_data* rdata)
+{
+    const pjsip_from_hdr* from_hdr = rdata->msg_info.from;
+    if (!from_hdr || !from_hdr->uri)
+    {
+        return {};
+    }
+    auto sip_uri = static_cast<const pjsip_sip_uri*>(pjsip_uri_get_uri(from_hdr->uri));
+    if (!sip_uri || sip_uri->user.slen <= 0)
+    {
+        return {};
+    }
+    return std::string_view(sip_uri->user.ptr, static_cast<size_t>(sip_uri->user.slen));
+}
+
+pj_bool_t SipHeartbeat::onRxMessage(pjsip_rx_data* rdata)
+{
+    pjsip_msg* msg = rdata->msg_info.msg;
+    if (!isMessageRequest(msg) || !msg->body || !msg->body->data)
+    {
+        return PJ_FALSE;
+    }
+
+    // 流式扫描，不构建 DOM；非心跳或扫描失败时交给常规分发流程做完整解析
+    ManscdpScanner::Summary summary;
+    std::string_view from_id = fromUser(rdata);
+    if (from_id.empty()
+        || !ManscdpScanner::scan(static_cast<const char*>(msg->body->data), msg->body->len, summary)
+        || !summary.isKeepalive() || summary.device_id.empty())
+    {
+        return PJ_FALSE;
+    }
+
+    // 在线状态按 From 记录，消息体中的 DeviceID 必须与之一致，
+    // 否则任意对端都能在消息体里冒用其他设备的ID维持其在线
+    int status_code = static_cast<int>(SipStatusCode::SIP_FORBIDEN);
+    if (summary.device_id != from_id)
+    {
+        LOG(WARNING) << "Keepalive DeviceID " << summary.device_id << " does not match From: " << from_id;
+    }
+    else if (!onKeepalive(from_id))
+    {
+        LOG(WARNING) << "Keepalive from unknown or unregistered device: " << from_id;
+    }
+    else
+    {
+        status_code = static_cast<int>(SipStatusCode::SIP_OK);
+        if (rdata->tp_info.transport
+            && pjsip_transport_get_type_from_flag(rdata->tp_info.transport->flag) == PJSIP_TRANSPORT_TCP)
+        {
+            // TCP 心跳刷新连接的空闲时间
+            TcpConnManager::getInstance()->adopt(std::string(from_id), rdata->tp_info.transport);
+        }
+    }
+
+    auto endpt = GlobalCtl::getInstance().getSipCore().getEndPoint();
+    if (endpt)
+    {
+        pj_status_t status = pjsip_endpt_respond_stateless(endpt.get(), rdata, status_code,
+            nullptr, nullptr, nullptr);
+        if (status != PJ_SUCCESS)
+        {
+            LOG(ERROR) << "Failed to respond keepalive, code: " << status;
+        }
+    }
+    return PJ_TRUE;
+}
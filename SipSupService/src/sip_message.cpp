@@ -0,0 +1,116 @@
+// sip_message.cpp
+#include "sip_message.h"
+#include "global_ctl.h"
+#include "pjsip_utils.h"
+#include "sip_heartbeat.h"
+
+#include <cstring>
+
+std::shared_ptr<SipMessage> SipMessage::instance_ = nullptr;
+std::mutex SipMessage::instance_mutex_;
+
+std::shared_ptr<SipMessage> SipMessage::getInstance(IDomainManager& domain_manager)
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+        instance_ = std::shared_ptr<SipMessage>(new SipMessage(domain_manager));
+    return instance_;
+}
+
+SipMessage::SipMessage(IDomainManager& domain_manager)
+    : domain_manager_(domain_manager)
+{
+}
+
+pj_status_t SipMessage::runRxTask(SipTypes::RxDataPtr rdata)
+{
+    PjSipUtils::ThreadRegistrar thread_registrar;
+    if (!rdata || !rdata->msg_info.msg)
+    {
+        LOG(ERROR) << "SipMessage: rdata or message is null";
+        return PJ_EINVAL;
+    }
+
+    pjsip_msg* msg = rdata->msg_info.msg;
+    std::string from_id;
+    try {
+        from_id = parseFromHeader(msg);
+    } catch (const std::exception& e) {
+        LOG(ERROR) << "SipMessage: failed to parse From header: " << e.what();
+        return respond(rdata, PJSIP_SC_BAD_REQUEST);
+    }
+
+    if (!domain_manager_.checkIsValid(from_id))
+    {
+        LOG(WARNING) << "MESSAGE from unknown or unregistered device: " << from_id;
+        return respond(rdata, static_cast<int>(SipStatusCode::SIP_FORBIDEN));
+    }
+
+    if (!msg->body || !msg->body->data)
+    {
+        LOG(WARNING) << "MESSAGE without body from: " << from_id;
+        return respond(rdata, PJSIP_SC_BAD_REQUEST);
+    }
+
+    tinyxml2::XMLDocument doc;
+    if (doc.Parse(static_cast<const char*>(msg->body->data), msg->body->len) != tinyxml2::XML_SUCCESS
+        || !doc.RootElement())
+    {
+        LOG(WARNING) << "Malformed MANSCDP body from: " << from_id;
+        return respond(rdata, PJSIP_SC_BAD_REQUEST);
+    }
+
+    auto root = doc.RootElement();
+    auto cmd_type = root->FirstChildElement("CmdType");
+    const char* cmd = (cmd_type && cmd_type->GetText()) ? cmd_type->GetText() : "";
+    LOG(INFO) << "MANSCDP " << root->Name() << "/" << cmd << " from: " << from_id;
+
+    // 快速路径无法处理的心跳（含实体引用等）在这里兜底
+    if (std::strcmp(root->Name(), "Notify") == 0 && std::strcmp(cmd, "Keepalive") == 0)
+    {
+        // 与快速路径一致：消息体中的 DeviceID 必须与 From 相同
+        auto device_elem = root->FirstChildElement("DeviceID");
+        const char* device_id = (device_elem && device_elem->GetText()) ? device_elem->GetText() : "";
+        if (from_id != device_id)
+        {
+            LOG(WARNING) << "Keepalive DeviceID " << device_id << " does not match From: " << from_id;
+            return respond(rdata, static_cast<int>(SipStatusCode::SIP_FORBIDEN));
+        }
+        SipHeartbeat::getInstance(domain_manager_)->onKeepalive(from_id);
+    }
+    return respond(rdata, static_cast<int>(SipStatusCode::SIP_OK));
+}
+
+pj_status_t SipMessage::respond(SipTypes::RxDataPtr rdata, int status_code)
+{
+    auto endpt = GlobalCtl::getInstance().getSipCore().getEndPoint();
+    if (!endpt)
+    {
+        LOG(ERROR) << "SipMessage: failed to get endpoint";
+        return PJ_EINVAL;
+    }
+    pj_status_t status = pjsip_endpt_respond_stateless(endpt.get(), rdata.get(), status_code,
+        nullptr, nullptr, nullptr);
+    if (status != PJ_SUCCESS)
+    {
+        LOG(ERROR) << "SipMessage: failed to send response, code: " << status;
+    }
+    return status;
+}
+
+std::string SipMessage::parseFromHeader(pjsip_msg* msg)
+{
+    auto from_hdr = static_cast<pjsip_from_hdr*>(
+        pjsip_msg_find_hdr(msg, PJSIP_H_FROM, nullptr));
+    if (!from_hdr || !from_hdr->uri)
+    {
+        throw std::runtime_error("From header not found");
+    }
+
+    auto sip_uri = static_cast<pjsip_sip_uri*>(pjsip_uri_get_uri(from_hdr->uri));
+    if (!sip_uri || sip_uri->user.slen <= 0)
+    {
+        throw std::runtime_error("Empty user ID in From URI");
+    }
+    return std::string(sip_uri->user.ptr, sip_uri->user.slen);
+}
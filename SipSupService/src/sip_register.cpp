@@ -3,6 +3,11 @@
 #include "sip_register.h"
 #include "global_ctl.h"
 #include "pjsip_utils.h"
+#include "sip_heartbeat.h"
+#include "tcp_conn_manager.h"
+#include "metrics.h"
+#include "request_trace.h"
+#include "log_rate_limit.h"
 
 #include <array>
 #include <chrono>
@@ -13,6 +18,34 @@
 #include <iomanip>
 #include <sstream>
 
+namespace {
+    // REGISTER 处理的指标，首次使用时注册
+    struct RegisterMetrics
+    {
+        Counter& received;
+        Counter& accepted;
+        Counter& challenged;
+        Counter& rejected;
+        Histogram& auth_latency;
+    };
+
+    RegisterMetrics& registerMetrics()
+    {
+        static RegisterMetrics metrics = [] {
+            auto registry = MetricsRegistry::getInstance();
+            const std::string help = "REGISTER responses by result";
+            return RegisterMetrics{
+                registry->counter("sip_register_received_total", "REGISTER requests received"),
+                registry->counter("sip_register_responses_total", help, {{"result", "accepted"}}),
+                registry->counter("sip_register_responses_total", help, {{"result", "challenged"}}),
+                registry->counter("sip_register_responses_total", help, {{"result", "rejected"}}),
+                registry->histogram("sip_register_auth_latency_seconds", "Digest verification time of authenticated REGISTER"),
+            };
+        }();
+        return metrics;
+    }
+}
+
 // 认证凭证回调函数
 static pj_status_t auth_cred_callback(
     pj_pool_t *pool,
@@ -30,7 +63,7 @@ static pj_status_t auth_cred_callback(
     try {
         // 记录请求中的用户名
         std::string acc_name_str(acc_name->ptr, acc_name->slen);
-        LOG(INFO) << "Auth request for username: " << acc_name_str;
+        LOG(DEBUG) << "Auth request for username: " << acc_name_str;
         
         // 获取配置中的用户名和密码
         std::string usr_str = GlobalCtl::getInstance().getConfig().getSipUsr();
@@ -43,14 +76,14 @@ static pj_status_t auth_cred_callback(
 
         // 增加用户名验证逻辑
         std::string config_usr = GlobalCtl::getInstance().getConfig().getSipUsr();
-        LOG(INFO) << fmt::format("Configure_username: {}, Username: {}, Password: {}", 
+        LOG(DEBUG) << fmt::format("Configure_username: {}, Username: {}, Password: {}", 
             config_usr, acc_name_str, pwd_str);
 
         // 验证用户名匹配
         pj_str_t usr;
         if (pj_stricmp(acc_name, pj_cstr(&usr, config_usr.c_str())) != 0)
         {
-            LOG(ERROR) << "Username mismatch";
+            LOG_LIMITED(ERROR, acc_name_str) << "Username mismatch: " << acc_name_str;
             return PJ_EINVAL;
         }
         
@@ -60,7 +93,7 @@ static pj_status_t auth_cred_callback(
         cred_info->data_type = PJSIP_CRED_DATA_PLAIN_PASSWD;
         cred_info->data = pj_str((char*)pwd_str.c_str());
         
-        LOG(INFO) << "Credentials set for requested username: " << acc_name_str;
+        LOG(DEBUG) << "Credentials set for requested username: " << acc_name_str;
         return PJ_SUCCESS;
     } catch (const std::exception& e) {
         LOG(ERROR) << "Exception in auth_cred_callback: " << e.what();
@@ -82,11 +115,10 @@ std::shared_ptr<SipRegister> SipRegister::getInstance(IDomainManager& domain_man
 }
 
 SipRegister::SipRegister(IDomainManager& domain_manager) 
-    : reg_timer_(std::make_shared<TaskTimer>())
+    : reg_timer_(std::make_shared<TaskTimer>("sup-register"))
     , domain_manager_(domain_manager)
 {
     reg_timer_->setInterval(10000); // 设置10秒间隔
-    reg_timer_->start();
 }
 
 SipRegister::~SipRegister() 
@@ -105,19 +137,24 @@ void SipRegister::startRegService()
     LOG(INFO) << "Starting registration service";
     if(reg_timer_)
     {
+        // 注册处理需要调用 PJSIP：挂在端点定时器堆上，直接在事件循环线程执行，
+        // 端点不可用时退回独立的定时器线程
+        reg_timer_->setEndpoint(GlobalCtl::getInstance().getSipCore().getEndPoint(),
+            []() { GlobalCtl::getInstance().getSipCore().wakeup(); });
         auto self = shared_from_this();
         reg_timer_->addTask([weak_this = std::weak_ptr<SipRegister>(self)](){
             if(auto shared_this = weak_this.lock())
             {
                 try{
                     shared_this->checkRegisterProc();
-                    LOG(INFO) << "checkRegisterProc task executed";
+                    LOG(DEBUG) << "checkRegisterProc task executed";
                 } catch (const std::exception& e) {
                     LOG(ERROR) << "Error in registration task: " << e.what();
                     throw;
                 }
             }
         });
+        reg_timer_->start();
         LOG(INFO) << "Registration timer started successfully";
     } else {
         LOG(ERROR) << "Timer not initialized";
@@ -127,14 +164,14 @@ void SipRegister::startRegService()
 // 定期的注册检查程序，比较当前时间和上次注册时间
 void SipRegister::checkRegisterProc()
 {
-    LOG(INFO) << "checkRegisterProc called";
+    LOG(DEBUG) << "checkRegisterProc called";
 
     // 获取当前系统运行时间
     time_t reg_time = 0;
     struct sysinfo info;
     if (sysinfo(&info) == 0){
         reg_time = info.uptime;
-        LOG(INFO) << "System uptime: " << info.uptime << " seconds";
+        LOG(DEBUG) << "System uptime: " << info.uptime << " seconds";
     }else{
         reg_time = std::time(nullptr);
         LOG(ERROR) << "Failed to get system uptime, using current time: " << reg_time;
@@ -143,17 +180,17 @@ void SipRegister::checkRegisterProc()
     try {
         PjSipUtils::ThreadRegistrar thread_registrar;
         std::lock_guard<std::mutex> lock(register_mutex_);
-        LOG(INFO) << "checkRegisterProc: lock acquired";
+        LOG(DEBUG) << "checkRegisterProc: lock acquired";
 
         auto& domains = GlobalCtl::getInstance().getDomainInfoList();
-        LOG(INFO) << "DomainInfoList size: " << domains.size();
+        LOG(DEBUG) << "DomainInfoList size: " << domains.size();
 
         // 遍历所有子域信息
         for (auto& domain : domains)
         {
             if (domain.registered)
             {
-                LOG(INFO) << "reg_time: " << reg_time << ", last_reg_time: " << domain.last_reg_time;
+                LOG(DEBUG) << "reg_time: " << reg_time << ", last_reg_time: " << domain.last_reg_time;
                 // 增加超时处理的容错机制
                 if (reg_time < domain.last_reg_time) 
                 {
@@ -165,6 +202,7 @@ void SipRegister::checkRegisterProc()
                 {
                     // 如果过期则标记为未注册状态
                     domain.registered = false;
+                    SipHeartbeat::getInstance(domain_manager_)->untrack(domain.sip_id);
                     LOG(INFO) << "Registration has expired.";
                 }
             }
@@ -178,7 +216,7 @@ void SipRegister::checkRegisterProc()
 // 修改为使用智能指针
 pj_status_t SipRegister::runRxTask(SipTypes::RxDataPtr rdata) 
 {
-    LOG(INFO) << "runRxTask called with rdata=" << (void*)rdata.get();
+    LOG(DEBUG) << "runRxTask called with rdata=" << (void*)rdata.get();
     PjSipUtils::ThreadRegistrar thread_registrar;
     return registerReqMsg(rdata);
 }
@@ -186,22 +224,23 @@ pj_status_t SipRegister::runRxTask(SipTypes::RxDataPtr rdata)
 // 处理注册请求消息，修改为接收智能指针
 pj_status_t SipRegister::registerReqMsg(SipTypes::RxDataPtr rdata)
 {
-    LOG(INFO) << "registerReqMsg called with rdata=" << (void*)rdata.get();
+    LOG(DEBUG) << "registerReqMsg called with rdata=" << (void*)rdata.get();
     
     if (!rdata || !rdata->msg_info.msg) {
         LOG(ERROR) << "Invalid rdata or message";
         return PJ_EINVAL;
     }
 
+    registerMetrics().received.inc();
     pjsip_msg* msg = rdata->msg_info.msg;
     // 根据认证状态决定调用哪种处理方式
     // 分为两种情况：已认证和未认证
     if(GlobalCtl::getInstance().getAuthInfo(parseFromHeader(msg)))
     {
-        LOG(INFO) << "Authentication required for domain: " << parseFromHeader(msg);
+        LOG(DEBUG) << "Authentication required for domain: " << parseFromHeader(msg);
         return handleAuthRegister(rdata); 
     }else{
-        LOG(INFO) << "No authentication required for domain: " << parseFromHeader(msg);
+        LOG(DEBUG) << "No authentication required for domain: " << parseFromHeader(msg);
         return handleRegister(rdata);
     }
 }
@@ -209,7 +248,7 @@ pj_status_t SipRegister::registerReqMsg(SipTypes::RxDataPtr rdata)
 // 处理需要认证的SIP注册请求，修改为接收智能指针
 pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
 {
-    LOG(INFO) << "handleAuthRegister called with rdata=" << (void*)rdata.get();
+    LOG(DEBUG) << "handleAuthRegister called with rdata=" << (void*)rdata.get();
     
     if (!rdata || !rdata->msg_info.msg) {
         LOG(ERROR) << "Invalid rdata or message";
@@ -228,7 +267,7 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
 
     pjsip_msg* msg = rdata->msg_info.msg;
     auto from_id = parseFromHeader(msg);
-    LOG(INFO) << "Processing auth request for user: " << from_id;
+    LOG(DEBUG) << "Processing auth request for user: " << from_id;
     
     int status_code = static_cast<int>(SipStatusCode::SIP_UNAUTHORIZED); // 401
     pj_status_t status = PJ_SUCCESS;
@@ -237,7 +276,9 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
     auto auth_hdr = pjsip_msg_find_hdr(msg, PJSIP_H_AUTHORIZATION, nullptr);
     if(auth_hdr == nullptr)
     {
-        LOG(INFO) << "No Authorization header found, sending challenge";
+        LOG(DEBUG) << "No Authorization header found, sending challenge";
+        RequestTrace::mark(TraceStage::AUTH);
+        RequestTrace::status(status_code);
     
         // 创建响应消息
         pjsip_tx_data* tdata = nullptr;
@@ -267,7 +308,7 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
             
             // nonce
             std::string nonce = GlobalCtl::getRandomNum(32);
-            LOG(INFO) << "Generated nonce: " << nonce;
+            LOG(DEBUG) << "Generated nonce: " << nonce;
             hdr->challenge.digest.nonce = pj_strdup3(tdata->pool, nonce.c_str());
 
             // realm - 使用from_id作为realm，确保匹配
@@ -275,7 +316,7 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
 
             // opaque
             std::string opaque = GlobalCtl::getRandomNum(32);
-            LOG(INFO) << "Generated opaque: " << opaque;
+            LOG(DEBUG) << "Generated opaque: " << opaque;
             hdr->challenge.digest.opaque = pj_strdup3(tdata->pool, opaque.c_str());
 
             // 加密方式
@@ -291,6 +332,7 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
                 pjsip_tx_data_dec_ref(tdata);
                 throw std::runtime_error("Failed to get response address");
             }
+            RequestTrace::mark(TraceStage::BUILD);
 
             status = pjsip_endpt_send_response(
                 endpt.get(),
@@ -298,6 +340,11 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
                 tdata,
                 nullptr,
                 nullptr);
+            RequestTrace::mark(TraceStage::SEND);
+            if (status == PJ_SUCCESS)
+            {
+                registerMetrics().challenged.inc();
+            }
 
         } catch (const std::exception& e) {
             LOG(ERROR) << "Exception in auth handling: " << e.what();
@@ -322,12 +369,12 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
                                     auth_hdr->credential.digest.username.slen);
             std::string auth_realm(auth_hdr->credential.digest.realm.ptr, 
                                 auth_hdr->credential.digest.realm.slen);
-            LOG(INFO) << "Authorization header found, username: " << auth_username 
+            LOG(DEBUG) << "Authorization header found, username: " << auth_username 
                     << ", realm: " << auth_realm;
         }
         
         try {
-            LOG(INFO) << "Creating temporary pool for authentication";
+            LOG(DEBUG) << "Creating temporary pool for authentication";
             pj_pool_t* tmp_pool = pjsip_endpt_create_pool(
                 endpt.get(),
                 "auth_pool", 4000, 4000);
@@ -335,7 +382,7 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
             if (!tmp_pool) {
                 throw std::runtime_error("Failed to create temporary pool");
             }
-            LOG(INFO) << "Created temporary pool: " << (void*)tmp_pool;
+            LOG(DEBUG) << "Created temporary pool: " << (void*)tmp_pool;
 
             // RAII方式管理临时池的生命周期
             std::unique_ptr<void, std::function<void(void*)>> pool_guard(
@@ -343,12 +390,13 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
                 [&endpt](void* p) { 
                     if (p) {
                         pjsip_endpt_release_pool(endpt.get(), static_cast<pj_pool_t*>(p));
-                        LOG(INFO) << "Authentication pool released";
+                        LOG(DEBUG) << "Authentication pool released";
                     }
                 }
             );
 
             // 认证验证代码
+            auto verify_start = std::chrono::steady_clock::now();
             pjsip_auth_srv auth_srv;
             auto realm = pj_str((char*)GlobalCtl::getInstance().getConfig().getSipRealm().c_str());
             status = pjsip_auth_srv_init(tmp_pool, &auth_srv, &realm, &auth_cred_callback, 0);
@@ -356,6 +404,14 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
                 throw std::runtime_error("Failed to initialize auth server");
             }
             pjsip_auth_srv_verify(&auth_srv, rdata.get(), &status_code);
+            registerMetrics().auth_latency.observe(std::chrono::steady_clock::now() - verify_start);
+            RequestTrace::mark(TraceStage::AUTH);
+            RequestTrace::status(status_code);
+            if (status_code != static_cast<int>(SipStatusCode::SIP_OK))
+            {
+                // 凭证错误的设备会按注册周期反复重试，按设备限流
+                LOG_LIMITED(WARNING, from_id) << "Authentication failed for " << from_id << ", status code " << status_code;
+            }
             // // 自定义认证处理，跳过PJSIP内置认证机制
             // // 这里直接假设认证成功，在实际应用中应该进行真实的密码验证
             // status_code = static_cast<int>(SipStatusCode::SIP_OK);
@@ -372,13 +428,13 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
             if (!tdata) {
                 throw std::runtime_error("Failed to create response");
             }
-            LOG(INFO) << "Created response with status code: " << status_code;
+            LOG(DEBUG) << "Created response with status code: " << status_code;
 
             // 添加日期头部
             if (!addDateHeader(tdata->msg, tdata->pool)) {
                 throw std::runtime_error("Failed to add Date header");
             }
-            LOG(INFO) << "Date header added to response";
+            LOG(DEBUG) << "Date header added to response";
 
             // 获取响应地址并发送
             pjsip_response_addr res_addr;
@@ -386,15 +442,24 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
             if (status != PJ_SUCCESS) {
                 throw std::runtime_error("Failed to get response address");
             }
+            RequestTrace::mark(TraceStage::BUILD);
 
-            LOG(INFO) << "Sending response...";
+            LOG(DEBUG) << "Sending response...";
             status = pjsip_endpt_send_response(
                 endpt.get(),
                 &res_addr,
                 tdata,
                 nullptr,
                 nullptr);
-            LOG(INFO) << "Response sent with status: " << status;
+            RequestTrace::mark(TraceStage::SEND);
+            LOG_SAMPLED(INFO) << "Response sent with status: " << status;
+            if (status == PJ_SUCCESS)
+            {
+                if (status_code == static_cast<int>(SipStatusCode::SIP_OK))
+                    registerMetrics().accepted.inc();
+                else
+                    registerMetrics().rejected.inc();
+            }
             
             // 如果认证成功，更新注册状态
             if (status == PJ_SUCCESS && status_code == static_cast<int>(SipStatusCode::SIP_OK)) 
@@ -405,11 +470,8 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
                 {
                     expires_value = expires_hdr->ivalue;
                 }
-                GlobalCtl::getInstance().setExpires(from_id, expires_value);
-                
-                // 使用写锁保护更新操作
-                std::unique_lock<std::shared_mutex> domain_lock(domain_manager_.getMutex()); 
-                LOG(INFO) << "Updating registration for domain: " << from_id;
+                // updateRegistration 内部持有写锁，这里不能再加锁
+                LOG(DEBUG) << "Updating registration for domain: " << from_id;
                 
                 time_t reg_time = 0;
                 struct sysinfo info;
@@ -421,10 +483,21 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
                 
                 domain_manager_.updateRegistration(from_id, expires_value, true, reg_time);
                 LOG(INFO) << "Registration updated: expires=" << expires_value << ", time=" << reg_time;
+                if (expires_value > 0)
+                {
+                    SipHeartbeat::getInstance(domain_manager_)->track(from_id);
+                    // 下级通过 TCP 注册时保留该连接，之后向其发送请求时复用
+                    TcpConnManager::getInstance()->adopt(from_id, rdata->tp_info.transport);
+                }
+                else
+                {
+                    SipHeartbeat::getInstance(domain_manager_)->untrack(from_id);
+                }
+                RequestTrace::mark(TraceStage::UPDATE);
             }
 
         } catch (const std::exception& e) {
-            LOG(ERROR) << "Exception in auth verification: " << e.what();
+            LOG_LIMITED(ERROR, from_id) << "Exception in auth verification: " << e.what();
             status = PJ_EINVAL;
         }
 
@@ -432,7 +505,7 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
         if (tdata) 
         {
             pjsip_tx_data_dec_ref(tdata);
-            LOG(INFO) << "Transaction data reference decremented";
+            LOG(DEBUG) << "Transaction data reference decremented";
         }
 
         return status;
@@ -442,7 +515,7 @@ pj_status_t SipRegister::handleAuthRegister(SipTypes::RxDataPtr rdata)
 // 普通注册处理，修改为接收智能指针
 pj_status_t SipRegister::handleRegister(SipTypes::RxDataPtr rdata)
 {
-    LOG(INFO) << "handleRegister called with rdata=" << (void*)rdata.get();
+    LOG(DEBUG) << "handleRegister called with rdata=" << (void*)rdata.get();
     // 生成32位随机数（用于安全目的）
     std::string random = GlobalCtl::getRandomNum(32);
     // 创建线程注册器实例，用于管理线程相关的资源
@@ -477,12 +550,15 @@ pj_status_t SipRegister::handleRegister(SipTypes::RxDataPtr rdata)
         auto domain = domain_manager_.findDomain(from_id);
         domain_exists = (domain != nullptr);
     } // 读锁在此释放
+    RequestTrace::mark(TraceStage::AUTH);
 
     // 如果域不存在，返回404错误
     if (!domain_exists)
     {
         status_code = static_cast<int> (SipStatusCode::SIP_NOT_FOUND);
-        LOG(ERROR) << "Domain not found: " << from_id;
+        RequestTrace::status(status_code);
+        LOG_LIMITED(ERROR, from_id) << "Domain not found: " << from_id;
+        registerMetrics().rejected.inc();
         return PJ_EINVAL;
     }
     // 如果域存在，获取Expires头部的值
@@ -490,7 +566,7 @@ pj_status_t SipRegister::handleRegister(SipTypes::RxDataPtr rdata)
             pjsip_msg_find_hdr(rdata->msg_info.msg, PJSIP_H_EXPIRES, nullptr)))
     {
         expires_value = expires_raw->ivalue;
-        LOG(INFO) << "Expires header: " << expires_value;
+        LOG(DEBUG) << "Expires header: " << expires_value;
     }
 
     // 创建响应消息
@@ -537,7 +613,7 @@ pj_status_t SipRegister::handleRegister(SipTypes::RxDataPtr rdata)
         [&endpt](void* p) { 
             if (p) {
                 pjsip_endpt_release_pool(endpt.get(), static_cast<pj_pool_t*>(p));
-                LOG(INFO) << "Date pool released";
+                LOG(DEBUG) << "Date pool released";
             }
         }
     );
@@ -559,6 +635,7 @@ pj_status_t SipRegister::handleRegister(SipTypes::RxDataPtr rdata)
         pjsip_tx_data_dec_ref(txdata);
         return status;
     }
+    RequestTrace::mark(TraceStage::BUILD);
     
     // 发送响应消息
     status = pjsip_endpt_send_response(
@@ -568,18 +645,20 @@ pj_status_t SipRegister::handleRegister(SipTypes::RxDataPtr rdata)
         nullptr,
         nullptr
     );
+    RequestTrace::mark(TraceStage::SEND);
     if(status != PJ_SUCCESS)
     {
         LOG(ERROR) << "Failed to send response: " << status;
         pjsip_tx_data_dec_ref(txdata);
         return status;
     }
+    registerMetrics().accepted.inc();
+    RequestTrace::status(status_code);
 
     // 更新注册状态
     {
-        // 使用写锁保护更新操作
-        std::unique_lock<std::shared_mutex> lock(domain_manager_.getMutex()); 
-        LOG(INFO) << "handleRegister: lock acquired for updateRegistration";
+        // updateRegistration 内部持有写锁，这里不能再加锁
+        LOG(DEBUG) << "handleRegister: updating registration";
         // 根据过期时间更新注册状态
         // 如果过期时间大于0，记录注册时间
         if(expires_value > 0)
@@ -590,22 +669,26 @@ pj_status_t SipRegister::handleRegister(SipTypes::RxDataPtr rdata)
             struct sysinfo info;
             if (sysinfo(&info) == 0){
                 reg_time = info.uptime;
-                LOG(INFO) << "System uptime: " << info.uptime << " seconds";
+                LOG(DEBUG) << "System uptime: " << info.uptime << " seconds";
             }else{
                 reg_time = std::time(nullptr);
                 LOG(ERROR) << "Failed to get system uptime, using current time: " << reg_time;
             }
             domain_manager_.updateRegistration(from_id, expires_value, true, reg_time);
             LOG(INFO) << "Registration successful for domain: " << from_id;
-            LOG(INFO) << "Registration time: " << reg_time;
+            LOG(DEBUG) << "Registration time: " << reg_time;
+            SipHeartbeat::getInstance(domain_manager_)->track(from_id);
+            TcpConnManager::getInstance()->adopt(from_id, rdata->tp_info.transport);
         }
         // 如果过期时间为0，表示注销请求
         else if(expires_value == 0)
         {
             domain_manager_.updateRegistration(from_id, 0, false, 0);
+            SipHeartbeat::getInstance(domain_manager_)->untrack(from_id);
             LOG(INFO) << "Unregistration successful for domain: " << from_id;
         }
-    } // 写锁在此释放
+    }
+    RequestTrace::mark(TraceStage::UPDATE);
     return status;
 }
 
@@ -638,7 +721,7 @@ std::string SipRegister::formatSIPDate(const std::tm& tm_utc)
     {
         throw std::runtime_error("Failed to format UTC time");
     }
-    LOG(INFO) << "Formatted SIP Date: " << buf;
+    LOG(DEBUG) << "Formatted SIP Date: " << buf;
     return std::string(buf);
 }
 
@@ -664,7 +747,7 @@ bool SipRegister::addDateHeader(pjsip_msg* msg, pj_pool_t* pool)
         }
         
         pjsip_msg_add_hdr(msg, reinterpret_cast<pjsip_hdr*>(date_hdr));
-        LOG(INFO) << "Date header added: " << date_str;
+        LOG(DEBUG) << "Date header added: " << date_str;
         return true;
         
     } catch (const std::exception& e) {
@@ -741,7 +824,7 @@ std::string SipRegister::parseFromHeader(pjsip_msg* msg)
         throw std::runtime_error("Empty user ID in URI: " + uri_str);
     }
 
-    LOG(INFO) << "Parsed From header user ID: " << user_id;
+    LOG(DEBUG) << "Parsed From header user ID: " << user_id;
     return user_id;
 }
 
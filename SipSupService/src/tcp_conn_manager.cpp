@@ -0,0 +1,312 @@
+// tcp_conn_manager.cpp
+#include "tcp_conn_manager.h"
+#include "global_ctl.h"
+#include "pjsip_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+std::shared_ptr<TcpConnManager> TcpConnManager::instance_ = nullptr;
+std::mutex TcpConnManager::instance_mutex_;
+
+// 空闲回收检查周期
+static constexpr unsigned int REAP_INTERVAL_MS = 10000;
+
+std::shared_ptr<TcpConnManager> TcpConnManager::getInstance()
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+        instance_ = std::shared_ptr<TcpConnManager>(new TcpConnManager());
+    return instance_;
+}
+
+TcpConnManager::TcpConnManager()
+    : reap_timer_(std::make_shared<TaskTimer>("tcp-reaper"))
+{
+    reap_timer_->setInterval(REAP_INTERVAL_MS);
+}
+
+TcpConnManager::~TcpConnManager()
+{
+    LOG(INFO) << "Destroying TcpConnManager";
+    if (reap_timer_)
+    {
+        reap_timer_->stop();
+    }
+}
+
+int64_t TcpConnManager::nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TcpConnManager::startReaper(unsigned int idle_timeout_sec)
+{
+    idle_timeout_ms_ = static_cast<int64_t>(idle_timeout_sec) * 1000;
+    LOG(INFO) << "Starting TCP connection reaper, idle timeout: " << idle_timeout_sec << "s";
+    reap_timer_->addTask([weak_this = std::weak_ptr<TcpConnManager>(shared_from_this())]() {
+        if (auto shared_this = weak_this.lock())
+        {
+            try {
+                shared_this->reapIdle();
+            } catch (const std::exception& e) {
+                LOG(ERROR) << "Error in TCP reaper task: " << e.what();
+            }
+        }
+    });
+    reap_timer_->start();
+}
+
+// 锁顺序：pjsip 持有传输锁调用 onTransportState，回调里再取 conn_mutex_，
+// 因此持有 conn_mutex_ 时不能调用任何会取传输锁的 pjsip 传输接口（建连、增删监听器、dec_ref）
+pjsip_transport* TcpConnManager::acquire(const std::string& peer_id, const std::string& ip, int port)
+{
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        auto it = conns_.find(peer_id);
+        if (it != conns_.end())
+        {
+            it->second.last_used_ms = nowMs();
+            reused_.fetch_add(1, std::memory_order_relaxed);
+            return it->second.tp;
+        }
+    }
+
+    auto endpt = GlobalCtl::getInstance().getSipCore().getEndPoint();
+    if (!endpt)
+    {
+        return nullptr;
+    }
+
+    pj_sockaddr addr;
+    pj_str_t host = pj_str(const_cast<char*>(ip.c_str()));
+    pj_status_t status = pj_sockaddr_init(pj_AF_INET(), &addr, &host, static_cast<pj_uint16_t>(port));
+    if (status != PJ_SUCCESS)
+    {
+        LOG(ERROR) << "Invalid TCP peer address " << ip << ":" << port;
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // acquire_transport 返回的传输已加一次引用，这份引用由管理器长期持有
+    pjsip_transport* tp { nullptr };
+    status = pjsip_endpt_acquire_transport(endpt.get(), PJSIP_TRANSPORT_TCP, &addr,
+        pj_sockaddr_get_len(&addr), nullptr, &tp);
+    if (status != PJ_SUCCESS || !tp)
+    {
+        LOG(ERROR) << "Failed to acquire TCP transport to " << ip << ":" << port
+                   << ", code: " << status;
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Conn conn;
+    conn.tp = tp;
+    conn.last_used_ms = nowMs();
+    pjsip_transport_add_state_listener(tp, &TcpConnManager::onTransportState, this, &conn.listener);
+
+    pjsip_transport* winner { nullptr };
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        auto it = conns_.find(peer_id);
+        if (it != conns_.end())
+        {
+            // 解锁期间其他线程已为该对端建立连接，使用先登记的那条
+            it->second.last_used_ms = conn.last_used_ms;
+            winner = it->second.tp;
+        }
+        else
+        {
+            conns_.emplace(peer_id, conn);
+        }
+    }
+    if (winner)
+    {
+        release(peer_id, conn);
+        reused_.fetch_add(1, std::memory_order_relaxed);
+        return winner;
+    }
+    created_.fetch_add(1, std::memory_order_relaxed);
+    LOG(INFO) << "TCP connection to " << peer_id << " (" << ip << ":" << port << ") created";
+    return tp;
+}
+
+void TcpConnManager::adopt(const std::string& peer_id, pjsip_transport* tp)
+{
+    if (!tp || pjsip_transport_get_type_from_flag(tp->flag) != PJSIP_TRANSPORT_TCP)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        auto it = conns_.find(peer_id);
+        if (it != conns_.end() && it->second.tp == tp)
+        {
+            it->second.last_used_ms = nowMs();
+            return;
+        }
+    }
+
+    pjsip_transport_add_ref(tp);
+    Conn conn;
+    conn.tp = tp;
+    conn.last_used_ms = nowMs();
+    pjsip_transport_add_state_listener(tp, &TcpConnManager::onTransportState, this, &conn.listener);
+
+    // 对端重新建立了连接时换下旧连接，解锁后再释放
+    Conn stale;
+    bool duplicate = false;
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        auto it = conns_.find(peer_id);
+        if (it == conns_.end())
+        {
+            conns_.emplace(peer_id, conn);
+        }
+        else if (it->second.tp == tp)
+        {
+            it->second.last_used_ms = conn.last_used_ms;
+            duplicate = true;
+        }
+        else
+        {
+            stale = it->second;
+            it->second = conn;
+        }
+    }
+    if (duplicate)
+    {
+        release(peer_id, conn);
+        return;
+    }
+    if (stale.tp)
+    {
+        release(peer_id, stale);
+    }
+    adopted_.fetch_add(1, std::memory_order_relaxed);
+    LOG(INFO) << "TCP connection from " << peer_id << " adopted";
+}
+
+pj_status_t TcpConnManager::bindTxData(pjsip_tx_data* tdata, const std::string& peer_id, const std::string& ip, int port)
+{
+    pjsip_transport* tp = acquire(peer_id, ip, port);
+    if (!tp)
+    {
+        return PJ_ENOTFOUND;
+    }
+    pjsip_tpselector sel;
+    pj_bzero(&sel, sizeof(sel));
+    sel.type = PJSIP_TPSELECTOR_TRANSPORT;
+    sel.u.transport = tp;
+    // tdata 会对传输另加引用，不影响管理器持有的引用
+    return pjsip_tx_data_set_transport(tdata, &sel);
+}
+
+pj_status_t TcpConnManager::bindRegc(pjsip_regc* regc, const std::string& peer_id, const std::string& ip, int port)
+{
+    pjsip_transport* tp = acquire(peer_id, ip, port);
+    if (!tp)
+    {
+        return PJ_ENOTFOUND;
+    }
+    pjsip_tpselector sel;
+    pj_bzero(&sel, sizeof(sel));
+    sel.type = PJSIP_TPSELECTOR_TRANSPORT;
+    sel.u.transport = tp;
+    return pjsip_regc_set_transport(regc, &sel);
+}
+
+void TcpConnManager::release(const std::string& peer_id, Conn& conn)
+{
+    if (conn.listener)
+    {
+        pjsip_transport_remove_state_listener(conn.tp, conn.listener, this);
+        conn.listener = nullptr;
+    }
+    pjsip_transport_dec_ref(conn.tp);
+    conn.tp = nullptr;
+    LOG(INFO) << "TCP connection to " << peer_id << " released";
+}
+
+void TcpConnManager::reapIdle()
+{
+    PjSipUtils::ThreadRegistrar thread_registrar;
+    int64_t now = nowMs();
+    int64_t idle_ms = idle_timeout_ms_.load(std::memory_order_relaxed);
+
+    // 锁内只摘下空闲连接，释放在解锁之后
+    std::vector<std::pair<std::string, Conn>> idle;
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        for (auto it = conns_.begin(); it != conns_.end();)
+        {
+            if (now - it->second.last_used_ms < idle_ms)
+            {
+                ++it;
+                continue;
+            }
+            // last_used_ms 只记录经管理器的使用；regc 自动刷新、在途的请求与事务都会对传输
+            // 另加引用，引用数大于管理器自己的这一份说明连接仍在使用，视为刚刚使用过
+            if (pj_atomic_get(it->second.tp->ref_cnt) > 1)
+            {
+                it->second.last_used_ms = now;
+                ++it;
+                continue;
+            }
+            idle.emplace_back(it->first, it->second);
+            it = conns_.erase(it);
+        }
+    }
+    for (auto& [peer_id, conn] : idle)
+    {
+        release(peer_id, conn);
+        reaped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TcpConnManager::onTransportState(pjsip_transport* tp, pjsip_transport_state state,
+                                      const pjsip_transport_state_info* info)
+{
+    if (state != PJSIP_TP_STATE_DISCONNECTED && state != PJSIP_TP_STATE_SHUTDOWN)
+    {
+        return;
+    }
+    auto self = getInstance();
+    std::string peer_id;
+    {
+        std::lock_guard<std::mutex> lock(self->conn_mutex_);
+        auto it = std::find_if(self->conns_.begin(), self->conns_.end(),
+            [tp](const auto& entry) { return entry.second.tp == tp; });
+        if (it == self->conns_.end())
+        {
+            return;
+        }
+        peer_id = it->first;
+        self->conns_.erase(it);
+    }
+    LOG(WARNING) << "TCP connection to " << peer_id << " closed, status: "
+                 << (info ? info->status : PJ_SUCCESS);
+    // 回调中不再移除监听器，pjsip 在销毁传输时统一清理
+    pjsip_transport_dec_ref(tp);
+    self->closed_.fetch_add(1, std::memory_order_relaxed);
+}
+
+TcpConnManager::Metrics TcpConnManager::metrics() const
+{
+    Metrics m;
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        m.active = conns_.size();
+    }
+    m.created = created_.load(std::memory_order_relaxed);
+    m.reused = reused_.load(std::memory_order_relaxed);
+    m.adopted = adopted_.load(std::memory_order_relaxed);
+    m.reaped = reaped_.load(std::memory_order_relaxed);
+    m.closed = closed_.load(std::memory_order_relaxed);
+    m.failed = failed_.load(std::memory_order_relaxed);
+    return m;
+}
@@ -0,0 +1,232 @@
+// thread_placement.cpp
+#include "thread_placement.h"
+#include "common.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+namespace {
+    int findNode(const std::vector<NumaNode>& nodes, int cpu)
+    {
+        for (const auto& node : nodes)
+        {
+            if (std::binary_search(node.cpus.begin(), node.cpus.end(), cpu))
+                return node.id;
+        }
+        return -1;
+    }
+}
+
+std::shared_ptr<ThreadPlacement> ThreadPlacement::instance_ = nullptr;
+std::mutex ThreadPlacement::instance_mutex_;
+
+std::shared_ptr<ThreadPlacement> ThreadPlacement::getInstance()
+{
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    if (!instance_)
+        instance_ = std::shared_ptr<ThreadPlacement>(new ThreadPlacement());
+    return instance_;
+}
+
+void ThreadPlacement::configure(const ThreadPlacementConfig& config)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+}
+
+std::vector<int> ThreadPlacement::cpusFor(ThreadRole role) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return config_.cpusFor(role);
+}
+
+void ThreadPlacement::preferLocalMemory() const
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!config_.numa_local_alloc) return;
+    }
+#ifdef HAVE_LIBNUMA
+    if (numa_available() >= 0)
+    {
+        numa_set_localalloc();
+    }
+#endif
+    // 未链接 libnuma 时内核默认策略即首次访问分配，无需额外处理
+}
+
+const char* ThreadPlacement::roleName(ThreadRole role)
+{
+    switch (role)
+    {
+        case ThreadRole::SIP_IO: return "sip_io";
+        case ThreadRole::WORKER: return "workers";
+        case ThreadRole::TIMER:  return "timers";
+        case ThreadRole::MEDIA:  return "media";
+        default:                 return "unknown";
+    }
+}
+
+bool ThreadPlacement::parseCpuList(std::string_view text, std::vector<int>& cpus, std::string* err)
+{
+    cpus.clear();
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t comma = text.find(',', pos);
+        std::string_view item = text.substr(pos, comma == std::string_view::npos ? std::string_view::npos : comma - pos);
+        pos = comma == std::string_view::npos ? text.size() : comma + 1;
+
+        while (!item.empty() && std::isspace(static_cast<unsigned char>(item.front()))) item.remove_prefix(1);
+        while (!item.empty() && std::isspace(static_cast<unsigned char>(item.back()))) item.remove_suffix(1);
+        if (item.empty()) continue;
+
+        int first = 0;
+        int last = 0;
+        size_t dash = item.find('-');
+        try {
+            first = std::stoi(std::string(item.substr(0, dash)));
+            last = dash == std::string_view::npos ? first : std::stoi(std::string(item.substr(dash + 1)));
+        } catch (const std::exception&) {
+            if (err) *err = "invalid cpu list item: " + std::string(item);
+            return false;
+        }
+        if (first < 0 || last < first || last >= CPU_SETSIZE)
+        {
+            if (err) *err = "invalid cpu range: " + std::string(item);
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return true;
+}
+
+std::string ThreadPlacement::formatCpuList(const std::vector<int>& cpus)
+{
+    if (cpus.empty()) return "any";
+    std::string out;
+    for (size_t i = 0; i < cpus.size();)
+    {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (!out.empty()) out += ",";
+        out += std::to_string(cpus[i]);
+        if (j > i) out += "-" + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+bool ThreadPlacement::pinCurrentThread(const std::vector<int>& cpus)
+{
+    if (cpus.empty()) return true;
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &cpuset);
+    }
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (rc != 0)
+    {
+        LOG(WARNING) << "Failed to pin thread to cpus " << formatCpuList(cpus) << ": " << std::strerror(rc);
+        return false;
+    }
+    return true;
+}
+
+std::vector<NumaNode> ThreadPlacement::numaNodes()
+{
+    // 在线节点列表与 cpulist 格式相同（如 "0,2-3"），节点号可能不连续
+    std::vector<NumaNode> nodes;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string line;
+    std::vector<int> ids;
+    if (online && std::getline(online, line))
+        parseCpuList(line, ids);
+    for (int id : ids)
+    {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+        if (!file) continue;
+        NumaNode node;
+        node.id = id;
+        std::getline(file, line);
+        parseCpuList(line, node.cpus);
+        nodes.push_back(std::move(node));
+    }
+    if (nodes.empty())
+    {
+        // 没有 NUMA 信息：所有在线 CPU 视为节点0
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        NumaNode node;
+        for (long cpu = 0; cpu < count; ++cpu) node.cpus.push_back(static_cast<int>(cpu));
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+int ThreadPlacement::nodeOfCpu(int cpu)
+{
+    return findNode(numaNodes(), cpu);
+}
+
+void ThreadPlacement::logTopology() const
+{
+    auto nodes = numaNodes();
+    LOG(INFO) << "NUMA topology: " << nodes.size() << " node(s)";
+    for (const auto& node : nodes)
+    {
+        LOG(INFO) << "  node" << node.id << ": cpus " << formatCpuList(node.cpus);
+    }
+
+    ThreadPlacementConfig config;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config = config_;
+    }
+    for (size_t i = 0; i < static_cast<size_t>(ThreadRole::COUNT); ++i)
+    {
+        auto role = static_cast<ThreadRole>(i);
+        const auto& cpus = config.cpusFor(role);
+
+        // 统计该角色跨越的节点，跨节点时给出提示
+        std::vector<int> role_nodes;
+        for (int cpu : cpus)
+        {
+            int node = findNode(nodes, cpu);
+            if (std::find(role_nodes.begin(), role_nodes.end(), node) == role_nodes.end())
+                role_nodes.push_back(node);
+        }
+        std::string node_text;
+        for (int node : role_nodes)
+        {
+            node_text += (node_text.empty() ? "" : ",") + std::to_string(node);
+        }
+        LOG(INFO) << fmt::format("  role {:<8} cpus {:<16} nodes {}", roleName(role),
+            formatCpuList(cpus), node_text.empty() ? "any" : node_text);
+        if (role_nodes.size() > 1)
+        {
+            LOG(WARNING) << "Thread role " << roleName(role) << " spans " << role_nodes.size() << " NUMA nodes";
+        }
+    }
+#ifdef HAVE_LIBNUMA
+    LOG(INFO) << "  numa local alloc: " << (config.numa_local_alloc && numa_available() >= 0 ? "libnuma" : "off");
+#else
+    LOG(INFO) << "  numa local alloc: " << (config.numa_local_alloc ? "first-touch" : "off");
+#endif
+}